@@ -17,6 +17,8 @@
 #ifndef INCcvtTableh
 #define INCcvtTableh    1
 
+#include <stddef.h>
+
 #include "dbCoreAPI.h"
 
 #ifdef __cplusplus
@@ -30,6 +32,24 @@ DBCORE_API long cvtEngToRawBpt(
 DBCORE_API long cvtRawToEngBpt(
     double *pval,short linr,short init,void **ppbrk, short *plbrk);
 
+/** @brief Convert an array of raw values using a breakpoint table
+ *
+ * Converts @a nelem values in place, as cvtRawToEngBpt() would one at a
+ * time. Returns an error status, or 1 if any value was outside the
+ * table and had to be extrapolated.
+ * @since UNRELEASED
+ */
+DBCORE_API long cvtRawToEngBptArray(double *pval, size_t nelem,
+    short linr, short init, void **ppbrk, short *plbrk);
+
+/** @brief Convert an array of engineering values using a breakpoint table
+ *
+ * The inverse of cvtRawToEngBptArray().
+ * @since UNRELEASED
+ */
+DBCORE_API long cvtEngToRawBptArray(double *pval, size_t nelem,
+    short linr, short init, void **ppbrk, short *plbrk);
+
 #ifdef __cplusplus
 }
 #endif
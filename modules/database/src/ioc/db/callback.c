@@ -42,6 +42,7 @@
 #include "dbFldTypes.h"
 #include "dbLock.h"
 #include "dbStaticLib.h"
+#include "dbTrace.h"
 #include "epicsExport.h"
 #include "link.h"
 #include "recSup.h"
@@ -221,7 +222,15 @@ static void callbackTask(void *arg)
             if(!epicsRingPointerIsEmpty(mySet->queue))
                 epicsEventMustTrigger(mySet->semWakeUp);
             mySet->queueOverflow = FALSE;
-            (*pcallback->callback)(pcallback);
+            if (dbTraceMode) {
+                const void *pfunc = (const void *)pcallback->callback;
+
+                dbTraceEvent(dbTraceCallback, 'B', pfunc, prio);
+                (*pcallback->callback)(pcallback);
+                dbTraceEvent(dbTraceCallback, 'E', pfunc, prio);
+            }
+            else
+                (*pcallback->callback)(pcallback);
         }
     }
 
@@ -360,6 +369,9 @@ int callbackRequest(epicsCallback *pcallback)
     }
     if (mySet->queueOverflow) return S_db_bufFull;
 
+    if (dbTraceMode && !epicsInterruptIsInterruptContext())
+        dbTraceEvent(dbTraceCallbackRequest, 'i',
+            (const void *)pcallback->callback, priority);
     pushOK = epicsRingPointerPush(mySet->queue, pcallback);
 
     if (!pushOK) {
@@ -478,6 +490,7 @@ void testSyncCallback(void)
 {
     sync_helper helper[NUM_CALLBACK_PRIORITIES];
     unsigned i;
+    int j, nthreads;
 
     testDiag("Begin testSyncCallback()");
 
@@ -489,14 +502,17 @@ void testSyncCallback(void)
          * the locking requirements for sync_helper.
          */
         testGlobalLock();
-        helper[i].nphase2 = helper[i].nphase3 = callbackQueue[i].threadsRunning;
+        nthreads = helper[i].nphase2 = helper[i].nphase3 =
+            callbackQueue[i].threadsRunning;
         testGlobalUnlock();
 
         callbackSetUser(&helper[i], &helper[i].cb);
         callbackSetPriority(i, &helper[i].cb);
         callbackSetCallback(sync_callback, &helper[i].cb);
 
-        callbackRequest(&helper[i].cb);
+        /* one request for each worker */
+        for(j=0; j<nthreads; j++)
+            callbackRequest(&helper[i].cb);
     }
 
     for(i=0; i<NUM_CALLBACK_PRIORITIES; i++) {
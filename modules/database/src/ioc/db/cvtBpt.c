@@ -39,32 +39,45 @@ static brkTable *findBrkTable(short linr)
     return dbFindBrkTable(pdbbase,pdbMenu->papChoiceValue[linr]);
 }
 
-/* Used by both ao and ai record types */
-long cvtRawToEngBpt(double *pval, short linr, short init,
+static long getBrkTable(brkTable **ppbrkTable, short linr, short init,
         void **ppbrk, short *plbrk)
 {
-    double      val = *pval;
-    long        status = 0;
-    brkTable    *pbrkTable;
-    brkInt      *pInt, *nInt;
-    short       lbrk;
-    int         number;
-
     if (linr < 2)
         return -1;
 
-    if (init || *ppbrk == NULL) {
-        pbrkTable = findBrkTable(linr);
+    if (init || *ppbrk == NULL) { /*must find breakpoint table*/
+        brkTable *pbrkTable = findBrkTable(linr);
+
         if (!pbrkTable)
             return S_dbLib_badField;
 
         *ppbrk = (void *)pbrkTable;
+        /* start at the beginning */
         *plbrk = 0;
-    } else
-        pbrkTable = (brkTable *)*ppbrk;
+    }
+    *ppbrkTable = (brkTable *)*ppbrk;
+    return 0;
+}
 
-    number = pbrkTable->number;
-    lbrk = *plbrk;
+/* Interval in the grid cell holding val */
+static short gridInterval(const brkIndex *pindex, double val)
+{
+    double cell = (val - pindex->low) * pindex->scale;
+
+    if (cell < 0)
+        return pindex->pcell[0];
+    if (!(cell < pindex->ncells))
+        return pindex->pcell[pindex->ncells - 1];
+    return pindex->pcell[(long)cell];
+}
+
+static long rawToEng(const brkTable *pbrkTable, double *pval, short *plbrk)
+{
+    double      val = *pval;
+    long        status = 0;
+    const brkInt *pInt, *nInt;
+    int         number = pbrkTable->number;
+    short       lbrk = *plbrk;
 
     /* Limit index to the size of the table */
     if (lbrk < 0)
@@ -75,6 +88,14 @@ long cvtRawToEngBpt(double *pval, short linr, short init,
     pInt = & pbrkTable->paBrkInt[lbrk];
     nInt = pInt + 1;
 
+    /* Jump to a nearby interval unless val is still in the last one */
+    if (pbrkTable->prawIndex &&
+        !((val - pInt->raw) * (val - nInt->raw) <= 0)) {
+        lbrk = gridInterval(pbrkTable->prawIndex, val);
+        pInt = & pbrkTable->paBrkInt[lbrk];
+        nInt = pInt + 1;
+    }
+
     if (nInt->raw > pInt->raw) {
         /* raw values increase down the table */
         while (val > nInt->raw) {
@@ -119,33 +140,13 @@ long cvtRawToEngBpt(double *pval, short linr, short init,
     return status;
 }
 
-/* Used by the ao record type */
-long cvtEngToRawBpt(double *pval, short linr, short init,
-        void **ppbrk, short *plbrk)
+static long engToRaw(const brkTable *pbrkTable, double *pval, short *plbrk)
 {
     double      val = *pval;
     long        status = 0;
-    brkTable    *pbrkTable;
-    brkInt      *pInt, *nInt;
-    short       lbrk;
-    int         number;
-
-    if (linr < 2)
-        return -1;
-
-    if (init || *ppbrk == NULL) { /*must find breakpoint table*/
-        pbrkTable = findBrkTable(linr);
-        if (!pbrkTable)
-            return S_dbLib_badField;
-
-        *ppbrk = (void *)pbrkTable;
-        /* start at the beginning */
-        *plbrk = 0;
-    } else
-        pbrkTable = (brkTable *)*ppbrk;
-
-    number = pbrkTable->number;
-    lbrk = *plbrk;
+    const brkInt *pInt, *nInt;
+    int         number = pbrkTable->number;
+    short       lbrk = *plbrk;
 
     /* Limit index to the size of the table */
     if (lbrk < 0)
@@ -156,6 +157,14 @@ long cvtEngToRawBpt(double *pval, short linr, short init,
     pInt = & pbrkTable->paBrkInt[lbrk];
     nInt = pInt + 1;
 
+    /* Jump to a nearby interval unless val is still in the last one */
+    if (pbrkTable->pengIndex &&
+        !((val - pInt->eng) * (val - nInt->eng) <= 0)) {
+        lbrk = gridInterval(pbrkTable->pengIndex, val);
+        pInt = & pbrkTable->paBrkInt[lbrk];
+        nInt = pInt + 1;
+    }
+
     if (nInt->eng > pInt->eng) {
         /* eng values increase down the table */
         while (val > nInt->eng) {
@@ -199,3 +208,64 @@ long cvtEngToRawBpt(double *pval, short linr, short init,
 
     return status;
 }
+
+/* Used by both ao and ai record types */
+long cvtRawToEngBpt(double *pval, short linr, short init,
+        void **ppbrk, short *plbrk)
+{
+    brkTable    *pbrkTable;
+    long        status = getBrkTable(&pbrkTable, linr, init, ppbrk, plbrk);
+
+    if (status)
+        return status;
+    return rawToEng(pbrkTable, pval, plbrk);
+}
+
+/* Used by the ao record type */
+long cvtEngToRawBpt(double *pval, short linr, short init,
+        void **ppbrk, short *plbrk)
+{
+    brkTable    *pbrkTable;
+    long        status = getBrkTable(&pbrkTable, linr, init, ppbrk, plbrk);
+
+    if (status)
+        return status;
+    return engToRaw(pbrkTable, pval, plbrk);
+}
+
+long cvtRawToEngBptArray(double *pval, size_t nelem, short linr,
+        short init, void **ppbrk, short *plbrk)
+{
+    brkTable    *pbrkTable;
+    long        status = getBrkTable(&pbrkTable, linr, init, ppbrk, plbrk);
+    size_t      i;
+
+    if (status)
+        return status;
+    for (i = 0; i < nelem; i++) {
+        /* Convert them all, but keep the first status */
+        long stat = rawToEng(pbrkTable, &pval[i], plbrk);
+
+        if (!status)
+            status = stat;
+    }
+    return status;
+}
+
+long cvtEngToRawBptArray(double *pval, size_t nelem, short linr,
+        short init, void **ppbrk, short *plbrk)
+{
+    brkTable    *pbrkTable;
+    long        status = getBrkTable(&pbrkTable, linr, init, ppbrk, plbrk);
+    size_t      i;
+
+    if (status)
+        return status;
+    for (i = 0; i < nelem; i++) {
+        long stat = engToRaw(pbrkTable, &pval[i], plbrk);
+
+        if (!status)
+            status = stat;
+    }
+    return status;
+}
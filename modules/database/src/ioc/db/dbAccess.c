@@ -30,6 +30,7 @@
 #include "dbDefs.h"
 #include "ellLib.h"
 #include "epicsMath.h"
+#include "epicsString.h"
 #include "epicsThread.h"
 #include "epicsTime.h"
 #include "errlog.h"
@@ -51,10 +52,12 @@
 #include "dbLink.h"
 #include "dbLockPvt.h"
 #include "dbNotify.h"
+#include "dbProfile.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
+#include "dbTrace.h"
 #include "devSup.h"
 #include "epicsEvent.h"
 #include "link.h"
@@ -605,7 +608,19 @@ long dbProcess(dbCommon *precord)
         printf("%s: dbProcess of '%s'\n", context, precord->name);
 
     /* process record */
-    status = prset->process(precord);
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceProcess, 'B', precord, 0);
+    if (dbProfiling) {
+        dbProfileFrame frame;
+
+        dbProfileBegin(&frame);
+        status = prset->process(precord);
+        dbProfileEnd(precord, &frame);
+    }
+    else
+        status = prset->process(precord);
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceProcess, 'E', precord, 0);
 
     /* Print record's fields if PRINT_MASK set in breakpoint field */
     if (lset_stack_count != 0) {
@@ -809,6 +824,59 @@ int dbLoadRecords(const char* file, const char* subs)
     return status;
 }
 
+/* Files queued by dbLoadRecordsQueue() */
+static dbReadBatchItem *batchItems;
+static int batchCount;
+static int batchAlloc;
+
+int dbLoadRecordsQueue(const char* file, const char* subs)
+{
+    dbReadBatchItem *pitem;
+
+    if (!file) {
+        printf("Usage: dbLoadRecordsQueue \"file\", \"subs\"\n");
+        return -1;
+    }
+    if (batchCount == batchAlloc) {
+        batchAlloc = batchAlloc ? 2 * batchAlloc : 16;
+        batchItems = realloc(batchItems, batchAlloc * sizeof(*batchItems));
+        if (!batchItems)
+            cantProceed("dbLoadRecordsQueue: Out of memory\n");
+    }
+    pitem = &batchItems[batchCount++];
+    pitem->filename = epicsStrDup(file);
+    pitem->substitutions = subs ? epicsStrDup(subs) : NULL;
+    pitem->status = 0;
+    return 0;
+}
+
+int dbLoadRecordsBatch(int threads)
+{
+    int status, i;
+
+    if (!batchCount)
+        return 0;
+    status = dbReadDatabaseBatch(&pdbbase, batchItems, batchCount, 0,
+        threads);
+    for (i = 0; i < batchCount; i++) {
+        dbReadBatchItem *pitem = &batchItems[i];
+
+        if (pitem->status == 0) {
+            if(dbLoadRecordsHook)
+                dbLoadRecordsHook(pitem->filename, pitem->substitutions);
+        } else {
+            fprintf(stderr, ERL_ERROR " failed to load '%s'\n",
+                pitem->filename);
+            if(pitem->status==-2)
+                fprintf(stderr, "    Records cannot be loaded after iocInit!\n");
+        }
+        free((char *)pitem->filename);
+        free((char *)pitem->substitutions);
+    }
+    batchCount = 0;
+    return status ? -1 : 0;
+}
+
 
 static long getLinkValue(DBADDR *paddr, short dbrType,
     char *pbuf, long *nRequest)
@@ -896,9 +964,9 @@ long dbGetField(DBADDR *paddr,short dbrType,
     dbCommon *precord = paddr->precord;
     long status = 0;
 
-    dbScanLock(precord);
+    dbScanLockShared(precord);
     status = dbGet(paddr, dbrType, pbuffer, options, nRequest, pflin);
-    dbScanUnlock(precord);
+    dbScanUnlockShared(precord);
     return status;
 }
 
@@ -906,7 +974,7 @@ long dbGet(DBADDR *paddr, short dbrType,
     void *pbuffer, long *options, long *nRequest, void *pflin)
 {
     char *pbuf = pbuffer;
-    void *pfieldsave = paddr->pfield;
+    DBADDR arrayAddr;
     db_field_log *pfl = (db_field_log *)pflin;
     short field_type;
     long capacity, no_elements, offset;
@@ -927,12 +995,15 @@ long dbGet(DBADDR *paddr, short dbrType,
     }
 
     /* Update field info from record (if necessary);
-     * may modify paddr->pfield.
+     * may modify the pfield of the copy of paddr it is given,
+     * so that readers sharing a lock set can share paddr too.
      */
     if (!dbfl_has_copy(pfl) &&
         paddr->pfldDes->special == SPC_DBADDR &&
         (prset = dbGetRset(paddr)) &&
         prset->get_array_info) {
+        arrayAddr = *paddr; /* Structure copy */
+        paddr = &arrayAddr;
         status = prset->get_array_info(paddr, &no_elements, &offset);
     } else {
         offset = 0;
@@ -1039,7 +1110,6 @@ long dbGet(DBADDR *paddr, short dbrType,
         }
     }
 done:
-    paddr->pfield = pfieldsave;
     return status;
 }
 
@@ -274,6 +274,23 @@ DBCORE_API int  dbLoadDatabase(
     const char *filename, const char *path, const char *substitutions);
 DBCORE_API int dbLoadRecords(
     const char* filename, const char* substitutions);
+/** @brief Queue a .db file to be loaded by dbLoadRecordsBatch().
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API int dbLoadRecordsQueue(
+    const char* filename, const char* substitutions);
+/** @brief Load the files queued by dbLoadRecordsQueue().
+ *
+ * The files are read and have their macros expanded using @p threads
+ * threads (<= 0 is relative to the number of CPUs), then are parsed in
+ * the order they were queued. iocInit() loads any files still queued.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ *
+ * @return 0 if every file was loaded.
+ */
+DBCORE_API int dbLoadRecordsBatch(int threads);
 
 #ifdef __cplusplus
 }
@@ -31,6 +31,7 @@
 #include "epicsThread.h"
 #include "epicsAtomic.h"
 #include "epicsTime.h"
+#include "epicsTimer.h"
 #include "errlog.h"
 #include "errMdef.h"
 #include "taskwd.h"
@@ -44,6 +45,7 @@
 #include "dbCa.h"
 #include "dbCaPvt.h"
 #include "dbCommon.h"
+#include "dbTrace.h"
 #include "db_convert.h"
 #include "dbLink.h"
 #include "dbLock.h"
@@ -51,6 +53,7 @@
 #include "link.h"
 #include "recGbl.h"
 #include "recSup.h"
+#include "epicsExport.h"
 
 /* from dbAccessDefs.h which can't be included here */
 #define S_db_badDbrtype (M_dbAccess| 3)
@@ -61,17 +64,37 @@
 extern void dbServiceIOInit();
 extern int dbServiceIsolate;
 
-static ELLLIST workList = ELLLIST_INIT;    /* Work list for dbCaTask */
-static epicsMutexId workListLock; /*Mutual exclusions semaphores for workList*/
-static epicsEventId workListEvent; /*wakeup event for dbCaTask*/
-static int removesOutstanding = 0;
+/* Each caLink is always queued to the same worker, chosen by a hash of
+ * its PV name, so the actions for a link are carried out in order.
+ */
+#define DBCA_MAX_WORKERS 64
+
+typedef struct workQueue {
+    ELLLIST workList;       /* Work list for dbCaTask */
+    epicsMutexId workListLock; /*Mutual exclusions semaphores for workList*/
+    epicsEventId workListEvent; /*wakeup event for dbCaTask*/
+    epicsThreadId worker;
+    int exit;
+    int removesOutstanding;
+    /* The following are for dbcar, guarded by workListLock */
+    unsigned long nActions;
+    int maxDepth;
+    epicsUInt64 latency;    /* from addAction to dbCaTask, ns */
+    epicsUInt64 maxLatency;
+} workQueue;
+
+static workQueue workQueues[DBCA_MAX_WORKERS];
+static int nWorkers = 1;
 #define removesOutstandingWarning 10000
 
+int dbCaWorkers = 1;
+epicsExportAddress(int, dbCaWorkers);
+
 static volatile enum dbCaCtl_t {
     ctlInit, ctlRun, ctlPause, ctlExit
 } dbCaCtl;
 static epicsEventId startStopEvent;
-static epicsThreadId dbCaWorker;
+static epicsTimerQueueId rateTimerQueue;
 
 struct ca_client_context * dbCaClientContext;
 
@@ -92,7 +115,7 @@ static int dbca_chan_count;
  *  dbScanLock -> caLink.lock -> workListLock
  *
  * workListLock:
- *   Guards access to workList.
+ *   Guards access to the workList of one worker.
  *
  * dbScanLock:
  *   All dbCa* functions operating on a single link may only be called when
@@ -128,11 +151,17 @@ static int dbca_chan_count;
  *   Thus the user's callback will get called exactly once.
  */
 
+static workQueue * linkQueue(const caLink *pca)
+{
+    return &workQueues[pca->hash % nWorkers];
+}
+
 static void addAction(caLink *pca, short link_action)
 {
+    workQueue *pq = linkQueue(pca);
     int callAdd;
 
-    epicsMutexMustLock(workListLock);
+    epicsMutexMustLock(pq->workListLock);
     callAdd = (pca->link_action == 0);
     if (pca->link_action & CA_CLEAR_CHANNEL) {
         errlogPrintf("dbCa::addAction %d with CA_CLEAR_CHANNEL set\n",
@@ -141,22 +170,29 @@ static void addAction(caLink *pca, short link_action)
         link_action = 0;
     }
     if (link_action & CA_CLEAR_CHANNEL) {
-        if (++removesOutstanding >= removesOutstandingWarning) {
+        if (++pq->removesOutstanding >= removesOutstandingWarning) {
             errlogPrintf("dbCa::addAction pausing, %d channels to clear\n",
-                removesOutstanding);
+                pq->removesOutstanding);
         }
-        while (removesOutstanding >= removesOutstandingWarning) {
-            epicsMutexUnlock(workListLock);
+        while (pq->removesOutstanding >= removesOutstandingWarning) {
+            epicsMutexUnlock(pq->workListLock);
             epicsThreadSleep(1.0);
-            epicsMutexMustLock(workListLock);
+            epicsMutexMustLock(pq->workListLock);
         }
     }
     pca->link_action |= link_action;
+    if (callAdd) {
+        int depth;
+
+        pca->queued = epicsMonotonicGet();
+        ellAdd(&pq->workList, &pca->node);
+        depth = ellCount(&pq->workList);
+        if (depth > pq->maxDepth)
+            pq->maxDepth = depth;
+    }
+    epicsMutexUnlock(pq->workListLock);
     if (callAdd)
-        ellAdd(&workList, &pca->node);
-    epicsMutexUnlock(workListLock);
-    if (callAdd)
-        epicsEventSignal(workListEvent);
+        epicsEventSignal(pq->workListEvent);
 }
 
 static void caLinkInc(caLink *pca)
@@ -178,7 +214,7 @@ static void caLinkDec(caLink *pca)
 
     if (pca->chid) {
         ca_clear_channel(pca->chid);
-        --dbca_chan_count;
+        epicsAtomicDecrIntT(&dbca_chan_count);
     }
     callback = pca->putCallback;
     if (callback) {
@@ -191,6 +227,8 @@ static void caLinkDec(caLink *pca)
     free(pca->pgetString);
     free(pca->pputString);
     free(pca->pvname);
+    if (pca->rateTimer)
+        epicsTimerQueueDestroyTimer(rateTimerQueue, pca->rateTimer);
     epicsMutexDestroy(pca->lock);
     free(pca);
     if (callback) callback(userPvt);
@@ -267,39 +305,46 @@ void testdbCaWaitForUpdateCount(DBLINK *plink, unsigned long cnt)
     testdbCaWaitForEvent(plink, cnt, testEventCount);
 }
 
-/* Block until worker thread has processed all previously queued actions.
+/* Block until worker threads have processed all previously queued actions.
  * Does not prevent additional actions from being queued.
  */
 void dbCaSync(void)
 {
-    epicsEventId wake;
-    caLink templink;
+    int n = nWorkers;
+    caLink *templinks = dbCalloc(n, sizeof(caLink));
+    int i;
 
-    /* we only partially initialize templink.
+    /* we only partially initialize each templink.
      * It has no link field and no subscription
      * so the worker must handle it early
      */
-    memset(&templink, 0, sizeof(templink));
-    templink.refcount = 1;
-
-    wake = epicsEventMustCreate(epicsEventEmpty);
-    templink.lock = epicsMutexMustCreate();
-
-    templink.userPvt = wake;
-
-    addAction(&templink, CA_SYNC);
-
-    epicsEventMustWait(wake);
-    /* Worker holds workListLock when calling epicsEventMustTrigger()
-     * we hold workListLock to ensure worker call to
-     * epicsEventMustTrigger() returns before we destroy the event.
-     */
-    epicsMutexMustLock(workListLock);
-    assert(templink.refcount==1);
+    for (i = 0; i < n; i++) {
+        caLink *ptemp = &templinks[i];
+
+        ptemp->refcount = 1;
+        ptemp->hash = i;
+        ptemp->lock = epicsMutexMustCreate();
+        ptemp->userPvt = epicsEventMustCreate(epicsEventEmpty);
+        addAction(ptemp, CA_SYNC);
+    }
 
-    epicsMutexDestroy(templink.lock);
-    epicsEventDestroy(wake);
-    epicsMutexUnlock(workListLock);
+    for (i = 0; i < n; i++) {
+        caLink *ptemp = &templinks[i];
+        workQueue *pq = linkQueue(ptemp);
+
+        epicsEventMustWait(ptemp->userPvt);
+        /* Worker holds workListLock when calling epicsEventMustTrigger()
+         * we hold workListLock to ensure worker call to
+         * epicsEventMustTrigger() returns before we destroy the event.
+         */
+        epicsMutexMustLock(pq->workListLock);
+        assert(ptemp->refcount==1);
+
+        epicsMutexDestroy(ptemp->lock);
+        epicsEventDestroy(ptemp->userPvt);
+        epicsMutexUnlock(pq->workListLock);
+    }
+    free(templinks);
 }
 
 void dbCaCallbackProcess(void *userPvt)
@@ -309,20 +354,63 @@ void dbCaCallbackProcess(void *userPvt)
     dbLinkAsyncComplete(plink);
 }
 
+static void signalWorkers(void)
+{
+    int i;
+
+    for (i = 0; i < nWorkers; i++)
+        epicsEventSignal(workQueues[i].workListEvent);
+}
+
 void dbCaShutdown(void)
 {
     enum dbCaCtl_t cur = dbCaCtl;
+    int i;
+
     assert(cur == ctlRun || cur == ctlPause);
     dbCaCtl = ctlExit;
-    epicsEventSignal(workListEvent);
-    epicsEventMustWait(startStopEvent);
-    if(dbCaWorker)
-        epicsThreadMustJoin(dbCaWorker);
+    /* The first worker owns the CA context, so it must be the last to go */
+    for (i = nWorkers - 1; i >= 0; i--) {
+        workQueue *pq = &workQueues[i];
+
+        pq->exit = 1;
+        epicsEventSignal(pq->workListEvent);
+        epicsEventMustWait(startStopEvent);
+        if (pq->worker)
+            epicsThreadMustJoin(pq->worker);
+        pq->worker = NULL;
+    }
+}
+
+/* Actions left from a previous IOC, such as clearing the channels of
+ * records freed after dbCaShutdown(), go to the worker for the number
+ * of workers about to be started.
+ */
+static void requeueActions(int n)
+{
+    ELLLIST pending = ELLLIST_INIT;
+    caLink *pca;
+    int i;
+
+    for (i = 0; i < DBCA_MAX_WORKERS && workQueues[i].workListLock; i++) {
+        ellConcat(&pending, &workQueues[i].workList);
+        workQueues[i].removesOutstanding = 0;
+    }
+    nWorkers = n;
+    while ((pca = (caLink *)ellGet(&pending))) {
+        workQueue *pq = linkQueue(pca);
+
+        ellAdd(&pq->workList, &pca->node);
+        if (pca->link_action & CA_CLEAR_CHANNEL)
+            pq->removesOutstanding++;
+    }
 }
 
 static void dbCaLinkInitImpl(int isolate)
 {
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int n = dbCaWorkers;
+    int i;
 
     opts.stackSize = epicsThreadGetStackSize(epicsThreadStackBig);
     opts.priority = epicsThreadPriorityMedium;
@@ -331,18 +419,42 @@ static void dbCaLinkInitImpl(int isolate)
     dbServiceIsolate = isolate;
     dbServiceIOInit();
 
-    if (!workListLock)
-        workListLock = epicsMutexMustCreate();
-    if (!workListEvent)
-        workListEvent = epicsEventMustCreate(epicsEventEmpty);
+    if (n < 1 || n > DBCA_MAX_WORKERS) {
+        errlogPrintf("dbCa: dbCaWorkers must be 1 to %d, using 1\n",
+            DBCA_MAX_WORKERS);
+        n = 1;
+    }
+    for (i = 0; i < n; i++) {
+        workQueue *pq = &workQueues[i];
+
+        pq->exit = 0;
+        if (!pq->workListLock)
+            pq->workListLock = epicsMutexMustCreate();
+        if (!pq->workListEvent)
+            pq->workListEvent = epicsEventMustCreate(epicsEventEmpty);
+    }
+    requeueActions(n);
 
     if(!startStopEvent)
         startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+    if(!rateTimerQueue)
+        rateTimerQueue = epicsTimerQueueAllocate(1,
+            epicsThreadPriorityScanHigh);
     dbCaCtl = ctlPause;
 
-    dbCaWorker = epicsThreadCreateOpt("dbCaLink", dbCaTask, NULL, &opts);
-    /* wait for worker to startup and initialize dbCaClientContext */
-    epicsEventMustWait(startStopEvent);
+    for (i = 0; i < n; i++) {
+        char name[20];
+
+        if (i == 0)
+            strcpy(name, "dbCaLink");
+        else
+            sprintf(name, "dbCaLink%d", i);
+        workQueues[i].worker = epicsThreadCreateOpt(name, dbCaTask,
+            &workQueues[i], &opts);
+        /* wait for worker to startup and attach to dbCaClientContext,
+         * which the first one creates */
+        epicsEventMustWait(startStopEvent);
+    }
 }
 
 void dbCaLinkInitIsolated(void)
@@ -359,7 +471,7 @@ void dbCaRun(void)
 {
     if (dbCaCtl == ctlPause) {
         dbCaCtl = ctlRun;
-        epicsEventSignal(workListEvent);
+        signalWorkers();
     }
 }
 
@@ -367,7 +479,35 @@ void dbCaPause(void)
 {
     if (dbCaCtl == ctlRun) {
         dbCaCtl = ctlPause;
-        epicsEventSignal(workListEvent);
+        signalWorkers();
+    }
+}
+
+void dbCaWorkerReport(void)
+{
+    int i;
+
+    printf("%d CA link worker%s\n", nWorkers, nWorkers != 1 ? "s" : "");
+    printf("%8s %8s %8s %10s %12s %12s\n", "Worker", "Depth", "Max",
+        "Actions", "Mean us", "Max us");
+    for (i = 0; i < nWorkers; i++) {
+        workQueue *pq = &workQueues[i];
+        int depth, maxDepth;
+        unsigned long nActions;
+        epicsUInt64 latency, maxLatency;
+
+        if (!pq->workListLock)
+            continue;
+        epicsMutexMustLock(pq->workListLock);
+        depth = ellCount(&pq->workList);
+        maxDepth = pq->maxDepth;
+        nActions = pq->nActions;
+        latency = pq->latency;
+        maxLatency = pq->maxLatency;
+        epicsMutexUnlock(pq->workListLock);
+        printf("%8d %8d %8d %10lu %12.1f %12.1f\n", i, depth, maxDepth,
+            nActions, nActions ? latency * 1e-3 / nActions : 0.0,
+            maxLatency * 1e-3);
     }
 }
 
@@ -383,6 +523,7 @@ void dbCaAddLinkCallback(struct link *plink,
     pca->lock = epicsMutexMustCreate();
     pca->plink = plink;
     pca->pvname = epicsStrDup(plink->value.pv_link.pvname);
+    pca->hash = epicsStrHash(pca->pvname, 0);
     pca->connect = connect;
     pca->monitor = monitor;
     pca->userPvt = userPvt;
@@ -404,6 +545,7 @@ long dbCaAddLink(struct dbLocker *locker, struct link *plink, short dbfType)
 void dbCaRemoveLink(struct dbLocker *locker, struct link *plink)
 {
     caLink *pca = (caLink *)plink->value.pv_link.pvt;
+    int rateWaiting;
 
     if (!pca) return;
     epicsMutexMustLock(pca->lock);
@@ -412,8 +554,20 @@ void dbCaRemoveLink(struct dbLocker *locker, struct link *plink)
     plink->value.pv_link.pvlMask = 0;
     plink->type = PV_LINK;
     plink->lset = NULL;
-    /* Unlock before addAction or dbCaTask might free first */
     epicsMutexUnlock(pca->lock);
+    if (pca->rateTimer) {
+        /* Once cancelled the timer won't run rateLimitCallback(),
+         * so the reference it held is released here.
+         */
+        epicsTimerCancel(pca->rateTimer);
+        epicsMutexMustLock(pca->lock);
+        rateWaiting = pca->rateWaiting;
+        pca->rateWaiting = FALSE;
+        epicsMutexUnlock(pca->lock);
+        if (rateWaiting)
+            caLinkDec(pca);
+    }
+    /* Unlocked before addAction or dbCaTask might free first */
     addAction(pca, CA_CLEAR_CHANNEL);
 }
 
@@ -434,6 +588,7 @@ long dbCaGetLink(struct link *plink, short dbrType, void *pdest,
         status = -1;
         goto done;
     }
+    pca->valueRead = TRUE;
     if (pca->dbrType == DBR_ENUM && dbDBRnewToDBRold[dbrType] == DBR_STRING){
         long (*fConvert)(const void *from, void *to, struct dbAddr *paddr);
 
@@ -798,6 +953,7 @@ static void scanComplete(void *raw, dbCommon *prec)
         errlogPrintf("dbCa.c complete callback w/ scanningOnce==0\n");
     } else if(--pca->scanningOnce){
         /* another scan is queued */
+        pca->valueRead = FALSE;
         if(scanOnceCallback(prec, scanComplete, raw)) {
             errlogPrintf("dbCa.c failed to re-queue scanOnce\n");
         } else
@@ -809,15 +965,74 @@ static void scanComplete(void *raw, dbCommon *prec)
 
 /* must be called with pca->lock held */
 static void scanLinkOnce(dbCommon *prec, caLink *pca) {
+    /* With LATEST, a queued scan that hasn't read the link yet will see
+     * this update, and one more scan after a running one is enough.
+     */
+    int latest = pca->plink &&
+        (pca->plink->value.pv_link.pvlMask & pvlOptLatest);
+
     if(pca->scanningOnce==0) {
+        pca->valueRead = FALSE;
         if(scanOnceCallback(prec, scanComplete, pca)) {
             errlogPrintf("dbCa.c failed to queue scanOnce\n");
         } else
             caLinkInc(pca);
     }
+    else if(latest && (!pca->valueRead || pca->scanningOnce>=2)) {
+        pca->nCoalesced++;
+        return;
+    }
     if(pca->scanningOnce<5)
         pca->scanningOnce++;
-    /* else too many scans queued */
+    else /* too many scans queued */
+        pca->nCoalesced++;
+    pca->lastScan = epicsMonotonicGet();
+}
+
+static void rateLimitCallback(void *raw)
+{
+    caLink *pca = raw;
+
+    epicsMutexMustLock(pca->lock);
+    if(!pca->rateWaiting) {
+        /* dbCaRemoveLink() has the reference */
+        epicsMutexUnlock(pca->lock);
+        return;
+    }
+    pca->rateWaiting = FALSE;
+    if(pca->plink && pca->plink->precord)
+        scanLinkOnce(pca->plink->precord, pca);
+    epicsMutexUnlock(pca->lock);
+    caLinkDec(pca);
+}
+
+/* must be called with pca->lock held.
+ * Scans the record for a monitor update unless that would exceed the
+ * link's maximum rate, in which case the scan is put off until it won't.
+ * Updates arriving in the meantime are all seen by that one scan.
+ */
+static void scanLinkUpdate(dbCommon *prec, caLink *pca) {
+    double maxRate = pca->plink->value.pv_link.maxRate;
+
+    if(maxRate > 0.0) {
+        epicsUInt64 interval = (epicsUInt64)(1e9 / maxRate);
+        epicsUInt64 since = epicsMonotonicGet() - pca->lastScan;
+
+        if(pca->rateWaiting) {
+            pca->nCoalesced++;
+            return;
+        }
+        if(pca->lastScan && since < interval) {
+            if(!pca->rateTimer)
+                pca->rateTimer = epicsTimerQueueCreateTimer(rateTimerQueue,
+                    rateLimitCallback, pca);
+            pca->rateWaiting = TRUE;
+            caLinkInc(pca);
+            epicsTimerStartDelay(pca->rateTimer, (interval - since) * 1e-9);
+            return;
+        }
+    }
+    scanLinkOnce(prec, pca);
 }
 
 static lset dbCa_lset = {
@@ -938,6 +1153,8 @@ static void eventCallback(struct event_handler_args arg)
     monitor = pca->monitor;
     userPvt = pca->userPvt;
     precord = plink->precord;
+    if (dbTraceMode && precord)
+        dbTraceRecordEvent(dbTraceCaUpdate, 'i', precord, arg.count);
     if (arg.status != ECA_NORMAL) {
         if (precord) {
             if (arg.status != ECA_NORDACCESS &&
@@ -988,7 +1205,7 @@ static void eventCallback(struct event_handler_args arg)
 
         if ((ppv_link->pvlMask & pvlOptCP) ||
             ((ppv_link->pvlMask & pvlOptCPP) && precord->scan == 0))
-        scanLinkOnce(precord, pca);
+        scanLinkUpdate(precord, pca);
     }
 done:
     epicsMutexUnlock(pca->lock);
@@ -1119,44 +1336,57 @@ static void getAttribEventCallback(struct event_handler_args arg)
 
 static void dbCaTask(void *arg)
 {
+    workQueue *pq = arg;
     epicsEventId requestSync = NULL;
     taskwdInsert(0, NULL, NULL);
-    SEVCHK(ca_context_create(ca_enable_preemptive_callback),
-        "dbCaTask calling ca_context_create");
-    dbCaClientContext = ca_current_context ();
-    SEVCHK(ca_add_exception_event(exceptionCallback,NULL),
-        "ca_add_exception_event");
+    if (pq == workQueues) {
+        SEVCHK(ca_context_create(ca_enable_preemptive_callback),
+            "dbCaTask calling ca_context_create");
+        dbCaClientContext = ca_current_context ();
+        SEVCHK(ca_add_exception_event(exceptionCallback,NULL),
+            "ca_add_exception_event");
+    }
+    else {
+        SEVCHK(ca_attach_context(dbCaClientContext),
+            "dbCaTask calling ca_attach_context");
+    }
     epicsEventSignal(startStopEvent);
 
     /* channel access event loop */
     while (TRUE){
         do {
-            epicsEventMustWait(workListEvent);
+            epicsEventMustWait(pq->workListEvent);
         } while (dbCaCtl == ctlPause);
         while (TRUE) { /* process all requests in workList*/
             caLink *pca;
             short  link_action;
             int    status;
+            epicsUInt64 latency;
 
-            epicsMutexMustLock(workListLock);
-            if (!(pca = (caLink *)ellGet(&workList))){  /* Take off list head */
+            epicsMutexMustLock(pq->workListLock);
+            if (!(pca = (caLink *)ellGet(&pq->workList))){  /* Take off list head */
                 if(requestSync) {
                     /* dbCaSync() requires workListLock to be held here */
                     epicsEventMustTrigger(requestSync);
                     requestSync = NULL;
                 }
-                epicsMutexUnlock(workListLock);
-                if (dbCaCtl == ctlExit) goto shutdown;
+                epicsMutexUnlock(pq->workListLock);
+                if (pq->exit) goto shutdown;
                 break; /* workList is empty */
             }
+            latency = epicsMonotonicGet() - pca->queued;
+            pq->latency += latency;
+            if (latency > pq->maxLatency)
+                pq->maxLatency = latency;
+            pq->nActions++;
             link_action = pca->link_action;
             if (link_action&CA_SYNC) {
                 assert(!requestSync);
                 requestSync = pca->userPvt;
             }
             pca->link_action = 0;
-            if (link_action & CA_CLEAR_CHANNEL) --removesOutstanding;
-            epicsMutexUnlock(workListLock);         /* Give back immediately */
+            if (link_action & CA_CLEAR_CHANNEL) --pq->removesOutstanding;
+            epicsMutexUnlock(pq->workListLock);     /* Give back immediately */
             if (link_action&CA_SYNC)
                 continue;
             if (link_action & CA_CLEAR_CHANNEL) {   /* This must be first */
@@ -1174,7 +1404,7 @@ static void dbCaTask(void *arg)
                     printLinks(pca);
                     continue;
                 }
-                dbca_chan_count++;
+                epicsAtomicIncrIntT(&dbca_chan_count);
                 status = ca_replace_access_rights_event(pca->chid,
                     accessRightsCallback);
                 if (status != ECA_NORMAL) {
@@ -1278,7 +1508,9 @@ static void dbCaTask(void *arg)
     }
 shutdown:
     taskwdRemove(0);
-    if (dbca_chan_count == 0)
+    if (pq != workQueues)
+        ca_detach_context();
+    else if (dbca_chan_count == 0)
         ca_context_destroy();
     else
         fprintf(stderr, "dbCa: chan_count = %d at shutdown\n", dbca_chan_count);
@@ -27,6 +27,11 @@ DBCORE_API void dbCaRun(void);
 DBCORE_API void dbCaPause(void);
 DBCORE_API void dbCaShutdown(void);
 
+/* Number of threads carrying out CA link actions, read by dbCaLinkInit().
+ * The actions for one link are always carried out by the same thread.
+ */
+DBCORE_API extern int dbCaWorkers;
+
 struct dbLocker;
 DBCORE_API void dbCaAddLinkCallback(struct link *plink,
     dbCaCallback connect, dbCaCallback monitor, void *userPvt);
@@ -19,6 +19,7 @@
 #include "dbCa.h"
 #include "ellLib.h"
 #include "epicsMutex.h"
+#include "epicsTimer.h"
 #include "epicsTypes.h"
 #include "link.h"
 
@@ -39,6 +40,8 @@ typedef struct caLink
 {
     ELLNODE         node;
     int             refcount;
+    unsigned int    hash;       /* of pvname, selects the worker */
+    epicsUInt64     queued;     /* when added to the work list */
     epicsMutexId    lock;
     struct link     *plink;
     char            *pvname;
@@ -90,10 +93,19 @@ typedef struct caLink
     char            newOutNative;
     char            newOutString;
     unsigned char scanningOnce;
+    /* The following are for CP/CPP links with LATEST or RATE= */
+    char            valueRead;  /* by the record since its scan was queued */
+    char            rateWaiting;
+    epicsUInt64     lastScan;   /* when the last scan was queued */
+    epicsTimerId    rateTimer;
     /* The following are for dbcar*/
     unsigned long   nDisconnect;
     unsigned long   nNoWrite; /*only modified by dbCaPutLink*/
     unsigned long   nUpdate;
+    unsigned long   nCoalesced; /* updates without a scan of their own */
 }caLink;
 
+/* For dbcar */
+void dbCaWorkerReport(void);
+
 #endif /* INC_dbCaPvt_H */
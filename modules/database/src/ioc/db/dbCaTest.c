@@ -66,6 +66,7 @@ long dbcar(char *precordname, int level)
     int                 noWriteAccess=0;
     unsigned long       nDisconnect=0;
     unsigned long       nNoWrite=0;
+    unsigned long       nCoalesced=0;
     caLink              *pca;
     int                 j;
 
@@ -98,6 +99,7 @@ long dbcar(char *precordname, int level)
                             nconnected++;
                             nDisconnect += pca->nDisconnect;
                             nNoWrite += pca->nNoWrite;
+                            nCoalesced += pca->nCoalesced;
                             if (!ca_read_access(pca->chid)) noReadAccess++;
                             if (!ca_write_access(pca->chid)) noWriteAccess++;
                             if (level>1) {
@@ -108,12 +110,13 @@ long dbcar(char *precordname, int level)
                                     "Write Only", "Read/Write"
                                 };
                                 int mask = plink->value.pv_link.pvlMask;
-                                printf("%28s.%-4s ==> %-28s  (%lu, %lu)\n",
+                                printf("%28s.%-4s ==> %-28s  (%lu, %lu, %lu)\n",
                                     precord->name,
                                     pdbFldDes->name,
                                     plink->value.pv_link.pvname,
                                     pca->nDisconnect,
-                                    pca->nNoWrite);
+                                    pca->nNoWrite,
+                                    pca->nCoalesced);
                                 printf("%21s [%s%s%s%s] host %s, %s\n", "",
                                     mask & pvlOptInpNative ? "IN" : "  ",
                                     mask & pvlOptInpString ? "IS" : "  ",
@@ -124,12 +127,13 @@ long dbcar(char *precordname, int level)
                             }
                         } else {
                             if (level>0) {
-                                printf("%28s.%-4s --> %-28s  (%lu, %lu)\n",
+                                printf("%28s.%-4s --> %-28s  (%lu, %lu, %lu)\n",
                                     precord->name,
                                     pdbFldDes->name,
                                     plink->value.pv_link.pvname,
                                     pca ? pca->nDisconnect : 0,
-                                    pca ? pca->nNoWrite : 0);
+                                    pca ? pca->nNoWrite : 0,
+                                    pca ? pca->nCoalesced : 0);
                             }
                         }
                     }
@@ -150,10 +154,14 @@ done:
            nconnected, (ncalinks - nconnected));
     printf("    %d can't read, %d can't write.",
            noReadAccess, noWriteAccess);
-    printf("  (%lu disconnects, %lu writes prohibited)\n\n",
+    printf("  (%lu disconnects, %lu writes prohibited)\n",
            nDisconnect, nNoWrite);
+    printf("    %lu updates coalesced.\n\n", nCoalesced);
     dbFinishEntry(pdbentry);
 
+    dbCaWorkerReport();
+    printf("\n");
+
     if ( level > 2  && dbCaClientContext != 0 ) {
         ca_context_status ( dbCaClientContext, level - 2 );
     }
@@ -636,9 +636,9 @@ long dbChannelGetField(dbChannel *chan, short dbrType, void *pbuffer,
     dbCommon *precord = chan->addr.precord;
     long status = 0;
 
-    dbScanLock(precord);
+    dbScanLockShared(precord);
     status = dbChannelGet(chan, dbrType, pbuffer, options, nRequest, pfl);
-    dbScanUnlock(precord);
+    dbScanUnlockShared(precord);
     return status;
 }
 
@@ -3,10 +3,37 @@
 
 #include <compilerDependencies.h>
 #include <dbDefs.h>
+#include <epicsTypes.h>
 #include "dbCommon.h"
 
 struct epicsThreadOSD;
 
+/* Processing profile, see dbProfile.c. Times are monotonic clock ticks,
+ * updated with the record locked. Allocated when the record is first
+ * processed with profiling enabled.
+ */
+typedef struct dbRecordProfile {
+    epicsUInt64 count;
+    epicsUInt64 self;
+    epicsUInt64 total;
+    epicsUInt64 max;
+    epicsUInt64 asyncCount;
+    epicsUInt64 asyncTotal;
+    epicsUInt64 asyncMax;
+    epicsUInt64 asyncStart;     /* when left with PACT set, else 0 */
+} dbRecordProfile;
+
+/* One call being profiled, on the stack of the processing thread */
+typedef struct dbProfileFrame {
+    struct dbProfileFrame *parent;
+    epicsUInt64 start;
+    epicsUInt64 child;
+} dbProfileFrame;
+
+void dbProfileBegin(dbProfileFrame *pframe);
+void dbProfileEnd(struct dbCommon *prec, dbProfileFrame *pframe);
+void dbProfileAsyncDone(struct dbCommon *prec);
+
 /** Base internal additional information for every record
  */
 typedef struct dbCommonPvt {
@@ -15,6 +42,14 @@ typedef struct dbCommonPvt {
     /* Thread which is currently processing this record */
     struct epicsThreadOSD* procThread;
 
+    dbRecordProfile *prof;
+
+    /* Selected for tracing, see dbTrace.c */
+    int trace;
+
+    /* Waiting in a scanOnce queue, see scanOnceSetCoalesce() */
+    int onceQueued;
+
     struct dbCommon common;
 } dbCommonPvt;
 
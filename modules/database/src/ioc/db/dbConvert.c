@@ -60,22 +60,38 @@ static void copyNoConvert(const void *pfrom,
 #define COPYNOCONVERT(N, FROM, TO, NREQ, NO_ELEM, OFFSET) \
     copyNoConvert(FROM, TO, (N)*(NREQ), (N)*(NO_ELEM), (N)*(OFFSET))
 
+/* Array conversions are done as at most two contiguous spans, split
+ * where the field wraps at no_elements, in simple loops the compiler
+ * can vectorize.
+ */
+#define SPANLENGTH(nRequest, no_elements, offset) \
+    ((offset) < (no_elements) && (nRequest) > (no_elements) - (offset) ? \
+        (no_elements) - (offset) : (nRequest))
+
+#define CONVERTSPAN(typea, typeb, PSRC, PDST, N) \
+{ \
+    const typea *ps = (PSRC); \
+    typeb *pd = (PDST); \
+    long i, nspan = (N); \
+    \
+    for (i = 0; i < nspan; i++) \
+        pd[i] = (typeb) ps[i]; \
+}
+
 #define GET(typea, typeb) (const dbAddr *paddr, \
     void *pto, long nRequest, long no_elements, long offset) \
 { \
     typea *psrc = (typea *) paddr->pfield; \
     typeb *pdst = (typeb *) pto; \
+    long n; \
     \
     if (nRequest==1 && offset==0) { \
         *pdst = (typeb) *psrc; \
         return 0; \
     } \
-    psrc += offset; \
-    while (nRequest--) { \
-        *pdst++ = (typeb) *psrc++; \
-        if (++offset == no_elements) \
-            psrc = (typea *) paddr->pfield; \
-    } \
+    n = SPANLENGTH(nRequest, no_elements, offset); \
+    CONVERTSPAN(typea, typeb, psrc + offset, pdst, n); \
+    CONVERTSPAN(typea, typeb, psrc, pdst + n, nRequest - n); \
     return 0; \
 }
 
@@ -98,17 +114,15 @@ static void copyNoConvert(const void *pfrom,
 { \
     const typea *psrc = (const typea *) pfrom; \
     typeb *pdst = (typeb *) paddr->pfield; \
+    long n; \
     \
     if (nRequest==1 && offset==0) { \
         *pdst = (typeb) *psrc; \
         return 0; \
     } \
-    pdst += offset; \
-    while (nRequest--) { \
-        *pdst++ = (typeb) *psrc++; \
-        if (++offset == no_elements) \
-            pdst = (typeb *) paddr->pfield; \
-    } \
+    n = SPANLENGTH(nRequest, no_elements, offset); \
+    CONVERTSPAN(typea, typeb, psrc, pdst + offset, n); \
+    CONVERTSPAN(typea, typeb, psrc + n, pdst, nRequest - n); \
     return 0; \
 }
 
@@ -812,18 +826,17 @@ static long getDoubleFloat(const dbAddr *paddr,
 {
     epicsFloat64 *psrc = (epicsFloat64 *) paddr->pfield;
     epicsFloat32 *pdst = (epicsFloat32 *) pto;
+    long i, n;
 
     if (nRequest==1 && offset==0) {
         *pdst = epicsConvertDoubleToFloat(*psrc);
         return 0;
     }
-    psrc += offset;
-    while (nRequest--) {
-        *pdst = epicsConvertDoubleToFloat(*psrc);
-        ++psrc; ++pdst;
-        if (++offset == no_elements)
-            psrc = (epicsFloat64 *) paddr->pfield;
-    }
+    n = SPANLENGTH(nRequest, no_elements, offset);
+    for (i = 0; i < n; i++)
+        pdst[i] = epicsConvertDoubleToFloat(psrc[offset + i]);
+    for (; i < nRequest; i++)
+        pdst[i] = epicsConvertDoubleToFloat(psrc[i - n]);
     return 0;
 }
 
@@ -1641,17 +1654,17 @@ static long putDoubleFloat(dbAddr *paddr,
 {
     const epicsFloat64 *psrc = (const epicsFloat64 *) pfrom;
     epicsFloat32 *pdst = (epicsFloat32 *) paddr->pfield;
+    long i, n;
 
     if (nRequest==1 && offset==0) {
         *pdst = epicsConvertDoubleToFloat(*psrc);
         return 0;
     }
-    pdst += offset;
-    while (nRequest--) {
-        *pdst++ = epicsConvertDoubleToFloat(*psrc++);
-        if (++offset == no_elements)
-            pdst = (epicsFloat32 *) paddr->pfield;
-    }
+    n = SPANLENGTH(nRequest, no_elements, offset);
+    for (i = 0; i < n; i++)
+        pdst[offset + i] = epicsConvertDoubleToFloat(psrc[i]);
+    for (; i < nRequest; i++)
+        pdst[i - n] = epicsConvertDoubleToFloat(psrc[i]);
     return 0;
 }
 
@@ -47,6 +47,7 @@
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "dbTrace.h"
 #include "link.h"
 #include "special.h"
 
@@ -873,6 +874,9 @@ unsigned int    caEventMask
 
     if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
 
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTracePost, 'i', prec, caEventMask);
+
     LOCKREC (prec);
 
     for (pevent = (struct evSubscrip *) prec->mlis.node.next;
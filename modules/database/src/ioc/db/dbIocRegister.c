@@ -22,11 +22,13 @@
 #include "dbJLink.h"
 #include "dbLock.h"
 #include "dbNotify.h"
+#include "dbProfile.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbState.h"
 #include "db_test.h"
 #include "dbTest.h"
+#include "dbTrace.h"
 
 DBCORE_API extern int callbackParallelThreadsDefault;
 
@@ -68,6 +70,37 @@ static void dbLoadRecordsCallFunc(const iocshArgBuf *args)
     iocshSetError(dbLoadRecords(args[0].sval,args[1].sval));
 }
 
+/* dbLoadRecordsQueue */
+static const iocshFuncDef dbLoadRecordsQueueFuncDef = {
+    "dbLoadRecordsQueue",
+    2,
+    dbLoadRecordsArgs,
+    "Queue the given .db file to be loaded with the given substitutions\n"
+    "by dbLoadRecordsBatch, or by iocInit.\n"
+    "Queued files are read using several threads but loaded in order.\n\n"
+    "Example: dbLoadRecordsQueue db/myRecords.db 'user=myself,host=myhost'\n",
+};
+static void dbLoadRecordsQueueCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(dbLoadRecordsQueue(args[0].sval,args[1].sval));
+}
+
+/* dbLoadRecordsBatch */
+static const iocshArg dbLoadRecordsBatchArg0 = { "threads",iocshArgInt};
+static const iocshArg * const dbLoadRecordsBatchArgs[1] =
+    {&dbLoadRecordsBatchArg0};
+static const iocshFuncDef dbLoadRecordsBatchFuncDef = {
+    "dbLoadRecordsBatch",
+    1,
+    dbLoadRecordsBatchArgs,
+    "Load the files queued by dbLoadRecordsQueue.\n"
+    "  threads - Threads reading files, <= 0 is relative to the CPU count\n",
+};
+static void dbLoadRecordsBatchCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(dbLoadRecordsBatch(args[0].ival));
+}
+
 /* dbb */
 static const iocshArg dbbArg0 = { "record name",iocshArgStringRecord};
 static const iocshArg * const dbbArgs[1] = {&dbbArg0};
@@ -147,7 +180,11 @@ static const iocshFuncDef dbcarFuncDef = {"dbcar",2,dbcarArgs,
                                           "Shows status of Channel Access links (CA_LINK).\n"
                                           " level 0 - Shows statistics for all links.\n"
                                           "       1 - Shows info. of only disconnected links.\n"
-                                          "       2 - Shows info. for all links.\n"};
+                                          "       2 - Shows info. for all links.\n"
+                                          "The numbers after each link are its disconnects, writes\n"
+                                          "prohibited and monitor updates coalesced.\n"
+                                          "The queue depth and latency of each CA link worker thread\n"
+                                          "are shown after the link statistics.\n"};
 static void dbcarCallFunc(const iocshArgBuf *args)
 {
     dbcar(args[0].sval,args[1].ival);
@@ -414,6 +451,133 @@ static const iocshFuncDef dbLockShowLockedFuncDef = {
 static void dbLockShowLockedCallFunc(const iocshArgBuf *args)
 { dbLockShowLocked(args[0].ival);}
 
+/* dbLockStatsEnable */
+static const iocshArg dbLockStatsEnableArg0 = { "enable",iocshArgInt};
+static const iocshArg * const dbLockStatsEnableArgs[1] = {&dbLockStatsEnableArg0};
+static const iocshFuncDef dbLockStatsEnableFuncDef = {
+    "dbLockStatsEnable",1,dbLockStatsEnableArgs,
+    "Turn timing of lock set waits and holds on (1) or off (0).\n"
+    "Show the results with dbLockStatsReport.\n"
+};
+static void dbLockStatsEnableCallFunc(const iocshArgBuf *args)
+{ dbLockStatsEnable(args[0].ival);}
+
+/* dbLockStatsReset */
+static const iocshFuncDef dbLockStatsResetFuncDef = {"dbLockStatsReset",0,0,
+    "Clear the lock set counts and times collected so far.\n"};
+static void dbLockStatsResetCallFunc(const iocshArgBuf *args)
+{ dbLockStatsReset();}
+
+/* dbLockStatsReport */
+static const iocshArg dbLockStatsReportArg0 = { "count",iocshArgInt};
+static const iocshArg dbLockStatsReportArg1 = { "interest level",iocshArgInt};
+static const iocshArg * const dbLockStatsReportArgs[2] = {
+    &dbLockStatsReportArg0,&dbLockStatsReportArg1};
+static const iocshFuncDef dbLockStatsReportFuncDef = {
+    "dbLockStatsReport",2,dbLockStatsReportArgs,
+    "Lock Set Contention Report.\n"
+    "List the lock sets that threads waited longest for, with the number\n"
+    "of locks and contended locks, the total wait, and the mean and\n"
+    "longest time each set was held. Times need dbLockStatsEnable 1.\n"
+    "count is the number of lock sets to list, all if 0.\n"
+    "interest level 1 also lists the DB links that joined the records\n"
+    "of each set.\n\n"
+    "Example: dbLockStatsReport 10 1\n"
+};
+static void dbLockStatsReportCallFunc(const iocshArgBuf *args)
+{ dbLockStatsReport(args[0].ival,args[1].ival);}
+
+/* dbProfileEnable */
+static const iocshArg dbProfileEnableArg0 = { "enable",iocshArgInt};
+static const iocshArg * const dbProfileEnableArgs[1] = {&dbProfileEnableArg0};
+static const iocshFuncDef dbProfileEnableFuncDef = {
+    "dbProfileEnable",1,dbProfileEnableArgs,
+    "Turn timing of record processing on (1) or off (0).\n"
+    "Show the results with dbprof.\n"
+};
+static void dbProfileEnableCallFunc(const iocshArgBuf *args)
+{ dbProfileEnable(args[0].ival);}
+
+/* dbProfileReset */
+static const iocshFuncDef dbProfileResetFuncDef = {"dbProfileReset",0,0,
+    "Clear the record processing times collected so far.\n"};
+static void dbProfileResetCallFunc(const iocshArgBuf *args)
+{ dbProfileReset();}
+
+/* dbprof */
+static const iocshArg dbprofArg0 = { "count",iocshArgInt};
+static const iocshArg dbprofArg1 = { "record type",iocshArgString};
+static const iocshArg * const dbprofArgs[2] = {&dbprofArg0,&dbprofArg1};
+static const iocshFuncDef dbprofFuncDef = {
+    "dbprof",2,dbprofArgs,
+    "Database Profile Report.\n"
+    "List the records that took the most processing time, and the\n"
+    "total for each record type. Self time excludes records processed\n"
+    "through links, total time includes them. The async columns show\n"
+    "the time from PACT being set to the record completing.\n"
+    "count is the number of records to list, 20 if 0.\n"
+    "Example: dbprof 10 calc\n"
+};
+static void dbprofCallFunc(const iocshArgBuf *args)
+{ dbprof(args[0].ival,args[1].sval);}
+
+/* dbTraceEnable */
+static const iocshArg dbTraceEnableArg0 = { "mode",iocshArgInt};
+static const iocshArg * const dbTraceEnableArgs[1] = {&dbTraceEnableArg0};
+static const iocshFuncDef dbTraceEnableFuncDef = {
+    "dbTraceEnable",1,dbTraceEnableArgs,
+    "Record trace events for record processing and related activity.\n"
+    "mode 0 - off.\n"
+    "     1 - records selected with dbTraceRecord.\n"
+    "     2 - all records.\n"
+    "Write the events out with dbTraceDump.\n"
+};
+static void dbTraceEnableCallFunc(const iocshArgBuf *args)
+{ dbTraceEnable(args[0].ival);}
+
+/* dbTraceRecord */
+static const iocshArg dbTraceRecordArg0 = { "record name",iocshArgStringRecord};
+static const iocshArg dbTraceRecordArg1 = { "on",iocshArgInt};
+static const iocshArg * const dbTraceRecordArgs[2] =
+    {&dbTraceRecordArg0,&dbTraceRecordArg1};
+static const iocshFuncDef dbTraceRecordFuncDef = {
+    "dbTraceRecord",2,dbTraceRecordArgs,
+    "Select (1) or deselect (0) a record for tracing in mode 1.\n\n"
+    "Example: dbTraceRecord aitest 1\n"
+};
+static void dbTraceRecordCallFunc(const iocshArgBuf *args)
+{ iocshSetError(dbTraceRecord(args[0].sval,args[1].ival));}
+
+/* dbTraceSetSize */
+static const iocshArg dbTraceSetSizeArg0 = { "events",iocshArgInt};
+static const iocshArg * const dbTraceSetSizeArgs[1] = {&dbTraceSetSizeArg0};
+static const iocshFuncDef dbTraceSetSizeFuncDef = {
+    "dbTraceSetSize",1,dbTraceSetSizeArgs,
+    "Set the number of trace events kept for each thread.\n"
+    "Only applies to threads that have not been traced yet.\n"
+};
+static void dbTraceSetSizeCallFunc(const iocshArgBuf *args)
+{ dbTraceSetSize(args[0].ival > 0 ? args[0].ival : 0);}
+
+/* dbTraceClear */
+static const iocshFuncDef dbTraceClearFuncDef = {"dbTraceClear",0,0,
+    "Discard the trace events recorded so far.\n"};
+static void dbTraceClearCallFunc(const iocshArgBuf *args)
+{ dbTraceClear();}
+
+/* dbTraceDump */
+static const iocshArg dbTraceDumpArg0 = { "file name",iocshArgStringPath};
+static const iocshArg * const dbTraceDumpArgs[1] = {&dbTraceDumpArg0};
+static const iocshFuncDef dbTraceDumpFuncDef = {
+    "dbTraceDump",1,dbTraceDumpArgs,
+    "Write the trace events in Chrome trace JSON format, which\n"
+    "chrome://tracing and the Perfetto UI can display.\n"
+    "Writes to stdout if no file name is given.\n\n"
+    "Example: dbTraceDump /tmp/ioc-trace.json\n"
+};
+static void dbTraceDumpCallFunc(const iocshArgBuf *args)
+{ iocshSetError(dbTraceDump(args[0].sval));}
+
 /* scanOnceSetQueueSize */
 static const iocshArg scanOnceSetQueueSizeArg0 = { "size",iocshArgInt};
 static const iocshArg * const scanOnceSetQueueSizeArgs[1] =
@@ -426,6 +590,30 @@ static void scanOnceSetQueueSizeCallFunc(const iocshArgBuf *args)
     scanOnceSetQueueSize(args[0].ival);
 }
 
+/* scanOnceSetThreads */
+static const iocshArg scanOnceSetThreadsArg0 = { "no of threads",iocshArgInt};
+static const iocshArg * const scanOnceSetThreadsArgs[1] =
+    {&scanOnceSetThreadsArg0};
+static const iocshFuncDef scanOnceSetThreadsFuncDef = {"scanOnceSetThreads",1,scanOnceSetThreadsArgs,
+                                                      "Process the Scan once queue with several threads.\n"
+                                                      "Requests are divided between the threads by lock set.\n"
+                                                      "no of threads <= 0 is relative to the number of CPUs.\n"
+                                                      "Must be called before iocInit().\n"};
+static void scanOnceSetThreadsCallFunc(const iocshArgBuf *args)
+{ scanOnceSetThreads(args[0].ival);}
+
+/* scanOnceSetCoalesce */
+static const iocshArg scanOnceSetCoalesceArg0 = { "enable",iocshArgInt};
+static const iocshArg * const scanOnceSetCoalesceArgs[1] =
+    {&scanOnceSetCoalesceArg0};
+static const iocshFuncDef scanOnceSetCoalesceFuncDef = {"scanOnceSetCoalesce",1,scanOnceSetCoalesceArgs,
+                                                       "Merge a scanOnce request with one already queued\n"
+                                                       "for the same record. Requests with a completion\n"
+                                                       "callback are never merged.\n"
+                                                       "Must be called before iocInit().\n"};
+static void scanOnceSetCoalesceCallFunc(const iocshArgBuf *args)
+{ scanOnceSetCoalesce(args[0].ival);}
+
 /* scanOnceQueueShow */
 static const iocshArg scanOnceQueueShowArg0 = { "reset",iocshArgInt};
 static const iocshArg * const scanOnceQueueShowArgs[1] =
@@ -446,6 +634,36 @@ static const iocshFuncDef scanpplFuncDef = {"scanppl",1,scanpplArgs,
 static void scanpplCallFunc(const iocshArgBuf *args)
 { scanppl(args[0].dval);}
 
+/* scanPeriodicThreads */
+static const iocshArg scanPeriodicThreadsArg0 = { "no of threads",iocshArgInt};
+static const iocshArg scanPeriodicThreadsArg1 = { "period",iocshArgDouble};
+static const iocshArg * const scanPeriodicThreadsArgs[2] =
+    {&scanPeriodicThreadsArg0,&scanPeriodicThreadsArg1};
+static const iocshFuncDef scanPeriodicThreadsFuncDef = {"scanPeriodicThreads",2,scanPeriodicThreadsArgs,
+                                                       "Process periodic scan lists with several threads.\n"
+                                                       "Records are divided between the threads by lock set.\n"
+                                                       "period selects one list in seconds, or 0.0 for all lists.\n"
+                                                       "no of threads <= 0 is relative to the number of CPUs.\n"
+                                                       "Must be called before iocInit().\n"};
+static void scanPeriodicThreadsCallFunc(const iocshArgBuf *args)
+{ scanPeriodicThreads(args[0].ival, args[1].dval);}
+
+/* scanPeriodicSpread */
+static const iocshArg scanPeriodicSpreadArg0 = { "no of slices",iocshArgInt};
+static const iocshArg scanPeriodicSpreadArg1 = { "period",iocshArgDouble};
+static const iocshArg scanPeriodicSpreadArg2 = { "by PHAS",iocshArgInt};
+static const iocshArg * const scanPeriodicSpreadArgs[3] =
+    {&scanPeriodicSpreadArg0,&scanPeriodicSpreadArg1,&scanPeriodicSpreadArg2};
+static const iocshFuncDef scanPeriodicSpreadFuncDef = {"scanPeriodicSpread",3,scanPeriodicSpreadArgs,
+                                                      "Spread processing of periodic scan lists over the period.\n"
+                                                      "Each list is processed in slices started at even intervals.\n"
+                                                      "period selects one list in seconds, or 0.0 for all lists.\n"
+                                                      "no of slices == 0 picks a count from the sleep quantum.\n"
+                                                      "by PHAS != 0 keeps records with the same PHAS in one slice.\n"
+                                                      "Must be called before iocInit().\n"};
+static void scanPeriodicSpreadCallFunc(const iocshArgBuf *args)
+{ scanPeriodicSpread(args[0].ival, args[1].dval, args[2].ival);}
+
 /* scanpel */
 static const iocshArg scanpelArg0 = { "event name",iocshArgString};
 static const iocshArg * const scanpelArgs[1] = {&scanpelArg0};
@@ -470,6 +688,21 @@ static const iocshFuncDef scanpiolFuncDef = {"scanpiol",0,0,
                                              "Print info for records with SCAN = \"I/O Intr\".\n"};
 static void scanpiolCallFunc(const iocshArgBuf *args) { scanpiol();}
 
+/* scanIoSetMode */
+static const iocshArg scanIoSetModeArg0 = { "merge",iocshArgInt};
+static const iocshArg scanIoSetModeArg1 = { "no of parts",iocshArgInt};
+static const iocshArg * const scanIoSetModeArgs[2] =
+    {&scanIoSetModeArg0,&scanIoSetModeArg1};
+static const iocshFuncDef scanIoSetModeFuncDef = {"scanIoSetMode",2,scanIoSetModeArgs,
+                                                 "Set how \"I/O Intr\" scans are requested.\n"
+                                                 "merge: merge a request with a scan not started yet.\n"
+                                                 "no of parts: split each scan by lock set into parts,\n"
+                                                 "  which run in parallel when callbackParallelThreads\n"
+                                                 "  gives the priority several threads.\n"
+                                                 "Must be called before iocInit().\n"};
+static void scanIoSetModeCallFunc(const iocshArgBuf *args)
+{ iocshSetError(scanIoSetMode(args[0].ival, args[1].ival));}
+
 /* callbackSetQueueSize */
 static const iocshArg callbackSetQueueSizeArg0 = { "bufsize",iocshArgInt};
 static const iocshArg * const callbackSetQueueSizeArgs[1] =
@@ -583,6 +816,8 @@ void dbIocRegister(void)
 
     iocshRegister(&dbLoadDatabaseFuncDef,dbLoadDatabaseCallFunc);
     iocshRegister(&dbLoadRecordsFuncDef,dbLoadRecordsCallFunc);
+    iocshRegister(&dbLoadRecordsQueueFuncDef,dbLoadRecordsQueueCallFunc);
+    iocshRegister(&dbLoadRecordsBatchFuncDef,dbLoadRecordsBatchCallFunc);
 
     iocshRegister(&dbaFuncDef,dbaCallFunc);
     iocshRegister(&dblFuncDef,dblCallFunc);
@@ -606,13 +841,29 @@ void dbIocRegister(void)
     iocshRegister(&tpnFuncDef,tpnCallFunc);
     iocshRegister(&dblsrFuncDef,dblsrCallFunc);
     iocshRegister(&dbLockShowLockedFuncDef,dbLockShowLockedCallFunc);
+    iocshRegister(&dbLockStatsEnableFuncDef,dbLockStatsEnableCallFunc);
+    iocshRegister(&dbLockStatsResetFuncDef,dbLockStatsResetCallFunc);
+    iocshRegister(&dbLockStatsReportFuncDef,dbLockStatsReportCallFunc);
+    iocshRegister(&dbProfileEnableFuncDef,dbProfileEnableCallFunc);
+    iocshRegister(&dbProfileResetFuncDef,dbProfileResetCallFunc);
+    iocshRegister(&dbprofFuncDef,dbprofCallFunc);
+    iocshRegister(&dbTraceEnableFuncDef,dbTraceEnableCallFunc);
+    iocshRegister(&dbTraceRecordFuncDef,dbTraceRecordCallFunc);
+    iocshRegister(&dbTraceSetSizeFuncDef,dbTraceSetSizeCallFunc);
+    iocshRegister(&dbTraceClearFuncDef,dbTraceClearCallFunc);
+    iocshRegister(&dbTraceDumpFuncDef,dbTraceDumpCallFunc);
 
     iocshRegister(&scanOnceSetQueueSizeFuncDef,scanOnceSetQueueSizeCallFunc);
+    iocshRegister(&scanOnceSetThreadsFuncDef,scanOnceSetThreadsCallFunc);
+    iocshRegister(&scanOnceSetCoalesceFuncDef,scanOnceSetCoalesceCallFunc);
     iocshRegister(&scanOnceQueueShowFuncDef,scanOnceQueueShowCallFunc);
     iocshRegister(&scanpplFuncDef,scanpplCallFunc);
+    iocshRegister(&scanPeriodicThreadsFuncDef,scanPeriodicThreadsCallFunc);
+    iocshRegister(&scanPeriodicSpreadFuncDef,scanPeriodicSpreadCallFunc);
     iocshRegister(&scanpelFuncDef,scanpelCallFunc);
     iocshRegister(&postEventFuncDef,postEventCallFunc);
     iocshRegister(&scanpiolFuncDef,scanpiolCallFunc);
+    iocshRegister(&scanIoSetModeFuncDef,scanIoSetModeCallFunc);
 
     iocshRegister(&callbackSetQueueSizeFuncDef,callbackSetQueueSizeCallFunc);
     iocshRegister(&callbackQueueShowFuncDef,callbackQueueShowCallFunc);
@@ -18,25 +18,35 @@
 #include "ellLib.h"
 #include "epicsAssert.h"
 #include "epicsAtomic.h"
+#include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsPrint.h"
 #include "epicsSpin.h"
 #include "epicsStdio.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 #include "errMdef.h"
 
 #include "dbAccessDefs.h"
 #include "dbAddr.h"
 #include "dbBase.h"
+#include "dbChannel.h"
 #include "dbLink.h"
 #include "dbCommon.h"
 #include "dbFldTypes.h"
 #include "dbLockPvt.h"
 #include "dbStaticLib.h"
+#include "dbTrace.h"
 #include "link.h"
+#include "epicsExport.h"
 
 typedef struct dbScanLockNode dbScanLockNode;
 
+int dbLockSharedReads = 0;
+epicsExportAddress(int, dbLockSharedReads);
+
+static int lockStats;
+
 static epicsThreadOnceId dbLockOnceInit = EPICS_THREAD_ONCE_INIT;
 
 static ELLLIST lockSetsActive; /* in use */
@@ -84,6 +94,7 @@ static lockSet* makeSet(void)
         ls=dbCalloc(1,sizeof(*ls));
         ellInit(&ls->lockRecordList);
         ls->lock = epicsMutexMustCreate();
+        ls->readersDone = epicsEventMustCreate(epicsEventEmpty);
         ls->id = epicsAtomicIncrSizeT(&next_id);
 
 #ifndef LOCKSET_NOFREE
@@ -156,6 +167,7 @@ void dbLockDecRef(lockSet *ls)
     ellAdd(&lockSetsFree, &ls->node);
 #else
     epicsMutexDestroy(ls->lock);
+    epicsEventDestroy(ls->readersDone);
     memset(ls, 0, sizeof(*ls)); /* paranoia */
     free(ls);
 #endif
@@ -172,6 +184,15 @@ lockSet* dbLockGetRef(lockRecord *lr)
     return ls;
 }
 
+size_t dbLockRecomputeCount(void)
+{
+#ifndef LOCKSET_NOCNT
+    return epicsAtomicGetSizeT(&recomputeCnt);
+#else
+    return 0;
+#endif
+}
+
 unsigned long dbLockGetLockId(dbCommon *precord)
 {
     unsigned long id=0;
@@ -181,19 +202,77 @@ unsigned long dbLockGetLockId(dbCommon *precord)
     return id;
 }
 
-void dbScanLock(dbCommon *precord)
+/* Lock the mutex of a lockSet, counting the times it was busy */
+static void lockSetMutex(lockSet *ls, int shared)
 {
-    int cnt;
-    lockRecord * const lr = precord->lset;
-    lockSet *ls;
+    epicsUInt64 start;
 
-    assert(lr);
+    if (epicsMutexTryLock(ls->lock) == epicsMutexLockOK)
+        return;
+    start = lockStats ? epicsMonotonicGet() : 0;
+    epicsMutexMustLock(ls->lock);
+    if (shared)
+        ls->nReaderBlocked++;
+    else
+        ls->nContended++;
+    if (start)
+        ls->waitTime += epicsMonotonicGet() - start;
+}
 
-    ls = dbLockGetRef(lr);
-    assert(epicsAtomicGetIntT(&ls->refcount)>0);
+/* Take ownership of a lockSet whose lock the caller has just locked.
+ * A thread taking it for the first time must wait for any readers to
+ * leave. New readers can't arrive while we hold the lock.
+ */
+static void lockSetOwn(lockSet *ls)
+{
+    const epicsThreadId self = epicsThreadGetIdSelf();
+
+    if (ls->writer == self) {
+        ls->depth++;
+        return;
+    }
+    if (epicsAtomicGetIntT(&ls->readers)) {
+        epicsUInt64 start = lockStats ? epicsMonotonicGet() : 0;
+
+        ls->nWriterWaited++;
+        epicsAtomicIncrIntT(&ls->writerWaiting);
+        while (epicsAtomicGetIntT(&ls->readers))
+            epicsEventMustWait(ls->readersDone);
+        epicsAtomicDecrIntT(&ls->writerWaiting);
+        if (start)
+            ls->waitTime += epicsMonotonicGet() - start;
+    }
+    ls->writer = self;
+    ls->depth = 1;
+    ls->nExclusive++;
+    ls->holdStart = lockStats ? epicsMonotonicGet() : 0;
+}
+
+static void lockSetRelease(lockSet *ls)
+{
+    if (--ls->depth == 0) {
+        ls->writer = NULL;
+        if (ls->holdStart) {
+            epicsUInt64 hold = epicsMonotonicGet() - ls->holdStart;
+
+            ls->holdTime += hold;
+            if (hold > ls->holdMax)
+                ls->holdMax = hold;
+            ls->nHolds++;
+        }
+    }
+    epicsMutexUnlock(ls->lock);
+}
+
+/* Lock the lockSet of lr, which the caller holds a reference to.
+ * Returns the lockSet, which may differ from ls if a recompute moved lr.
+ */
+static lockSet* lockSetFind(lockRecord *lr, lockSet *ls, int shared)
+{
+    int cnt;
 
 retry:
-    epicsMutexMustLock(ls->lock);
+    lockSetMutex(ls, shared);
 
     epicsSpinLock(lr->spin);
     if(ls!=lr->plockSet) {
@@ -213,13 +292,33 @@ retry:
     }
     epicsSpinUnlock(lr->spin);
 
-    /* Release reference taken within this
-     * function.  The count will *never* fall to zero
+    /* Release reference taken by the caller.
+     * The count will *never* fall to zero
      * as the lockRecords can't be changed while
      * we hold the lock.
      */
     cnt = epicsAtomicDecrIntT(&ls->refcount);
     assert(cnt>0);
+    return ls;
+}
+
+void dbScanLock(dbCommon *precord)
+{
+    lockRecord * const lr = precord->lset;
+    lockSet *ls;
+
+    assert(lr);
+
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceLock, 'B', precord, 0);
+    ls = dbLockGetRef(lr);
+    assert(epicsAtomicGetIntT(&ls->refcount)>0);
+
+    ls = lockSetFind(lr, ls, 0);
+    lockSetOwn(ls);
+
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceLock, 'E', precord, 0);
 
 #ifdef LOCKSET_DEBUG
     if(ls->owner) {
@@ -245,10 +344,57 @@ void dbScanUnlock(dbCommon *precord)
     if(ls->ownercount==0)
         ls->owner = NULL;
 #endif
-    epicsMutexUnlock(ls->lock);
+    lockSetRelease(ls);
     dbLockDecRef(ls);
 }
 
+void dbScanLockShared(dbCommon *precord)
+{
+    lockRecord * const lr = precord->lset;
+    lockSet *ls;
+
+    if (!dbLockSharedReads) {
+        dbScanLock(precord);
+        return;
+    }
+    assert(lr);
+
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceLock, 'B', precord, 0);
+    ls = dbLockGetRef(lr);
+    ls = lockSetFind(lr, ls, 1);
+    if (ls->writer == epicsThreadGetIdSelf()) {
+        /* Already held exclusively by this thread */
+        ls->depth++;
+#ifdef LOCKSET_DEBUG
+        ls->ownercount++;
+#endif
+    }
+    else {
+        /* A merge or split needs the lockSet exclusively,
+         * so lr can't move while we are a reader.
+         */
+        epicsAtomicIncrIntT(&ls->readers);
+        ls->nShared++;
+        epicsMutexUnlock(ls->lock);
+    }
+    if (dbTraceMode)
+        dbTraceRecordEvent(dbTraceLock, 'E', precord, 0);
+}
+
+void dbScanUnlockShared(dbCommon *precord)
+{
+    lockSet *ls = precord->lset->plockSet;
+
+    if (ls->writer == epicsThreadGetIdSelf()) {
+        dbScanUnlock(precord);
+        return;
+    }
+    if (!epicsAtomicDecrIntT(&ls->readers) &&
+        epicsAtomicGetIntT(&ls->writerWaiting))
+        epicsEventMustTrigger(ls->readersDone);
+}
+
 static
 int lrrcompare(const void *rawA, const void *rawB)
 {
@@ -409,7 +555,8 @@ retry:
             continue;
         plock = ref->plockSet;
 
-        epicsMutexMustLock(plock->lock);
+        lockSetMutex(plock, 0);
+        lockSetOwn(plock);
         assert(plock->ownerlocker==NULL);
         plock->ownerlocker = locker;
         ellAdd(&locker->locked, &plock->lockernode);
@@ -465,7 +612,7 @@ void dbScanUnlockMany(dbLocker* locker)
             plock->owner = NULL;
 #endif
 
-        epicsMutexUnlock(plock->lock);
+        lockSetRelease(plock);
         /* release ref for locked list */
         dbLockDecRef(plock);
     }
@@ -571,6 +718,7 @@ void dbLockCleanupRecords(dbBase *pdbbase)
         assert(ls->refcount==0);
         assert(ellCount(&ls->lockRecordList)==0);
         epicsMutexDestroy(ls->lock);
+        epicsEventDestroy(ls->readersDone);
         free(ls);
     }
 #endif
@@ -657,7 +805,7 @@ void dbLockSetMerge(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
         B->ownerlocker = NULL;
         epicsAtomicDecrIntT(&B->refcount);
 
-        epicsMutexUnlock(B->lock);
+        lockSetRelease(B);
     }
 
     dbLockDecRef(B); /* last ref we hold */
@@ -796,6 +944,7 @@ void dbLockSetSplit(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
         splitset = makeSet(); /* reference for locker->locked */
 
         epicsMutexMustLock(splitset->lock);
+        lockSetOwn(splitset);
 
         assert(splitset->ownerlocker==NULL);
         ellAdd(&locker->locked, &splitset->lockernode);
@@ -905,6 +1054,12 @@ long dblsr(char *recordname,int level)
     for( ; plockSet; plockSet = (lockSet *)ellNext(&plockSet->node)) {
         printf("Lock Set %lu %d members %d refs epicsMutexId %p\n",
             plockSet->id,ellCount(&plockSet->lockRecordList),plockSet->refcount,plockSet->lock);
+        if(plockSet->nShared)
+            printf("    %lu exclusive, %lu shared, %lu readers blocked, "
+                "%lu writers waited for readers, %d readers now\n",
+                plockSet->nExclusive, plockSet->nShared,
+                plockSet->nReaderBlocked, plockSet->nWriterWaited,
+                epicsAtomicGetIntT(&plockSet->readers));
 
         if(level==0) { if(recordname) break; continue; }
         for(plockRecord = (lockRecord *)ellFirst(&plockSet->lockRecordList);
@@ -972,6 +1127,111 @@ long dbLockShowLocked(int level)
     return 0;
 }
 
+void dbLockStatsEnable(int on)
+{
+    lockStats = !!on;
+}
+
+void dbLockStatsReset(void)
+{
+    lockSet *plockSet;
+
+    epicsMutexMustLock(lockSetsGuard);
+    for(plockSet = (lockSet *)ellFirst(&lockSetsActive); plockSet;
+        plockSet = (lockSet *)ellNext(&plockSet->node)) {
+        plockSet->nExclusive = plockSet->nShared = 0;
+        plockSet->nReaderBlocked = plockSet->nWriterWaited = 0;
+        plockSet->nContended = plockSet->nHolds = 0;
+        plockSet->waitTime = plockSet->holdTime = plockSet->holdMax = 0;
+    }
+    epicsMutexUnlock(lockSetsGuard);
+}
+
+static int cmpWaitTime(const void *a, const void *b)
+{
+    const lockSet *lsa = *(const lockSet * const *)a;
+    const lockSet *lsb = *(const lockSet * const *)b;
+
+    if (lsa->waitTime != lsb->waitTime)
+        return lsa->waitTime < lsb->waitTime ? 1 : -1;
+    if (lsa->nContended != lsb->nContended)
+        return lsa->nContended < lsb->nContended ? 1 : -1;
+    return lsa->id < lsb->id ? -1 : lsa->id > lsb->id;
+}
+
+/* The DB links between members are what merged them into one set */
+static void showMergingLinks(lockSet *plockSet)
+{
+    lockRecord *plockRecord;
+
+    for(plockRecord = (lockRecord *)ellFirst(&plockSet->lockRecordList);
+        plockRecord; plockRecord = (lockRecord *)ellNext(&plockRecord->node)) {
+        dbCommon *precord = plockRecord->precord;
+        dbRecordType *pdbRecordType = precord->rdes;
+        short link;
+
+        for(link=0; link<pdbRecordType->no_links; link++) {
+            dbFldDes *pdbFldDes =
+                pdbRecordType->papFldDes[pdbRecordType->link_ind[link]];
+            DBLINK *plink = (DBLINK *)((char *)precord + pdbFldDes->offset);
+            dbCommon *ptarget;
+
+            if(plink->type != DB_LINK) continue;
+            ptarget = dbChannelRecord((dbChannel *)plink->value.pv_link.pvt);
+            if(ptarget == precord) continue;
+            printf("        %s.%s -> %s\n", precord->name,
+                pdbFldDes->name, ptarget->name);
+        }
+    }
+}
+
+long dbLockStatsReport(int count, int level)
+{
+    lockSet **sets;
+    lockSet *plockSet;
+    int nsets, i;
+
+    epicsMutexMustLock(lockSetsGuard);
+    nsets = ellCount(&lockSetsActive);
+    sets = malloc((nsets ? nsets : 1) * sizeof(*sets));
+    if(!sets) {
+        epicsMutexUnlock(lockSetsGuard);
+        errlogPrintf("dbLockStatsReport: Out of memory\n");
+        return -1;
+    }
+    for(i = 0, plockSet = (lockSet *)ellFirst(&lockSetsActive); plockSet;
+        plockSet = (lockSet *)ellNext(&plockSet->node))
+        sets[i++] = plockSet;
+    qsort(sets, nsets, sizeof(*sets), cmpWaitTime);
+
+    if(count <= 0 || count > nsets)
+        count = nsets;
+    if(!lockStats)
+        printf("Lock set timing is off, use dbLockStatsEnable 1\n");
+    printf("%8s %7s %10s %10s %10s %10s %10s  %s\n", "Set", "Records",
+        "Locks", "Contended", "Wait ms", "Hold us", "Max us", "First record");
+    for(i = 0; i < count; i++) {
+        lockRecord *pfirst;
+
+        plockSet = sets[i];
+        pfirst = (lockRecord *)ellFirst(&plockSet->lockRecordList);
+        printf("%8lu %7d %10lu %10lu %10.3f %10.1f %10.1f  %s\n",
+            plockSet->id, ellCount(&plockSet->lockRecordList),
+            plockSet->nExclusive + plockSet->nShared,
+            plockSet->nContended + plockSet->nReaderBlocked,
+            plockSet->waitTime * 1e-6,
+            plockSet->nHolds ?
+                plockSet->holdTime * 1e-3 / plockSet->nHolds : 0.0,
+            plockSet->holdMax * 1e-3,
+            pfirst ? pfirst->precord->name : "");
+        if(level > 0)
+            showMergingLinks(plockSet);
+    }
+    epicsMutexUnlock(lockSetsGuard);
+    free(sets);
+    return 0;
+}
+
 int * dbLockSetAddrTrace(dbCommon *precord)
 {
     lockRecord  *plockRecord = precord->lset;
@@ -53,6 +53,34 @@ DBCORE_API void dbScanLock(struct dbCommon *precord);
  */
 DBCORE_API void dbScanUnlock(struct dbCommon *precord);
 
+/** @brief Lock a record for reading only.
+ *
+ *  When ::dbLockSharedReads is set, any number of threads may hold a
+ *  record's lock set shared at the same time, while dbScanLock() waits
+ *  until they have all left. Otherwise this is the same as dbScanLock().
+ *  A thread already holding the lock set from dbScanLock() gets it
+ *  again exclusively.
+ *
+ *  While locked the caller may read the record with dbGet(), and must not
+ *  change it or lock it again. Record and device support routines that
+ *  dbGet() calls for the record must not modify it either.
+ *  The caller must later call dbScanUnlockShared().
+ *  @since UNRELEASED
+ */
+DBCORE_API void dbScanLockShared(struct dbCommon *precord);
+/** @brief Unlock a record locked with dbScanLockShared().
+ *  @since UNRELEASED
+ */
+DBCORE_API void dbScanUnlockShared(struct dbCommon *precord);
+
+/** @brief Allow dbScanLockShared() readers to share lock sets.
+ *
+ *  When zero (the default) all record locks are exclusive. This can be
+ *  changed at any time.
+ *  @since UNRELEASED
+ */
+DBCORE_API extern int dbLockSharedReads;
+
 /** @brief Prepare to lock a set of records.
  * @param precs Array of nrecs dbCommon pointers.
  * @param nrecs Length of precs array
@@ -98,6 +126,36 @@ DBCORE_API long dblsr(char *recordname,int level);
 
 DBCORE_API long dbLockShowLocked(int level);
 
+/** @brief Turn timing of lock set waits and holds on or off
+ *
+ * Lock set acquisitions and contended acquisitions are always counted.
+ * While this is on, the time spent waiting for each lock set and the
+ * time it was held are measured as well, which costs a clock read or
+ * two per lock.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ * @since UNRELEASED
+ */
+DBCORE_API void dbLockStatsEnable(int on);
+/** @brief Zero the lock set statistics
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ * @since UNRELEASED
+ */
+DBCORE_API void dbLockStatsReset(void);
+/** @brief Report the lock sets that were waited for the longest
+ *
+ * Lists up to @a count lock sets, or all if @a count is 0, ordered by
+ * the total time threads waited for them. For each set the number of
+ * records, locks taken, contended locks, total wait, and the mean and
+ * longest hold time are shown. At @a level 1 or more the DB links
+ * between members which placed them in the same set are listed too.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ * @since UNRELEASED
+ */
+DBCORE_API long dbLockStatsReport(int count, int level);
+
 /*KLUDGE to support field TPRO*/
 DBCORE_API int * dbLockSetAddrTrace(struct dbCommon *precord);
 
@@ -10,8 +10,11 @@
 #define DBLOCKPVT_H
 
 #include "dbLock.h"
+#include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsSpin.h"
+#include "epicsThread.h"
+#include "epicsTypes.h"
 
 /* Define to enable additional error checking */
 #undef LOCKSET_DEBUG
@@ -22,8 +25,8 @@
 /* Define to disable use of recomputeCnt optimization */
 #undef LOCKSET_NOCNT
 
-/* except for refcount (and lock), all members of dbLockSet
- * are guarded by its lock.
+/* except for refcount, readers and writerWaiting (and lock),
+ * all members of dbLockSet are guarded by its lock.
  */
 typedef struct dbLockSet {
     ELLNODE             node;
@@ -32,6 +35,28 @@ typedef struct dbLockSet {
     unsigned long       id;
 
     int                 refcount;
+
+    /* Exclusive owner, which holds lock and waited for readers to leave */
+    epicsThreadId       writer;
+    int                 depth;          /* recursive locks by writer */
+    /* Threads in dbScanLockShared(), which don't hold lock */
+    int                 readers;
+    int                 writerWaiting;
+    epicsEventId        readersDone;
+    /* For dblsr */
+    unsigned long       nExclusive;
+    unsigned long       nShared;
+    unsigned long       nReaderBlocked; /* shared lock waited for lock */
+    unsigned long       nWriterWaited;  /* exclusive waited for readers */
+    /* For dbLockStatsReport, times are in nanoseconds and are only
+     * collected while dbLockStatsEnable() is on.
+     */
+    unsigned long       nContended;     /* exclusive waited for lock */
+    epicsUInt64         waitTime;       /* waiting for lock or readers */
+    epicsUInt64         holdStart;      /* 0 if not being timed */
+    epicsUInt64         holdTime;
+    epicsUInt64         holdMax;
+    unsigned long       nHolds;         /* in holdTime */
 #ifdef LOCKSET_DEBUG
     int                 ownercount;
     epicsThreadId       owner;
@@ -106,6 +131,9 @@ void dbLockerPrepare(struct dbLocker *locker,
                      size_t nrecs);
 void dbLockerFinalize(dbLocker *);
 
+/* Changes whenever any record moves to a different lockset */
+size_t dbLockRecomputeCount(void);
+
 void dbLockSetMerge(struct dbLocker *locker,
                     struct dbCommon *pfirst,
                     struct dbCommon *psecond);
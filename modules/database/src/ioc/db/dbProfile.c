@@ -0,0 +1,352 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Record processing profiler, see dbProfile.h
+ *
+ * The counters of each record are allocated the first time it finishes
+ * processing while profiling is on, so records that are never profiled
+ * only pay for a pointer in their dbCommonPvt. They are freed with the
+ * record by dbFreeRecord(), and are only written by the thread processing
+ * the record, with the record locked. Reports read them without locking, so a report may mix values
+ * from before and after a concurrent update.
+ *
+ * Each thread keeps its innermost profiled call in a thread private
+ * variable, so that the time of a call can be subtracted from the self
+ * time of the call that caused it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "ellLib.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "dbAccessDefs.h"
+#include "dbBase.h"
+#include "dbCommonPvt.h"
+#include "dbLock.h"
+#include "dbProfile.h"
+#include "dbStaticLib.h"
+
+int dbProfiling = 0;
+
+static epicsThreadOnceId profileOnceId = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId currentFrame;
+
+static void profileOnce(void *junk)
+{
+    currentFrame = epicsThreadPrivateCreate();
+}
+
+void dbProfileBegin(dbProfileFrame *pframe)
+{
+    /* dbProfiling may have been set without calling dbProfileEnable() */
+    epicsThreadOnce(&profileOnceId, profileOnce, NULL);
+    pframe->parent = epicsThreadPrivateGet(currentFrame);
+    pframe->child = 0;
+    epicsThreadPrivateSet(currentFrame, pframe);
+    pframe->start = epicsMonotonicGet();
+}
+
+void dbProfileEnd(dbCommon *prec, dbProfileFrame *pframe)
+{
+    dbCommonPvt *ppvt = dbRec2Pvt(prec);
+    dbRecordProfile *prof = ppvt->prof;
+    epicsUInt64 now = epicsMonotonicGet();
+    epicsUInt64 total = now - pframe->start;
+
+    epicsThreadPrivateSet(currentFrame, pframe->parent);
+    if (pframe->parent)
+        pframe->parent->child += total;
+
+    if (!prof) {
+        prof = calloc(1, sizeof(dbRecordProfile));
+        if (!prof)
+            return;
+        /* Readers may see the pointer before the record is unlocked */
+        epicsAtomicWriteMemoryBarrier();
+        ppvt->prof = prof;
+    }
+
+    prof->count++;
+    prof->total += total;
+    prof->self += total > pframe->child ? total - pframe->child : 0;
+    if (total > prof->max)
+        prof->max = total;
+    if (prec->pact && !prof->asyncStart)
+        prof->asyncStart = now;
+}
+
+void dbProfileAsyncDone(dbCommon *prec)
+{
+    dbRecordProfile *prof = dbRec2Pvt(prec)->prof;
+    epicsUInt64 latency;
+
+    if (!prof || !prof->asyncStart)
+        return;
+    latency = epicsMonotonicGet() - prof->asyncStart;
+    prof->asyncStart = 0;
+    prof->asyncCount++;
+    prof->asyncTotal += latency;
+    if (latency > prof->asyncMax)
+        prof->asyncMax = latency;
+}
+
+typedef void (*recordFunc)(dbCommon *prec, void *arg);
+
+static void forEachRecord(dbRecordType *pdbRecordType, recordFunc func,
+    void *arg)
+{
+    dbRecordNode *pdbRecordNode;
+
+    for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+         pdbRecordNode;
+         pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
+        dbCommon *precord = pdbRecordNode->precord;
+
+        if (!precord->name[0] ||
+            pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
+            continue;
+        func(precord, arg);
+    }
+}
+
+static void forAllRecords(recordFunc func, void *arg)
+{
+    dbRecordType *pdbRecordType;
+
+    if (!pdbbase)
+        return;
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node))
+        forEachRecord(pdbRecordType, func, arg);
+}
+
+static void clearRecord(dbCommon *prec, void *arg)
+{
+    dbRecordProfile *prof = dbRec2Pvt(prec)->prof;
+
+    if (!prof)
+        return;
+    dbScanLock(prec);
+    if (arg)
+        prof->asyncStart = 0;
+    else
+        memset(prof, 0, sizeof(*prof));
+    dbScanUnlock(prec);
+}
+
+void dbProfileEnable(int enable)
+{
+    epicsThreadOnce(&profileOnceId, profileOnce, NULL);
+    if (enable && !dbProfiling) {
+        /* Forget completions still pending from an earlier run */
+        forAllRecords(clearRecord, &enable);
+    }
+    dbProfiling = !!enable;
+}
+
+void dbProfileReset(void)
+{
+    forAllRecords(clearRecord, NULL);
+}
+
+/* The profile of a record, all zero if it has never been profiled */
+static dbRecordProfile getProfile(dbCommon *prec)
+{
+    dbRecordProfile *prof = dbRec2Pvt(prec)->prof;
+    dbRecordProfile zero = {0};
+
+    return prof ? *prof : zero;
+}
+
+static void fillEntry(dbProfileEntry *pentry, dbCommon *prec)
+{
+    dbRecordProfile prof = getProfile(prec);
+
+    pentry->precord = prec;
+    pentry->count = (double)prof.count;
+    pentry->selfTime = prof.self * 1e-9;
+    pentry->totalTime = prof.total * 1e-9;
+    pentry->maxTime = prof.max * 1e-9;
+    pentry->asyncCount = (double)prof.asyncCount;
+    pentry->asyncTime = prof.asyncTotal * 1e-9;
+    pentry->asyncMax = prof.asyncMax * 1e-9;
+}
+
+typedef struct topList {
+    dbProfileEntry *entries;
+    int size;
+    int used;
+} topList;
+
+/* Insert into a list kept sorted by self time, most costly first */
+static void rankRecord(dbCommon *prec, void *arg)
+{
+    topList *ptop = (topList *)arg;
+    dbRecordProfile *prof = dbRec2Pvt(prec)->prof;
+    epicsUInt64 self = prof ? prof->self : 0;
+    double selfTime = self * 1e-9;
+    int i;
+
+    if (!self || (ptop->used == ptop->size &&
+        selfTime <= ptop->entries[ptop->used - 1].selfTime))
+        return;
+    if (ptop->used < ptop->size)
+        ptop->used++;
+    for (i = ptop->used - 1;
+         i > 0 && ptop->entries[i - 1].selfTime < selfTime; i--)
+        ptop->entries[i] = ptop->entries[i - 1];
+    fillEntry(&ptop->entries[i], prec);
+}
+
+int dbProfileTop(dbProfileEntry *entries, int count)
+{
+    topList top;
+
+    top.entries = entries;
+    top.size = count;
+    top.used = 0;
+    if (count > 0)
+        forAllRecords(rankRecord, &top);
+    return top.used;
+}
+
+static void sumRecord(dbCommon *prec, void *arg)
+{
+    dbRecordProfile *psum = (dbRecordProfile *)arg;
+    dbRecordProfile prof = getProfile(prec);
+
+    psum->count += prof.count;
+    psum->self += prof.self;
+    psum->total += prof.total;
+    if (prof.max > psum->max)
+        psum->max = prof.max;
+    psum->asyncCount += prof.asyncCount;
+    psum->asyncTotal += prof.asyncTotal;
+    if (prof.asyncMax > psum->asyncMax)
+        psum->asyncMax = prof.asyncMax;
+}
+
+typedef struct typeSum {
+    const char *name;
+    dbRecordProfile sum;
+} typeSum;
+
+/* Most costly first, record types never processed last */
+static int cmpTypeSum(const void *a, const void *b)
+{
+    const dbRecordProfile *pa = &((const typeSum *)a)->sum;
+    const dbRecordProfile *pb = &((const typeSum *)b)->sum;
+
+    if (pa->self != pb->self)
+        return pa->self < pb->self ? 1 : -1;
+    if (pa->count != pb->count)
+        return pa->count < pb->count ? 1 : -1;
+    return 0;
+}
+
+static void printLine(const char *name, double count, double self,
+    double total, double max, double asyncCount, double asyncTime,
+    double asyncMax)
+{
+    printf("%-30s %10.0f %10.3f %10.3f %8.3f", name, count,
+        self * 1e3, total * 1e3, max * 1e3);
+    if (asyncCount > 0)
+        printf(" %8.0f %8.3f %8.3f", asyncCount,
+            asyncTime / asyncCount * 1e3, asyncMax * 1e3);
+    printf("\n");
+}
+
+static void printHeader(const char *what)
+{
+    printf("%-30s %10s %10s %10s %8s %8s %8s %8s\n", what, "count",
+        "self ms", "total ms", "max ms", "async", "avg ms", "max ms");
+}
+
+long dbprof(int count, const char *recordTypeName)
+{
+    dbRecordType *pdbRecordType;
+    dbProfileEntry *entries;
+    typeSum *sums;
+    int i, n;
+
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return 0;
+    }
+    if (recordTypeName &&
+        (*recordTypeName == '\0' || !strcmp(recordTypeName, "*")))
+        recordTypeName = NULL;
+    if (count <= 0)
+        count = 20;
+
+    printf("Record processing profiling is %s\n",
+        dbProfiling ? "enabled" : "disabled");
+
+    entries = dbCalloc(count, sizeof(dbProfileEntry));
+    if (recordTypeName) {
+        DBENTRY dbentry;
+        topList top;
+
+        dbInitEntry(pdbbase, &dbentry);
+        pdbRecordType = dbFindRecordType(&dbentry, recordTypeName) ?
+            NULL : dbentry.precordType;
+        dbFinishEntry(&dbentry);
+        if (!pdbRecordType) {
+            printf("No record type\n");
+            free(entries);
+            return 0;
+        }
+        top.entries = entries;
+        top.size = count;
+        top.used = 0;
+        forEachRecord(pdbRecordType, rankRecord, &top);
+        n = top.used;
+    }
+    else {
+        n = dbProfileTop(entries, count);
+    }
+
+    printHeader("Record");
+    for (i = 0; i < n; i++) {
+        dbProfileEntry *pentry = &entries[i];
+
+        printLine(pentry->precord->name, pentry->count, pentry->selfTime,
+            pentry->totalTime, pentry->maxTime, pentry->asyncCount,
+            pentry->asyncTime, pentry->asyncMax);
+    }
+    free(entries);
+    if (recordTypeName)
+        return 0;
+
+    n = ellCount(&pdbbase->recordTypeList);
+    sums = dbCalloc(n, sizeof(typeSum));
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList),
+         i = 0;
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node), i++) {
+        sums[i].name = pdbRecordType->name;
+        forEachRecord(pdbRecordType, sumRecord, &sums[i].sum);
+    }
+    qsort(sums, n, sizeof(typeSum), cmpTypeSum);
+
+    printHeader("Record type");
+    for (i = 0; i < n && sums[i].sum.count; i++) {
+        dbRecordProfile *psum = &sums[i].sum;
+
+        printLine(sums[i].name, (double)psum->count, psum->self * 1e-9,
+            psum->total * 1e-9, psum->max * 1e-9, (double)psum->asyncCount,
+            psum->asyncTotal * 1e-9, psum->asyncMax * 1e-9);
+    }
+    free(sums);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#ifndef INCdbProfileH
+#define INCdbProfileH
+
+#include "dbCoreAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file dbProfile.h
+ * @brief Record processing profiler
+ *
+ * While enabled, every call from dbProcess() to a record's process
+ * routine is timed. For each record the profiler keeps the number of
+ * calls, the total time including records processed from inside the call
+ * (forward and process-passive links), the time spent in the record itself,
+ * and the longest call. Records that return with PACT set also collect the
+ * time until their asynchronous completion calls recGblFwdLink().
+ *
+ * Each call costs two monotonic clock reads and a few additions while
+ * profiling is on, and one flag test while it is off.
+ */
+
+struct dbCommon;
+
+/** @brief Profile of one record, times in seconds. */
+typedef struct dbProfileEntry {
+    struct dbCommon *precord;
+    double count;       /**< @brief Calls to the process routine */
+    double selfTime;    /**< @brief Excluding records processed from it */
+    double totalTime;   /**< @brief Including records processed from it */
+    double maxTime;     /**< @brief Longest total time of one call */
+    double asyncCount;  /**< @brief Asynchronous completions */
+    double asyncTime;   /**< @brief Total time from PACT set to completion */
+    double asyncMax;    /**< @brief Longest asynchronous completion */
+} dbProfileEntry;
+
+/** @brief Non-zero while profiling is enabled.
+ *
+ * Read only, call dbProfileEnable() to change it.
+ */
+DBCORE_API extern int dbProfiling;
+
+/** @brief Turn the profiler on or off.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API void dbProfileEnable(int enable);
+
+/** @brief Clear the profile of every record.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API void dbProfileReset(void);
+
+/** @brief Find the records that cost the most.
+ *
+ * Fills @p entries with up to @p count records with the highest self
+ * time, most costly first.
+ *
+ * @return The number of entries filled.
+ */
+DBCORE_API int dbProfileTop(dbProfileEntry *entries, int count);
+
+/** @brief Print the most costly records and a summary by record type.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ *
+ * @param count Number of records to list, 20 if <= 0.
+ * @param recordTypeName Only include this record type if not NULL or "".
+ */
+DBCORE_API long dbprof(int count, const char *recordTypeName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdbProfileH */
@@ -30,6 +30,7 @@
 #include "epicsMutex.h"
 #include "epicsPrint.h"
 #include "epicsRingBytes.h"
+#include "epicsSpin.h"
 #include "epicsStdio.h"
 #include "epicsStdlib.h"
 #include "epicsString.h"
@@ -41,9 +42,11 @@
 #include "dbAccessDefs.h"
 #include "dbAddr.h"
 #include "dbBase.h"
+#include "dbCommonPvt.h"
 #include "dbCommon.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "dbLockPvt.h"
 #include "dbScan.h"
 #include "dbStaticLib.h"
 #include "devSup.h"
@@ -61,19 +64,33 @@ static volatile enum ctl scanCtl;
 
 /* SCAN ONCE */
 
+typedef struct once_queue {
+    epicsRingBytesId    ring;
+    epicsEventId        sem;
+    epicsThreadId       tid;
+} once_queue;
+
 static int onceQueueSize = 1000;
-static epicsEventId onceSem;
-static epicsRingBytesId onceQ;
+static int onceThreads = 1;
+static int onceCoalesce = FALSE;
+static once_queue *onceQueues;
+static int nOnce;
 static int onceQOverruns = 0;
-static epicsThreadId onceTaskId;
+static int onceCoalesced = 0;
 static void *exitOnce;
 
+typedef struct {
+    struct dbCommon *prec;
+    once_complete cb;
+    void *usr;
+} onceEntry;
+
 
 /* All other scan types */
 typedef struct scan_list{
     epicsMutexId        lock;
     ELLLIST             list;
-    short               modified;/*has list been modified?*/
+    unsigned            modified;/*has list been modified? a bit per part*/
 } scan_list;
 /*scan_elements are allocated and the address stored in dbCommon.spvt*/
 typedef struct scan_element{
@@ -87,6 +104,28 @@ typedef struct scan_element{
 
 #define OVERRUN_REPORT_DELAY 10.0   /* Time between initial reports */
 #define OVERRUN_REPORT_MAX 3600.0   /* Maximum time between reports */
+
+#define MAX_SLICES 1000             /* Limit for spreading a list */
+
+/* Buckets of the slice start latency histogram: <10us, <100us, ... */
+#define NUM_LATENCY_BUCKETS 7
+
+struct periodic_scan_list;
+
+/* One of the threads sharing a parallel periodic scan list */
+typedef struct scan_worker {
+    struct periodic_scan_list *ppsl;
+    epicsThreadId       tid;
+    epicsEventId        startEvent;
+    int                 first;      /* share of ppsl->records */
+    int                 count;
+    int                 slice;      /* slice to process when started */
+    double              busyNow;    /* processing time, this period */
+    double              busy;       /* processing time, last period */
+    double              busyMax;
+    unsigned long       overruns;   /* periods with busy > period */
+} scan_worker;
+
 typedef struct periodic_scan_list {
     scan_list           scan_list;
     double              period;
@@ -94,8 +133,36 @@ typedef struct periodic_scan_list {
     unsigned long       overruns;
     volatile enum ctl   scanCtl;
     epicsEventId        loopEvent;
+    /* Processing from a snapshot of the list, used when the list is
+     * processed by several threads or spread over the period */
+    int                 nWorkers;
+    int                 nSlices;
+    int                 byPhase;    /* don't split a PHAS group */
+    scan_worker         *workers;   /* workers[0] is the periodic task */
+    epicsEventId        doneEvent;
+    int                 pending;    /* workers still busy */
+    int                 stopWorkers;
+    struct dbCommon     **records;  /* list snapshot, grouped by worker */
+    int                 nRecords;
+    int                 partitioned;
+    size_t              recomputed; /* dbLockRecomputeCount() at snapshot */
+    /* Timing statistics */
+    epicsTimeStamp      statsStart;
+    double              busyTotal;
+    unsigned long       latency[NUM_LATENCY_BUCKETS];
+    double              latencyMax;
 } periodic_scan_list;
 
+/* Configuration from scanPeriodicThreads() and scanPeriodicSpread() */
+typedef struct periodic_config {
+    ELLNODE             node;
+    double              period;     /* 0 means all periods */
+    int                 threads;    /* 0 if not set by this entry */
+    int                 slices;     /* -1 if not set by this entry */
+    int                 byPhase;
+} periodic_config;
+static ELLLIST periodicConfig = ELLLIST_INIT;
+
 static int nPeriodic = 0;
 static periodic_scan_list **papPeriodic; /* pointer to array of pointers */
 static epicsThreadId *periodicTaskId;    /* array of thread ids */
@@ -119,9 +186,33 @@ static epicsMutexId event_lock;
 
 /* IO_EVENT*/
 
+#define MAX_IO_PARTS 32             /* Limit for splitting a list */
+#define IO_STAMPS 16                /* Request times kept for latency */
+
+typedef struct io_scan_stamp {
+    unsigned seq;           /* of the scan requested at time */
+    epicsUInt64 time;
+} io_scan_stamp;
+
+/* The fields after scan_list are guarded by the ioscan_head's lock.
+ * A list split into parts runs one scan at a time; requests arriving
+ * while it runs are pending until it finishes.
+ */
 typedef struct io_scan_list {
     epicsCallback callback;
     scan_list scan_list;
+    epicsCallback *parts;   /* &callback, or one per part when split */
+    int busy;               /* callbacks queued, running or about to be */
+    int pending;            /* scans requested, not started */
+    unsigned seqIn;         /* scans requested */
+    unsigned seqOut;        /* scans started */
+    io_scan_stamp stamps[IO_STAMPS];
+    /* Statistics */
+    size_t requests;
+    size_t merged;
+    size_t scans;
+    size_t lost;            /* parts that could not be queued */
+    epicsUInt64 latencyMax;
 } io_scan_list;
 
 typedef struct ioscan_head {
@@ -129,15 +220,27 @@ typedef struct ioscan_head {
     struct io_scan_list iosl[NUM_CALLBACK_PRIORITIES];
     io_scan_complete cb;
     void *arg;
+    epicsSpinId lock;       /* taken by scanIoRequest(), may be an ISR */
+    int merge;
+    int nParts;
 } ioscan_head;
 
 static ioscan_head *pioscan_list = NULL;
 static epicsMutexId ioscan_lock;
+static int ioscanMerge = FALSE;     /* defaults from scanIoSetMode() */
+static int ioscanParts = 1;
 
 /* Private routines */
 static void onceTask(void *);
 static void initOnce(void);
+static void deleteOnce(void);
+static int pushOnce(once_queue *poq, onceEntry *pent);
 static void periodicTask(void *arg);
+static void periodicWorker(void *arg);
+static void scanSnapshot(periodic_scan_list *ppsl,
+    const epicsTimeStamp *start);
+static void printStats(periodic_scan_list *ppsl);
+static void addLatency(periodic_scan_list *ppsl, double latency);
 static void initPeriodic(void);
 static void deletePeriodic(void);
 static void spawnPeriodic(int ind);
@@ -145,8 +248,13 @@ static void eventCallback(epicsCallback *pcallback);
 static void ioscanInit(void);
 static void ioscanCallback(epicsCallback *pcallback);
 static void ioscanDestroy(void);
-static void printList(scan_list *psl, char *message);
+static int requestScan(ioscan_head *piosh, io_scan_list *piosl);
+static int launchScans(ioscan_head *piosh, io_scan_list *piosl);
+static void scanRequested(io_scan_list *piosl);
+static void scanStarted(io_scan_list *piosl);
+static int printList(scan_list *psl, char *message);
 static void scanList(scan_list *psl);
+static void scanListPart(scan_list *psl, int nParts, int part);
 static void buildScanLists(void);
 static void addToList(struct dbCommon *precord, scan_list *psl);
 static void deleteFromList(struct dbCommon *precord, scan_list *psl);
@@ -172,9 +280,16 @@ void scanStop(void)
         epicsThreadMustJoin(periodicTaskId[i]);
     }
 
-    scanOnce((dbCommon *)&exitOnce);
-    epicsEventWait(startStopEvent);
-    epicsThreadMustJoin(onceTaskId);
+    for (i = 0; i < nOnce; i++) {
+        onceEntry ent;
+
+        ent.prec = (dbCommon *)&exitOnce;
+        ent.cb = NULL;
+        ent.usr = NULL;
+        pushOnce(&onceQueues[i], &ent);
+        epicsEventWait(startStopEvent);
+        epicsThreadMustJoin(onceQueues[i].tid);
+    }
 }
 
 void scanCleanup(void)
@@ -183,11 +298,16 @@ void scanCleanup(void)
     deletePeriodic();
     ioscanDestroy();
 
-    epicsRingBytesDelete(onceQ);
+    deleteOnce();
 
     free(periodicTaskId);
     papPeriodic = NULL;
     periodicTaskId = NULL;
+    ellFree(&periodicConfig);
+    onceThreads = 1;
+    onceCoalesce = FALSE;
+    ioscanMerge = FALSE;
+    ioscanParts = 1;
 }
 
 long scanInit(void)
@@ -404,10 +524,86 @@ int scanppl(double period)      /* print periodic scan list(s) */
         sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
             ppsl->name, ppsl->overruns);
         printList(&ppsl->scan_list, message);
+        if (ellCount(&ppsl->scan_list.list) > 0)
+            printStats(ppsl);
+        if (ppsl->nWorkers > 1) {
+            int j;
+
+            printf("  Processed by %d threads:\n", ppsl->nWorkers);
+            for (j = 0; j < ppsl->nWorkers; j++) {
+                scan_worker *pw = &ppsl->workers[j];
+
+                printf("    Thread %d: %5d records, busy %.3f ms (max %.3f),"
+                    " %lu over-runs\n", j, pw->count, pw->busy * 1e3,
+                    pw->busyMax * 1e3, pw->overruns);
+            }
+        }
     }
     return 0;
 }
 
+static void printStats(periodic_scan_list *ppsl)
+{
+    static const char *bucketName[NUM_LATENCY_BUCKETS] = {
+        "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"
+    };
+    epicsTimeStamp now;
+    double elapsed;
+    int i;
+
+    epicsTimeGetMonotonic(&now);
+    elapsed = epicsTimeDiffInSeconds(&now, &ppsl->statsStart);
+    printf("  Duty cycle %.1f%%", elapsed > 0.0 ?
+        100.0 * ppsl->busyTotal / elapsed : 0.0);
+    if (ppsl->nSlices > 1)
+        printf(", spread over %d slices%s", ppsl->nSlices,
+            ppsl->byPhase ? " by PHAS" : "");
+    printf("\n  Start latency:");
+    for (i = 0; i < NUM_LATENCY_BUCKETS; i++)
+        printf(" %s %lu", bucketName[i], ppsl->latency[i]);
+    printf(", max %.3f ms\n", ppsl->latencyMax * 1e3);
+}
+
+static int addConfig(const char *cmd, double period, int threads,
+    int slices, int byPhase)
+{
+    periodic_config *pcfg;
+
+    if (papPeriodic) {
+        fprintf(stderr, "%s: Scan system already initialized\n", cmd);
+        return -1;
+    }
+    if (period < 0.0) {
+        fprintf(stderr, "%s: Bad period %g\n", cmd, period);
+        return -1;
+    }
+
+    pcfg = dbCalloc(1, sizeof(periodic_config));
+    pcfg->period = period;
+    pcfg->threads = threads;
+    pcfg->slices = slices;
+    pcfg->byPhase = byPhase;
+    ellAdd(&periodicConfig, &pcfg->node);
+    return 0;
+}
+
+int scanPeriodicThreads(int count, double period)
+{
+    if (count <= 0)
+        count = epicsThreadGetCPUs() + count;
+    if (count < 1) count = 1;
+
+    return addConfig("scanPeriodicThreads", period, count, -1, 0);
+}
+
+int scanPeriodicSpread(int slices, double period, int byPhase)
+{
+    if (slices > MAX_SLICES) slices = MAX_SLICES;
+    if (slices < 0) slices = 1;
+
+    return addConfig("scanPeriodicSpread", period, 0, slices, byPhase);
+}
+
 int scanpel(const char* eventname)   /* print event list */
 {
     char message[80];
@@ -441,10 +637,24 @@ int scanpiol(void)                  /* print pioscan_list */
         for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
             io_scan_list *piosl = &piosh->iosl[prio];
             char message[80];
+            io_scan_list stats;
 
             sprintf(message, "IO Event %p: Priority %s",
                 piosh, priorityName[prio]);
-            printList(&piosl->scan_list, message);
+            if (!printList(&piosl->scan_list, message))
+                continue;
+            epicsSpinLock(piosh->lock);
+            stats = *piosl;
+            epicsSpinUnlock(piosh->lock);
+            printf("  Requests %lu, merged %lu, scans %lu, lost parts %lu, "
+                "max latency %.3f ms\n",
+                (unsigned long)stats.requests, (unsigned long)stats.merged,
+                (unsigned long)stats.scans, (unsigned long)stats.lost,
+                stats.latencyMax * 1e-6);
+            if (piosh->merge || piosh->nParts > 1)
+                printf("  Requests %s, split in %d part%s\n",
+                    piosh->merge ? "merged" : "not merged", piosh->nParts,
+                    piosh->nParts > 1 ? "s" : "");
         }
         piosh = piosh->next;
     }
@@ -576,9 +786,14 @@ static void ioscanDestroy(void)
         int prio;
 
         for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsMutexDestroy(piosh->iosl[prio].scan_list.lock);
-            ellFree(&piosh->iosl[prio].scan_list.list);
+            io_scan_list *piosl = &piosh->iosl[prio];
+
+            epicsMutexDestroy(piosl->scan_list.lock);
+            ellFree(&piosl->scan_list.list);
+            if (piosl->parts != &piosl->callback)
+                free(piosl->parts);
         }
+        epicsSpinDestroy(piosh->lock);
         free(piosh);
         piosh = pnext;
     }
@@ -598,8 +813,13 @@ void scanIoInit(IOSCANPVT *pioscanpvt)
         callbackSetUser(piosh, &piosl->callback);
         ellInit(&piosl->scan_list.list);
         piosl->scan_list.lock = epicsMutexMustCreate();
+        piosl->parts = &piosl->callback;
     }
+    piosh->lock = epicsSpinMustCreate();
+    piosh->nParts = 1;
     epicsMutexMustLock(ioscan_lock);
+    piosh->merge = ioscanMerge;
+    scanIoSetParallel(piosh, ioscanParts);
     piosh->next = pioscan_list;
     pioscan_list = piosh;
     epicsMutexUnlock(ioscan_lock);
@@ -621,13 +841,138 @@ unsigned int scanIoRequest(IOSCANPVT piosh)
         io_scan_list *piosl = &piosh->iosl[prio];
 
         if (ellCount(&piosl->scan_list.list) > 0)
-            if (!callbackRequest(&piosl->callback))
+            if (requestScan(piosh, piosl))
                 queued |= 1 << prio;
     }
 
     return queued;
 }
 
+/* Queue the callbacks for one scan of a list, or merge the request with
+ * a scan that has been requested but not started yet. A split list with
+ * a scan running only notes the request; its last part queues the next.
+ * Returns FALSE if the scan could not be queued.
+ *
+ * callbackRequest() may not be called inside the spin section, so the
+ * callbacks are counted busy with the lock held and queued after it is
+ * released. Any that can't be queued are then taken off again.
+ */
+static int requestScan(ioscan_head *piosh, io_scan_list *piosl)
+{
+    epicsCallback *pcallback;
+
+    epicsSpinLock(piosh->lock);
+    piosl->requests++;
+    if (piosh->merge && piosl->pending) {
+        piosl->merged++;
+        epicsSpinUnlock(piosh->lock);
+        return TRUE;
+    }
+    scanRequested(piosl);
+    if (piosh->nParts > 1) {
+        epicsSpinUnlock(piosh->lock);
+        return launchScans(piosh, piosl);
+    }
+    piosl->busy++;
+    pcallback = piosl->parts;
+    epicsSpinUnlock(piosh->lock);
+
+    if (!callbackRequest(pcallback))
+        return TRUE;
+
+    epicsSpinLock(piosh->lock);
+    piosl->busy--;
+    piosl->lost++;
+    piosl->pending--;
+    piosl->seqOut++;
+    epicsSpinUnlock(piosh->lock);
+    return FALSE;
+}
+
+/* Queue every part of the pending scans of a split list in turn while
+ * nothing else of it is busy. Called without the lock; the parts are
+ * counted busy before it is released, so only one thread launches a
+ * scan. Parts which can't be queued are counted as lost and miss that
+ * scan, which is dropped if no part of it was queued. Returns FALSE if
+ * a scan was dropped.
+ */
+static int launchScans(ioscan_head *piosh, io_scan_list *piosl)
+{
+    int prio = (int)(piosl - piosh->iosl);
+    int queued = TRUE;
+
+    epicsSpinLock(piosh->lock);
+    while (piosl->pending && !piosl->busy) {
+        epicsCallback *parts = piosl->parts;
+        int nParts = piosh->nParts;
+        int part0, nLost, i;
+
+        piosl->busy = nParts;
+        epicsSpinUnlock(piosh->lock);
+
+        part0 = !callbackRequest(&parts[0]);
+        nLost = !part0;
+        for (i = 1; i < nParts; i++)
+            nLost += callbackRequest(&parts[i]) != 0;
+
+        epicsSpinLock(piosh->lock);
+        if (!nLost)
+            break;
+        piosl->lost += nLost;
+        piosl->busy -= nLost;
+        if (nLost == nParts) {
+            piosl->pending--;
+            piosl->seqOut++;
+            queued = FALSE;
+            continue;
+        }
+        /* Part 0 can't mark the start */
+        if (!part0)
+            scanStarted(piosl);
+        if (!piosl->busy && piosh->cb) {
+            /* The queued parts finished before the lost ones were
+             * taken off, so their last one left this scan to us.
+             */
+            epicsSpinUnlock(piosh->lock);
+            piosh->cb(piosh->arg, piosh, prio);
+            epicsSpinLock(piosh->lock);
+        }
+    }
+    epicsSpinUnlock(piosh->lock);
+    return queued;
+}
+
+/* Note a new scan and when it was requested, with the lock held */
+static void scanRequested(io_scan_list *piosl)
+{
+    unsigned seq = piosl->seqIn++;
+
+    piosl->pending++;
+    /* Older scans still waiting keep their slots */
+    if (seq - piosl->seqOut < IO_STAMPS) {
+        io_scan_stamp *pstamp = &piosl->stamps[seq % IO_STAMPS];
+
+        pstamp->seq = seq;
+        pstamp->time = epicsMonotonicGet();
+    }
+}
+
+/* Count the start of the oldest pending scan, with the lock held */
+static void scanStarted(io_scan_list *piosl)
+{
+    unsigned seq = piosl->seqOut++;
+    io_scan_stamp *pstamp = &piosl->stamps[seq % IO_STAMPS];
+
+    piosl->pending--;
+    piosl->scans++;
+    if (pstamp->seq == seq) {
+        epicsUInt64 latency = epicsMonotonicGet() - pstamp->time;
+
+        if (latency > piosl->latencyMax)
+            piosl->latencyMax = latency;
+    }
+}
+
 unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
 {
     io_scan_list *piosl;
@@ -650,34 +995,103 @@ unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
     return 1 << prio;
 }
 
-/* May not be called while a scan request is queued or running */
 void scanIoSetComplete(IOSCANPVT piosh, io_scan_complete cb, void *arg)
 {
     piosh->cb = cb;
     piosh->arg = arg;
 }
 
-int scanOnce(struct dbCommon *precord) {
-    return scanOnceCallback(precord, NULL, NULL);
+void scanIoSetMerge(IOSCANPVT piosh, int enable)
+{
+    piosh->merge = !!enable;
 }
 
-typedef struct {
-    struct dbCommon *prec;
-    once_complete cb;
-    void *usr;
-} onceEntry;
+/* Fails while a callback of the list is queued or running */
+int scanIoSetParallel(IOSCANPVT piosh, int parts)
+{
+    epicsCallback *newParts[NUM_CALLBACK_PRIORITIES];
+    int prio, busy = 0;
 
-int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
+    if (parts < 1 || parts > MAX_IO_PARTS) {
+        errlogPrintf("scanIoSetParallel: parts must be 1 to %d\n",
+            MAX_IO_PARTS);
+        return -1;
+    }
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        io_scan_list *piosl = &piosh->iosl[prio];
+        int i;
+
+        newParts[prio] = &piosl->callback;
+        if (parts == 1)
+            continue;
+        newParts[prio] = dbCalloc(parts, sizeof(epicsCallback));
+        for (i = 0; i < parts; i++) {
+            callbackSetCallback(ioscanCallback, &newParts[prio][i]);
+            callbackSetPriority(prio, &newParts[prio][i]);
+            callbackSetUser(piosh, &newParts[prio][i]);
+        }
+    }
+
+    epicsSpinLock(piosh->lock);
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++)
+        busy |= piosh->iosl[prio].busy;
+    if (!busy) {
+        for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+            epicsCallback *old = piosh->iosl[prio].parts;
+
+            piosh->iosl[prio].parts = newParts[prio];
+            newParts[prio] = old;
+        }
+        piosh->nParts = parts;
+    }
+    epicsSpinUnlock(piosh->lock);
+
+    /* Free the arrays not in use */
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        if (newParts[prio] != &piosh->iosl[prio].callback)
+            free(newParts[prio]);
+    }
+    if (busy) {
+        errlogPrintf("scanIoSetParallel: Scan in progress, try again\n");
+        return -1;
+    }
+    return 0;
+}
+
+int scanIoSetMode(int merge, int parts)
 {
-    static int newOverflow = TRUE;
-    onceEntry ent;
-    int pushOK;
+    ioscan_head *piosh;
 
-    ent.prec = precord;
-    ent.cb = cb;
-    ent.usr = usr;
+    if (papPeriodic) {
+        fprintf(stderr, "scanIoSetMode: Scan system already initialized\n");
+        return -1;
+    }
+    if (parts < 1 || parts > MAX_IO_PARTS) {
+        fprintf(stderr, "scanIoSetMode: parts must be 1 to %d\n",
+            MAX_IO_PARTS);
+        return -1;
+    }
 
-    pushOK = epicsRingBytesPut(onceQ, (void*)&ent, sizeof(ent));
+    ioscanInit();
+    epicsMutexMustLock(ioscan_lock);
+    ioscanMerge = !!merge;
+    ioscanParts = parts;
+    for (piosh = pioscan_list; piosh; piosh = piosh->next) {
+        scanIoSetMerge(piosh, merge);
+        scanIoSetParallel(piosh, parts);
+    }
+    epicsMutexUnlock(ioscan_lock);
+    return 0;
+}
+
+int scanOnce(struct dbCommon *precord) {
+    return scanOnceCallback(precord, NULL, NULL);
+}
+
+static int pushOnce(once_queue *poq, onceEntry *pent)
+{
+    static int newOverflow = TRUE;
+    int pushOK = epicsRingBytesPut(poq->ring, (void*)pent, sizeof(*pent));
 
     if (!pushOK) {
         if (newOverflow) errlogPrintf("scanOnce: Ring buffer overflow\n");
@@ -686,22 +1100,59 @@ int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
     } else {
         newOverflow = TRUE;
     }
-    epicsEventSignal(onceSem);
+    epicsEventSignal(poq->sem);
+
+    return pushOK;
+}
+
+int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
+{
+    once_queue *poq = &onceQueues[0];
+    int *pqueued = NULL;
+    onceEntry ent;
+    int pushOK;
+
+    /* A request with a completion callback is never merged, as each
+     * caller expects its own callback.
+     */
+    if (onceCoalesce && !cb) {
+        pqueued = &dbRec2Pvt(precord)->onceQueued;
+        if (epicsAtomicCmpAndSwapIntT(pqueued, 0, 1) != 0) {
+            epicsAtomicIncrIntT(&onceCoalesced);
+            return 0;
+        }
+    }
+
+    /* Keep each lock set on one thread, so its records are processed
+     * in the order they were requested.
+     */
+    if (nOnce > 1)
+        poq = &onceQueues[dbLockGetLockId(precord) % nOnce];
+
+    ent.prec = precord;
+    ent.cb = cb;
+    ent.usr = usr;
+
+    pushOK = pushOnce(poq, &ent);
+    if (!pushOK && pqueued)
+        epicsAtomicSetIntT(pqueued, 0);
 
     return !pushOK;
 }
 
 static void onceTask(void *arg)
 {
+    once_queue *poq = (once_queue *)arg;
+
     taskwdInsert(0, NULL, NULL);
     epicsEventSignal(startStopEvent);
 
     while (TRUE) {
 
-        epicsEventMustWait(onceSem);
+        epicsEventMustWait(poq->sem);
         while(1) {
             onceEntry ent;
-            int bytes = epicsRingBytesGet(onceQ, (void*)&ent, sizeof(ent));
+            int bytes = epicsRingBytesGet(poq->ring, (void*)&ent, sizeof(ent));
             if(bytes==0)
                 break;
             if(bytes!=sizeof(ent)) {
@@ -710,6 +1161,11 @@ static void onceTask(void *arg)
                 continue; /* what to do? */
             } else if (ent.prec == (void*)&exitOnce) goto shutdown;
 
+            /* Cleared before processing, so that a request arriving
+             * while the record processes is queued again.
+             */
+            if (!ent.cb)
+                epicsAtomicSetIntT(&dbRec2Pvt(ent.prec)->onceQueued, 0);
             dbScanLock(ent.prec);
             dbProcess(ent.prec);
             dbScanUnlock(ent.prec);
@@ -729,21 +1185,60 @@ int scanOnceSetQueueSize(int size)
     return 0;
 }
 
+int scanOnceSetThreads(int count)
+{
+    if (nOnce) {
+        errlogPrintf("scanOnceSetThreads: Scan system already initialized\n");
+        return -1;
+    }
+    if (count <= 0)
+        count += epicsThreadGetCPUs();
+    if (count < 1)
+        count = 1;
+    onceThreads = count;
+    return 0;
+}
+
+int scanOnceSetCoalesce(int enable)
+{
+    if (nOnce) {
+        errlogPrintf("scanOnceSetCoalesce: Scan system already initialized\n");
+        return -1;
+    }
+    onceCoalesce = !!enable;
+    return 0;
+}
+
+static void queueStatus(once_queue *poq, scanOnceQueueStats *result)
+{
+    result->size = epicsRingBytesSize(poq->ring) / sizeof(onceEntry);
+    result->numUsed = epicsRingBytesUsedBytes(poq->ring) / sizeof(onceEntry);
+    result->maxUsed = epicsRingBytesHighWaterMark(poq->ring) / sizeof(onceEntry);
+    result->numOverflow = epicsAtomicGetIntT(&onceQOverruns);
+}
+
+/* With several threads the sizes and counts are totals */
 int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
 {
-    int ret;
-    if (!onceQ) return -1;
+    int ret, i;
+    if (!nOnce) return -1;
     if (result) {
-        result->size = epicsRingBytesSize(onceQ) / sizeof(onceEntry);
-        result->numUsed = epicsRingBytesUsedBytes(onceQ) / sizeof(onceEntry);
-        result->maxUsed = epicsRingBytesHighWaterMark(onceQ) / sizeof(onceEntry);
-        result->numOverflow = epicsAtomicGetIntT(&onceQOverruns);
+        queueStatus(&onceQueues[0], result);
+        for (i = 1; i < nOnce; i++) {
+            scanOnceQueueStats stats;
+
+            queueStatus(&onceQueues[i], &stats);
+            result->size += stats.size;
+            result->numUsed += stats.numUsed;
+            result->maxUsed += stats.maxUsed;
+        }
         ret = 0;
     } else {
         ret = -2;
     }
     if (reset) {
-        epicsRingBytesResetHighWaterMark(onceQ);
+        for (i = 0; i < nOnce; i++)
+            epicsRingBytesResetHighWaterMark(onceQueues[i].ring);
     }
     return ret;
 }
@@ -751,32 +1246,75 @@ int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
 void scanOnceQueueShow(const int reset)
 {
     scanOnceQueueStats stats;
-    if (scanOnceQueueStatus(reset, &stats) == -1) {
+    if (scanOnceQueueStatus(0, &stats) == -1) {
         fprintf(stderr, "scanOnce system not initialized, yet. Please run "
             "iocInit before using this command.\n");
     } else {
         double qusage = 100.0 * stats.numUsed / stats.size;
+        int i;
+
         printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS\n");
         printf("%8s  %15d  %10d  %6d  %6.1f  %11d\n", "scanOnce", stats.maxUsed,
                stats.numUsed, stats.size, qusage,
                epicsAtomicGetIntT(&onceQOverruns));
+        for (i = 0; nOnce > 1 && i < nOnce; i++) {
+            char name[24];
+
+            queueStatus(&onceQueues[i], &stats);
+            sprintf(name, "thread %d", i);
+            printf("%16s  %7d  %10d  %6d  %6.1f\n", name, stats.maxUsed,
+                   stats.numUsed, stats.size,
+                   100.0 * stats.numUsed / stats.size);
+        }
+        if (onceCoalesce)
+            printf("Coalesced requests: %d\n",
+                   epicsAtomicGetIntT(&onceCoalesced));
+        if (reset)
+            scanOnceQueueStatus(reset, NULL);
     }
 }
 
 static void initOnce(void)
 {
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i;
+
     opts.joinable = 1;
     opts.priority = epicsThreadPriorityScanLow + nPeriodic;
     opts.stackSize = epicsThreadStackBig;
-    if ((onceQ = epicsRingBytesLockedCreate(sizeof(onceEntry)*onceQueueSize)) == NULL) {
-        cantProceed("initOnce: Ring buffer create failed\n");
+
+    onceQueues = dbCalloc(onceThreads, sizeof(once_queue));
+    for (i = 0; i < onceThreads; i++) {
+        once_queue *poq = &onceQueues[i];
+        char taskName[24];
+
+        poq->ring = epicsRingBytesLockedCreate(sizeof(onceEntry)*onceQueueSize);
+        if (!poq->ring)
+            cantProceed("initOnce: Ring buffer create failed\n");
+        poq->sem = epicsEventMustCreate(epicsEventEmpty);
+        if (onceThreads > 1)
+            sprintf(taskName, "scanOnce-%d", i);
+        else
+            strcpy(taskName, "scanOnce");
+        poq->tid = epicsThreadCreateOpt(taskName, onceTask, poq, &opts);
+
+        epicsEventWait(startStopEvent);
     }
-    if(!onceSem)
-        onceSem = epicsEventMustCreate(epicsEventEmpty);
-    onceTaskId = epicsThreadCreateOpt("scanOnce", onceTask, 0, &opts);
+    epicsAtomicSetIntT(&onceCoalesced, 0);
+    nOnce = onceThreads;
+}
 
-    epicsEventWait(startStopEvent);
+static void deleteOnce(void)
+{
+    int i;
+
+    for (i = 0; i < nOnce; i++) {
+        epicsRingBytesDelete(onceQueues[i].ring);
+        epicsEventDestroy(onceQueues[i].sem);
+    }
+    free(onceQueues);
+    onceQueues = NULL;
+    nOnce = 0;
 }
 
 static void periodicTask(void *arg)
@@ -791,17 +1329,47 @@ static void periodicTask(void *arg)
     const double penalty = (ppsl->period >= 2) ? 1 : (ppsl->period / 2);
 
     taskwdInsert(0, NULL, NULL);
+
+    if (ppsl->nWorkers > 1) {
+        epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+        char taskName[40];
+        int i;
+
+        opts.joinable = 1;
+        opts.priority = epicsThreadGetPrioritySelf();
+        opts.stackSize = epicsThreadStackBig;
+        for (i = 1; i < ppsl->nWorkers; i++) {
+            scan_worker *pw = &ppsl->workers[i];
+
+            sprintf(taskName, "scan-%g-%d", ppsl->period, i);
+            pw->tid = epicsThreadCreateOpt(taskName, periodicWorker, pw,
+                &opts);
+        }
+    }
     epicsEventSignal(startStopEvent);
 
     epicsTimeGetMonotonic(&next);
     reported = next;
+    ppsl->statsStart = next;
 
     while (ppsl->scanCtl != ctlExit) {
         double delay;
         epicsTimeStamp now;
 
-        if (ppsl->scanCtl == ctlRun)
-            scanList(&ppsl->scan_list);
+        if (ppsl->scanCtl == ctlRun) {
+            if (ppsl->workers) {
+                scanSnapshot(ppsl, &next);
+            }
+            else {
+                epicsTimeStamp start;
+
+                epicsTimeGetMonotonic(&start);
+                addLatency(ppsl, epicsTimeDiffInSeconds(&start, &next));
+                scanList(&ppsl->scan_list);
+                epicsTimeGetMonotonic(&now);
+                ppsl->busyTotal += epicsTimeDiffInSeconds(&now, &start);
+            }
+        }
 
         epicsTimeAddSeconds(&next, ppsl->period);
         epicsTimeGetMonotonic(&now);
@@ -846,15 +1414,240 @@ static void periodicTask(void *arg)
         epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
     }
 
+    if (ppsl->nWorkers > 1) {
+        int i;
+
+        ppsl->stopWorkers = TRUE;
+        for (i = 1; i < ppsl->nWorkers; i++)
+            epicsEventMustTrigger(ppsl->workers[i].startEvent);
+        for (i = 1; i < ppsl->nWorkers; i++)
+            epicsThreadMustJoin(ppsl->workers[i].tid);
+    }
+
     taskwdRemove(0);
     epicsEventSignal(startStopEvent);
 }
 
+static void addLatency(periodic_scan_list *ppsl, double latency)
+{
+    double limit = 10e-6;
+    int i;
+
+    for (i = 0; i < NUM_LATENCY_BUCKETS - 1 && latency >= limit; i++)
+        limit *= 10;
+    ppsl->latency[i]++;
+    if (latency > ppsl->latencyMax)
+        ppsl->latencyMax = latency;
+}
+
+/* Index into a worker's share where a slice begins. When spreading by
+ * phase the boundary moves forward so no PHAS group is split.
+ */
+static int sliceStart(scan_worker *pw, int slice)
+{
+    periodic_scan_list *ppsl = pw->ppsl;
+    struct dbCommon **pprec = &ppsl->records[pw->first];
+    int i = (int)((double)pw->count * slice / ppsl->nSlices);
+
+    if (ppsl->byPhase) {
+        while (i > 0 && i < pw->count && pprec[i]->phas == pprec[i-1]->phas)
+            i++;
+    }
+    return i;
+}
+
+/* Process one slice of one worker's share of a periodic scan list.
+ * A record whose SCAN changed after the snapshot was taken is skipped;
+ * SCAN is only changed with the record locked.
+ */
+static void scanShare(scan_worker *pw)
+{
+    periodic_scan_list *ppsl = pw->ppsl;
+    struct dbCommon **pprec = &ppsl->records[pw->first];
+    int end = sliceStart(pw, pw->slice + 1);
+    epicsTimeStamp start, stop;
+    int i;
+
+    epicsTimeGetMonotonic(&start);
+    for (i = sliceStart(pw, pw->slice); i < end; i++) {
+        struct dbCommon *precord = pprec[i];
+        scan_element *pse;
+
+        dbScanLock(precord);
+        pse = precord->spvt;
+        if (pse && pse->pscan_list == &ppsl->scan_list)
+            dbProcess(precord);
+        dbScanUnlock(precord);
+    }
+    epicsTimeGetMonotonic(&stop);
+
+    pw->busyNow += epicsTimeDiffInSeconds(&stop, &start);
+}
+
+static void periodicWorker(void *arg)
+{
+    scan_worker *pw = (scan_worker *)arg;
+    periodic_scan_list *ppsl = pw->ppsl;
+
+    taskwdInsert(0, NULL, NULL);
+
+    while (TRUE) {
+        epicsEventMustWait(pw->startEvent);
+        if (ppsl->stopWorkers)
+            break;
+
+        scanShare(pw);
+        if (epicsAtomicDecrIntT(&ppsl->pending) == 0)
+            epicsEventMustTrigger(ppsl->doneEvent);
+    }
+
+    taskwdRemove(0);
+}
+
+typedef struct lockset_member {
+    unsigned long id;
+    int index;
+} lockset_member;
+
+static int lockset_member_cmp(const void *pa, const void *pb)
+{
+    const lockset_member *a = pa, *b = pb;
+
+    if (a->id != b->id)
+        return a->id < b->id ? -1 : 1;
+    return a->index - b->index;
+}
+
+/* Take a snapshot of the scan list and divide it between the workers.
+ * All records of a lockset go to the same worker, which processes them
+ * in scan list order; each lockset is given to the least loaded worker.
+ */
+static void partitionList(periodic_scan_list *ppsl)
+{
+    scan_list *psl = &ppsl->scan_list;
+    struct dbCommon **precords;
+    lockset_member *members;
+    int *owner;
+    scan_element *pse;
+    int i, n, w;
+
+    epicsMutexMustLock(psl->lock);
+    psl->modified = FALSE;
+    ppsl->recomputed = dbLockRecomputeCount();
+    n = ellCount(&psl->list);
+    precords = dbCalloc(n + 1, sizeof(struct dbCommon *));
+    members = dbCalloc(n + 1, sizeof(lockset_member));
+    owner = dbCalloc(n + 1, sizeof(int));
+    for (i = 0, pse = (scan_element *)ellFirst(&psl->list);
+         pse; i++, pse = (scan_element *)ellNext(&pse->node)) {
+        precords[i] = pse->precord;
+        members[i].id = dbLockGetLockId(pse->precord);
+        members[i].index = i;
+    }
+    epicsMutexUnlock(psl->lock);
+
+    for (w = 0; w < ppsl->nWorkers; w++)
+        ppsl->workers[w].count = 0;
+
+    qsort(members, n, sizeof(lockset_member), lockset_member_cmp);
+    for (i = 0; i < n; ) {
+        int j, least = 0;
+
+        for (w = 1; w < ppsl->nWorkers; w++) {
+            if (ppsl->workers[w].count < ppsl->workers[least].count)
+                least = w;
+        }
+        for (j = i; j < n && members[j].id == members[i].id; j++)
+            owner[members[j].index] = least;
+        ppsl->workers[least].count += j - i;
+        i = j;
+    }
+
+    /* Group the snapshot by worker, keeping scan list order */
+    free(ppsl->records);
+    ppsl->records = dbCalloc(n + 1, sizeof(struct dbCommon *));
+    for (w = 0, i = 0; w < ppsl->nWorkers; w++) {
+        ppsl->workers[w].first = i;
+        i += ppsl->workers[w].count;
+        ppsl->workers[w].count = 0;
+    }
+    for (i = 0; i < n; i++) {
+        scan_worker *pw = &ppsl->workers[owner[i]];
+
+        ppsl->records[pw->first + pw->count++] = precords[i];
+    }
+    ppsl->nRecords = n;
+    ppsl->partitioned = TRUE;
+
+    free(owner);
+    free(members);
+    free(precords);
+}
+
+/* Process a periodic scan list from its snapshot, one slice at a time.
+ * Slices are started at even intervals through the period, and each
+ * one is shared between the workers.
+ */
+static void scanSnapshot(periodic_scan_list *ppsl,
+    const epicsTimeStamp *periodStart)
+{
+    int modified, slice, i;
+
+    epicsMutexMustLock(ppsl->scan_list.lock);
+    modified = ppsl->scan_list.modified;
+    epicsMutexUnlock(ppsl->scan_list.lock);
+    if (modified || !ppsl->partitioned ||
+        ppsl->recomputed != dbLockRecomputeCount())
+        partitionList(ppsl);
+
+    for (slice = 0; slice < ppsl->nSlices; slice++) {
+        epicsTimeStamp due = *periodStart, start, stop;
+        double delay;
+
+        epicsTimeAddSeconds(&due, ppsl->period * slice / ppsl->nSlices);
+        epicsTimeGetMonotonic(&start);
+        delay = epicsTimeDiffInSeconds(&due, &start);
+        if (delay > 0.0) {
+            epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
+            if (ppsl->scanCtl != ctlRun)
+                break;
+            epicsTimeGetMonotonic(&start);
+        }
+        addLatency(ppsl, epicsTimeDiffInSeconds(&start, &due));
+
+        for (i = 0; i < ppsl->nWorkers; i++)
+            ppsl->workers[i].slice = slice;
+        if (ppsl->nWorkers > 1) {
+            epicsAtomicSetIntT(&ppsl->pending, ppsl->nWorkers - 1);
+            for (i = 1; i < ppsl->nWorkers; i++)
+                epicsEventMustTrigger(ppsl->workers[i].startEvent);
+        }
+        scanShare(&ppsl->workers[0]);
+        if (ppsl->nWorkers > 1)
+            epicsEventMustWait(ppsl->doneEvent);
+
+        epicsTimeGetMonotonic(&stop);
+        ppsl->busyTotal += epicsTimeDiffInSeconds(&stop, &start);
+    }
+
+    for (i = 0; i < ppsl->nWorkers; i++) {
+        scan_worker *pw = &ppsl->workers[i];
+
+        pw->busy = pw->busyNow;
+        pw->busyNow = 0.0;
+        if (pw->busy > pw->busyMax)
+            pw->busyMax = pw->busy;
+        if (pw->busy > ppsl->period)
+            pw->overruns++;
+    }
+}
+
 
 static void initPeriodic(void)
 {
     dbMenu *pmenu = dbFindMenu(pdbbase, "menuScan");
     double quantum = epicsThreadSleepQuantum();
+    periodic_config *pcfg;
     int i;
 
     if (!pmenu) {
@@ -905,6 +1698,38 @@ static void initPeriodic(void)
         ppsl->scanCtl = ctlPause;
         ppsl->loopEvent = epicsEventMustCreate(epicsEventEmpty);
 
+        ppsl->nWorkers = 1;
+        ppsl->nSlices = 1;
+        for (pcfg = (periodic_config *)ellFirst(&periodicConfig); pcfg;
+             pcfg = (periodic_config *)ellNext(&pcfg->node)) {
+            if (pcfg->period != 0.0 &&
+                fabs(pcfg->period - ppsl->period) >= 1e-6 * ppsl->period)
+                continue;
+            if (pcfg->threads)
+                ppsl->nWorkers = pcfg->threads;
+            if (pcfg->slices >= 0) {
+                ppsl->nSlices = pcfg->slices;
+                ppsl->byPhase = pcfg->byPhase;
+            }
+        }
+        if (ppsl->nSlices == 0) {
+            /* Automatic, each slice at least a few sleep quanta long */
+            number = ppsl->period / (4 * quantum);
+            ppsl->nSlices = number < 1 ? 1 :
+                number > MAX_SLICES ? MAX_SLICES : (int)number;
+        }
+        if (ppsl->nWorkers > 1 || ppsl->nSlices > 1) {
+            int j;
+
+            ppsl->workers = dbCalloc(ppsl->nWorkers, sizeof(scan_worker));
+            for (j = 0; j < ppsl->nWorkers; j++) {
+                ppsl->workers[j].ppsl = ppsl;
+                ppsl->workers[j].startEvent =
+                    epicsEventMustCreate(epicsEventEmpty);
+            }
+            ppsl->doneEvent = epicsEventMustCreate(epicsEventEmpty);
+        }
+
         number = ppsl->period / quantum;
         if ((ppsl->period < 2 * quantum) ||
             (number / floor(number) > 1.1)) {
@@ -925,6 +1750,15 @@ static void deletePeriodic(void)
 
         if (!ppsl) continue;
         ellFree(&ppsl->scan_list.list);
+        if (ppsl->workers) {
+            int j;
+
+            for (j = 0; j < ppsl->nWorkers; j++)
+                epicsEventDestroy(ppsl->workers[j].startEvent);
+            epicsEventDestroy(ppsl->doneEvent);
+            free(ppsl->workers);
+            free(ppsl->records);
+        }
         epicsEventDestroy(ppsl->loopEvent);
         epicsMutexDestroy(ppsl->scan_list.lock);
         free(ppsl);
@@ -952,19 +1786,43 @@ static void spawnPeriodic(int ind)
     epicsEventWait(startStopEvent);
 }
 
+/* Process one part of an I/O Intr scan. Part 0 marks the start of the
+ * scan, so a request arriving after this is not merged with it.
+ * The completion callback is called after each scan of a list that is
+ * not split, else when no part of the scan is left, which may also queue
+ * the next scan.
+ */
 static void ioscanCallback(epicsCallback *pcallback)
 {
     ioscan_head *piosh;
-    int prio;
+    io_scan_list *piosl;
+    int prio, part, nParts, done;
 
     callbackGetUser(piosh, pcallback);
     callbackGetPriority(prio, pcallback);
-    scanList(&piosh->iosl[prio].scan_list);
-    if (piosh->cb)
+    piosl = &piosh->iosl[prio];
+
+    epicsSpinLock(piosh->lock);
+    nParts = piosh->nParts;
+    part = (int)(pcallback - piosl->parts);
+    if (part == 0)
+        scanStarted(piosl);
+    epicsSpinUnlock(piosh->lock);
+
+    scanListPart(&piosl->scan_list, nParts, part);
+
+    epicsSpinLock(piosh->lock);
+    done = --piosl->busy == 0 || nParts == 1;
+    epicsSpinUnlock(piosh->lock);
+
+    if (done && nParts > 1)
+        launchScans(piosh, piosl);
+    if (done && piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
 }
 
-static void printList(scan_list *psl, char *message)
+/* Returns FALSE if the list is empty */
+static int printList(scan_list *psl, char *message)
 {
     scan_element *pse;
 
@@ -973,7 +1831,7 @@ static void printList(scan_list *psl, char *message)
     epicsMutexUnlock(psl->lock);
 
     if (!pse)
-        return;
+        return FALSE;
 
     printf("%s\n", message);
     while (pse) {
@@ -982,25 +1840,36 @@ static void printList(scan_list *psl, char *message)
         if (pse->pscan_list != psl) {
             epicsMutexUnlock(psl->lock);
             printf("    Scan list changed while printing, try again.\n");
-            return;
+            return TRUE;
         }
         pse = (scan_element *)ellNext(&pse->node);
         epicsMutexUnlock(psl->lock);
     }
+    return TRUE;
 }
 
 static void scanList(scan_list *psl)
+{
+    scanListPart(psl, 1, 0);
+}
+
+/* Process the records of a list whose lock set id modulo nParts is part.
+ * Each part has its own bit in psl->modified, so parts can scan the
+ * list at the same time.
+ */
+static void scanListPart(scan_list *psl, int nParts, int part)
 {
     /* When reading this code remember that the call to dbProcess can result
      * in the SCAN field being changed in an arbitrary number of records.
      */
 
+    unsigned mask = nParts > 1 ? 1u << part : ~0u;
     scan_element *pse;
     scan_element *prev = NULL;
     scan_element *next = NULL;
 
     epicsMutexMustLock(psl->lock);
-    psl->modified = FALSE;
+    psl->modified &= ~mask;
     pse = (scan_element *)ellFirst(&psl->list);
     if (pse) next = (scan_element *)ellNext(&pse->node);
     epicsMutexUnlock(psl->lock);
@@ -1008,12 +1877,14 @@ static void scanList(scan_list *psl)
     while (pse) {
         struct dbCommon *precord = pse->precord;
 
-        dbScanLock(precord);
-        dbProcess(precord);
-        dbScanUnlock(precord);
+        if (nParts <= 1 || dbLockGetLockId(precord) % nParts == part) {
+            dbScanLock(precord);
+            dbProcess(precord);
+            dbScanUnlock(precord);
+        }
 
         epicsMutexMustLock(psl->lock);
-        if (!psl->modified) {
+        if (!(psl->modified & mask)) {
             prev = pse;
             pse = (scan_element *)ellNext(&pse->node);
             if (pse) next = (scan_element *)ellNext(&pse->node);
@@ -1022,7 +1893,7 @@ static void scanList(scan_list *psl)
             prev = pse;
             pse = (scan_element *)ellNext(&pse->node);
             if (pse) next = (scan_element *)ellNext(&pse->node);
-            psl->modified = FALSE;
+            psl->modified &= ~mask;
         } else if (prev && prev->pscan_list == psl) {
             /*Previous scan element is still in same scan list*/
             pse = (scan_element *)ellNext(&prev->node);
@@ -1030,13 +1901,13 @@ static void scanList(scan_list *psl)
                 prev = (scan_element *)ellPrevious(&pse->node);
                 next = (scan_element *)ellNext(&pse->node);
             }
-            psl->modified = FALSE;
+            psl->modified &= ~mask;
         } else if (next && next->pscan_list == psl) {
             /*Next scan element is still in same scan list*/
             pse = next;
             prev = (scan_element *)ellPrevious(&pse->node);
             next = (scan_element *)ellNext(&pse->node);
-            psl->modified = FALSE;
+            psl->modified &= ~mask;
         } else {
             /*Too many changes. Just wait till next period*/
             epicsMutexUnlock(psl->lock);
@@ -1087,7 +1958,7 @@ static void addToList(struct dbCommon *precord, scan_list *psl)
         ptemp = (scan_element *)ellPrevious(&ptemp->node);
     }
     ellInsert(&psl->list, (ptemp ? &ptemp->node : NULL), &pse->node);
-    psl->modified = TRUE;
+    psl->modified = ~0u;
     epicsMutexUnlock(psl->lock);
 }
 
@@ -1113,6 +1984,6 @@ static void deleteFromList(struct dbCommon *precord, scan_list *psl)
     }
     pse->pscan_list = NULL;
     ellDelete(&psl->list, &pse->node);
-    psl->modified = TRUE;
+    psl->modified = ~0u;
     epicsMutexUnlock(psl->lock);
 }
@@ -67,6 +67,14 @@ DBCORE_API int scanOnceCallback(struct dbCommon *, once_complete cb, void *usr);
 DBCORE_API int scanOnceSetQueueSize(int size);
 DBCORE_API int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result);
 DBCORE_API void scanOnceQueueShow(const int reset);
+/*configure scanOnce threads and merging of repeated requests, before iocInit*/
+DBCORE_API int scanOnceSetThreads(int count);
+DBCORE_API int scanOnceSetCoalesce(int enable);
+
+/*configure parallel processing of periodic lists, before iocInit*/
+DBCORE_API int scanPeriodicThreads(int count, double period);
+/*spread periodic list processing over the period, before iocInit*/
+DBCORE_API int scanPeriodicSpread(int slices, double period, int byPhase);
 
 /*print periodic lists*/
 DBCORE_API int scanppl(double rate);
@@ -81,6 +89,13 @@ DBCORE_API void scanIoInit(IOSCANPVT *ppios);
 DBCORE_API unsigned int scanIoRequest(IOSCANPVT pios);
 DBCORE_API unsigned int scanIoImmediate(IOSCANPVT pios, int prio);
 DBCORE_API void scanIoSetComplete(IOSCANPVT, io_scan_complete, void *usr);
+/*merge requests with a scan not started yet*/
+DBCORE_API void scanIoSetMerge(IOSCANPVT, int enable);
+/*split each scan by lock set into callbacks which may run in parallel,
+ *fails while a scan of the source is queued or running*/
+DBCORE_API int scanIoSetParallel(IOSCANPVT, int parts);
+/*set the above for all I/O Intr sources, before iocInit*/
+DBCORE_API int scanIoSetMode(int merge, int parts);
 
 #ifdef __cplusplus
 }
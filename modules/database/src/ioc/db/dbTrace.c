@@ -0,0 +1,287 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Event tracer, see dbTrace.h
+ *
+ * Each thread gets its own ring the first time it records an event while
+ * tracing is on. The owner is the only writer: it fills the slot and then
+ * publishes it by advancing head after a write barrier. Rings are kept
+ * for the life of the IOC so that threads which have exited can still be
+ * dumped.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "ellLib.h"
+#include "epicsAtomic.h"
+#include "epicsMutex.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "errlog.h"
+
+#include "dbAccessDefs.h"
+#include "dbAddr.h"
+#include "dbCommonPvt.h"
+#include "dbTrace.h"
+
+#define DEFAULT_RING_SIZE 8192
+
+typedef struct traceEvent {
+    epicsUInt64 time;
+    const void *ptr;
+    epicsUInt32 value;
+    epicsUInt16 type;
+    char phase;
+} traceEvent;
+
+typedef struct traceRing {
+    ELLNODE node;
+    int index;
+    char name[32];
+    unsigned mask;              /* size - 1 */
+    size_t head;                /* events ever written */
+    size_t start;               /* first event not cleared */
+    traceEvent *events;
+} traceRing;
+
+int dbTraceMode = dbTraceOff;
+
+static epicsThreadOnceId traceOnceId = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId myRing;
+static epicsMutexId ringLock;
+static ELLLIST rings = ELLLIST_INIT;   /* guarded by ringLock */
+static unsigned ringSize = DEFAULT_RING_SIZE;
+
+static const struct {
+    const char *category;
+    const char *name;           /* NULL to use the record name */
+    const char *valueName;
+} typeInfo[] = {
+    {"process",  NULL,       NULL},
+    {"lock",     NULL,       NULL},
+    {"callback", "request",  "priority"},
+    {"callback", "callback", "priority"},
+    {"post",     NULL,       "mask"},
+    {"ca",       NULL,       "count"},
+    {"rsrv",     "send",     "bytes"},
+};
+
+static void traceOnce(void *junk)
+{
+    myRing = epicsThreadPrivateCreate();
+    ringLock = epicsMutexMustCreate();
+}
+
+static traceRing * createRing(void)
+{
+    traceRing *pring = calloc(1, sizeof(traceRing));
+
+    if (!pring)
+        return NULL;
+    epicsMutexMustLock(ringLock);
+    pring->mask = ringSize - 1;
+    pring->events = calloc(ringSize, sizeof(traceEvent));
+    if (!pring->events) {
+        epicsMutexUnlock(ringLock);
+        free(pring);
+        return NULL;
+    }
+    pring->index = ellCount(&rings) + 1;
+    strncpy(pring->name, epicsThreadGetNameSelf(), sizeof(pring->name) - 1);
+    ellAdd(&rings, &pring->node);
+    epicsMutexUnlock(ringLock);
+
+    epicsThreadPrivateSet(myRing, pring);
+    return pring;
+}
+
+void dbTraceEvent(dbTraceType type, char phase, const void *ptr,
+    unsigned value)
+{
+    traceRing *pring;
+    traceEvent *pev;
+
+    if (dbTraceMode == dbTraceOff)
+        return;
+    /* dbTraceMode may have been set without calling dbTraceEnable() */
+    epicsThreadOnce(&traceOnceId, traceOnce, NULL);
+    pring = epicsThreadPrivateGet(myRing);
+    if (!pring && !(pring = createRing()))
+        return;
+
+    pev = &pring->events[pring->head & pring->mask];
+    pev->time = epicsMonotonicGet();
+    pev->ptr = ptr;
+    pev->value = value;
+    pev->type = type;
+    pev->phase = phase;
+    epicsAtomicWriteMemoryBarrier();
+    pring->head++;
+}
+
+void dbTraceRecordEvent(dbTraceType type, char phase, dbCommon *prec,
+    unsigned value)
+{
+    if (dbTraceMode == dbTraceAll ||
+        (dbTraceMode == dbTraceSelected && dbRec2Pvt(prec)->trace))
+        dbTraceEvent(type, phase, prec, value);
+}
+
+void dbTraceEnable(int mode)
+{
+    if (mode < dbTraceOff || mode > dbTraceAll) {
+        errlogPrintf("dbTraceEnable: mode must be 0 (off), "
+            "1 (selected records) or 2 (all records)\n");
+        return;
+    }
+    epicsThreadOnce(&traceOnceId, traceOnce, NULL);
+    dbTraceMode = mode;
+}
+
+long dbTraceRecord(const char *name, int on)
+{
+    DBADDR addr;
+    long status;
+
+    if (!name || !*name) {
+        printf("Usage: dbTraceRecord \"record name\", 1|0\n");
+        return S_db_notFound;
+    }
+    status = dbNameToAddr(name, &addr);
+    if (status) {
+        printf("Record '%s' not found\n", name);
+        return status;
+    }
+    dbRec2Pvt(addr.precord)->trace = !!on;
+    return 0;
+}
+
+void dbTraceSetSize(unsigned nEvents)
+{
+    unsigned size = 16;
+
+    while (size < nEvents && size < 0x10000000u)
+        size <<= 1;
+    epicsThreadOnce(&traceOnceId, traceOnce, NULL);
+    epicsMutexMustLock(ringLock);
+    ringSize = size;
+    epicsMutexUnlock(ringLock);
+}
+
+void dbTraceClear(void)
+{
+    traceRing *pring;
+
+    epicsThreadOnce(&traceOnceId, traceOnce, NULL);
+    epicsMutexMustLock(ringLock);
+    for (pring = (traceRing *)ellFirst(&rings); pring;
+         pring = (traceRing *)ellNext(&pring->node))
+        pring->start = epicsAtomicGetSizeT(&pring->head);
+    epicsMutexUnlock(ringLock);
+}
+
+static void printString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', fp);
+        if ((unsigned char)*str >= ' ')
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+static void dumpRing(FILE *fp, traceRing *pring, int *pfirst)
+{
+    size_t head = epicsAtomicGetSizeT(&pring->head);
+    size_t first = pring->start;
+    int depth = 0;
+    size_t i;
+
+    epicsAtomicReadMemoryBarrier();
+    if (head - first > (size_t)pring->mask + 1)
+        first = head - pring->mask - 1;
+
+    fprintf(fp, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+        "\"tid\":%d,\"args\":{\"name\":", *pfirst ? "" : ",", pring->index);
+    printString(fp, pring->name);
+    fprintf(fp, "}}");
+    *pfirst = 0;
+
+    for (i = first; i < head; i++) {
+        const traceEvent *pev = &pring->events[i & pring->mask];
+        unsigned type = pev->type;
+
+        if (type >= NELEMENTS(typeInfo))
+            continue;
+        /* Spans that began before the oldest event kept can't be shown */
+        if (pev->phase == 'B')
+            depth++;
+        else if (pev->phase == 'E' && depth-- <= 0) {
+            depth = 0;
+            continue;
+        }
+
+        fprintf(fp, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+            "\"cat\":\"%s\",\"name\":", pev->phase, pring->index,
+            pev->time * 1e-3, typeInfo[type].category);
+        if (typeInfo[type].name)
+            printString(fp, typeInfo[type].name);
+        else
+            printString(fp, ((const dbCommon *)pev->ptr)->name);
+        if (pev->phase == 'i')
+            fprintf(fp, ",\"s\":\"t\"");
+        if (pev->phase != 'E') {
+            fprintf(fp, ",\"args\":{");
+            if (typeInfo[type].valueName)
+                fprintf(fp, "\"%s\":%u%s", typeInfo[type].valueName,
+                    (unsigned)pev->value, typeInfo[type].name ? "," : "");
+            if (typeInfo[type].name)
+                fprintf(fp, "\"ptr\":\"%p\"", pev->ptr);
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}");
+    }
+}
+
+long dbTraceDump(const char *filename)
+{
+    FILE *fp = stdout;
+    traceRing *pring;
+    int first = 1;
+    long status = 0;
+
+    if (filename && *filename) {
+        fp = fopen(filename, "w");
+        if (!fp) {
+            errlogPrintf("dbTraceDump: Can't open '%s'\n", filename);
+            return -1;
+        }
+    }
+
+    epicsThreadOnce(&traceOnceId, traceOnce, NULL);
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    epicsMutexMustLock(ringLock);
+    for (pring = (traceRing *)ellFirst(&rings); pring;
+         pring = (traceRing *)ellNext(&pring->node))
+        dumpRing(fp, pring, &first);
+    epicsMutexUnlock(ringLock);
+    fprintf(fp, "\n]}\n");
+
+    if (fp != stdout) {
+        if (ferror(fp))
+            status = -1;
+        if (fclose(fp))
+            status = -1;
+        if (status)
+            errlogPrintf("dbTraceDump: Error writing '%s'\n", filename);
+    }
+    return status;
+}
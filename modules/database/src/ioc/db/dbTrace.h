@@ -0,0 +1,119 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#ifndef INCdbTraceH
+#define INCdbTraceH
+
+#include "dbCoreAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file dbTrace.h
+ * @brief Event tracer for record processing chains
+ *
+ * While enabled, the IOC records compact timestamped events into a ring
+ * buffer owned by each thread. Only the owning thread writes to its ring,
+ * so recording an event takes no locks. The rings can be written out in
+ * the Chrome trace event JSON format, which chrome://tracing and Perfetto
+ * can display as a timeline per thread.
+ *
+ * Events are recorded when records are processed, when a thread waits
+ * for a record's lock set, when callbacks are requested and run, when
+ * monitors are posted, when CA links receive updates and when the CA
+ * server sends to a client.
+ */
+
+struct dbCommon;
+
+/** @brief What is traced. */
+typedef enum {
+    dbTraceOff,         /**< @brief Nothing */
+    dbTraceSelected,    /**< @brief Records selected by dbTraceRecord() */
+    dbTraceAll          /**< @brief Every record */
+} dbTraceModes;
+
+/** @brief Kinds of trace event. */
+typedef enum {
+    dbTraceProcess,         /**< @brief Record process routine */
+    dbTraceLock,            /**< @brief Waiting for a record's lock set */
+    dbTraceCallbackRequest, /**< @brief callbackRequest() */
+    dbTraceCallback,        /**< @brief Callback routine running */
+    dbTracePost,            /**< @brief db_post_events() with monitors */
+    dbTraceCaUpdate,        /**< @brief CA link received an update */
+    dbTraceSend             /**< @brief CA server sending to a client */
+} dbTraceType;
+
+/** @brief The current dbTraceModes value.
+ *
+ * Read only, call dbTraceEnable() to change it.
+ */
+DBCORE_API extern int dbTraceMode;
+
+/** @brief Record an event not tied to a record.
+ *
+ * Callers should test dbTraceMode first, so that tracing costs nothing
+ * more than that test while it is off.
+ *
+ * @param type The kind of event.
+ * @param phase 'B' to begin a span, 'E' to end it, 'i' for an instant.
+ * @param ptr The object concerned, e.g. a callback routine.
+ * @param value A number shown with the event.
+ */
+DBCORE_API void dbTraceEvent(dbTraceType type, char phase, const void *ptr,
+    unsigned value);
+
+/** @brief Record an event for a record, if that record is traced. */
+DBCORE_API void dbTraceRecordEvent(dbTraceType type, char phase,
+    struct dbCommon *prec, unsigned value);
+
+/** @brief Select what to trace, one of dbTraceModes.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API void dbTraceEnable(int mode);
+
+/** @brief Select or deselect one record for dbTraceSelected mode.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ *
+ * @return 0, or an error status if the record does not exist.
+ */
+DBCORE_API long dbTraceRecord(const char *name, int on);
+
+/** @brief Set the number of events each thread's ring holds.
+ *
+ * Only affects threads that have not recorded events yet. The size is
+ * rounded up to a power of two.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API void dbTraceSetSize(unsigned nEvents);
+
+/** @brief Discard the events recorded so far.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+DBCORE_API void dbTraceClear(void);
+
+/** @brief Write the recorded events as Chrome trace JSON.
+ *
+ * Events recorded while the dump runs may be missing or overwritten;
+ * turn tracing off first for a consistent view.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ *
+ * @param filename The file to write, or NULL or "" for stdout.
+ * @return 0, or -1 if the file could not be written.
+ */
+DBCORE_API long dbTraceDump(const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdbTraceH */
@@ -154,7 +154,7 @@ int dbChannel_get_count(
     * in the dbAccess.c dbGet() and getOptions() routines.
     */
 
-    dbScanLock(dbChannelRecord(chan));
+    dbScanLockShared(dbChannelRecord(chan));
 
     switch(buffer_type) {
     case(oldDBR_STRING):
@@ -798,7 +798,7 @@ int dbChannel_get_count(
         break;
     }
 
-    dbScanUnlock(dbChannelRecord(chan));
+    dbScanUnlockShared(dbChannelRecord(chan));
 
     if (status) return -1;
     return 0;
@@ -35,12 +35,14 @@
 #include "dbAddr.h"
 #include "dbBase.h"
 #include "dbCommon.h"
+#include "dbCommonPvt.h"
 #include "menuSimm.h"
 #include "dbEvent.h"
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbLink.h"
 #include "dbNotify.h"
+#include "dbProfile.h"
 #include "dbScan.h"
 #include "devSup.h"
 #include "link.h"
@@ -283,6 +285,8 @@ void recGblFwdLink(void *precord)
 {
     dbCommon *pdbc = precord;
 
+    if (dbProfiling)
+        dbProfileAsyncDone(pdbc);
     dbScanFwdLink(&pdbc->flnk);
     /*Handle dbPutFieldNotify record completions*/
     if(pdbc->ppn) dbNotifyCompletion(pdbc);
@@ -70,11 +70,20 @@ typedef struct brkInt{ /* breakpoint interval */
     double          eng;            /*converted value for beginning of interval*/
 }brkInt;
 
+typedef struct brkIndex { /* uniform grid over the raw or eng values */
+    double          low;            /*lowest value in the table             */
+    double          scale;          /*grid cells per unit value             */
+    long            ncells;         /*number of grid cells                  */
+    short           *pcell;         /*first interval reaching each cell     */
+}brkIndex;
+
 typedef struct brkTable { /* breakpoint table */
     ELLNODE         node;
     char            *name;          /*breakpoint table name                 */
     long            number;         /*number of brkInt in this table        */
     struct brkInt   *paBrkInt;      /* ptr to array of brkInts              */
+    struct brkIndex *prawIndex;     /*NULL unless the table is monotonic    */
+    struct brkIndex *pengIndex;     /*NULL unless the table is monotonic    */
 }brkTable;
 
 typedef struct dbFldDes{  /* field description */
@@ -167,6 +176,7 @@ typedef struct dbRecordType {
     /*The following are only available on run time system*/
     rset            *prset;
     int             rec_size;       /*record size in bytes          */
+    struct dbRecordSlabs *slabs;    /*record instance storage, see dbStaticRun.c*/
 }dbRecordType;
 
 struct dbPvd;           /* Contents private to dbPvdLib code */
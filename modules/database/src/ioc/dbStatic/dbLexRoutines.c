@@ -14,6 +14,7 @@
 
 #include <ctype.h>
 #include <epicsStdlib.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -21,8 +22,11 @@
 #include "dbDefs.h"
 #include "dbmf.h"
 #include "ellLib.h"
+#include "epicsEvent.h"
 #include "epicsPrint.h"
 #include "epicsString.h"
+#include "epicsThread.h"
+#include "epicsThreadPool.h"
 #include "errMdef.h"
 #include "freeList.h"
 #include "gpHash.h"
@@ -97,15 +101,24 @@ static void dbRecordBody(void);
 
 /*private declarations*/
 #define MY_BUFFER_SIZE 1024
+#define READ_CHUNK 65536
 static char *my_buffer=NULL;
 static char *mac_input_buffer=NULL;
-static char *my_buffer_ptr=NULL;
+static const char *my_buffer_ptr=NULL;
+static const char *my_buffer_end=NULL;
 static MAC_HANDLE *macHandle = NULL;
+/* Named files are read into memory when opened. Only a FILE passed to
+ * dbReadDatabaseFP() is read line by line, as it may be a pipe.
+ */
 typedef struct inputFile{
     ELLNODE     node;
     const char  *path;
     const char  *filename;
     FILE        *fp;
+    char        *data;      /* whole file, or NULL to use fp */
+    const char  *next;      /* next line in data */
+    const char  *end;
+    int         expanded;   /* macros were already expanded */
     int         line_num;
 }inputFile;
 static ELLLIST inputFileList = ELLLIST_INIT;
@@ -193,18 +206,79 @@ const char *dbOpenFile(DBBASE *pdbbase,const char *filename,FILE **fp)
 }
 
 
+static void freeInputFile(inputFile *pinputFile)
+{
+    if(pinputFile->fp && fclose(pinputFile->fp))
+        errPrintf(0,__FILE__, __LINE__,
+                    "Closing file %s",pinputFile->filename);
+    free(pinputFile->data);
+    free((void *)pinputFile->filename);
+    ellDelete(&inputFileList,(ELLNODE *)pinputFile);
+    free((void *)pinputFile);
+}
+
 static void freeInputFileList(void)
 {
     inputFile *pinputFileNow;
 
-    while((pinputFileNow=(inputFile *)ellFirst(&inputFileList))) {
-        if(fclose(pinputFileNow->fp))
-            errPrintf(0,__FILE__, __LINE__,
-                        "Closing file %s",pinputFileNow->filename);
-        free((void *)pinputFileNow->filename);
-        ellDelete(&inputFileList,(ELLNODE *)pinputFileNow);
-        free((void *)pinputFileNow);
-    }
+    while((pinputFileNow=(inputFile *)ellFirst(&inputFileList)))
+        freeInputFile(pinputFileNow);
+}
+
+/* Read the rest of fp into a NUL terminated buffer */
+static char * readWholeFile(FILE *fp, size_t *psize)
+{
+    size_t size = 0, alloc = READ_CHUNK;
+    char *data = dbMalloc(alloc + 1);
+
+    while (TRUE) {
+        size_t n = fread(data + size, 1, alloc - size, fp);
+
+        size += n;
+        if (size < alloc)
+            break;
+        alloc *= 2;
+        data = realloc(data, alloc + 1);
+        if (!data)
+            cantProceed("readWholeFile: Out of memory\n");
+    }
+    data[size] = '\0';
+    *psize = size;
+    return data;
+}
+
+/* Switch an opened file to reading from memory */
+static void loadInputFile(inputFile *pinputFile)
+{
+    size_t size;
+
+    pinputFile->data = readWholeFile(pinputFile->fp, &size);
+    pinputFile->next = pinputFile->data;
+    pinputFile->end = pinputFile->data + size;
+    if(fclose(pinputFile->fp))
+        errPrintf(0,__FILE__, __LINE__,
+                    "Closing file %s",pinputFile->filename);
+    pinputFile->fp = NULL;
+}
+
+/* Like fgets(), from a file read into memory */
+static char * nextLine(inputFile *pinputFile, char *buf, int size)
+{
+    const char *next = pinputFile->next;
+    size_t n = pinputFile->end - next;
+    const char *nl;
+
+    if (!n)
+        return NULL;
+    if (n > (size_t)size - 1)
+        n = size - 1;
+    nl = memchr(next, '\n', n);
+    if (nl)
+        n = nl - next + 1;
+    memcpy(buf, next, n);
+    buf[n] = '\0';
+    pinputFile->next = next + n;
+    return buf;
 }
 
 static
@@ -216,12 +290,30 @@ int cmp_dbRecordNode(const ELLNODE *lhs, const ELLNODE *rhs)
     return strcmp(LHS->recordname, RHS->recordname);
 }
 
+static void setSearchPath(DBBASE *pdbbase,const char *path)
+{
+    char        *penv;
+
+    if(path && strlen(path)>0) {
+        dbPath(pdbbase,path);
+    } else {
+        penv = getenv("EPICS_DB_INCLUDE_PATH");
+        if(penv) {
+            dbPath(pdbbase,penv);
+        } else {
+            dbPath(pdbbase,".");
+        }
+    }
+}
+
+/* If text is given it is used instead of reading the file, and must
+ * already have had the substitutions applied. The text is freed.
+ */
 static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
-        const char *path,const char *substitutions)
+        const char *path,const char *substitutions, char *text, size_t size)
 {
     long        status;
     inputFile   *pinputFile = NULL;
-    char        *penv;
     char        **macPairs;
 
     if (ellCount(&tempList)) {
@@ -229,28 +321,21 @@ static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
     }
 
     if (getIocState() != iocVoid) {
+        free(text);
         status = -2;
         goto cleanup;
     }
 
     if(*ppdbbase == 0) *ppdbbase = dbAllocBase();
     savedPdbbase = *ppdbbase;
-    if(path && strlen(path)>0) {
-        dbPath(savedPdbbase,path);
-    } else {
-        penv = getenv("EPICS_DB_INCLUDE_PATH");
-        if(penv) {
-            dbPath(savedPdbbase,penv);
-        } else {
-            dbPath(savedPdbbase,".");
-        }
-    }
+    setSearchPath(savedPdbbase,path);
     my_buffer = dbCalloc(MY_BUFFER_SIZE,sizeof(char));
     freeListInitPvt(&freeListPvt,sizeof(tempListNode),100);
     if (substitutions == NULL)
         substitutions = "";
     if(macCreateHandle(&macHandle,NULL)) {
         fprintf(stderr, ERL_ERROR ": macCreateHandle failed\n");
+        free(text);
         status = -1;
         goto cleanup;
     }
@@ -268,7 +353,12 @@ static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
     if (filename) {
         pinputFile->filename = macEnvExpand(filename);
     }
-    if (!fp) {
+    if (text) {
+        pinputFile->data = text;
+        pinputFile->next = text;
+        pinputFile->end = text + size;
+        pinputFile->expanded = TRUE;
+    } else if (!fp) {
         FILE *fp1 = 0;
 
         if (pinputFile->filename)
@@ -282,14 +372,14 @@ static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
             goto cleanup;
         }
         pinputFile->fp = fp1;
+        loadInputFile(pinputFile);
     } else {
         pinputFile->fp = fp;
         fp = NULL;
     }
     pinputFile->line_num = 0;
     pinputFileNow = pinputFile;
-    my_buffer[0] = '\0';
-    my_buffer_ptr = my_buffer;
+    my_buffer_ptr = my_buffer_end = my_buffer;
     ellAdd(&inputFileList,&pinputFile->node);
     status = pvt_yy_parse();
 
@@ -347,50 +437,262 @@ cleanup:
 
 long dbReadDatabase(DBBASE **ppdbbase,const char *filename,
         const char *path,const char *substitutions)
-{return (dbReadCOM(ppdbbase,filename,0,path,substitutions));}
+{return (dbReadCOM(ppdbbase,filename,0,path,substitutions,NULL,0));}
 
 long dbReadDatabaseFP(DBBASE **ppdbbase,FILE *fp,
         const char *path,const char *substitutions)
-{return (dbReadCOM(ppdbbase,0,fp,path,substitutions));}
+{return (dbReadCOM(ppdbbase,0,fp,path,substitutions,NULL,0));}
+
+/* dbReadDatabaseBatch(): Each file is opened, read and has its macros
+ * expanded by a job on a thread pool. The parser keeps its state in
+ * globals, so the expanded text is then parsed by the calling thread, in
+ * order, starting as soon as the next file in line is ready. Only
+ * BATCH_AHEAD files per thread are expanded ahead of the parser, so the
+ * texts waiting to be parsed don't all sit in memory at once.
+ */
+#define BATCH_AHEAD 2
+
+typedef struct batchJob {
+    DBBASE      *pdbbase;
+    dbReadBatchItem *pitem;
+    epicsJob    *job;
+    epicsEventId done;
+    char        *text;          /* NULL if the file couldn't be read */
+    size_t      size;
+    int         *undefined;     /* lines with undefined macros */
+    int         nUndefined;
+} batchJob;
+
+static void batchUndefined(batchJob *pjob, int line_num)
+{
+    if (!(pjob->nUndefined & (pjob->nUndefined + 1))) {
+        /* Full when the count is 0, 1, 3, 7, ... */
+        pjob->undefined = realloc(pjob->undefined,
+            (2 * pjob->nUndefined + 1) * sizeof(int));
+        if (!pjob->undefined)
+            cantProceed("dbReadDatabaseBatch: Out of memory\n");
+    }
+    pjob->undefined[pjob->nUndefined++] = line_num;
+}
+
+static void batchExpand(batchJob *pjob)
+{
+    const char *substitutions = pjob->pitem->substitutions;
+    char *filename = macEnvExpand(pjob->pitem->filename);
+    MAC_HANDLE *handle = NULL;
+    char **pairs = NULL;
+    inputFile input;
+    FILE *fp = NULL;
+    char *line, *out;
+    size_t alloc;
+    int line_num = 0;
+
+    if (filename)
+        dbOpenFile(pjob->pdbbase, filename, &fp);
+    free(filename);
+    if (!fp)
+        return;
+    memset(&input, 0, sizeof(input));
+    input.data = readWholeFile(fp, &pjob->size);
+    fclose(fp);
+
+    if (substitutions && macCreateHandle(&handle, NULL) == 0)
+        macParseDefns(handle, substitutions, &pairs);
+    if (!pairs) {
+        /* Nothing to expand, dbReadCOM() will use the file as read */
+        if (handle)
+            macDeleteHandle(handle);
+        pjob->text = input.data;
+        return;
+    }
+    macInstallMacros(handle, pairs);
+    free(pairs);
+    macSuppressWarning(handle, dbQuietMacroWarnings);
+
+    input.next = input.data;
+    input.end = input.data + pjob->size;
+    line = dbMalloc(2 * MY_BUFFER_SIZE);
+    out = line + MY_BUFFER_SIZE;
+    alloc = pjob->size + pjob->size / 4 + MY_BUFFER_SIZE;
+    pjob->text = dbMalloc(alloc + 1);
+    pjob->size = 0;
+    while (nextLine(&input, line, MY_BUFFER_SIZE)) {
+        size_t n;
+
+        line_num++;
+        if (macExpandString(handle, line, out, MY_BUFFER_SIZE) < 0)
+            batchUndefined(pjob, line_num);
+        n = strlen(out);
+        if (pjob->size + n > alloc) {
+            alloc = 2 * alloc + n;
+            pjob->text = realloc(pjob->text, alloc + 1);
+            if (!pjob->text)
+                cantProceed("dbReadDatabaseBatch: Out of memory\n");
+        }
+        memcpy(pjob->text + pjob->size, out, n);
+        pjob->size += n;
+    }
+    pjob->text[pjob->size] = '\0';
+    free(line);
+    free(input.data);
+    macDeleteHandle(handle);
+}
+
+static void batchExpandJob(void *arg, epicsJobMode mode)
+{
+    batchJob *pjob = (batchJob *)arg;
+
+    if (mode == epicsJobModeRun)
+        batchExpand(pjob);
+    epicsEventMustTrigger(pjob->done);
+}
+
+static void batchStart(batchJob *pjob)
+{
+    if (!pjob->job || epicsJobQueue(pjob->job))
+        batchExpandJob(pjob, epicsJobModeRun);
+}
+
+long dbReadDatabaseBatch(DBBASE **ppdbbase, dbReadBatchItem *items,
+        int count, const char *path, int threads)
+{
+    epicsThreadPool *pool = NULL;
+    DBBASE pathBase;    /* dbReadCOM() resets the path of *ppdbbase */
+    batchJob *jobs;
+    long status = 0;
+    int i, j, ahead = 0;
+
+    if (getIocState() != iocVoid)
+        return -2;
+    if (count <= 0)
+        return 0;
+    if (threads <= 0)
+        threads += epicsThreadGetCPUs();
+    if (threads > count)
+        threads = count;
+
+    memset(&pathBase, 0, sizeof(pathBase));
+    setSearchPath(&pathBase, path);
+    jobs = dbCalloc(count, sizeof(batchJob));
+    for (i = 0; i < count; i++) {
+        jobs[i].pdbbase = &pathBase;
+        jobs[i].pitem = &items[i];
+    }
+
+    if (threads > 1) {
+        epicsThreadPoolConfig opts;
+
+        epicsThreadPoolConfigDefaults(&opts);
+        opts.initialThreads = opts.maxThreads = threads;
+        pool = epicsThreadPoolCreate(&opts);
+    }
+    if (pool) {
+        for (i = 0; i < count; i++) {
+            jobs[i].done = epicsEventMustCreate(epicsEventEmpty);
+            jobs[i].job = epicsJobCreate(pool, batchExpandJob, &jobs[i]);
+        }
+        ahead = BATCH_AHEAD * threads;
+        for (i = 0; i < count && i < ahead; i++)
+            batchStart(&jobs[i]);
+    }
+
+    for (i = 0; i < count; i++) {
+        batchJob *pjob = &jobs[i];
+        char *filename;
+
+        if (pool)
+            epicsEventMustWait(pjob->done);
+        else
+            batchExpand(pjob);
+
+        filename = macEnvExpand(pjob->pitem->filename);
+        for (j = 0; j < pjob->nUndefined; j++)
+            fprintf(stderr, "Warning: '%s' line %d has undefined macros\n",
+                filename, pjob->undefined[j]);
+        if (pjob->text) {
+            pjob->pitem->status = dbReadCOM(ppdbbase, pjob->pitem->filename,
+                NULL, path, pjob->pitem->substitutions, pjob->text,
+                pjob->size);
+        } else {
+            errPrintf(0, __FILE__, __LINE__,
+                "dbRead opening file %s\n", filename);
+            pjob->pitem->status = -1;
+        }
+        free(filename);
+        free(pjob->undefined);
+        if (pjob->pitem->status)
+            status = pjob->pitem->status;
+        if (pool && i + ahead < count)
+            batchStart(&jobs[i + ahead]);
+    }
+
+    if (pool) {
+        for (i = 0; i < count; i++) {
+            if (jobs[i].job)
+                epicsJobDestroy(jobs[i].job);
+            epicsEventDestroy(jobs[i].done);
+        }
+        epicsThreadPoolDestroy(pool);
+    }
+    free(jobs);
+    dbFreePath(&pathBase);
+    return status;
+}
 
+/* Lines are passed to the lexer one at a time, so an include statement
+ * takes effect at the end of its line.
+ */
 static int db_yyinput(char *buf, int max_size)
 {
-    size_t  l,n;
+    size_t  n;
     char        *fgetsRtn;
 
     if(yyAbort) return(0);
-    if(*my_buffer_ptr==0) {
+    if(my_buffer_ptr==my_buffer_end) {
         while(TRUE) { /*until we get some input*/
-            if(macHandle) {
-                fgetsRtn = fgets(mac_input_buffer,MY_BUFFER_SIZE,
-                        pinputFileNow->fp);
-                if(fgetsRtn) {
-                    int exp = macExpandString(macHandle,mac_input_buffer,
-                        my_buffer,MY_BUFFER_SIZE);
-                    if (exp < 0) {
-                        fprintf(stderr, "Warning: '%s' line %d has undefined macros\n",
-                            pinputFileNow->filename, pinputFileNow->line_num+1);
+            inputFile *pinputFile = pinputFileNow;
+
+            if(pinputFile->data && (!macHandle || pinputFile->expanded)) {
+                /* Fast path, use the line where it is */
+                const char *next = pinputFile->next;
+                const char *nl = memchr(next, '\n', pinputFile->end - next);
+
+                my_buffer_ptr = next;
+                my_buffer_end = nl ? nl + 1 : pinputFile->end;
+                pinputFile->next = my_buffer_end;
+                if(my_buffer_ptr!=my_buffer_end) break;
+            } else {
+                if(macHandle) {
+                    fgetsRtn = pinputFile->data ?
+                        nextLine(pinputFile,mac_input_buffer,MY_BUFFER_SIZE) :
+                        fgets(mac_input_buffer,MY_BUFFER_SIZE,pinputFile->fp);
+                    if(fgetsRtn) {
+                        int exp = macExpandString(macHandle,mac_input_buffer,
+                            my_buffer,MY_BUFFER_SIZE);
+                        if (exp < 0) {
+                            fprintf(stderr, "Warning: '%s' line %d has undefined macros\n",
+                                pinputFile->filename, pinputFile->line_num+1);
+                        }
                     }
+                } else {
+                    fgetsRtn = fgets(my_buffer,MY_BUFFER_SIZE,pinputFile->fp);
+                }
+                if(fgetsRtn) {
+                    my_buffer_ptr = my_buffer;
+                    my_buffer_end = my_buffer + strlen(my_buffer);
+                    break;
                 }
-            } else {
-                fgetsRtn = fgets(my_buffer,MY_BUFFER_SIZE,pinputFileNow->fp);
             }
-            if(fgetsRtn) break;
-            if(fclose(pinputFileNow->fp))
-                errPrintf(0,__FILE__, __LINE__,
-                        "Closing file %s",pinputFileNow->filename);
-            free((void *)pinputFileNow->filename);
-            ellDelete(&inputFileList,(ELLNODE *)pinputFileNow);
-            free((void *)pinputFileNow);
+            freeInputFile(pinputFile);
             pinputFileNow = (inputFile *)ellLast(&inputFileList);
             if(!pinputFileNow) return(0);
         }
-        if(dbStaticDebug) fprintf(stderr,"%s",my_buffer);
+        if(dbStaticDebug)
+            fwrite(my_buffer_ptr,1,my_buffer_end-my_buffer_ptr,stderr);
         pinputFileNow->line_num++;
-        my_buffer_ptr = &my_buffer[0];
     }
-    l = strlen(my_buffer_ptr);
-    n = (l<=max_size ? l : max_size);
+    n = my_buffer_end - my_buffer_ptr;
+    if(n > (size_t)max_size) n = max_size;
     memcpy(buf,my_buffer_ptr,n);
     my_buffer_ptr += n;
     return (int)n;
@@ -441,6 +743,7 @@ static void dbIncludeNew(char *filename)
         return;
     }
     pinputFile->fp = fp;
+    loadInputFile(pinputFile);
     ellAdd(&inputFileList,&pinputFile->node);
     pinputFileNow = pinputFile;
 }
@@ -980,12 +1283,44 @@ static void dbBreakItem(char *value)
     allocTemp(epicsStrDup(value));
 }
 
+/* Value of column eng (or raw) in interval i */
+#define BRK_VALUE(paBrkInt, i, eng) \
+    ((eng) ? (paBrkInt)[i].eng : (paBrkInt)[i].raw)
+
+/* Build a uniform grid over the raw or eng values of a monotonic table.
+ * Each cell holds the interval containing the start of the cell, so the
+ * conversion routines only have to step past the breakpoints inside one
+ * cell instead of walking the table from the last interval used.
+ */
+static brkIndex * dbBreakIndex(const brkInt *paBrkInt, int number, int eng)
+{
+    double first = BRK_VALUE(paBrkInt, 0, eng);
+    double last = BRK_VALUE(paBrkInt, number - 1, eng);
+    long ncells = 2 * number;
+    brkIndex *pindex = dbCalloc(1, sizeof(brkIndex) + ncells * sizeof(short));
+    long cell;
+    int i = 0;
+
+    pindex->low = first;
+    pindex->scale = ncells / (last - first);
+    pindex->ncells = ncells;
+    pindex->pcell = (short *)(pindex + 1);
+    for (cell = 0; cell < ncells; cell++) {
+        while (i < number - 2 &&
+               (BRK_VALUE(paBrkInt, i + 1, eng) - first) * pindex->scale <= cell)
+            i++;
+        pindex->pcell[cell] = i;
+    }
+    return pindex;
+}
+
 static void dbBreakBody(void)
 {
     brkTable            *pnewbrkTable;
     brkInt              *paBrkInt;
     brkTable            *pbrkTable;
     int                 number, down=0;
+    int                 rawDown, engDown, sorted = 1;
     int                 i;
     GPHENTRY            *pgphentry;
 
@@ -1042,6 +1377,22 @@ static void dbBreakBody(void)
     }
     /* Continue with last slope beyond the final point */
     paBrkInt[number-1].slope = paBrkInt[number-2].slope;
+    /* Index tables which can be searched in either direction */
+    rawDown = paBrkInt[1].raw < paBrkInt[0].raw;
+    engDown = paBrkInt[1].eng < paBrkInt[0].eng;
+    for (i=0; i<number-1; i++) {
+        if (!(rawDown ? paBrkInt[i+1].raw < paBrkInt[i].raw
+                      : paBrkInt[i+1].raw > paBrkInt[i].raw) ||
+            !(engDown ? paBrkInt[i+1].eng < paBrkInt[i].eng
+                      : paBrkInt[i+1].eng > paBrkInt[i].eng)) {
+            sorted = 0;
+            break;
+        }
+    }
+    if (sorted && number <= SHRT_MAX) {
+        pnewbrkTable->prawIndex = dbBreakIndex(paBrkInt, number, 0);
+        pnewbrkTable->pengIndex = dbBreakIndex(paBrkInt, number, 1);
+    }
     /* Add brkTable in sorted order */
     pbrkTable = (brkTable *)ellFirst(&savedPdbbase->bptList);
     while (pbrkTable) {
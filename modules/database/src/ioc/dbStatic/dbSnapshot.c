@@ -0,0 +1,497 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Database snapshots, see dbWriteSnapshot() and dbReadSnapshot()
+ *
+ * A snapshot holds the record instances of a database, not its
+ * definitions. It starts with a header:
+ *     "EPICSDBS"  magic
+ *     u32         format version
+ *     u32         checksum of the record type definitions
+ *     u32         number of records
+ * followed by entries, each a tag byte and its arguments:
+ *     'R' u16 type, u8 visible, str name    Start a record
+ *     'F' u16 field, str value              Set a field of that record
+ *     'I' str name, str value               Add an info item to it
+ *     'A' str record, str alias             Create an alias
+ *     'E'                                   End of the snapshot
+ * Numbers are big-endian. A str is a u32 length followed by that many
+ * bytes. Record types and fields are identified by their position in the
+ * definitions, which the checksum guarantees are the same as when the
+ * snapshot was written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "ellLib.h"
+#include "epicsPrint.h"
+#include "epicsString.h"
+#include "epicsTypes.h"
+#include "errlog.h"
+
+#include "dbBase.h"
+#include "dbFldTypes.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "iocInit.h"
+#include "link.h"
+
+#define SNAPSHOT_MAGIC "EPICSDBS"
+#define SNAPSHOT_VERSION 1
+
+/* FNV-1a over the parts of the record type definitions that positions
+ * in a snapshot depend on. Field sizes of DBF_NOACCESS fields are set by
+ * record support and may differ between targets, so are left out.
+ */
+static epicsUInt32 hashBytes(epicsUInt32 hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while (len--) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static epicsUInt32 hashString(epicsUInt32 hash, const char *str)
+{
+    return hashBytes(hash, str, strlen(str) + 1);
+}
+
+epicsUInt32 dbSnapshotChecksum(DBBASE *pdbbase)
+{
+    epicsUInt32 hash = 2166136261u;
+    dbRecordType *prt;
+
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node)) {
+        int i;
+
+        hash = hashString(hash, prt->name);
+        for (i = 0; i < prt->no_fields; i++) {
+            dbFldDes *pflddes = prt->papFldDes[i];
+            unsigned char type[3];
+
+            type[0] = (unsigned char)pflddes->field_type;
+            type[1] = (unsigned char)(pflddes->field_type == DBF_STRING ?
+                pflddes->size : 0);
+            type[2] = (unsigned char)(pflddes->field_type == DBF_STRING ?
+                pflddes->size >> 8 : 0);
+            hash = hashString(hash, pflddes->name);
+            hash = hashBytes(hash, type, sizeof(type));
+        }
+    }
+    return hash;
+}
+
+static void putU16(FILE *fp, unsigned val)
+{
+    fputc((val >> 8) & 0xff, fp);
+    fputc(val & 0xff, fp);
+}
+
+static void putU32(FILE *fp, epicsUInt32 val)
+{
+    putU16(fp, val >> 16);
+    putU16(fp, val & 0xffff);
+}
+
+static void putStr(FILE *fp, const char *str)
+{
+    size_t len = str ? strlen(str) : 0;
+
+    putU32(fp, (epicsUInt32)len);
+    fwrite(str, 1, len, fp);
+}
+
+static int cmpOrder(const void *a, const void *b)
+{
+    const dbRecordNode *pa = *(const dbRecordNode * const *)a;
+    const dbRecordNode *pb = *(const dbRecordNode * const *)b;
+
+    return pa->order < pb->order ? -1 : pa->order > pb->order;
+}
+
+/* Before iocInit a link field only holds its text, which
+ * dbIsDefaultValue() doesn't look at.
+ */
+static int isDefault(DBENTRY *pdbentry)
+{
+    dbFldDes *pflddes = pdbentry->pflddes;
+    DBLINK *plink = (DBLINK *)pdbentry->pfield;
+
+    switch (pflddes->field_type) {
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        if (plink->type == CONSTANT && plink->value.constantStr == NULL)
+            return !strcmp(plink->text ? plink->text : "",
+                pflddes->initial ? pflddes->initial : "");
+        break;
+    default:
+        break;
+    }
+    return dbIsDefaultValue(pdbentry);
+}
+
+static void writeRecord(FILE *fp, DBENTRY *pdbentry, unsigned type)
+{
+    long status;
+
+    fputc('R', fp);
+    putU16(fp, type);
+    fputc(dbIsVisibleRecord(pdbentry), fp);
+    putStr(fp, dbGetRecordName(pdbentry));
+
+    for (status = dbFirstField(pdbentry, FALSE); !status;
+         status = dbNextField(pdbentry, FALSE)) {
+        dbFldDes *pflddes = pdbentry->pflddes;
+
+        if (pflddes->field_type == DBF_NOACCESS ||
+            !strcmp(pflddes->name, "NAME") || isDefault(pdbentry))
+            continue;
+        fputc('F', fp);
+        putU16(fp, pdbentry->indfield);
+        putStr(fp, dbGetString(pdbentry));
+    }
+
+    for (status = dbFirstInfo(pdbentry); !status;
+         status = dbNextInfo(pdbentry)) {
+        fputc('I', fp);
+        putStr(fp, dbGetInfoName(pdbentry));
+        putStr(fp, dbGetInfoString(pdbentry));
+    }
+}
+
+long dbWriteSnapshot(DBBASE *pdbbase, const char *filename)
+{
+    DBENTRY dbentry;
+    dbRecordType *prt;
+    dbRecordNode **nodes;
+    FILE *fp;
+    int nNodes = 0, nRecords = 0, i;
+    unsigned type;
+    long status = 0;
+
+    /* After iocInit the fields hold run-time values, and reading them
+     * here would race with the records processing.
+     */
+    if (getIocState() != iocVoid) {
+        fprintf(stderr, ERL_ERROR ": dbWriteSnapshot: Only possible "
+            "before iocInit\n");
+        return -2;
+    }
+    if (!pdbbase) {
+        fprintf(stderr, ERL_ERROR ": dbWriteSnapshot: No database\n");
+        return -1;
+    }
+    fp = fopen(filename, "wb");
+    if (!fp) {
+        fprintf(stderr, ERL_ERROR ": dbWriteSnapshot: Can't create '%s'\n",
+            filename);
+        return -1;
+    }
+
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node))
+        nNodes += ellCount(&prt->recList);
+    nodes = dbCalloc(nNodes + 1, sizeof(dbRecordNode *));
+    nNodes = 0;
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node)) {
+        dbRecordNode *precnode;
+
+        for (precnode = (dbRecordNode *)ellFirst(&prt->recList); precnode;
+             precnode = (dbRecordNode *)ellNext(&precnode->node)) {
+            nodes[nNodes++] = precnode;
+            if (!(precnode->flags & DBRN_FLAGS_ISALIAS))
+                nRecords++;
+        }
+    }
+    /* Records and aliases are recreated in the order they were loaded */
+    qsort(nodes, nNodes, sizeof(dbRecordNode *), cmpOrder);
+
+    fwrite(SNAPSHOT_MAGIC, 1, 8, fp);
+    putU32(fp, SNAPSHOT_VERSION);
+    putU32(fp, dbSnapshotChecksum(pdbbase));
+    putU32(fp, nRecords);
+
+    dbInitEntry(pdbbase, &dbentry);
+    for (i = 0; i < nNodes; i++) {
+        dbRecordNode *precnode = nodes[i];
+
+        if (dbFindRecord(&dbentry, precnode->recordname))
+            continue;
+        if (precnode->flags & DBRN_FLAGS_ISALIAS) {
+            fputc('A', fp);
+            putStr(fp, precnode->aliasedRecnode->recordname);
+            putStr(fp, precnode->recordname);
+            continue;
+        }
+        for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList),
+             type = 0; prt != dbentry.precordType;
+             prt = (dbRecordType *)ellNext(&prt->node))
+            type++;
+        writeRecord(fp, &dbentry, type);
+    }
+    dbFinishEntry(&dbentry);
+    fputc('E', fp);
+    free(nodes);
+
+    if (ferror(fp))
+        status = -1;
+    if (fclose(fp))
+        status = -1;
+    if (status)
+        fprintf(stderr, ERL_ERROR ": dbWriteSnapshot: Error writing '%s'\n",
+            filename);
+    return status;
+}
+
+typedef struct snapReader {
+    const unsigned char *next;
+    const unsigned char *end;
+    int bad;
+} snapReader;
+
+static unsigned getU8(snapReader *prd)
+{
+    if (prd->next + 1 > prd->end) {
+        prd->bad = TRUE;
+        return 0;
+    }
+    return *prd->next++;
+}
+
+static unsigned getU16(snapReader *prd)
+{
+    unsigned val = getU8(prd) << 8;
+
+    return val | getU8(prd);
+}
+
+static epicsUInt32 getU32(snapReader *prd)
+{
+    epicsUInt32 val = (epicsUInt32)getU16(prd) << 16;
+
+    return val | getU16(prd);
+}
+
+/* Strings are copied to buf, which grows as needed */
+static const char * getStr(snapReader *prd, char **pbuf, size_t *psize)
+{
+    epicsUInt32 len = getU32(prd);
+
+    if (prd->bad || len > (size_t)(prd->end - prd->next)) {
+        prd->bad = TRUE;
+        return "";
+    }
+    if (len >= *psize) {
+        *psize = len + 1;
+        free(*pbuf);
+        *pbuf = dbMalloc(*psize);
+    }
+    memcpy(*pbuf, prd->next, len);
+    (*pbuf)[len] = '\0';
+    prd->next += len;
+    return *pbuf;
+}
+
+static char * readFile(const char *filename, size_t *psize)
+{
+    FILE *fp = fopen(filename, "rb");
+    char *data = NULL;
+    long size;
+
+    if (!fp)
+        return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) >= 0 &&
+        fseek(fp, 0, SEEK_SET) == 0) {
+        data = dbMalloc(size + 1);
+        if (fread(data, 1, size, fp) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+        *psize = size;
+    }
+    fclose(fp);
+    return data;
+}
+
+/* Set a field from the snapshot. The value was valid when the snapshot
+ * was written, so link text is stored without being parsed again.
+ */
+static long putField(DBENTRY *pdbentry, const char *value)
+{
+    dbFldDes *pflddes = pdbentry->pflddes;
+    DBLINK *plink = (DBLINK *)pdbentry->pfield;
+
+    switch (pflddes->field_type) {
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        if (plink->type == CONSTANT && plink->value.constantStr == NULL) {
+            free(plink->text);
+            plink->text = epicsStrDup(value);
+            return 0;
+        }
+        break;
+    default:
+        break;
+    }
+    return dbPutString(pdbentry, value);
+}
+
+long dbReadSnapshot(DBBASE **ppdbbase, const char *filename)
+{
+    DBBASE *pdbbase = *ppdbbase;
+    dbRecordType **types;
+    DBENTRY dbentry;
+    snapReader rd;
+    char *data, *name = NULL, *value = NULL;
+    size_t size, nameSize = 0, valueSize = 0;
+    epicsUInt32 version, checksum;
+    dbRecordType *prt;
+    int nTypes = 0, haveRecord = FALSE, done = FALSE;
+    long status = 0;
+
+    if (getIocState() != iocVoid)
+        return -2;
+    if (!pdbbase) {
+        fprintf(stderr, ERL_ERROR ": dbReadSnapshot: Load the DBD first\n");
+        return -1;
+    }
+    data = readFile(filename, &size);
+    if (!data) {
+        fprintf(stderr, ERL_ERROR ": dbReadSnapshot: Can't read '%s'\n",
+            filename);
+        return -1;
+    }
+    rd.next = (const unsigned char *)data;
+    rd.end = rd.next + size;
+    rd.bad = size < 8 || memcmp(data, SNAPSHOT_MAGIC, 8);
+    rd.next += 8;
+    version = getU32(&rd);
+    checksum = getU32(&rd);
+    getU32(&rd);
+    if (rd.bad || version != SNAPSHOT_VERSION) {
+        fprintf(stderr, ERL_ERROR ": dbReadSnapshot: '%s' is not a version %d "
+            "database snapshot\n", filename, SNAPSHOT_VERSION);
+        free(data);
+        return -1;
+    }
+    if (checksum != dbSnapshotChecksum(pdbbase)) {
+        fprintf(stderr, ERL_ERROR ": dbReadSnapshot: '%s' was made with "
+            "different record type definitions\n", filename);
+        free(data);
+        return -1;
+    }
+
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node))
+        nTypes++;
+    types = dbCalloc(nTypes + 1, sizeof(dbRecordType *));
+    nTypes = 0;
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node))
+        types[nTypes++] = prt;
+
+    dbInitEntry(pdbbase, &dbentry);
+    while (!done && !status && !rd.bad) {
+        int tag = getU8(&rd);
+
+        switch (tag) {
+        case 'R': {
+            unsigned type = getU16(&rd);
+            int visible = getU8(&rd);
+
+            getStr(&rd, &name, &nameSize);
+            if (rd.bad || type >= (unsigned)nTypes) {
+                rd.bad = TRUE;
+                break;
+            }
+            dbentry.precordType = types[type];
+            status = dbCreateRecord(&dbentry, name);
+            if (status == S_dbLib_recExists) {
+                /* Duplicate records are ok if the same type */
+                if (dbentry.precordType != types[type]) {
+                    fprintf(stderr, ERL_ERROR ": Record \"%s\" of type "
+                        "\"%s\" redefined with new type \"%s\"\n", name,
+                        dbGetRecordTypeName(&dbentry), types[type]->name);
+                    break;
+                }
+                status = 0;
+            }
+            if (!status && visible)
+                dbVisibleRecord(&dbentry);
+            haveRecord = !status;
+            break;
+        }
+        case 'F': {
+            unsigned field = getU16(&rd);
+
+            getStr(&rd, &value, &valueSize);
+            if (rd.bad || !haveRecord ||
+                field >= (unsigned)dbentry.precordType->no_fields) {
+                rd.bad = TRUE;
+                break;
+            }
+            dbentry.indfield = field;
+            dbentry.pflddes = dbentry.precordType->papFldDes[field];
+            status = dbGetFieldAddress(&dbentry);
+            if (!status)
+                status = putField(&dbentry, value);
+            if (status)
+                fprintf(stderr, ERL_ERROR ": Can't set \"%s.%s\" to \"%s\"\n",
+                    dbGetRecordName(&dbentry), dbentry.pflddes->name, value);
+            break;
+        }
+        case 'I':
+            getStr(&rd, &name, &nameSize);
+            getStr(&rd, &value, &valueSize);
+            if (rd.bad || !haveRecord) {
+                rd.bad = TRUE;
+                break;
+            }
+            status = dbPutInfo(&dbentry, name, value);
+            break;
+        case 'A':
+            getStr(&rd, &name, &nameSize);
+            getStr(&rd, &value, &valueSize);
+            if (rd.bad)
+                break;
+            haveRecord = FALSE;
+            status = dbFindRecord(&dbentry, name);
+            if (!status)
+                status = dbCreateAlias(&dbentry, value);
+            if (status)
+                fprintf(stderr, ERL_ERROR ": Can't create alias \"%s\" "
+                    "for \"%s\"\n", value, name);
+            break;
+        case 'E':
+            done = TRUE;
+            break;
+        default:
+            rd.bad = TRUE;
+        }
+    }
+    dbFinishEntry(&dbentry);
+
+    if (rd.bad) {
+        fprintf(stderr, ERL_ERROR ": dbReadSnapshot: '%s' is corrupt\n",
+            filename);
+        status = -1;
+    }
+    free(types);
+    free(name);
+    free(value);
+    free(data);
+    return status;
+}
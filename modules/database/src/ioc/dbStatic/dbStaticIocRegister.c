@@ -226,6 +226,23 @@ static void dbReportDeviceConfigCallFunc(const iocshArgBuf *args)
     dbReportDeviceConfig(*iocshPpdbbase,stdout);
 }
 
+/* dbReportRecordMemory */
+static const iocshArg dbReportRecordMemoryArg0 = { "verbose",iocshArgInt};
+static const iocshArg * const dbReportRecordMemoryArgs[] =
+    {&dbReportRecordMemoryArg0};
+static const iocshFuncDef dbReportRecordMemoryFuncDef = {
+    "dbReportRecordMemory",
+    1,
+    dbReportRecordMemoryArgs,
+    "Show the memory used by the records of each record type.\n"
+    "Records are allocated from slabs of up to dbRecordSlabSize records.\n"
+    "If verbose, list all record types regardless of being instanced.\n\n"
+    "Example: dbReportRecordMemory 0\n",
+};
+static void dbReportRecordMemoryCallFunc(const iocshArgBuf *args)
+{
+    dbReportRecordMemory(*iocshPpdbbase,args[0].ival);
+}
 
 static const iocshArg dbCreateAliasArg0 = { "record",iocshArgStringRecord};
 static const iocshArg dbCreateAliasArg1 = { "alias",iocshArgStringRecord};
@@ -260,6 +277,55 @@ static void dbCreateAliasCallFunc(const iocshArgBuf *args)
     }
 }
 
+/* dbWriteSnapshot */
+static const iocshArg dbSnapshotArg0 = { "file name",iocshArgStringPath};
+static const iocshArg * const dbSnapshotArgs[] = {&dbSnapshotArg0};
+static const iocshFuncDef dbWriteSnapshotFuncDef = {
+    "dbWriteSnapshot",
+    1,
+    dbSnapshotArgs,
+    "Write the records loaded so far to a binary snapshot file,\n"
+    "which dbReadSnapshot can load faster than the .db files.\n"
+    "Must be run before iocInit.\n"
+    "\n"
+    "Example: dbWriteSnapshot db/ioc.dbsnap\n",
+};
+static void dbWriteSnapshotCallFunc(const iocshArgBuf *args)
+{
+    if (!args[0].sval) {
+        fprintf(stderr, "Usage: dbWriteSnapshot \"file\"\n");
+        iocshSetError(1);
+        return;
+    }
+    iocshSetError(dbWriteSnapshot(*iocshPpdbbase, args[0].sval) != 0);
+}
+
+/* dbReadSnapshot */
+static const iocshFuncDef dbReadSnapshotFuncDef = {
+    "dbReadSnapshot",
+    1,
+    dbSnapshotArgs,
+    "Load the records from a snapshot file written by dbWriteSnapshot\n"
+    "or by the dbMakeSnapshot tool. The DBD must be loaded first and must\n"
+    "define the same record types as when the snapshot was written.\n"
+    "\n"
+    "Example: dbReadSnapshot db/ioc.dbsnap\n",
+};
+static void dbReadSnapshotCallFunc(const iocshArgBuf *args)
+{
+    long status;
+
+    if (!args[0].sval) {
+        fprintf(stderr, "Usage: dbReadSnapshot \"file\"\n");
+        iocshSetError(1);
+        return;
+    }
+    status = dbReadSnapshot(iocshPpdbbase, args[0].sval);
+    if (status == -2)
+        fprintf(stderr, "    Records cannot be loaded after iocInit!\n");
+    iocshSetError(status != 0);
+}
+
 void dbStaticIocRegister(void)
 {
     iocshRegister(&dbDumpPathFuncDef, dbDumpPathCallFunc);
@@ -277,5 +343,8 @@ void dbStaticIocRegister(void)
     iocshRegister(&dbPvdDumpFuncDef, dbPvdDumpCallFunc);
     iocshRegister(&dbPvdTableSizeFuncDef,dbPvdTableSizeCallFunc);
     iocshRegister(&dbReportDeviceConfigFuncDef, dbReportDeviceConfigCallFunc);
+    iocshRegister(&dbReportRecordMemoryFuncDef, dbReportRecordMemoryCallFunc);
     iocshRegister(&dbCreateAliasFuncDef, dbCreateAliasCallFunc);
+    iocshRegister(&dbWriteSnapshotFuncDef, dbWriteSnapshotCallFunc);
+    iocshRegister(&dbReadSnapshotFuncDef, dbReadSnapshotCallFunc);
 }
@@ -575,6 +575,8 @@ void dbFreeBase(dbBase *pdbbase)
         ellDelete(&pdbbase->bptList,&pbrkTable->node);
         free(pbrkTable->name);
         free((void *)pbrkTable->paBrkInt);
+        free((void *)pbrkTable->prawIndex);
+        free((void *)pbrkTable->pengIndex);
         free((void *)pbrkTable);
         pbrkTable = pbrkTableNext;
     }
@@ -1923,18 +1925,23 @@ char * dbGetString(DBENTRY *pdbentry)
         case DB_LINK: {
             int     ppind;
             short   pvlMask;
+            char    rate[40] = "";
 
             pvlMask = plink->value.pv_link.pvlMask;
+            if (plink->value.pv_link.maxRate > 0.0)
+                epicsSnprintf(rate, sizeof(rate), " RATE=%g",
+                    plink->value.pv_link.maxRate);
             if (pvlMask&pvlOptPP) ppind=1;
             else if(pvlMask&pvlOptCA) ppind=2;
             else if(pvlMask&pvlOptCP) ppind=3;
             else if(pvlMask&pvlOptCPP) ppind=4;
             else ppind=0;
-            dbMsgPrint(pdbentry, "%s%s%s%s",
+            dbMsgPrint(pdbentry, "%s%s%s%s%s%s",
                    plink->value.pv_link.pvname ? plink->value.pv_link.pvname : "",
                    (plink->flags & DBLINK_FLAG_TSELisTIME) ? ".TIME" : "",
                    ppstring[ppind],
-                   msstring[plink->value.pv_link.pvlMask&pvlOptMsMode]);
+                   msstring[plink->value.pv_link.pvlMask&pvlOptMsMode],
+                   (pvlMask & pvlOptLatest) ? " LATEST" : "", rate);
             break;
         }
         case VME_IO:
@@ -2363,12 +2370,25 @@ long dbParseLink(const char *str, short ftype, dbLinkInfo *pinfo)
         else if (strstr(pstr, "MSS")) pinfo->modifiers |= pvlOptMSS;
         else if (strstr(pstr, "MS")) pinfo->modifiers |= pvlOptMS;
 
+        /* Only used with CP or CPP */
+        if (strstr(pstr, "LATEST")) pinfo->modifiers |= pvlOptLatest;
+        if ((pstr = strstr(pstr, "RATE="))) {
+            char *end;
+
+            pinfo->maxRate = epicsStrtod(pstr + 5, &end);
+            if (end == pstr + 5 || !(pinfo->maxRate >= 0.0)) goto fail;
+        }
+
         /* filter modifiers based on link type */
         switch(ftype) {
         case DBF_INLINK: /* accept all */ break;
         case DBF_OUTLINK: pinfo->modifiers &= ~pvlOptCPP; break;
         case DBF_FWDLINK: pinfo->modifiers &= pvlOptCA; break;
         }
+        if (!(pinfo->modifiers & (pvlOptCP | pvlOptCPP))) {
+            pinfo->modifiers &= ~pvlOptLatest;
+            pinfo->maxRate = 0.0;
+        }
     }
 
     return 0;
@@ -2414,6 +2434,7 @@ void dbSetLinkPV(DBLINK *plink, dbLinkInfo *pinfo)
     plink->type = PV_LINK;
     plink->value.pv_link.pvname = pinfo->target;
     plink->value.pv_link.pvlMask = pinfo->modifiers;
+    plink->value.pv_link.maxRate = pinfo->maxRate;
 
     pinfo->target = NULL;
 }
@@ -79,6 +79,53 @@ DBCORE_API long dbReadDatabase(DBBASE **ppdbbase,
  */
 DBCORE_API long dbReadDatabaseFP(DBBASE **ppdbbase,
     FILE *fp, const char *path, const char *substitutions);
+/** \brief One file for dbReadDatabaseBatch() */
+typedef struct dbReadBatchItem {
+    const char *filename;       /**< \brief File to read/search */
+    const char *substitutions;  /**< \brief Macro definitions, or NULL */
+    long status;                /**< \brief Set to the result of reading it */
+} dbReadBatchItem;
+/** \brief Read several .db files, using several threads.
+ *
+ *  The files are opened, read and have their macros expanded by a pool
+ *  of threads. They are then parsed one at a time in the order given, so
+ *  the result is the same as calling dbReadDatabase() for each item.
+ *
+ *  \param ppdbbase The database.  Typically the "&pdbbase" global
+ *  \param items The files to read. Each item's status is set.
+ *  \param count Number of items
+ *  \param path As for dbReadDatabase()
+ *  \param threads Number of threads, <= 0 is relative to the number of CPUs
+ *  \return 0 if every file was read successfully
+ */
+DBCORE_API long dbReadDatabaseBatch(DBBASE **ppdbbase,
+    dbReadBatchItem *items, int count, const char *path, int threads);
+/** \brief Write the record instances of a database to a snapshot file.
+ *
+ *  The snapshot holds every record with its non-default field values,
+ *  info items and aliases, but not the record type definitions.
+ *
+ *  \param pdbbase The database.
+ *  Only possible before iocInit, while the fields still hold the values
+ *  that were loaded.
+ *
+ *  \param pdbbase The database.
+ *  \param filename File to create.
+ *  \return 0 on success, -2 after iocInit
+ */
+DBCORE_API long dbWriteSnapshot(DBBASE *pdbbase, const char *filename);
+/** \brief Load the records from a snapshot file.
+ *
+ *  The DBD must already have been loaded, and must define the same
+ *  record types as when the snapshot was written.
+ *
+ *  \param ppdbbase The database.  Typically the "&pdbbase" global
+ *  \param filename Snapshot written by dbWriteSnapshot()
+ *  \return 0 on success, -2 after iocInit
+ */
+DBCORE_API long dbReadSnapshot(DBBASE **ppdbbase, const char *filename);
+/** \brief Checksum of the record type definitions, as kept in snapshots */
+DBCORE_API epicsUInt32 dbSnapshotChecksum(DBBASE *pdbbase);
 DBCORE_API long dbPath(DBBASE *pdbbase, const char *path);
 DBCORE_API long dbAddPath(DBBASE *pdbbase, const char *path);
 DBCORE_API char * dbGetPromptGroupNameFromKey(DBBASE *pdbbase,
@@ -148,6 +195,24 @@ DBCORE_API long dbNextRecord(DBENTRY *pdbentry);
 DBCORE_API int  dbGetNRecords(DBENTRY *pdbentry);
 DBCORE_API int  dbGetNAliases(DBENTRY *pdbentry);
 DBCORE_API char * dbGetRecordName(DBENTRY *pdbentry);
+
+/** @brief Memory used by the records of one record type. */
+typedef struct dbRecordMemory {
+    size_t records;     /**< @brief Records allocated */
+    size_t capacity;    /**< @brief Records the slabs can hold */
+    size_t slabs;       /**< @brief Slabs allocated */
+    size_t recordSize;  /**< @brief Bytes per record, with padding */
+    size_t bytes;       /**< @brief Bytes allocated for slabs */
+} dbRecordMemory;
+
+/** @brief Get the record memory statistics of the current record type.
+ *
+ * Record instances are allocated from per-type slabs of up to
+ * ::dbRecordSlabSize records each.
+ *
+ * @return 0, or S_dbLib_recordTypeNotFound if there's no current type.
+ */
+DBCORE_API long dbGetRecordMemory(DBENTRY *pdbentry, dbRecordMemory *pmem);
 DBCORE_API long dbCopyRecord(DBENTRY *pdbentry,
     const char *newRecordName, int overWriteOK);
 
@@ -242,6 +307,7 @@ DBCORE_API void dbDumpBreaktable(DBBASE *pdbbase,
 DBCORE_API void dbPvdDump(DBBASE *pdbbase, int verbose);
 DBCORE_API void dbReportDeviceConfig(DBBASE *pdbbase,
     FILE *report);
+DBCORE_API void dbReportRecordMemory(DBBASE *pdbbase, int verbose);
 
 /* Misc useful routines*/
 #define dbCalloc(nobj,size) callocMustSucceed(nobj,size,"dbCalloc")
@@ -251,6 +317,12 @@ DBCORE_API void dbCatString(char **string, int *stringLength,
 
 extern int dbStaticDebug;
 extern int dbConvertStrict;
+/** @brief Most records in one slab, 1 gives each record its own.
+ *
+ * Read each time a record type needs a new slab, so a change only
+ * affects the slabs allocated after it.
+ */
+DBCORE_API extern int dbRecordSlabSize;
 
 #define S_dbLib_recordTypeNotFound (M_dbLib|1) /* Record Type does not exist */
 #define S_dbLib_recExists (M_dbLib|3)          /* Record Already exists */
@@ -67,6 +67,9 @@ typedef struct dbLinkInfo {
 
     /* for JSON_LINK */
     struct jlink *jlink;
+
+    /* for PV_LINK with RATE= */
+    double maxRate;
 } dbLinkInfo;
 
 long dbInitRecordLinks(dbRecordType *rtyp, struct dbCommon *prec);
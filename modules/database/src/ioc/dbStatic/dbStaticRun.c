@@ -11,6 +11,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <math.h>
@@ -35,6 +36,144 @@
 int dbConvertStrict = 0;
 epicsExportAddress(int, dbConvertStrict);
 
+/* Records of each type are carved out of slabs, so that records which
+ * are scanned and processed together also sit together in memory. Each
+ * slab holds twice as many records as the one before, up to the value of
+ * dbRecordSlabSize when it is allocated. Freed records are kept on a
+ * free list for reuse, and the slabs are released once every record of
+ * the type has been freed.
+ */
+int dbRecordSlabSize = 1024;
+epicsExportAddress(int, dbRecordSlabSize);
+
+#define SLAB_ALIGN 64   /* a cache line */
+#define SLAB_FIRST 4    /* records in the first slab */
+
+typedef struct dbRecordSlab {
+    struct dbRecordSlab *next;
+    size_t nrecords;
+    size_t bytes;
+} dbRecordSlab;
+
+typedef struct dbRecordSlabs {
+    dbRecordSlab *slabs;
+    void *freeList;         /* of unused records */
+    size_t recSize;         /* rounded up to SLAB_ALIGN */
+    size_t nextSize;        /* records in the next slab, before the limit */
+    dbRecordMemory mem;
+} dbRecordSlabs;
+
+static void *slabAlloc(dbRecordType *pdbRecordType)
+{
+    dbRecordSlabs *ps = pdbRecordType->slabs;
+    void *prec;
+
+    if (!ps) {
+        size_t size = offsetof(dbCommonPvt, common) + pdbRecordType->rec_size;
+
+        ps = dbCalloc(1, sizeof(dbRecordSlabs));
+        ps->recSize = (size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+        ps->nextSize = SLAB_FIRST;
+        ps->mem.recordSize = ps->recSize;
+        pdbRecordType->slabs = ps;
+    }
+
+    if (!ps->freeList) {
+        size_t maxSize = dbRecordSlabSize > 1 ? dbRecordSlabSize : 1;
+        size_t nrecords = ps->nextSize < maxSize ? ps->nextSize : maxSize;
+        size_t bytes = sizeof(dbRecordSlab) + SLAB_ALIGN - 1 +
+            nrecords * ps->recSize;
+        dbRecordSlab *pslab = dbMalloc(bytes);
+        char *pfirst = (char *)pslab + sizeof(dbRecordSlab);
+        size_t i;
+
+        pfirst += (SLAB_ALIGN - (size_t)pfirst % SLAB_ALIGN) % SLAB_ALIGN;
+        pslab->next = ps->slabs;
+        pslab->nrecords = nrecords;
+        pslab->bytes = bytes;
+        ps->slabs = pslab;
+        /* Thread the free list in address order */
+        for (i = pslab->nrecords; i-- > 0; ) {
+            void **pfree = (void **)(pfirst + i * ps->recSize);
+
+            *pfree = ps->freeList;
+            ps->freeList = pfree;
+        }
+        ps->mem.slabs++;
+        ps->mem.capacity += pslab->nrecords;
+        ps->mem.bytes += bytes;
+        if (ps->nextSize < maxSize)
+            ps->nextSize *= 2;
+    }
+
+    prec = ps->freeList;
+    ps->freeList = *(void **)prec;
+    ps->mem.records++;
+    memset(prec, 0, ps->recSize);
+    return prec;
+}
+
+static void slabFree(dbRecordType *pdbRecordType, void *prec)
+{
+    dbRecordSlabs *ps = pdbRecordType->slabs;
+
+    *(void **)prec = ps->freeList;
+    ps->freeList = prec;
+    if (--ps->mem.records)
+        return;
+
+    while (ps->slabs) {
+        dbRecordSlab *pslab = ps->slabs;
+
+        ps->slabs = pslab->next;
+        free(pslab);
+    }
+    free(ps);
+    pdbRecordType->slabs = NULL;
+}
+
+long dbGetRecordMemory(DBENTRY *pdbentry, dbRecordMemory *pmem)
+{
+    dbRecordType *pdbRecordType = pdbentry->precordType;
+
+    memset(pmem, 0, sizeof(*pmem));
+    if (!pdbRecordType) return S_dbLib_recordTypeNotFound;
+    if (pdbRecordType->slabs)
+        *pmem = pdbRecordType->slabs->mem;
+    return 0;
+}
+
+void dbReportRecordMemory(DBBASE *pdbbase, int verbose)
+{
+    DBENTRY dbentry;
+    dbRecordMemory mem;
+    size_t records = 0, bytes = 0;
+    long status;
+
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return;
+    }
+
+    dbInitEntry(pdbbase, &dbentry);
+    printf("Records Capacity Slabs  Size    KiB  Record Type\n");
+    for (status = dbFirstRecordType(&dbentry); !status;
+         status = dbNextRecordType(&dbentry)) {
+        dbGetRecordMemory(&dbentry, &mem);
+        records += mem.records;
+        bytes += mem.bytes;
+        if (verbose || mem.records)
+            printf("%7lu %8lu %5lu %5lu %6lu  %s\n",
+                (unsigned long)mem.records, (unsigned long)mem.capacity,
+                (unsigned long)mem.slabs, (unsigned long)mem.recordSize,
+                (unsigned long)((mem.bytes + 1023) / 1024),
+                dbGetRecordTypeName(&dbentry));
+    }
+    dbFinishEntry(&dbentry);
+    printf("Total %lu records in %lu KiB\n", (unsigned long)records,
+        (unsigned long)((bytes + 1023) / 1024));
+}
+
 static long do_nothing(struct dbCommon *precord) { return 0; }
 
 /* Dummy DSXT used for soft device supports */
@@ -90,7 +229,7 @@ long dbAllocRecord(DBENTRY *pdbentry,const char *precordName)
                     precordName, pdbRecordType->name, pdbRecordType->rec_size);
         return(S_dbLib_noRecSup);
     }
-    ppvt = dbCalloc(1, offsetof(dbCommonPvt, common) + pdbRecordType->rec_size);
+    ppvt = slabAlloc(pdbRecordType);
     precord = &ppvt->common;
     ppvt->recnode = precnode;
     precord->rdes = pdbRecordType;
@@ -180,7 +319,8 @@ long dbFreeRecord(DBENTRY *pdbentry)
     if(!pdbRecordType) return(S_dbLib_recordTypeNotFound);
     if(!precnode) return(S_dbLib_recNotFound);
     if(!precnode->precord) return(S_dbLib_recNotFound);
-    free(dbRec2Pvt(precnode->precord));
+    free(dbRec2Pvt(precnode->precord)->prof);
+    slabFree(pdbRecordType, dbRec2Pvt(precnode->precord));
     precnode->precord = NULL;
     return(0);
 }
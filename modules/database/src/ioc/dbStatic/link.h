@@ -68,6 +68,7 @@ DBCORE_API extern const maplinkType pamaplinkType[LINK_NTYPES];
 #define pvlOptInpString  0x100  /*Input as string*/
 #define pvlOptOutNative  0x200  /*Output native*/
 #define pvlOptOutString  0x400  /*Output as string*/
+#define pvlOptLatest     0x800  /*CP/CPP: One process for queued updates*/
 
 /* DBLINK Flag bits */
 #define DBLINK_FLAG_INITIALIZED    1 /* dbInitLink() called */
@@ -87,6 +88,7 @@ struct pv_link {
     LINKCVT     getCvt;         /* input conversion function */
     short       pvlMask;        /* Options mask */
     short       lastGetdbrType; /* last dbrType for DB or CA get */
+    double      maxRate;        /* CP/CPP: Max processing rate, 0 = none */
 };
 
 struct jlink;
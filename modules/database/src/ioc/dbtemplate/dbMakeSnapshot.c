@@ -0,0 +1,156 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* dbMakeSnapshot: Load a DBD and .db files and write their records to a
+ * snapshot file, which an IOC can load with dbReadSnapshot.
+ *
+ * Record support isn't linked in, so the fields of each record type are
+ * given storage of their own here. dbStatic only needs somewhere to keep
+ * their values, and uses the dbCommon members it knows about directly.
+ * Without link support, records with JSON links can't be loaded; write
+ * snapshots of those from an IOC with dbWriteSnapshot instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccessDefs.h"
+#include "dbBase.h"
+#include "dbCommon.h"
+#include "dbStaticLib.h"
+#include "link.h"
+#include "osiFileName.h"
+
+static int fieldSize(const dbFldDes *pflddes)
+{
+    switch (pflddes->field_type) {
+    case DBF_STRING:
+        return pflddes->size;
+    case DBF_CHAR:
+    case DBF_UCHAR:
+        return 1;
+    case DBF_SHORT:
+    case DBF_USHORT:
+    case DBF_ENUM:
+    case DBF_MENU:
+    case DBF_DEVICE:
+        return 2;
+    case DBF_LONG:
+    case DBF_ULONG:
+    case DBF_FLOAT:
+        return 4;
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        return sizeof(DBLINK);
+    default:
+        return 8;
+    }
+}
+
+static void layoutRecordTypes(DBBASE *pdbbase)
+{
+    dbRecordType *prt;
+
+    for (prt = (dbRecordType *)ellFirst(&pdbbase->recordTypeList); prt;
+         prt = (dbRecordType *)ellNext(&prt->node)) {
+        size_t offset = sizeof(dbCommon);
+        int i;
+
+        if (prt->rec_size)
+            continue;
+        /* NAME must be where dbCommon has it */
+        for (i = 1; i < prt->no_fields; i++) {
+            dbFldDes *pflddes = prt->papFldDes[i];
+
+            offset = (offset + 7) & ~(size_t)7;
+            pflddes->offset = (unsigned short)offset;
+            pflddes->size = fieldSize(pflddes);
+            offset += pflddes->size;
+        }
+        prt->rec_size = (int)offset;
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: dbMakeSnapshot [-I dir] -o outfile file.dbd [-S subs] file.db ...\n"
+        "  -I dir   Add dir to the search path, may be repeated\n"
+        "  -S subs  Macro substitutions for the .db files that follow\n"
+        "  -o file  Snapshot file to write\n"
+        "The DBD must be the expanded DBD the IOC is built with.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outfile = NULL;
+    const char *dbdfile = NULL;
+    const char *subs = NULL;
+    char *path = NULL;
+    int i, nfiles = 0;
+
+    /* Options may come between files, so parse them as we go */
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (arg[0] == '-' && arg[1] && !arg[2] && strchr("ISo", arg[1])) {
+            const char *val = i + 1 < argc ? argv[++i] : NULL;
+
+            if (!val) {
+                usage();
+                return 1;
+            }
+            if (arg[1] == 'I') {
+                size_t len = path ? strlen(path) + 1 : 0;
+                char *newpath = realloc(path, len + strlen(val) + 1);
+
+                if (!newpath)
+                    return 1;
+                path = newpath;
+                if (len)
+                    strcpy(path + len - 1, OSI_PATH_LIST_SEPARATOR);
+                strcpy(path + len, val);
+            }
+            else if (arg[1] == 'S')
+                subs = val;
+            else
+                outfile = val;
+            continue;
+        }
+        if (arg[0] == '-') {
+            usage();
+            return 1;
+        }
+
+        if (!dbdfile) {
+            dbdfile = arg;
+            if (dbReadDatabase(&pdbbase, dbdfile, path, NULL)) {
+                fprintf(stderr, "dbMakeSnapshot: Can't load '%s'\n", dbdfile);
+                return 1;
+            }
+            layoutRecordTypes(pdbbase);
+        }
+        else {
+            if (dbReadDatabase(&pdbbase, arg, path, subs)) {
+                fprintf(stderr, "dbMakeSnapshot: Can't load '%s'\n", arg);
+                return 1;
+            }
+            nfiles++;
+        }
+    }
+
+    if (!outfile || !nfiles) {
+        usage();
+        return 1;
+    }
+    if (dbWriteSnapshot(pdbbase, outfile))
+        return 1;
+    dbFreeBase(pdbbase);
+    free(path);
+    return 0;
+}
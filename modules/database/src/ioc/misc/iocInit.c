@@ -30,7 +30,10 @@
 #include "epicsGeneralTime.h"
 #include "epicsPrint.h"
 #include "epicsSignal.h"
+#include "epicsString.h"
 #include "epicsThread.h"
+#include "epicsThreadPool.h"
+#include "epicsTime.h"
 #include "errMdef.h"
 #include "iocsh.h"
 #include "taskwd.h"
@@ -86,6 +89,7 @@ static void finishDevSup(void);
 static void initDatabase(void);
 static void initialProcess(void);
 static void exitDatabase(void *dummy);
+static void initTimingInit(void);
 
 /*
  * Iterate through all record instances (but not aliases),
@@ -98,6 +102,49 @@ static void iterateRecords(recIterFunc func, void *user);
 int dbThreadRealtimeLock = 1;
 epicsExportAddress(int, dbThreadRealtimeLock);
 
+/* Parallel record initialization, see iocInitThreads() */
+#define INIT_CHUNK 256          /* Records per pool job */
+#define MAX_HOOK_TIMES 64
+
+typedef struct threadSafeDecl {
+    ELLNODE node;
+    char *recordType;
+    char *dtyp;                 /* NULL for the record support */
+} threadSafeDecl;
+
+typedef struct initChunk {
+    recIterFunc func;
+    epicsJob *job;              /* NULL to run serially */
+    int parallel;               /* records are thread safe */
+    int queued;
+    int type;                   /* index in typeTimes */
+    dbRecordType *rtype;
+    dbCommon **precs;
+    int count;
+    epicsUInt64 elapsed;
+} initChunk;
+
+typedef struct initTypeTimes {
+    const char *name;
+    size_t records;
+    size_t parallel;
+    epicsUInt64 pass[2];
+} initTypeTimes;
+
+enum {initPass0, initLinks, initPass1, initPini, initNumPhases};
+
+static int initThreads = 1;
+static ELLLIST threadSafeList = ELLLIST_INIT;
+static int initThreadsUsed;
+static epicsUInt64 phaseTime[initNumPhases];
+static initTypeTimes *typeTimes;
+static int nTypeTimes;
+static struct {
+    initHookState state;
+    epicsUInt64 time;
+} hookTimes[MAX_HOOK_TIMES];
+static int nHookTimes;
+
 enum iocStateEnum getIocState(void)
 {
     return iocState;
@@ -118,6 +165,11 @@ static int iocBuild_1(void)
         return -1;
     }
     errlogInit(0);
+    if (dbLoadRecordsBatch(0)) {
+        errlogPrintf("iocBuild: " ERL_ERROR " Aborting, failed to load queued database files\n");
+        return -1;
+    }
+    initTimingInit();
     initHookAnnounce(initHookAtIocBuild);
 
     if (!epicsThreadIsOkToBlock()) {
@@ -557,16 +609,330 @@ static void doInitRecord1(dbRecordType *pdbRecordType, dbCommon *precord,
         prset->init_record(precord, 1);
 }
 
+int iocInitThreads(int count)
+{
+    if (iocState != iocVoid) {
+        errlogPrintf("iocInitThreads: IOC already initialized\n");
+        return -1;
+    }
+    if (count <= 0)
+        count += epicsThreadGetCPUs();
+    if (count < 1)
+        count = 1;
+    initThreads = count;
+    return 0;
+}
+
+int iocInitThreadSafe(const char *recordType, const char *dtyp)
+{
+    threadSafeDecl *pdecl;
+
+    if (!recordType || !*recordType) {
+        errlogPrintf("iocInitThreadSafe: Record type name required\n");
+        return -1;
+    }
+    pdecl = dbCalloc(1, sizeof(threadSafeDecl));
+    pdecl->recordType = epicsStrDup(recordType);
+    pdecl->dtyp = dtyp && *dtyp ? epicsStrDup(dtyp) : NULL;
+    ellAdd(&threadSafeList, &pdecl->node);
+    return 0;
+}
+
+static int isDeclared(const char *recordType, const char *dtyp)
+{
+    threadSafeDecl *pdecl;
+
+    for (pdecl = (threadSafeDecl *)ellFirst(&threadSafeList); pdecl;
+         pdecl = (threadSafeDecl *)ellNext(&pdecl->node)) {
+        if (strcmp(pdecl->recordType, recordType))
+            continue;
+        if (dtyp ? pdecl->dtyp && !strcmp(pdecl->dtyp, dtyp) : !pdecl->dtyp)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Registered by each iocBuild, like piniProcessHook, as the hook list
+ * may have been freed since. A second registration would see each state
+ * twice in a row.
+ */
+static void initTimingHook(initHookState state)
+{
+    if (state == initHookAtIocBuild)
+        nHookTimes = 0;
+    else if (nHookTimes && hookTimes[nHookTimes - 1].state == state)
+        return;
+    if (nHookTimes < MAX_HOOK_TIMES) {
+        hookTimes[nHookTimes].state = state;
+        hookTimes[nHookTimes].time = epicsMonotonicGet();
+        nHookTimes++;
+    }
+}
+
+static void initTimingInit(void)
+{
+    initHookRegister(initTimingHook);
+    memset(phaseTime, 0, sizeof(phaseTime));
+    initThreadsUsed = 1;
+    free(typeTimes);
+    typeTimes = NULL;
+    nTypeTimes = 0;
+}
+
+static void initChunkJob(void *arg, epicsJobMode mode)
+{
+    initChunk *pchunk = (initChunk *)arg;
+    epicsUInt64 start;
+    int i;
+
+    if (mode != epicsJobModeRun)
+        return;
+    start = epicsMonotonicGet();
+    for (i = 0; i < pchunk->count; i++)
+        pchunk->func(pchunk->rtype, pchunk->precs[i], NULL);
+    pchunk->elapsed = epicsMonotonicGet() - start;
+}
+
+/* Divide the records into chunks of one record type. Records of a type
+ * which is not thread safe form one serial chunk per type; the others
+ * are split into parallel chunks of up to INIT_CHUNK records.
+ * A record is thread safe if its record support and its device support,
+ * if any, have been declared so with iocInitThreadSafe(). Without split
+ * every record is serial, so each type keeps its usual order.
+ */
+static initChunk * makeChunks(dbCommon **precs, int *pnChunks, int split)
+{
+    dbRecordType *pdbRecordType;
+    initChunk *chunks;
+    int type, nChunks = 0, maxChunks = 0;
+
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node))
+        maxChunks += 1 + ellCount(&pdbRecordType->recList) / INIT_CHUNK + 1;
+    chunks = dbCalloc(maxChunks, sizeof(initChunk));
+
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList),
+         type = 0;
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node),
+         type++) {
+        int rsetSafe = split && isDeclared(pdbRecordType->name, NULL);
+        int nDev = ellCount(&pdbRecordType->devList);
+        char *devSafe = dbCalloc(nDev + 1, 1);
+        dbRecordNode *pdbRecordNode;
+        devSup *pdevSup;
+        dbCommon **pserial, **pparallel;
+        int i, nSerial = 0, nParallel = 0;
+
+        for (pdevSup = (devSup *)ellFirst(&pdbRecordType->devList), i = 0;
+             pdevSup;
+             pdevSup = (devSup *)ellNext(&pdevSup->node), i++)
+            devSafe[i] = isDeclared(pdbRecordType->name, pdevSup->choice);
+
+        for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+             pdbRecordNode;
+             pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
+            dbCommon *precord = pdbRecordNode->precord;
+
+            if (!precord->name[0] ||
+                pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
+                continue;
+            typeTimes[type].records++;
+            if (rsetSafe && (precord->dtyp >= nDev || devSafe[precord->dtyp]))
+                nParallel++;
+            else
+                nSerial++;
+        }
+        typeTimes[type].name = pdbRecordType->name;
+        typeTimes[type].parallel = nParallel;
+
+        /* Serial records first, each group in list order */
+        pserial = precs;
+        pparallel = precs + nSerial;
+        for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+             pdbRecordNode;
+             pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
+            dbCommon *precord = pdbRecordNode->precord;
+
+            if (!precord->name[0] ||
+                pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
+                continue;
+            if (rsetSafe && (precord->dtyp >= nDev || devSafe[precord->dtyp]))
+                *pparallel++ = precord;
+            else
+                *pserial++ = precord;
+        }
+        free(devSafe);
+
+        if (nSerial) {
+            chunks[nChunks].type = type;
+            chunks[nChunks].rtype = pdbRecordType;
+            chunks[nChunks].precs = precs;
+            chunks[nChunks].count = nSerial;
+            nChunks++;
+        }
+        for (i = 0; i < nParallel; i += INIT_CHUNK) {
+            chunks[nChunks].parallel = TRUE;
+            chunks[nChunks].type = type;
+            chunks[nChunks].rtype = pdbRecordType;
+            chunks[nChunks].precs = precs + nSerial + i;
+            chunks[nChunks].count = nParallel - i < INIT_CHUNK ?
+                nParallel - i : INIT_CHUNK;
+            nChunks++;
+        }
+        precs += nSerial + nParallel;
+    }
+    *pnChunks = nChunks;
+    return chunks;
+}
+
+/* Run one initialization pass over all chunks. The serial chunks are
+ * run by this thread while the pool works on the others.
+ */
+static void initPass(int pass, recIterFunc func, epicsThreadPool *pool,
+    initChunk *chunks, int nChunks)
+{
+    epicsUInt64 start = epicsMonotonicGet();
+    int i;
+
+    for (i = 0; i < nChunks; i++) {
+        initChunk *pchunk = &chunks[i];
+
+        pchunk->func = func;
+        pchunk->elapsed = 0;
+        pchunk->queued = pchunk->job && !epicsJobQueue(pchunk->job);
+    }
+    for (i = 0; i < nChunks; i++) {
+        if (!chunks[i].queued)
+            initChunkJob(&chunks[i], epicsJobModeRun);
+    }
+    if (pool)
+        epicsThreadPoolWait(pool, -1.0);
+
+    for (i = 0; i < nChunks; i++)
+        typeTimes[chunks[i].type].pass[pass] += chunks[i].elapsed;
+    phaseTime[pass == 0 ? initPass0 : initPass1] = epicsMonotonicGet() - start;
+}
+
 static void initDatabase(void)
 {
+    epicsThreadPool *pool = NULL;
+    dbRecordType *pdbRecordType;
+    initChunk *chunks;
+    dbCommon **precs;
+    epicsUInt64 start;
+    int i, nChunks, nRecords = 0;
+
     dbChannelInit();
-    iterateRecords(doInitRecord0, NULL);
+
+    nTypeTimes = ellCount(&pdbbase->recordTypeList);
+    typeTimes = dbCalloc(nTypeTimes + 1, sizeof(initTypeTimes));
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node))
+        nRecords += ellCount(&pdbRecordType->recList);
+    precs = dbCalloc(nRecords + 1, sizeof(dbCommon *));
+
+    if (initThreads > 1) {
+        epicsThreadPoolConfig opts;
+
+        epicsThreadPoolConfigDefaults(&opts);
+        opts.initialThreads = opts.maxThreads = initThreads;
+        opts.workerStack = epicsThreadGetStackSize(epicsThreadStackBig);
+        pool = epicsThreadPoolCreate(&opts);
+        if (!pool)
+            errlogPrintf("iocInit: " ERL_WARNING
+                " Can't create thread pool, initializing serially\n");
+    }
+    chunks = makeChunks(precs, &nChunks, pool != NULL);
+    if (pool) {
+        initThreadsUsed = initThreads;
+        for (i = 0; i < nChunks; i++) {
+            if (chunks[i].parallel)
+                chunks[i].job = epicsJobCreate(pool, initChunkJob, &chunks[i]);
+        }
+    }
+
+    initPass(0, doInitRecord0, pool, chunks, nChunks);
+
+    start = epicsMonotonicGet();
     iterateRecords(doResolveLinks, NULL);
-    iterateRecords(doInitRecord1, NULL);
+    phaseTime[initLinks] = epicsMonotonicGet() - start;
+
+    initPass(1, doInitRecord1, pool, chunks, nChunks);
+
+    if (pool) {
+        for (i = 0; i < nChunks; i++) {
+            if (chunks[i].job)
+                epicsJobDestroy(chunks[i].job);
+        }
+        epicsThreadPoolDestroy(pool);
+    }
+    free(chunks);
+    free(precs);
 
     epicsAtExit(exitDatabase, NULL);
     return;
 }
+
+/* Most costly first */
+static int cmpTypeTimes(const void *a, const void *b)
+{
+    const initTypeTimes *pa = (const initTypeTimes *)a;
+    const initTypeTimes *pb = (const initTypeTimes *)b;
+    epicsUInt64 ta = pa->pass[0] + pa->pass[1];
+    epicsUInt64 tb = pb->pass[0] + pb->pass[1];
+
+    if (ta != tb)
+        return ta < tb ? 1 : -1;
+    return 0;
+}
+
+void iocInitTimes(void)
+{
+    static const char *phaseName[initNumPhases] = {
+        "init_record pass 0", "Link resolution", "init_record pass 1",
+        "PINI YES processing"
+    };
+    initTypeTimes *sorted;
+    int i;
+
+    if (!nHookTimes) {
+        printf("iocInit has not been run\n");
+        return;
+    }
+
+    printf("%-30s %10s %10s\n", "Init hook", "at s", "step ms");
+    for (i = 0; i < nHookTimes; i++) {
+        printf("%-30s %10.3f %10.3f\n", initHookName(hookTimes[i].state),
+            (hookTimes[i].time - hookTimes[0].time) * 1e-9,
+            i ? (hookTimes[i].time - hookTimes[i - 1].time) * 1e-6 : 0.0);
+    }
+
+    printf("\nRecord initialization with %d thread%s:\n", initThreadsUsed,
+        initThreadsUsed > 1 ? "s" : "");
+    for (i = 0; i < initNumPhases; i++)
+        printf("  %-28s %10.3f ms\n", phaseName[i], phaseTime[i] * 1e-6);
+
+    if (!nTypeTimes)
+        return;
+    sorted = dbCalloc(nTypeTimes, sizeof(initTypeTimes));
+    memcpy(sorted, typeTimes, nTypeTimes * sizeof(initTypeTimes));
+    qsort(sorted, nTypeTimes, sizeof(initTypeTimes), cmpTypeTimes);
+    printf("\n%-30s %10s %10s %10s %10s\n", "Record type", "records",
+        "parallel", "pass 0 ms", "pass 1 ms");
+    for (i = 0; i < nTypeTimes; i++) {
+        if (!sorted[i].records)
+            continue;
+        printf("%-30s %10lu %10lu %10.3f %10.3f\n", sorted[i].name,
+            (unsigned long)sorted[i].records,
+            (unsigned long)sorted[i].parallel,
+            sorted[i].pass[0] * 1e-6, sorted[i].pass[1] * 1e-6);
+    }
+    free(sorted);
+}
+
 
 /*
  *  Process database records at initialization ordered by phase
@@ -640,8 +1006,11 @@ static void piniProcessHook(initHookState state)
 
 static void initialProcess(void)
 {
+    epicsUInt64 start = epicsMonotonicGet();
+
     initHookRegister(piniProcessHook);
     piniProcess(menuPiniYES);
+    phaseTime[initPini] = epicsMonotonicGet() - start;
 }
 
 
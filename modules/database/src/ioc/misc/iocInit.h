@@ -30,6 +30,17 @@ DBCORE_API int iocRun(void);
 DBCORE_API int iocPause(void);
 DBCORE_API int iocShutdown(void);
 
+/* Initialize records with several threads, before iocInit.
+ * count <= 0 is relative to the number of CPUs.
+ */
+DBCORE_API int iocInitThreads(int count);
+/* Declare the init_record() of a record type (dtyp NULL) or of one of
+ * its device supports safe to run in parallel with other records.
+ */
+DBCORE_API int iocInitThreadSafe(const char *recordType, const char *dtyp);
+/* Print the time taken by each step of the last iocInit */
+DBCORE_API void iocInitTimes(void);
+
 #ifdef __cplusplus
 }
 #endif
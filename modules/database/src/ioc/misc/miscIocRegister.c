@@ -53,6 +53,43 @@ static void iocPauseCallFunc(const iocshArgBuf *args)
     iocshSetError(iocPause());
 }
 
+/* iocInitThreads */
+static const iocshArg iocInitThreadsArg0 = { "no of threads",iocshArgInt};
+static const iocshArg * const iocInitThreadsArgs[] = {&iocInitThreadsArg0};
+static const iocshFuncDef iocInitThreadsFuncDef = {"iocInitThreads",1,iocInitThreadsArgs,
+             "Run init_record() for records declared thread safe with several threads.\n"
+             "no of threads <= 0 is relative to the number of CPUs.\n"
+             "Must be called before iocInit.\n"
+             "See more: iocInitThreadSafe, iocInitTimes\n"};
+static void iocInitThreadsCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(iocInitThreads(args[0].ival));
+}
+
+/* iocInitThreadSafe */
+static const iocshArg iocInitThreadSafeArg0 = { "record type",iocshArgString};
+static const iocshArg iocInitThreadSafeArg1 = { "DTYP",iocshArgString};
+static const iocshArg * const iocInitThreadSafeArgs[] =
+    {&iocInitThreadSafeArg0, &iocInitThreadSafeArg1};
+static const iocshFuncDef iocInitThreadSafeFuncDef = {"iocInitThreadSafe",2,iocInitThreadSafeArgs,
+             "Declare that init_record() of a record type, or of one of its device\n"
+             "supports if DTYP is given, may run in parallel with other records.\n"
+             "A record is initialized in parallel when both its record type and\n"
+             "its device support, if it has one, have been declared.\n"};
+static void iocInitThreadSafeCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(iocInitThreadSafe(args[0].sval, args[1].sval));
+}
+
+/* iocInitTimes */
+static const iocshFuncDef iocInitTimesFuncDef = {"iocInitTimes",0,NULL,
+             "Print the time taken by each step of the last iocInit,\n"
+             "and by the init_record() passes of each record type.\n"};
+static void iocInitTimesCallFunc(const iocshArgBuf *args)
+{
+    iocInitTimes();
+}
+
 /* coreRelease */
 static const iocshFuncDef coreReleaseFuncDef = {"coreRelease",0,NULL,
              "Print release information for iocCore.\n"};
@@ -68,6 +105,9 @@ void miscIocRegister(void)
     iocshRegister(&iocBuildFuncDef,iocBuildCallFunc);
     iocshRegister(&iocRunFuncDef,iocRunCallFunc);
     iocshRegister(&iocPauseFuncDef,iocPauseCallFunc);
+    iocshRegister(&iocInitThreadsFuncDef,iocInitThreadsCallFunc);
+    iocshRegister(&iocInitThreadSafeFuncDef,iocInitThreadSafeCallFunc);
+    iocshRegister(&iocInitTimesFuncDef,iocInitTimesCallFunc);
     iocshRegister(&coreReleaseFuncDef, coreReleaseCallFunc);
 }
 
@@ -30,6 +30,7 @@
 #include "caerr.h"
 #include "net_convert.h"
 
+#include "dbTrace.h"
 #include "server.h"
 
 /*
@@ -64,7 +65,13 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
     }
 
     while ( pclient->send.stk && ! pclient->disconnect ) {
+        if ( dbTraceMode ) {
+            dbTraceEvent ( dbTraceSend, 'B', pclient, pclient->send.stk );
+        }
         status = send ( pclient->sock, pclient->send.buf, pclient->send.stk, 0 );
+        if ( dbTraceMode ) {
+            dbTraceEvent ( dbTraceSend, 'E', pclient, 0 );
+        }
         if ( status >= 0 ) {
             unsigned transferSize = (unsigned) status;
             if ( transferSize >= pclient->send.stk ) {
@@ -0,0 +1,163 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *   Waveform device support for the record processing profiler.
+ *
+ *   The INP field selects which column of the profile the waveform holds,
+ *   one element per record, most costly record first:
+ *     @NAME       record names, FTVL must be STRING
+ *     @COUNT      calls to the process routine
+ *     @SELF       self time in seconds
+ *     @TOTAL      total time in seconds
+ *     @MAX        longest call in seconds
+ *     @ASYNC      mean time from PACT set to completion in seconds
+ *     @ASYNCMAX   longest time from PACT set to completion in seconds
+ *   All columns except NAME need FTVL DOUBLE.
+ *
+ *   The ranking is shared by all these waveforms and only recomputed when
+ *   it is older than RANK_AGE seconds, so waveforms processed together
+ *   (e.g. through forward links) show the same records in the same order.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "dbProfile.h"
+#include "epicsMutex.h"
+#include "epicsString.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "menuFtype.h"
+#include "recGbl.h"
+#include "devSup.h"
+#include "waveformRecord.h"
+#include "epicsExport.h"
+
+#define RANK_AGE 0.1
+
+static struct wf_channel {
+    char *name;
+    size_t offset;      /* of a double in dbProfileEntry */
+} wf_channels[] = {
+    {"NAME",     0},
+    {"COUNT",    offsetof(dbProfileEntry, count)},
+    {"SELF",     offsetof(dbProfileEntry, selfTime)},
+    {"TOTAL",    offsetof(dbProfileEntry, totalTime)},
+    {"MAX",      offsetof(dbProfileEntry, maxTime)},
+    {"ASYNC",    offsetof(dbProfileEntry, asyncTime)},
+    {"ASYNCMAX", offsetof(dbProfileEntry, asyncMax)},
+};
+
+static epicsThreadOnceId rankOnceId = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId rankLock;
+static dbProfileEntry *ranking;
+static int rankSize;
+static int rankUsed;
+static epicsTimeStamp rankTime;
+
+static void rankOnce(void *junk)
+{
+    rankLock = epicsMutexMustCreate();
+}
+
+static long init_record(dbCommon *pcommon)
+{
+    waveformRecord *prec = (waveformRecord *)pcommon;
+    int i;
+
+    if (prec->inp.type != INST_IO) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "devWfDbProfile::init_record: Illegal INP field");
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+
+    epicsThreadOnce(&rankOnceId, rankOnce, NULL);
+    for (i = 0; i < NELEMENTS(wf_channels); i++) {
+        struct wf_channel *pchan = &wf_channels[i];
+
+        if (epicsStrCaseCmp(prec->inp.value.instio.string, pchan->name))
+            continue;
+        if (prec->ftvl != (pchan->offset ? menuFtypeDOUBLE : menuFtypeSTRING))
+            break;
+        prec->dpvt = pchan;
+        prec->nord = 0;
+
+        epicsMutexMustLock(rankLock);
+        if ((int)prec->nelm > rankSize) {
+            free(ranking);
+            ranking = callocMustSucceed(prec->nelm, sizeof(dbProfileEntry),
+                "devWfDbProfile");
+            rankSize = prec->nelm;
+            rankUsed = 0;
+        }
+        epicsMutexUnlock(rankLock);
+        return 0;
+    }
+
+    recGblRecordError(S_db_badField, (void *)prec,
+                      "devWfDbProfile::init_record: Bad parm or FTVL");
+    prec->pact = TRUE;
+    prec->dpvt = NULL;
+    return S_db_badField;
+}
+
+static long read_wf(waveformRecord *prec)
+{
+    struct wf_channel *pchan = (struct wf_channel *)prec->dpvt;
+    epicsUInt32 nord = prec->nord;
+    epicsTimeStamp now;
+    int i, n;
+
+    if (!pchan)
+        return -1;
+
+    epicsMutexMustLock(rankLock);
+    epicsTimeGetMonotonic(&now);
+    if (!rankUsed || epicsTimeDiffInSeconds(&now, &rankTime) > RANK_AGE) {
+        rankUsed = dbProfileTop(ranking, rankSize);
+        rankTime = now;
+    }
+
+    n = rankUsed < (int)prec->nelm ? rankUsed : (int)prec->nelm;
+    for (i = 0; i < n; i++) {
+        dbProfileEntry *pentry = &ranking[i];
+
+        if (!pchan->offset) {
+            char *pname = (char *)prec->bptr + i * MAX_STRING_SIZE;
+
+            strncpy(pname, pentry->precord->name, MAX_STRING_SIZE);
+            pname[MAX_STRING_SIZE - 1] = '\0';
+        }
+        else if (pchan->offset == offsetof(dbProfileEntry, asyncTime)) {
+            ((double *)prec->bptr)[i] = pentry->asyncCount > 0 ?
+                pentry->asyncTime / pentry->asyncCount : 0.0;
+        }
+        else {
+            ((double *)prec->bptr)[i] =
+                *(double *)((char *)pentry + pchan->offset);
+        }
+    }
+    epicsMutexUnlock(rankLock);
+
+    prec->nord = n;
+    prec->udf = FALSE;
+    if (nord != prec->nord)
+        db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
+    return 0;
+}
+
+wfdset devWfDbProfile = {
+    {5, NULL, NULL, init_record, NULL},
+    read_wf
+};
+epicsExportAddress(dset, devWfDbProfile);
@@ -10,6 +10,9 @@
 /*  Usage
  *      {calc:{expr:"A*B", args:[{...}, ...], units:"mm"}}
  *  First link in 'args' is 'A', second is 'B', and so forth.
+ *  An input link with 'nelm' reads its args as arrays of up to that many
+ *  elements, and returns the expression's value for each element, or one
+ *  value if 'reduce' names a reduction.
  */
 
 #include <string.h>
@@ -49,6 +52,7 @@ typedef struct calc_link {
         ps_prec,
         ps_units,
         ps_time,
+        ps_nelm, ps_reduce,
         ps_error
     } pstate;
     epicsEnum16 stat;
@@ -69,10 +73,39 @@ typedef struct calc_link {
     epicsTimeStamp time;
     epicsUTag utag;
     double val;
+    /* Array mode, when nelm > 0 */
+    epicsUInt32 nelm;
+    int reduce;
+    double *parr[CALCPERFORM_NARGS];
+    epicsUInt32 narr[CALCPERFORM_NARGS];
+    double *pval;
+    double *palarm;
+    epicsUInt32 nval;
 } calc_link;
 
 static lset lnkCalc_lset;
 
+static const struct {
+    const char *name;
+    int op;
+} reductions[] = {
+    {"sum", CALC_REDUCE_SUM},
+    {"min", CALC_REDUCE_MIN},
+    {"max", CALC_REDUCE_MAX},
+    {"avg", CALC_REDUCE_AVG},
+    {"std", CALC_REDUCE_STD},
+};
+
+static void freeArrays(calc_link *clink)
+{
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++)
+        free(clink->parr[i]);
+    free(clink->pval);
+    free(clink->palarm);
+}
+
 
 /*************************** jlif Routines **************************/
 
@@ -117,6 +150,7 @@ static void lnkCalc_free(jlink *pjlink)
     free(clink->post_major);
     free(clink->post_minor);
     free(clink->units);
+    freeArrays(clink);
     free(clink);
 }
 
@@ -129,6 +163,15 @@ static jlif_result lnkCalc_integer(jlink *pjlink, long long num)
         return jlif_continue;
     }
 
+    if (clink->pstate == ps_nelm) {
+        if (num < 1 || num > 0x7fffffff) {
+            errlogPrintf("lnkCalc: Bad 'nelm' %lld\n", num);
+            return jlif_stop;
+        }
+        clink->nelm = num;
+        return jlif_continue;
+    }
+
     if (clink->pstate != ps_args) {
         errlogPrintf("lnkCalc: Unexpected integer %lld\n", num);
         return jlif_stop;
@@ -176,6 +219,20 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
         return jlif_continue;
     }
 
+    if (clink->pstate == ps_reduce) {
+        int i;
+
+        for (i = 0; i < NELEMENTS(reductions); i++) {
+            if (strlen(reductions[i].name) == len &&
+                !epicsStrnCaseCmp(val, reductions[i].name, len)) {
+                clink->reduce = reductions[i].op;
+                return jlif_continue;
+            }
+        }
+        errlogPrintf("lnkCalc: Unknown reduction \"%.*s\"\n", (int) len, val);
+        return jlif_stop;
+    }
+
     if (clink->pstate == ps_time) {
         char tinp;
 
@@ -273,6 +330,8 @@ static jlif_result lnkCalc_map_key(jlink *pjlink, const char *key, size_t len)
             clink->pstate = ps_prec;
         else if (!strncmp(key, "time", len))
             clink->pstate = ps_time;
+        else if (!strncmp(key, "nelm", len) && !clink->nelm)
+            clink->pstate = ps_nelm;
         else {
             errlogPrintf("lnkCalc: Unknown key \"%.4s\"\n", key);
             return jlif_stop;
@@ -290,6 +349,8 @@ static jlif_result lnkCalc_map_key(jlink *pjlink, const char *key, size_t len)
             return jlif_stop;
         }
     }
+    else if (len == 6 && !strncmp(key, "reduce", len) && !clink->reduce)
+        clink->pstate = ps_reduce;
     else {
         errlogPrintf("lnkCalc: Unknown key \"%.*s\"\n", (int) len, key);
         return jlif_stop;
@@ -314,6 +375,30 @@ static jlif_result lnkCalc_end_map(jlink *pjlink)
         errlogPrintf("lnkCalc: No output link ('out' key)\n");
         return jlif_stop;
     }
+    else if (clink->reduce && !clink->nelm) {
+        errlogPrintf("lnkCalc: 'reduce' needs 'nelm'\n");
+        return jlif_stop;
+    }
+    else if (clink->nelm) {
+        int i;
+
+        if (clink->dbfType != DBF_INLINK) {
+            errlogPrintf("lnkCalc: 'nelm' is only for input links\n");
+            return jlif_stop;
+        }
+        for (i = 0; i < clink->nArgs; i++) {
+            clink->parr[i] = calloc(clink->nelm, sizeof(double));
+            if (!clink->parr[i])
+                goto nomem;
+        }
+        clink->pval = calloc(clink->nelm, sizeof(double));
+        clink->palarm = calloc(clink->nelm, sizeof(double));
+        if (!clink->pval || !clink->palarm) {
+nomem:
+            errlogPrintf("lnkCalc: Out of memory\n");
+            return jlif_stop;
+        }
+    }
 
     return jlif_continue;
 }
@@ -381,9 +466,14 @@ static void lnkCalc_report(const jlink *pjlink, int level, int indent)
     calc_link *clink = CONTAINER(pjlink, struct calc_link, jlink);
     int i;
 
-    printf("%*s'calc': \"%s\" = %.*g %s\n", indent, "",
-        clink->expr, clink->prec, clink->val,
-        clink->units ? clink->units : "");
+    if (clink->nelm && !clink->reduce)
+        printf("%*s'calc': \"%s\" = [%u of %u] %s\n", indent, "",
+            clink->expr, clink->nval, clink->nelm,
+            clink->units ? clink->units : "");
+    else
+        printf("%*s'calc': \"%s\" = %.*g %s\n", indent, "",
+            clink->expr, clink->prec, clink->val,
+            clink->units ? clink->units : "");
 
     if (level > 0) {
         if (clink->sevr)
@@ -412,8 +502,12 @@ static void lnkCalc_report(const jlink *pjlink, int level, int indent)
             jlink *child = plink->type == JSON_LINK ?
                 plink->value.json.jlink : NULL;
 
-            printf("%*s  Input %c: %g\n", indent, "",
-                i + 'A', clink->arg[i]);
+            if (clink->nelm)
+                printf("%*s  Input %c: [%u elements]\n", indent, "",
+                    i + 'A', clink->narr[i]);
+            else
+                printf("%*s  Input %c: %g\n", indent, "",
+                    i + 'A', clink->arg[i]);
 
             if (child)
                 dbJLinkReport(child, level - 1, indent + 4);
@@ -460,6 +554,15 @@ static void lnkCalc_open(struct link *plink)
         child->precord = plink->precord;
         dbJLinkInit(child);
         dbLoadLink(child, DBR_DOUBLE, &clink->arg[i]);
+
+        if (clink->nelm) {
+            long n = clink->nelm;
+
+            clink->parr[i][0] = clink->arg[i];
+            clink->narr[i] = 1;
+            if (!dbLoadLinkArray(child, DBR_DOUBLE, clink->parr[i], &n))
+                clink->narr[i] = n;
+        }
     }
 
     if (clink->out.type == JSON_LINK) {
@@ -490,6 +593,7 @@ static void lnkCalc_remove(struct dbLocker *locker, struct link *plink)
     free(clink->post_major);
     free(clink->post_minor);
     free(clink->units);
+    freeArrays(clink);
     free(clink);
     plink->value.json.jlink = NULL;
 }
@@ -527,7 +631,10 @@ static int lnkCalc_getDBFtype(const struct link *plink)
 
 static long lnkCalc_getElements(const struct link *plink, long *nelements)
 {
-    *nelements = 1;
+    calc_link *clink = CONTAINER(plink->value.json.jlink,
+        struct calc_link, jlink);
+
+    *nelements = clink->nelm && !clink->reduce ? clink->nelm : 1;
     return 0;
 }
 
@@ -536,13 +643,15 @@ struct lcvt {
     double *pval;
     epicsTimeStamp *ptime;
     epicsUTag *ptag;
+    long *pnReq;
 };
 
 static long readLocked(struct link *pinp, void *vvt)
 {
     struct lcvt *pvt = (struct lcvt *) vvt;
     long nReq = 1;
-    long status = dbGetLink(pinp, DBR_DOUBLE, pvt->pval, NULL, &nReq);
+    long status = dbGetLink(pinp, DBR_DOUBLE, pvt->pval, NULL,
+        pvt->pnReq ? pvt->pnReq : &nReq);
 
     if (!status && pvt->ptime)
         dbGetTimeStampTag(pinp, pvt->ptime, pvt->ptag);
@@ -550,6 +659,124 @@ static long readLocked(struct link *pinp, void *vvt)
     return status;
 }
 
+/* Evaluate an alarm expression over the results, TRUE if any element is */
+static int arrayAlarm(calc_link *clink, const calcArrayArg *args,
+    const char *post, long *pstatus)
+{
+    epicsUInt32 n = clink->nval;
+    epicsUInt32 i;
+
+    memcpy(clink->palarm, clink->pval, n * sizeof(double));
+    *pstatus = calcPerformArray(args, clink->palarm, &n, post);
+    for (i = 0; !*pstatus && i < n; i++) {
+        if (clink->palarm[i])
+            return 1;
+    }
+    return 0;
+}
+
+static long getArrayValue(struct link *plink, short dbrType, void *pbuffer,
+    long *pnRequest)
+{
+    calc_link *clink = CONTAINER(plink->value.json.jlink,
+        struct calc_link, jlink);
+    dbCommon *prec = plink->precord;
+    calcArrayArg args[CALCPERFORM_NARGS];
+    FASTCONVERT conv = dbFastPutConvertRoutine[DBR_DOUBLE][dbrType];
+    const double *presult = clink->pval;
+    long nResult = 0;
+    long status = 0;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        struct link *child = &clink->inp[i];
+        long nReq = clink->nelm;
+
+        args[i].pval = &clink->arg[i];
+        args[i].nelem = 1;
+        if (i >= clink->nArgs)
+            continue;
+        args[i].pval = clink->parr[i];
+
+        /* Constants were loaded by lnkCalc_open() */
+        if (!dbLinkIsConstant(child)) {
+            if (i == clink->tinp) {
+                struct lcvt vt = {clink->parr[i], &clink->time, &clink->utag,
+                    &nReq};
+
+                status = dbLinkDoLocked(child, readLocked, &vt);
+                if (status == S_db_noLSET)
+                    status = readLocked(child, &vt);
+
+                if (dbLinkIsConstant(&prec->tsel) &&
+                    prec->tse == epicsTimeEventDeviceTime) {
+                    prec->time = clink->time;
+                    prec->utag = clink->utag;
+                }
+            }
+            else
+                status = dbGetLink(child, DBR_DOUBLE, clink->parr[i], NULL,
+                    &nReq);
+            if (!status)
+                clink->narr[i] = nReq;
+        }
+        args[i].nelem = clink->narr[i];
+    }
+    clink->stat = 0;
+    clink->sevr = 0;
+    clink->amsg[0] = '\0';
+
+    clink->nval = clink->nelm;
+    status = calcPerformArray(args, clink->pval, &clink->nval,
+        clink->post_expr);
+    if (status)
+        clink->nval = 0;
+    clink->val = clink->nval ? clink->pval[0] : 0.0;
+
+    if (!status && clink->post_major &&
+        arrayAlarm(clink, args, clink->post_major, &status)) {
+        clink->stat = LINK_ALARM;
+        clink->sevr = MAJOR_ALARM;
+        strcpy(clink->amsg, "post_major error");
+        recGblSetSevrMsg(prec, clink->stat, clink->sevr, "post_major error");
+    }
+
+    if (!status && !clink->sevr && clink->post_minor &&
+        arrayAlarm(clink, args, clink->post_minor, &status)) {
+        clink->stat = LINK_ALARM;
+        clink->sevr = MINOR_ALARM;
+        strcpy(clink->amsg, "post_minor error");
+        recGblSetSevrMsg(prec, clink->stat, clink->sevr, "post_minor error");
+    }
+
+    if (!status) {
+        if (clink->reduce) {
+            status = calcArrayReduce(clink->reduce, clink->pval, clink->nval,
+                &clink->val);
+            presult = &clink->val;
+            nResult = 1;
+        }
+        else
+            nResult = clink->nval;
+    }
+    if (!pnRequest && nResult > 1)
+        nResult = 1;
+    else if (pnRequest && nResult > *pnRequest)
+        nResult = *pnRequest;
+
+    if (!status) {
+        char *pdest = pbuffer;
+        int size = dbValueSize(dbrType);
+
+        for (i = 0; !status && i < nResult; i++, pdest += size)
+            status = conv(&presult[i], pdest, NULL);
+    }
+    if (pnRequest)
+        *pnRequest = status ? 0 : nResult;
+
+    return status;
+}
+
 static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     long *pnRequest)
 {
@@ -563,6 +790,9 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if(INVALID_DB_REQ(dbrType))
         return S_db_badDbrtype;
 
+    if (clink->nelm)
+        return getArrayValue(plink, dbrType, pbuffer, pnRequest);
+
     conv = dbFastPutConvertRoutine[DBR_DOUBLE][dbrType];
 
     /* Any link errors will trigger a LINK/INVALID alarm in the child link */
@@ -571,7 +801,7 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
         long nReq = 1;
 
         if (i == clink->tinp) {
-            struct lcvt vt = {&clink->arg[i], &clink->time, &clink->utag};
+            struct lcvt vt = {&clink->arg[i], &clink->time, &clink->utag, NULL};
 
             status = dbLinkDoLocked(child, readLocked, &vt);
             if (status == S_db_noLSET)
@@ -651,7 +881,7 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
         long nReq = 1;
 
         if (i == clink->tinp) {
-            struct lcvt vt = {&clink->arg[i], &clink->time, &clink->utag};
+            struct lcvt vt = {&clink->arg[i], &clink->time, &clink->utag, NULL};
 
             status = dbLinkDoLocked(child, readLocked, &vt);
             if (status == S_db_noLSET)
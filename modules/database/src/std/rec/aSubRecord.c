@@ -20,14 +20,21 @@
 #include <string.h>
 
 #include "alarm.h"
+#include "callback.h"
 #include "cantProceed.h"
 #include "dbDefs.h"
 #include "dbEvent.h"
 #include "dbAccess.h"
+#include "dbLock.h"
 #include "dbFldTypes.h"
 #include "dbStaticLib.h"
 #include "errMdef.h"
 #include "errlog.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsThreadPool.h"
+#include "epicsTime.h"
+#include "menuYesNo.h"
 #include "recSup.h"
 #include "devSup.h"
 #include "special.h"
@@ -88,9 +95,19 @@ static long initFields(epicsEnum16 *pft, epicsUInt32 *pno, epicsUInt32 *pne,
 static long fetch_values(aSubRecord *prec);
 static void monitor(aSubRecord *);
 static long do_sub(aSubRecord *);
+static int async_start(aSubRecord *);
+static long async_finish(aSubRecord *);
 
 #define NUM_ARGS        21
 
+/* Threads in the pool for ASYN=YES, 0 means one per CPU */
+int aSubAsyncThreads = 0;
+epicsExportAddress(int, aSubAsyncThreads);
+
+/* Subroutines queued or running on the pool at once, over all records */
+int aSubAsyncMaxJobs = 64;
+epicsExportAddress(int, aSubAsyncMaxJobs);
+
 /* These are the names of the Input fields */
 static const char *Ifldnames[] = {
     "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K",
@@ -105,6 +122,19 @@ static const char *Ofldnames[] = {
 };
 
 
+/* State kept for ASYN=YES */
+struct aSubAsync {
+    aSubRecord *prec;
+    aSubRecord shadow;
+    epicsJob *job;
+    epicsCallback callback;
+    void *pin[NUM_ARGS];
+    void *pout[NUM_ARGS];
+    epicsUInt64 queued, started, finished;
+    long status;
+    int done;
+};
+
 static long init_record(struct dbCommon *pcommon, int pass)
 {
     struct aSubRecord *prec = (struct aSubRecord *)pcommon;
@@ -219,7 +249,12 @@ static long process(struct dbCommon *pcommon)
     }
 
     if (!status) {
-        status = do_sub(prec);
+        if (pact && prec->apvt && prec->apvt->done)
+            status = async_finish(prec);
+        else if (!pact && prec->asyn == menuYesNoYES && async_start(prec))
+            return 0;
+        else
+            status = do_sub(prec);
         prec->val = status;
     }
 
@@ -472,6 +507,167 @@ static long do_sub(aSubRecord *prec)
 }
 
 
+/* Asynchronous execution on the thread pool.
+ *
+ * The subroutine is given a copy of the record whose input and output
+ * pointers lead to buffers of our own, so it can run without the lock
+ * while the record's fields are being read or written by others.
+ */
+
+static epicsThreadOnceId asyncOnce = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPool *asyncPool;
+static int asyncJobs;
+
+static void async_pool_create(void *junk)
+{
+    epicsThreadPoolConfig opts;
+
+    epicsThreadPoolConfigDefaults(&opts);
+    if (aSubAsyncThreads > 0)
+        opts.maxThreads = aSubAsyncThreads;
+    asyncPool = epicsThreadPoolCreate(&opts);
+    if (!asyncPool)
+        errlogPrintf("aSubRecord: " ERL_WARNING
+            " Can't create thread pool, ASYN will be ignored\n");
+}
+
+static void async_job(void *arg, epicsJobMode mode)
+{
+    struct aSubAsync *pasync = arg;
+    aSubRecord *prec = pasync->prec;
+
+    if (mode == epicsJobModeCleanup)
+        return;
+
+    /* The record isn't locked here, so use the copies that async_start()
+     * made in the shadow while it was, in case SNAM or PRIO change.
+     */
+    pasync->started = epicsMonotonicGet();
+    pasync->status = pasync->shadow.sadr(&pasync->shadow);
+    pasync->finished = epicsMonotonicGet();
+    pasync->done = TRUE;
+
+    if (callbackRequestProcessCallback(&pasync->callback,
+            pasync->shadow.prio, prec)) {
+        /* Callback queue full, finish on this thread instead */
+        dbScanLock((dbCommon *)prec);
+        prec->rset->process((dbCommon *)prec);
+        dbScanUnlock((dbCommon *)prec);
+    }
+}
+
+static struct aSubAsync * async_alloc(aSubRecord *prec)
+{
+    struct aSubAsync *pasync = callocMustSucceed(1, sizeof(struct aSubAsync),
+        "aSubRecord::async_alloc");
+    int i;
+
+    pasync->prec = prec;
+    for (i = 0; i < NUM_ARGS; i++) {
+        pasync->pin[i] = callocMustSucceed((&prec->noa)[i],
+            dbValueSize((&prec->fta)[i]), "aSubRecord::async_alloc");
+        pasync->pout[i] = callocMustSucceed((&prec->nova)[i],
+            dbValueSize((&prec->ftva)[i]), "aSubRecord::async_alloc");
+    }
+    pasync->job = epicsJobCreate(asyncPool, async_job, pasync);
+    if (!pasync->job) {
+        for (i = 0; i < NUM_ARGS; i++) {
+            free(pasync->pin[i]);
+            free(pasync->pout[i]);
+        }
+        free(pasync);
+        return NULL;
+    }
+    return pasync;
+}
+
+/* Returns TRUE if the subroutine was queued */
+static int async_start(aSubRecord *prec)
+{
+    struct aSubAsync *pasync = prec->apvt;
+    aSubRecord *pshadow;
+    int i;
+
+    if (prec->snam[0] == 0 || !prec->sadr)
+        return FALSE;
+
+    epicsThreadOnce(&asyncOnce, async_pool_create, NULL);
+    if (!asyncPool)
+        return FALSE;
+    if (!pasync) {
+        pasync = prec->apvt = async_alloc(prec);
+        if (!pasync)
+            return FALSE;
+    }
+
+    if (epicsAtomicIncrIntT(&asyncJobs) > aSubAsyncMaxJobs) {
+        epicsAtomicDecrIntT(&asyncJobs);
+        prec->nsyn++;
+        return FALSE;
+    }
+
+    /* The shadow includes the SADR that async_job() will call */
+    pshadow = &pasync->shadow;
+    *pshadow = *prec;
+    for (i = 0; i < NUM_ARGS; i++) {
+        memcpy(pasync->pin[i], (&prec->a)[i],
+            (&prec->noa)[i] * dbValueSize((&prec->fta)[i]));
+        memcpy(pasync->pout[i], (&prec->vala)[i],
+            (&prec->nova)[i] * dbValueSize((&prec->ftva)[i]));
+        (&pshadow->a)[i] = pasync->pin[i];
+        (&pshadow->vala)[i] = pasync->pout[i];
+    }
+    pshadow->pact = TRUE;
+
+    pasync->done = FALSE;
+    pasync->queued = epicsMonotonicGet();
+    if (epicsJobQueue(pasync->job)) {
+        epicsAtomicDecrIntT(&asyncJobs);
+        return FALSE;
+    }
+    prec->pact = TRUE;
+    return TRUE;
+}
+
+static long async_finish(aSubRecord *prec)
+{
+    struct aSubAsync *pasync = prec->apvt;
+    aSubRecord *pshadow = &pasync->shadow;
+    long status = pasync->status;
+    int i;
+
+    epicsAtomicDecrIntT(&asyncJobs);
+    pasync->done = FALSE;
+
+    prec->nrun++;
+    prec->tque = (pasync->started - pasync->queued) * 1e-9;
+    prec->texe = (pasync->finished - pasync->started) * 1e-9;
+    if (prec->texe > prec->tmax)
+        prec->tmax = prec->texe;
+
+    for (i = 0; i < NUM_ARGS; i++) {
+        epicsUInt32 nev = (&pshadow->neva)[i];
+
+        if (nev > (&prec->nova)[i])
+            nev = (&prec->nova)[i];
+        (&prec->neva)[i] = nev;
+        memcpy((&prec->vala)[i], pasync->pout[i],
+            nev * dbValueSize((&prec->ftva)[i]));
+    }
+    prec->dpvt = pshadow->dpvt;
+    if (pshadow->nsev > prec->nsev)
+        recGblSetSevrMsg(prec, pshadow->nsta, pshadow->nsev, "%s",
+            pshadow->namsg);
+
+    if (status < 0)
+        recGblSetSevr(prec, SOFT_ALARM, prec->brsv);
+    else
+        prec->udf = FALSE;
+
+    return status;
+}
+
+
 static long cvt_dbaddr(DBADDR *paddr)
 {
     aSubRecord *prec = (aSubRecord *)paddr->precord;
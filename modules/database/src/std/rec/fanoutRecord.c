@@ -20,13 +20,18 @@
 #include <string.h>
 
 #include "dbDefs.h"
+#include "epicsAtomic.h"
 #include "epicsPrint.h"
 #include "alarm.h"
+#include "callback.h"
+#include "cantProceed.h"
 #include "dbAccess.h"
 #include "dbEvent.h"
 #include "dbFldTypes.h"
 #include "errMdef.h"
 #include "epicsTypes.h"
+#include "link.h"
+#include "menuYesNo.h"
 #include "recSup.h"
 #include "recGbl.h"
 #include "dbCommon.h"
@@ -43,7 +48,7 @@
 #define initialize NULL
 static long init_record(struct dbCommon *, int);
 static long process(struct dbCommon *);
-#define special NULL
+static long special(DBADDR *, int);
 #define get_value NULL
 #define cvt_dbaddr NULL
 #define get_array_info NULL
@@ -89,14 +94,124 @@ static long init_record(struct dbCommon *pcommon, int pass)
     return 0;
 }
 
+/* State for PARL=YES, allocated when first needed */
+typedef struct fanoutPvt fanoutPvt;
+
+typedef struct fanoutLink {
+    epicsCallback callback;
+    fanoutPvt *ppvt;
+    char lookup;                /* The link has changed */
+    char local;                 /* A CA link to a record in this IOC */
+    DBADDR addr;                /* PROC field of the target */
+} fanoutLink;
+
+struct fanoutPvt {
+    fanoutRecord *prec;
+    epicsCallback done;
+    int pending;                /* Links still being processed */
+    epicsUInt16 oldn;
+    fanoutLink link[NLINKS];
+};
+
+static void parallelCallback(epicsCallback *pcallback)
+{
+    fanoutLink *pfl;
+    fanoutPvt *ppvt;
+    epicsUInt8 proc = 1;
+
+    callbackGetUser(pfl, pcallback);
+    ppvt = pfl->ppvt;
+    dbPutField(&pfl->addr, DBR_UCHAR, &proc, 1);
+
+    /* The last one to finish completes the fanout */
+    if (!epicsAtomicDecrIntT(&ppvt->pending))
+        callbackRequestProcessCallback(&ppvt->done, ppvt->prec->prio,
+            ppvt->prec);
+}
+
+/* Find the PROC field a CA forward link puts to, if its target is one of
+ * our records.
+ */
+static void lookupLink(fanoutLink *pfl, struct link *plink)
+{
+    pfl->local = plink->type == CA_LINK &&
+        (plink->value.pv_link.pvlMask & pvlOptFWD) &&
+        !dbNameToAddr(plink->value.pv_link.pvname, &pfl->addr);
+    pfl->lookup = FALSE;
+}
+
+/* Hand the selected CA links to local records to the callback threads and
+ * scan the rest here. Returns the number still being processed.
+ */
+static int scanParallel(fanoutRecord *prec, epicsUInt16 mask)
+{
+    fanoutPvt *ppvt = prec->rpvt;
+    struct link *plink = &prec->lnk0;
+    int i;
+
+    if (!ppvt) {
+        ppvt = callocMustSucceed(1, sizeof(fanoutPvt), "fanout::process");
+        ppvt->prec = prec;
+        for (i = 0; i < NLINKS; i++) {
+            fanoutLink *pfl = &ppvt->link[i];
+
+            pfl->ppvt = ppvt;
+            callbackSetCallback(parallelCallback, &pfl->callback);
+            callbackSetUser(pfl, &pfl->callback);
+            lookupLink(pfl, &prec->lnk0 + i);
+        }
+        prec->rpvt = ppvt;
+    }
+
+    /* Hold off completion until every link has been started */
+    epicsAtomicSetIntT(&ppvt->pending, 1);
+    for (i = 0; i < NLINKS; i++, mask >>= 1, plink++) {
+        fanoutLink *pfl = &ppvt->link[i];
+
+        if (!(mask & 1))
+            continue;
+        if (pfl->lookup)
+            lookupLink(pfl, plink);
+        if (pfl->local) {
+            callbackSetPriority(prec->prio, &pfl->callback);
+            epicsAtomicIncrIntT(&ppvt->pending);
+            if (!callbackRequest(&pfl->callback))
+                continue;
+            epicsAtomicDecrIntT(&ppvt->pending);
+        }
+        dbScanFwdLink(plink);
+    }
+    return epicsAtomicDecrIntT(&ppvt->pending);
+}
+
+static long special(DBADDR *paddr, int after)
+{
+    fanoutRecord *prec = (fanoutRecord *)paddr->precord;
+    int lnkIndex = dbGetFieldIndex(paddr) - fanoutRecordLNK0;
+
+    /* The parallel callbacks may still be using the old address, so it's
+     * looked up again when the record next processes.
+     */
+    if (after && prec->rpvt && lnkIndex >= 0 && lnkIndex < NLINKS)
+        prec->rpvt->link[lnkIndex].lookup = TRUE;
+    return 0;
+}
+
 static long process(struct dbCommon *pcommon)
 {
     struct fanoutRecord *prec = (struct fanoutRecord *)pcommon;
     struct link *plink;
     epicsUInt16 seln, events;
+    epicsUInt16 mask = 0;
     int         i;
     epicsUInt16 oldn = prec->seln;
 
+    if (prec->pact) {
+        /* Parallel links have finished */
+        oldn = prec->rpvt->oldn;
+        goto finish;
+    }
+
     prec->pact = TRUE;
 
     /* fetch link selection */
@@ -105,10 +220,7 @@ static long process(struct dbCommon *pcommon)
 
     switch (prec->selm) {
     case fanoutSELM_All:
-        plink = &prec->lnk0;
-        for (i = 0; i < NLINKS; i++, plink++) {
-            dbScanFwdLink(plink);
-        }
+        mask = 0xffff;
         break;
 
     case fanoutSELM_Specified:
@@ -117,8 +229,7 @@ static long process(struct dbCommon *pcommon)
             recGblSetSevr(prec, SOFT_ALARM, INVALID_ALARM);
             break;
         }
-        plink = &prec->lnk0 + i;
-        dbScanFwdLink(plink);
+        mask = 1 << i;
         break;
 
     case fanoutSELM_Mask:
@@ -129,18 +240,27 @@ static long process(struct dbCommon *pcommon)
             recGblSetSevr(prec, SOFT_ALARM, INVALID_ALARM);
             break;
         }
-        seln = (i >= 0) ? seln >> i : seln << -i;
-        if (seln == 0)
-            break;
-        plink = &prec->lnk0;
-        for (i = 0; i < NLINKS; i++, seln >>= 1, plink++) {
-            if (seln & 1)
-                dbScanFwdLink(plink);
-        }
+        mask = (i >= 0) ? seln >> i : seln << -i;
         break;
     default:
         recGblSetSevr(prec, SOFT_ALARM, INVALID_ALARM);
     }
+
+    if (prec->parl == menuYesNoYES && mask) {
+        if (scanParallel(prec, mask)) {
+            prec->rpvt->oldn = oldn;
+            return 0;
+        }
+    }
+    else {
+        plink = &prec->lnk0;
+        for (i = 0; i < NLINKS; i++, mask >>= 1, plink++) {
+            if (mask & 1)
+                dbScanFwdLink(plink);
+        }
+    }
+
+finish:
     prec->udf = FALSE;
     recGblGetTimeStamp(prec);
 
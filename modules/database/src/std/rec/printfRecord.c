@@ -13,12 +13,14 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "dbDefs.h"
 #include "errlog.h"
 #include "alarm.h"
 #include "cantProceed.h"
+#include "cvtFast.h"
 #include "dbAccess.h"
 #include "dbEvent.h"
 #include "dbFldTypes.h"
@@ -44,7 +46,224 @@
 #define F_BADLNK 0x80
 #define F_BAD (F_BADFMT | F_BADLNK)
 
-#define GET_PRINT(VALTYPE, DBRTYPE) \
+/* FMT is compiled into a program of these when it is set, so that the
+ * directives don't have to be parsed every time the record processes.
+ */
+typedef enum {
+    OP_TEXT,            /* Literal text */
+    OP_PRINT,           /* Directive */
+    OP_STAR             /* Directive with '*', finished when processed */
+} opType;
+
+typedef struct printfOp {
+    char type;          /* opType */
+    char conv;          /* Conversion character */
+    char fast;          /* Directive has no flags, width or precision */
+    short flags;
+    short width;
+    short precision;
+    short text;         /* Offset in strings of the text or directive */
+    short len;          /* Length of the text */
+} printfOp;
+
+typedef struct printfProgram {
+    int nops;
+    char *strings;
+    printfOp ops[1];
+} printfProgram;
+
+/* Space for a directive with every char a '*' replaced by a number */
+#define FORMAT_SIZE (6 * sizeof(((printfRecord *)0)->fmt) + 1)
+
+/* Parse the directive after a '%', copying it into format[] and setting
+ * the width, precision, flags and conversion character of pop. Returns
+ * the number of chars used from pfmt, or 0 if FMT ends first.
+ *
+ * When compiling, plink is NULL and a '*' just marks the directive as
+ * OP_STAR. While processing, each '*' is replaced by an integer read
+ * from the next input link, as printf would take it from the arguments.
+ */
+static int parseDirective(const char *pfmt, char *format, printfOp *pop,
+    DBLINK **pplink, int *plinkn)
+{
+    const char *pstart = pfmt;
+    char *pformat = format;
+    int width = 0;
+    int precision = 0;
+    int *pnum = &width;
+    int flags = 0;
+    int cont = 1;
+    int ch;
+
+    *pformat++ = '%';
+    while (cont && (ch = *pfmt++)) {
+        *pformat++ = ch;
+        switch (ch) {
+        case '+': case ' ': case '#':
+            break;
+        case '-':
+            flags |= F_LEFT;
+            break;
+        case '.':
+            pnum = &precision;
+            break;
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            *pnum = *pnum * 10 + ch - '0';
+            break;
+        case '*':
+            if (!pplink) {
+                pop->type = OP_STAR;
+            }
+            else if (*pnum) {
+                flags |= F_BADFMT;
+            }
+            else if ((*plinkn)++ < PRINTF_NLINKS) {
+                epicsInt16 i;
+                int ok;
+
+                if (dbLinkIsConstant(*pplink))
+                    ok = recGblInitConstantLink((*pplink)++, DBR_SHORT, &i);
+                else
+                    ok = ! dbGetLink((*pplink)++, DBR_SHORT, &i, 0, 0);
+                if (ok) {
+                    *pnum = i;
+                    --pformat;
+                    pformat += epicsSnprintf(pformat, 7, "%d", i);
+                }
+                else /* No more LNKn fields */
+                    flags |= F_BADLNK;
+            }
+            else
+                flags |= F_BADLNK;
+            break;
+        case 'h':
+            if (flags & (F_LONGLONG | F_LONG | F_CHAR))
+                flags |= F_BADFMT;
+            else if (flags & F_SHORT)
+                flags = (flags & ~F_SHORT) | F_CHAR;
+            else
+                flags |= F_SHORT;
+            break;
+        case 'l':
+            if (flags & (F_LONGLONG | F_SHORT | F_CHAR))
+                flags |= F_BADFMT;
+            else if (flags & F_LONG)
+                flags = (flags & ~F_LONG) | F_LONGLONG;
+            else
+                flags |= F_LONG;
+            break;
+        default:
+            if (strchr("diouxXeEfFgGcs%", ch) == NULL)
+                flags |= F_BADFMT;
+            cont = 0;
+            break;
+        }
+    }
+    *pformat = 0;
+    if (!ch)        /* End of format string */
+        return 0;
+
+    if (width < 0) {
+        width = -width;
+        flags |= F_LEFT;
+    }
+    if (precision < 0)
+        precision = 0;
+
+    /* The value of an integer conversion is only 32 bits when F_LONG
+     * is set, so the 'l' must not be passed on to epicsSnprintf()
+     */
+    if ((flags & (F_LONG | F_BADFMT)) == F_LONG && strchr("diouxX", ch)) {
+        char *pl = strchr(format, 'l');
+
+        memmove(pl, pl + 1, pformat - pl);
+        pformat--;
+    }
+
+    pop->conv = ch;
+    pop->flags = flags;
+    pop->width = width;
+    pop->precision = precision;
+    /* '%' and only length modifiers before the conversion. A length
+     * modifier on %c sets flags, which would send it to the integer
+     * conversion, so leave those to epicsSnprintf().
+     */
+    pop->fast = ch == 'c' ? pformat - format == 2 :
+        strspn(format + 1, "hl") == (size_t)(pformat - format - 2);
+    return pfmt - pstart;
+}
+
+static printfProgram * compileFormat(const char *pfmt)
+{
+    printfOp ops[sizeof(((printfRecord *)0)->fmt)];
+    char strings[FORMAT_SIZE];
+    size_t nstrings = 0;
+    printfProgram *prog;
+    int nops = 0;
+
+    while (*pfmt) {
+        printfOp *pop = &ops[nops];
+
+        memset(pop, 0, sizeof(printfOp));
+        pop->text = nstrings;
+        if (*pfmt != '%') {
+            size_t len = strcspn(pfmt, "%");
+
+            pop->type = OP_TEXT;
+            pop->len = len;
+            memcpy(strings + nstrings, pfmt, len);
+            nstrings += len;
+            pfmt += len;
+        }
+        else {
+            int used;
+
+            pop->type = OP_PRINT;
+            used = parseDirective(pfmt + 1, strings + nstrings, pop, NULL, NULL);
+            if (!used)      /* Unterminated, ignored */
+                break;
+            nstrings += strlen(strings + nstrings) + 1;
+            pfmt += used + 1;
+        }
+        nops++;
+    }
+
+    prog = malloc(sizeof(printfProgram) + nops * sizeof(printfOp) + nstrings);
+    if (!prog)
+        return NULL;
+    prog->nops = nops;
+    memcpy(prog->ops, ops, nops * sizeof(printfOp));
+    prog->strings = (char *)&prog->ops[nops];
+    memcpy(prog->strings, strings, nstrings);
+    return prog;
+}
+
+/* Copy what epicsSnprintf() would have written */
+static int putString(char *pval, int vspace, const char *str, int len)
+{
+    memcpy(pval, str, len < vspace ? len : vspace);
+    return len;
+}
+
+#define GET_PRINT(VALTYPE, DBRTYPE, FAST) \
+    VALTYPE val; \
+    int ok; \
+\
+    if (dbLinkIsConstant(plink)) \
+        ok = recGblInitConstantLink(plink++, DBRTYPE, &val); \
+    else \
+        ok = ! dbGetLink(plink++, DBRTYPE, &val, 0, 0); \
+    if (!ok) \
+        flags |= F_BADLNK; \
+    else if (pop->fast) { \
+        char buf[24]; \
+        added = putString(pval, vspace, buf, FAST(val, buf)); \
+    } \
+    else \
+        added = epicsSnprintf(pval, vspace + 1, format, val)
+
+#define SLOW_PRINT(VALTYPE, DBRTYPE) \
     VALTYPE val; \
     int ok; \
 \
@@ -67,255 +286,219 @@
 
 static void doPrintf(printfRecord *prec)
 {
-    const char *pfmt = prec->fmt;
+    const printfProgram *prog = prec->fprg;
     DBLINK *plink = &prec->inp0;
     int linkn = 0;
     char *pval = prec->val;
     int vspace = prec->sizv - 1;
-    int ch;
-
-    while (vspace > 0 && (ch = *pfmt++)) {
-        if (ch != '%') {
+    int i;
+
+    for (i = 0; prog && i < prog->nops && vspace > 0; i++) {
+        const printfOp *pop = &prog->ops[i];
+        const char *format = prog->strings + pop->text;
+        char starFormat[FORMAT_SIZE];
+        int flags = pop->flags;
+        int width = pop->width;
+        int precision = pop->precision;
+        int ch = pop->conv;
+        int added = 0;
+
+        if (pop->type == OP_TEXT) {
             /* Copy literal strings directly into prec->val */
-            *pval++ = ch;
-            --vspace;
+            added = pop->len < vspace ? pop->len : vspace;
+            memcpy(pval, format, added);
+            pval += added;
+            vspace -= added;
+            continue;
         }
-        else {
-            char format[20];
-            char *pformat = format;
-            int width = 0;
-            int precision = 0;
-            int *pnum = &width;
-            int flags = 0;
-            int added = 0;
-            int cont = 1;
-
-            /* The format directive parsing here is not comprehensive,
-             * in most cases we just copy each directive into format[]
-             * and get epicsSnprintf() do all the work.  We do replace
-             * all variable-length field width or precision '*' chars
-             * with an integer read from the next input link, and we
-             * also convert %ls (long string) directives ourself, so
-             * we need to know the width, precision and justification.
-             */
-
-            *pformat++ = ch; /* '%' */
-            while (cont && (ch = *pfmt++)) {
-                *pformat++ = ch;
-                switch (ch) {
-                case '+': case ' ': case '#':
-                    break;
-                case '-':
-                    flags |= F_LEFT;
-                    break;
-                case '.':
-                    pnum = &precision;
-                    break;
-                case '0': case '1': case '2': case '3': case '4':
-                case '5': case '6': case '7': case '8': case '9':
-                    *pnum = *pnum * 10 + ch - '0';
-                    break;
-                case '*':
-                    if (*pnum) {
-                        flags |= F_BADFMT;
-                    }
-                    else if (linkn++ < PRINTF_NLINKS) {
-                        epicsInt16 i;
-                        int ok;
-
-                        if (dbLinkIsConstant(plink))
-                            ok = recGblInitConstantLink(plink++, DBR_SHORT, &i);
-                        else
-                            ok = ! dbGetLink(plink++, DBR_SHORT, &i, 0, 0);
-                        if (ok) {
-                            *pnum = i;
-                            added = epicsSnprintf(--pformat, 6, "%d", i);
-                            pformat += added;
-                        }
-                        else /* No more LNKn fields */
-                            flags |= F_BADLNK;
+        if (pop->type == OP_STAR) {
+            printfOp op = *pop;
+
+            parseDirective(format + 1, starFormat, &op, &plink, &linkn);
+            format = starFormat;
+            flags = op.flags;
+            width = op.width;
+            precision = op.precision;
+        }
+
+        if (flags & F_BAD)
+            goto bad_format;
+
+        if (ch == '%') {
+            added = epicsSnprintf(pval, vspace + 1, format);
+        }
+        else if (linkn++ >= PRINTF_NLINKS) {
+            /* No more LNKn fields */
+            flags |= F_BADLNK;
+        }
+        else
+            switch (ch) { /* Conversion character */
+            case 'c':
+                if (pop->fast && !flags) {
+                    epicsInt8 val;
+                    int ok;
+
+                    if (dbLinkIsConstant(plink))
+                        ok = recGblInitConstantLink(plink++, DBR_CHAR, &val);
+                    else
+                        ok = ! dbGetLink(plink++, DBR_CHAR, &val, 0, 0);
+                    if (ok) {
+                        *pval = val;
+                        added = 1;
                     }
                     else
                         flags |= F_BADLNK;
                     break;
-                case 'h':
-                    if (flags & (F_LONGLONG | F_LONG | F_CHAR))
-                        flags |= F_BADFMT;
-                    else if (flags & F_SHORT)
-                        flags = (flags & ~F_SHORT) | F_CHAR;
-                    else
-                        flags |= F_SHORT;
-                    break;
-                case 'l':
-                    if (flags & (F_LONGLONG | F_SHORT | F_CHAR))
-                        flags |= F_BADFMT;
-                    else if (flags & F_LONG)
-                        flags = (flags & ~F_LONG) | F_LONGLONG;
-                    else
-                        flags |= F_LONG;
-                    break;
-                default:
-                    if (strchr("diouxXeEfFgGcs%", ch) == NULL)
-                        flags |= F_BADFMT;
-                    cont = 0;
-                    break;
                 }
-            }
-            if (!ch)        /* End of format string */
+                /* fall through */
+            case 'd': case 'i':
+                if (ch == 'c' || flags & F_CHAR) {
+                    GET_PRINT(epicsInt8, DBR_CHAR, cvtInt32ToString);
+                }
+                else if (flags & F_SHORT) {
+                    GET_PRINT(epicsInt16, DBR_SHORT, cvtInt32ToString);
+                }
+                else if (flags & F_LONGLONG) {
+                    GET_PRINT(epicsInt64, DBR_INT64, cvtInt64ToString);
+                }
+                else { /* F_LONG has no real effect */
+                    GET_PRINT(epicsInt32, DBR_LONG, cvtInt32ToString);
+                }
                 break;
 
-            if (flags & F_BAD)
-                goto bad_format;
-
-            *pformat = 0;   /* Terminate our format string */
-
-            if (width < 0) {
-                width = -width;
-                flags |= F_LEFT;
-            }
-            if (precision < 0)
-                precision = 0;
+            case 'u':
+                if (flags & F_CHAR) {
+                    GET_PRINT(epicsUInt8, DBR_UCHAR, cvtUInt32ToString);
+                }
+                else if (flags & F_SHORT) {
+                    GET_PRINT(epicsUInt16, DBR_USHORT, cvtUInt32ToString);
+                }
+                else if (flags & F_LONGLONG) {
+                    GET_PRINT(epicsUInt64, DBR_UINT64, cvtUInt64ToString);
+                }
+                else { /* F_LONG has no real effect */
+                    GET_PRINT(epicsUInt32, DBR_ULONG, cvtUInt32ToString);
+                }
+                break;
 
-            if (ch == '%') {
-                added = epicsSnprintf(pval, vspace + 1, format);
-            }
-            else if (linkn++ >= PRINTF_NLINKS) {
-                /* No more LNKn fields */
-                flags |= F_BADLNK;
-            }
-            else
-                switch (ch) { /* Conversion character */
-                case 'c': case 'd': case 'i':
-                    if (ch == 'c' || flags & F_CHAR) {
-                        GET_PRINT(epicsInt8, DBR_CHAR);
-                    }
-                    else if (flags & F_SHORT) {
-                        GET_PRINT(epicsInt16, DBR_SHORT);
-                    }
-                    else if (flags & F_LONGLONG) {
-                        GET_PRINT(epicsInt64, DBR_INT64);
-                    }
-                    else { /* F_LONG has no real effect */
-                        GET_PRINT(epicsInt32, DBR_LONG);
-                    }
-                    break;
+            case 'o': case 'x': case 'X':
+                if (flags & F_CHAR) {
+                    SLOW_PRINT(epicsUInt8, DBR_UCHAR);
+                }
+                else if (flags & F_SHORT) {
+                    SLOW_PRINT(epicsUInt16, DBR_USHORT);
+                }
+                else if (flags & F_LONGLONG) {
+                    SLOW_PRINT(epicsUInt64, DBR_UINT64);
+                }
+                else { /* F_LONG has no real effect */
+                    SLOW_PRINT(epicsUInt32, DBR_ULONG);
+                }
+                break;
 
-                case 'o': case 'x': case 'X': case 'u':
-                    if (flags & F_CHAR) {
-                        GET_PRINT(epicsUInt8, DBR_UCHAR);
-                    }
-                    else if (flags & F_SHORT) {
-                        GET_PRINT(epicsUInt16, DBR_USHORT);
-                    }
-                    else if (flags & F_LONGLONG) {
-                        GET_PRINT(epicsUInt64, DBR_UINT64);
-                    }
-                    else { /* F_LONG has no real effect */
-                        GET_PRINT(epicsUInt32, DBR_ULONG);
-                    }
-                    break;
+            case 'e': case 'E':
+            case 'f': case 'F':
+            case 'g': case 'G':
+                if (flags & F_SHORT) {
+                    SLOW_PRINT(epicsFloat32, DBR_FLOAT);
+                }
+                else {
+                    SLOW_PRINT(epicsFloat64, DBR_DOUBLE);
+                }
+                break;
 
-                case 'e': case 'E':
-                case 'f': case 'F':
-                case 'g': case 'G':
-                    if (flags & F_SHORT) {
-                        GET_PRINT(epicsFloat32, DBR_FLOAT);
+            case 's':
+                if (flags & F_LONG) {
+                    long n = vspace + 1;
+                    long status;
+
+                    if (precision && n > precision)
+                        n = precision + 1;
+                        /* If set, precision is the maximum number of
+                         * characters to be printed from the string.
+                         * It does not limit the field width however.
+                         */
+                    if (dbLinkIsConstant(plink)) {
+                        epicsUInt32 len = n;
+                        status = dbLoadLinkLS(plink++, pval, n, &len);
+                        n = len;
                     }
+                    else
+                        status = dbGetLink(plink++, DBR_CHAR, pval, 0, &n);
+                    if (status)
+                        flags |= F_BADLNK;
                     else {
-                        GET_PRINT(epicsFloat64, DBR_DOUBLE);
-                    }
-                    break;
+                        int padding;
+
+                        /* Terminate string and measure its length,
+                         * only vspace chars can be kept anyway */
+                        pval[n < vspace ? n : vspace] = 0;
+                        added = strlen(pval);
+                        padding = width - added;
+
+                        if (padding > 0) {
+                            if (flags & F_LEFT) {
+                                /* add spaces on RHS */
+                                if (width > vspace)
+                                    padding = vspace - added;
+                                memset(pval + added, ' ', padding);
+                            }
+                            else {
+                                /* insert spaces on LHS */
+                                int trunc = width - vspace;
 
-                case 's':
-                    if (flags & F_LONG) {
-                        long n = vspace + 1;
-                        long status;
-
-                        if (precision && n > precision)
-                            n = precision + 1;
-                            /* If set, precision is the maximum number of
-                             * characters to be printed from the string.
-                             * It does not limit the field width however.
-                             */
-                        if (dbLinkIsConstant(plink)) {
-                            epicsUInt32 len = n;
-                            status = dbLoadLinkLS(plink++, pval, n, &len);
-                            n = len;
-                        }
-                        else
-                            status = dbGetLink(plink++, DBR_CHAR, pval, 0, &n);
-                        if (status)
-                            flags |= F_BADLNK;
-                        else {
-                            int padding;
-
-                            /* Terminate string and measure its length */
-                            pval[n] = 0;
-                            added = strlen(pval);
-                            padding = width - added;
-
-                            if (padding > 0) {
-                                if (flags & F_LEFT) {
-                                    /* add spaces on RHS */
-                                    if (width > vspace)
-                                        padding = vspace - added;
-                                    memset(pval + added, ' ', padding);
+                                if (trunc < added) {
+                                    added -= trunc;
+                                    memmove(pval + padding, pval, added);
                                 }
                                 else {
-                                    /* insert spaces on LHS */
-                                    int trunc = width - vspace;
-
-                                    if (trunc < added) {
-                                        added -= trunc;
-                                        memmove(pval + padding, pval, added);
-                                    }
-                                    else {
-                                        padding = vspace;
-                                        added = 0;
-                                    }
-                                    memset(pval, ' ', padding);
+                                    padding = vspace;
+                                    added = 0;
                                 }
-                                added += padding;
+                                memset(pval, ' ', padding);
                             }
+                            added += padding;
                         }
                     }
-                    else {
-                        char val[MAX_STRING_SIZE];
-                        int ok;
-
-                        if (dbLinkIsConstant(plink))
-                            ok = recGblInitConstantLink(plink++, DBR_STRING, val);
-                        else
-                            ok = ! dbGetLink(plink++, DBR_STRING, val, 0, 0);
-                        if (ok)
-                            added = epicsSnprintf(pval, vspace + 1, format, val);
-                        else
-                            flags |= F_BADLNK;
-                    }
-                    break;
+                }
+                else {
+                    char val[MAX_STRING_SIZE];
+                    int ok;
 
-                default:
-                    errlogPrintf("printfRecord: Unexpected conversion '%s'\n",
-                        format);
-                    flags |= F_BADFMT;
-                    break;
+                    if (dbLinkIsConstant(plink))
+                        ok = recGblInitConstantLink(plink++, DBR_STRING, val);
+                    else
+                        ok = ! dbGetLink(plink++, DBR_STRING, val, 0, 0);
+                    if (!ok)
+                        flags |= F_BADLNK;
+                    else if (pop->fast && !flags)
+                        added = putString(pval, vspace, val, strlen(val));
+                    else
+                        added = epicsSnprintf(pval, vspace + 1, format, val);
                 }
+                break;
 
-            if (flags & F_BAD) {
-    bad_format:
-                added = epicsSnprintf(pval, vspace + 1, "%s",
-                    flags & F_BADLNK ? prec->ivls : format);
+            default:
+                errlogPrintf("printfRecord: Unexpected conversion '%s'\n",
+                    format);
+                flags |= F_BADFMT;
+                break;
             }
 
-            if (added <= vspace) {
-                pval += added;
-                vspace -= added;
-            }
-            else {
-                /* Output was truncated */
-                pval += vspace;
-                vspace = 0;
-            }
+        if (flags & F_BAD) {
+    bad_format:
+            added = epicsSnprintf(pval, vspace + 1, "%s",
+                flags & F_BADLNK ? prec->ivls : format);
+        }
+
+        if (added <= vspace) {
+            pval += added;
+            vspace -= added;
+        }
+        else {
+            /* Output was truncated */
+            pval += vspace;
+            vspace = 0;
         }
     }
     *pval++ = 0;  /* Terminate the VAL string */
@@ -344,6 +527,11 @@ static long init_record(struct dbCommon *pcommon, int pass)
 
         prec->val = callocMustSucceed(1, sizv, "printf::init_record");
         prec->len = 0;
+        prec->fprg = compileFormat(prec->fmt);
+        if (!prec->fprg) {
+            recGblRecordError(S_db_noMemory, prec, "printf::init_record");
+            return S_db_noMemory;
+        }
         return 0;
     }
 
@@ -405,6 +593,24 @@ static long process(struct dbCommon *pcommon)
     return status;
 }
 
+static long special(DBADDR *paddr, int after)
+{
+    printfRecord *prec = (printfRecord *)paddr->precord;
+    printfProgram *prog;
+
+    if (!after || dbGetFieldIndex(paddr) != printfRecordFMT)
+        return 0;
+
+    prog = compileFormat(prec->fmt);
+    if (!prog) {
+        recGblRecordError(S_db_noMemory, prec, "printf::special");
+        return S_db_noMemory;
+    }
+    free(prec->fprg);
+    prec->fprg = prog;
+    return 0;
+}
+
 static long cvt_dbaddr(DBADDR *paddr)
 {
     printfRecord *prec = (printfRecord *)paddr->precord;
@@ -439,7 +645,7 @@ static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
 #define initialize NULL
 /* init_record */
 /* process */
-#define special NULL
+/* special */
 #define get_value NULL
 /* cvt_dbaddr */
 /* get_array_info */
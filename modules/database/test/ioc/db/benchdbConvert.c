@@ -5,6 +5,7 @@
 * EPICS BASE is distributed subject to a Software License Agreement found
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
+#include "stdio.h"
 #include "string.h"
 
 #include "cantProceed.h"
@@ -112,9 +113,79 @@ done:
     free(tdat.output);
 }
 
+static const char *typeNames[] = {
+    NULL, "CHAR", "UCHAR", "SHORT", "USHORT", "LONG", "ULONG",
+    "INT64", "UINT64", "FLOAT", "DOUBLE", "ENUM"
+};
+
+/* Million elements/s converting between a field of type ftype and a
+ * buffer of type dtype, repeated for at least 0.1 sec.
+ */
+static double runPair(int put, int ftype, int dtype, DBADDR *paddr,
+                      void *buffer, long nelem, long offset)
+{
+    epicsTimeStamp start, stop;
+    double elapsed;
+    size_t count = 0;
+
+    paddr->field_type = ftype;
+    epicsTimeGetCurrent(&start);
+    do {
+        if (put)
+            dbPutConvertRoutine[dtype][ftype](paddr, buffer, nelem, nelem, offset);
+        else
+            dbGetConvertRoutine[ftype][dtype](paddr, buffer, nelem, nelem, offset);
+        count += nelem;
+        epicsTimeGetCurrent(&stop);
+        elapsed = epicsTimeDiffInSeconds(&stop, &start);
+    } while (elapsed < 0.1);
+    return count / elapsed / 1e6;
+}
+
+/* Every pair of numeric types. A non-zero offset wraps at the end of
+ * the field.
+ */
+static void runMatrix(int put, size_t nelem, long offset)
+{
+    /* Zeros are valid values of every type */
+    void *field = callocMustSucceed(nelem, sizeof(epicsFloat64), "runMatrix");
+    void *buffer = callocMustSucceed(nelem, sizeof(epicsFloat64), "runMatrix");
+    DBADDR addr;
+    char line[128];
+    int row, col;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.no_elements = nelem;
+    addr.pfield = field;
+
+    testDiag("%s %lu elements from offset %ld, million elements/s",
+             put ? "dbPut DBR (down) to DBF (across)" :
+                   "dbGet DBF (down) to DBR (across)",
+             (unsigned long)nelem, offset);
+    strcpy(line, "      ");
+    for (col = DBF_CHAR; col <= DBF_ENUM; col++)
+        sprintf(line + strlen(line), " %6s", typeNames[col]);
+    testDiag("%s", line);
+    for (row = DBF_CHAR; row <= DBF_ENUM; row++) {
+        sprintf(line, "%-6s", typeNames[row]);
+        for (col = DBF_CHAR; col <= DBF_ENUM; col++)
+            sprintf(line + strlen(line), " %6.0f", put ?
+                    runPair(put, col, row, &addr, buffer, nelem, offset) :
+                    runPair(put, row, col, &addr, buffer, nelem, offset));
+        testDiag("%s", line);
+    }
+
+    free(field);
+    free(buffer);
+}
+
 MAIN(benchdbConvert)
 {
     testPlan(0);
+    runMatrix(0, 1000000, 0);
+    runMatrix(0, 1000000, 500000);
+    runMatrix(1, 1000000, 0);
+    runMatrix(1, 1000000, 500000);
     runBench(1, 10000000, 10);
     runBench(2,  5000000, 10);
     runBench(10, 1000000, 10);
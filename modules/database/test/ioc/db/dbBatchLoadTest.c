@@ -0,0 +1,108 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "envDefs.h"
+#include "errlog.h"
+#include "iocInit.h"
+#include "osiFileName.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char *path = "." OSI_PATH_LIST_SEPARATOR ".." ;
+
+static dbReadBatchItem items[] = {
+    {"dbBatchLoadTest.db", "P=b1:", 0},
+    {"dbBatchLoadTest.db", "P=b2:", 0},
+    {"noSuchFile.db", "P=b0:", 0},
+    {"dbBatchLoadTest.db", "P=b3:,D=three", 0},
+    {"dbBatchLoadTest.db", "P=b4:", 0},
+};
+
+/* Records must be in the order loaded */
+static const char *expected[] = {
+    "s1:a", "s1:b", "s2:a", "s2:b",
+    "b1:a", "b1:b", "b2:a", "b2:b", "b3:a", "b3:b", "b4:a", "b4:b",
+    NULL
+};
+
+static void checkOrder(void)
+{
+    DBENTRY dbentry;
+    long status;
+    int i = 0, good = 1;
+
+    dbInitEntry(pdbbase, &dbentry);
+    status = dbFindRecordType(&dbentry, "x");
+    if (!status)
+        status = dbFirstRecord(&dbentry);
+    for (; !status; status = dbNextRecord(&dbentry), i++) {
+        const char *name = dbGetRecordName(&dbentry);
+
+        if (!expected[i] || strcmp(name, expected[i])) {
+            testDiag("record %d is %s, expected %s", i, name,
+                expected[i] ? expected[i] : "none");
+            good = 0;
+            break;
+        }
+    }
+    dbFinishEntry(&dbentry);
+    testOk(good && !expected[i], "%d records loaded in order", i);
+}
+
+MAIN(dbBatchLoadTest)
+{
+    int i;
+
+    testPlan(12);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbBatchLoadTest.db", path, "P=s1:");
+    testdbReadDatabase("dbBatchLoadTest.db", path, "P=s2:");
+
+    /* Fewer files are expanded ahead than there are in the batch */
+    testDiag("Batch with one missing file");
+    eltc(0);
+    testOk(dbReadDatabaseBatch(&pdbbase, items, NELEMENTS(items), path, 2),
+        "dbReadDatabaseBatch reports failure");
+    eltc(1);
+    for (i = 0; i < NELEMENTS(items); i++)
+        testOk((items[i].status != 0) == (i == 2), "%s %s status %ld",
+            items[i].filename, items[i].substitutions, items[i].status);
+    checkOrder();
+
+    testDiag("Queued file loaded by iocInit");
+    epicsEnvSet("EPICS_DB_INCLUDE_PATH", path);
+    testOk1(dbLoadRecordsQueue("dbBatchLoadTest.db", "P=q:") == 0);
+
+    testIocInitOk();
+
+    testdbGetFieldEqual("b1:a.DESC", DBR_STRING, "default");
+    testdbGetFieldEqual("b3:a.DESC", DBR_STRING, "three");
+    testdbGetFieldEqual("q:b.DESC", DBR_STRING, "q:");
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    testDiag("Queued file that can't be loaded");
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    dbLoadRecordsQueue("noSuchFile.db", NULL);
+    eltc(0);
+    testOk(iocBuild() != 0, "iocBuild fails");
+    eltc(1);
+    testdbCleanup();
+
+    return testDone();
+}
@@ -17,6 +17,7 @@
 #define EPICS_DBCA_PRIVATE_API
 
 #include "epicsString.h"
+#include "epicsAtomic.h"
 #include "dbUnitTest.h"
 #include "epicsThread.h"
 #include "cantProceed.h"
@@ -301,6 +302,165 @@ static void testCP(void)
     waitEvent = NULL;
 }
 
+static void postTarget(xRecord *ptarg, epicsInt32 val)
+{
+    dbScanLock((dbCommon*)ptarg);
+    ptarg->val = val;
+    db_post_events(ptarg, &ptarg->val, DBE_VALUE|DBE_ALARM|DBE_ARCHIVE);
+    dbScanUnlock((dbCommon*)ptarg);
+}
+
+/* Without taking the record lock, which the caller may be holding */
+static void waitUpdates(caLink *pca, unsigned long cnt)
+{
+    int i;
+
+    for (i = 0; i < 500; i++) {
+        unsigned long nUpdate;
+
+        epicsMutexMustLock(pca->lock);
+        nUpdate = pca->nUpdate;
+        epicsMutexUnlock(pca->lock);
+        if (nUpdate >= cnt)
+            return;
+        epicsThreadSleep(0.01);
+    }
+    testAbort("Timeout waiting for %lu updates", cnt);
+}
+
+static void testLatest(void)
+{
+    xRecord *psrc, *ptarg;
+    caLink *pca;
+    epicsInt32 val;
+
+    testDiag("Link CP LATEST modifier");
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("dbCaLinkTest1.db", NULL, "TARGET=target CP LATEST");
+
+    psrc = (xRecord*)testdbRecordPtr("source");
+    ptarg= (xRecord*)testdbRecordPtr("target");
+
+    waitCounter=0;
+    psrc->clbk = &wasproc;
+
+    assert(!waitEvent);
+    waitEvent = epicsEventMustCreate(epicsEventEmpty);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+    dbCaSync();
+
+    epicsEventMustWait(waitEvent);
+    pca = (caLink *)psrc->lnk.value.pv_link.pvt;
+    testOp("%u",waitCounter,==,1); /* initial processing */
+
+    /* Hold the source so that the scan queued by the first update waits */
+    dbScanLock((dbCommon*)psrc);
+    for (val = 1; val <= 10; val++)
+        postTarget(ptarg, val);
+    waitUpdates(pca, 11);
+    testOp("%lu",pca->nCoalesced,==,9ul);
+    dbScanUnlock((dbCommon*)psrc);
+
+    epicsEventMustWait(waitEvent);
+    epicsThreadSleep(0.1);
+    dbCaSync();
+    testOp("%u",waitCounter,==,2); /* one process for 10 updates */
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    epicsEventDestroy(waitEvent);
+    waitEvent = NULL;
+}
+
+static void testMaxRate(void)
+{
+    xRecord *psrc, *ptarg;
+    caLink *pca;
+    epicsTimeStamp start, end;
+    double delay;
+
+    testDiag("Link CP RATE= modifier");
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("dbCaLinkTest1.db", NULL, "TARGET=target CP RATE=2");
+
+    psrc = (xRecord*)testdbRecordPtr("source");
+    ptarg= (xRecord*)testdbRecordPtr("target");
+
+    waitCounter=0;
+    psrc->clbk = &wasproc;
+
+    assert(!waitEvent);
+    waitEvent = epicsEventMustCreate(epicsEventEmpty);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+    dbCaSync();
+
+    epicsEventMustWait(waitEvent);
+    pca = (caLink *)psrc->lnk.value.pv_link.pvt;
+    testOp("%u",waitCounter,==,1); /* initial processing */
+
+    /* The first is put off until 0.5 sec after the initial processing,
+     * and the others are seen by that same scan.
+     */
+    epicsTimeGetCurrent(&start);
+    postTarget(ptarg, 1);
+    postTarget(ptarg, 2);
+    postTarget(ptarg, 3);
+    waitUpdates(pca, 4);
+    epicsEventMustWait(waitEvent);
+    epicsTimeGetCurrent(&end);
+    delay = epicsTimeDiffInSeconds(&end, &start);
+    testOk(delay > 0.2, "Processing put off for %.3f sec", delay);
+
+    epicsThreadSleep(1.0);
+    testOp("%u",waitCounter,==,2);
+    testOp("%lu",pca->nCoalesced,==,2ul);
+
+    /* The next update is scanned at once and the one after is put off.
+     * Removing the link must release the reference held for that scan.
+     */
+    postTarget(ptarg, 4);
+    epicsEventMustWait(waitEvent);
+    epicsThreadSleep(0.1);
+    postTarget(ptarg, 5);
+    waitUpdates(pca, 6);
+    testOk(pca->rateWaiting && epicsAtomicGetIntT(&pca->refcount)==2,
+        "Scan put off, refcount %d", epicsAtomicGetIntT(&pca->refcount));
+
+    dbCaPause();
+    testdbPutFieldOk("source.LNK", DBR_STRING, "");
+    testOp("%d",epicsAtomicGetIntT(&pca->refcount),==,1);
+    dbCaRun();
+    dbCaSync();
+
+    epicsThreadSleep(1.0);
+    testOp("%u",waitCounter,==,3);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    epicsEventDestroy(waitEvent);
+    waitEvent = NULL;
+}
+
 static void fillArray(epicsInt32 *buf, unsigned count, epicsInt32 first)
 {
     for(;count;count--,first++)
@@ -610,17 +770,112 @@ static void testCAC(void)
     free(buftarg2);
 }
 
+#define NWORKLINKS 6
+
+static char workerName[NWORKLINKS][20];
+
+/* Called in the dbCa worker which put to wtgtN.PROC */
+static void saveWorker(xRecord *prec)
+{
+    int i = atoi(prec->name + 4);
+
+    strncpy(workerName[i], epicsThreadGetNameSelf(), sizeof(workerName[i]) - 1);
+}
+
+static void testWorkerThreads(void)
+{
+    xRecord *psrc;
+    char name[20];
+    unsigned used = 0;
+    epicsInt32 val;
+    int i;
+
+    testDiag("Each link is served by the worker its name hashes to");
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for (i = 0; i < NWORKLINKS; i++) {
+        sprintf(name, "N=%d", i);
+        testdbReadDatabase("dbCaLinkTest4.db", NULL, name);
+        sprintf(name, "wtgt%d", i);
+        ((xRecord*)testdbRecordPtr(name))->clbk = &saveWorker;
+    }
+    testdbReadDatabase("dbCaLinkTest4.db", NULL, "N=order,FIELD=");
+    memset(workerName, 0, sizeof(workerName));
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+    dbCaSync();
+
+    for (i = 0; i < NWORKLINKS; i++) {
+        val = 1;
+        sprintf(name, "wsrc%d", i);
+        psrc = (xRecord*)testdbRecordPtr(name);
+        dbScanLock((dbCommon*)psrc);
+        if (dbPutLink(&psrc->lnk, DBR_LONG, &val, 1))
+            testDiag("Put to %s failed", name);
+        dbScanUnlock((dbCommon*)psrc);
+    }
+    dbCaSync();
+
+    for (i = 0; i < NWORKLINKS; i++) {
+        int worker;
+
+        sprintf(name, "wtgt%d.PROC", i);
+        worker = epicsStrHash(name, 0) % dbCaWorkers;
+        used |= 1u << worker;
+        if (worker)
+            sprintf(name, "dbCaLink%d", worker);
+        else
+            strcpy(name, "dbCaLink");
+        testOk(strcmp(workerName[i], name) == 0,
+            "wtgt%d.PROC served by %s (%s)", i, workerName[i], name);
+    }
+    testOk(used & (used - 1), "Links use more than one worker (0x%x)", used);
+
+    testDiag("Puts through one link arrive in order");
+    psrc = (xRecord*)testdbRecordPtr("wsrcorder");
+    for (val = 1; val <= 100; val++) {
+        dbScanLock((dbCommon*)psrc);
+        dbPutLink(&psrc->lnk, DBR_LONG, &val, 1);
+        dbScanUnlock((dbCommon*)psrc);
+    }
+    dbCaSync();
+    testdbGetFieldEqual("wtgtorder", DBR_LONG, 100);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+}
+
+static void testWorkers(void)
+{
+    testDiag("CA links shared between several workers");
+    dbCaWorkers = 3;
+    testStringLink();
+    testArrayLink(10,10);
+    testWorkerThreads();
+    dbCaWorkers = 1;
+}
+
 MAIN(dbCaLinkTest)
 {
-    testPlan(101);
+    testPlan(138);
     testNativeLink();
     testStringLink();
     testCP();
+    testLatest();
+    testMaxRate();
     testArrayLink(1,1);
     testArrayLink(10,1);
     testArrayLink(1,10);
     testArrayLink(10,10);
     testreTargetTypeChange();
     testCAC();
+    testWorkers();
     return testDone();
 }
@@ -0,0 +1,103 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Time loading 1M records with dbReadDatabase() and dbReadDatabaseBatch().
+ * This is not a test, it measures performance.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NFILES 100
+#define NRECORDS 10000      /* per file */
+#define FILENAME "dbLoadPerform.db"
+
+static dbReadBatchItem items[NFILES];
+static char subs[NFILES][16];
+
+static int writeFile(void)
+{
+    FILE *fp = fopen(FILENAME, "w");
+    int i;
+
+    if (!fp)
+        return -1;
+    for (i = 0; i < NRECORDS; i++)
+        fprintf(fp, "record(x, \"$(P)r%d\") {\n"
+            "    field(DESC, \"$(P) record %d\")\n"
+            "    field(VAL, \"%d\")\n"
+            "}\n", i, i, i);
+    return fclose(fp);
+}
+
+static void prepare(void)
+{
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+}
+
+static double timeSerial(void)
+{
+    epicsUInt64 start;
+    int i;
+
+    prepare();
+    start = epicsMonotonicGet();
+    for (i = 0; i < NFILES; i++)
+        dbReadDatabase(&pdbbase, FILENAME, ".", subs[i]);
+    start = epicsMonotonicGet() - start;
+    testdbCleanup();
+    return start * 1e-9;
+}
+
+static double timeBatch(int threads)
+{
+    epicsUInt64 start;
+
+    prepare();
+    start = epicsMonotonicGet();
+    dbReadDatabaseBatch(&pdbbase, items, NFILES, ".", threads);
+    start = epicsMonotonicGet() - start;
+    testdbCleanup();
+    return start * 1e-9;
+}
+
+MAIN(dbLoadPerform)
+{
+    int i, cpus = epicsThreadGetCPUs();
+
+    if (writeFile()) {
+        printf("Can't write " FILENAME "\n");
+        return 1;
+    }
+    for (i = 0; i < NFILES; i++) {
+        sprintf(subs[i], "P=f%d:", i);
+        items[i].filename = FILENAME;
+        items[i].substitutions = subs[i];
+    }
+
+    /* Otherwise looking up record names dominates */
+    dbPvdTableSize(65536);
+    printf("Loading %d records from %d files\n", NFILES * NRECORDS, NFILES);
+    printf("dbReadDatabase()                %8.3f sec\n", timeSerial());
+    printf("dbReadDatabaseBatch(1 thread)   %8.3f sec\n", timeBatch(1));
+    printf("dbReadDatabaseBatch(%2d threads) %8.3f sec\n", cpus,
+        timeBatch(cpus));
+
+    remove(FILENAME);
+    return 0;
+}
@@ -12,6 +12,8 @@
 
 #include <stdlib.h>
 
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
 #include "epicsSpin.h"
 #include "epicsMutex.h"
 #include "dbCommon.h"
@@ -148,6 +150,174 @@ static void testSingleLock(void)
     testdbCleanup();
 }
 
+typedef struct {
+    dbCommon *prec;
+    int shared;
+    epicsEventId locked, release, done;
+} lockerThread;
+
+static void lockerMain(void *raw)
+{
+    lockerThread *pt = raw;
+
+    if (pt->shared)
+        dbScanLockShared(pt->prec);
+    else
+        dbScanLock(pt->prec);
+    epicsEventMustTrigger(pt->locked);
+    epicsEventMustWait(pt->release);
+    if (pt->shared)
+        dbScanUnlockShared(pt->prec);
+    else
+        dbScanUnlock(pt->prec);
+    epicsEventMustTrigger(pt->done);
+}
+
+static void startLocker(lockerThread *pt, dbCommon *prec, int shared)
+{
+    pt->prec = prec;
+    pt->shared = shared;
+    pt->locked = epicsEventMustCreate(epicsEventEmpty);
+    pt->release = epicsEventMustCreate(epicsEventEmpty);
+    pt->done = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadMustCreate(shared ? "reader" : "writer",
+        epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackSmall), lockerMain, pt);
+}
+
+static void stopLocker(lockerThread *pt)
+{
+    epicsEventMustTrigger(pt->release);
+    epicsEventMustWait(pt->done);
+    epicsEventDestroy(pt->locked);
+    epicsEventDestroy(pt->release);
+    epicsEventDestroy(pt->done);
+}
+
+static void testSharedLock(void)
+{
+    lockerThread r1, r2, r3, w;
+    dbCommon *prec;
+    lockSet *ls;
+
+    testDiag("testing dbScanLockShared()/dbScanUnlockShared()");
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = testdbRecordPtr("reca");
+    ls = prec->lset->plockSet;
+    dbLockSharedReads = 1;
+
+    startLocker(&r1, prec, 1);
+    epicsEventMustWait(r1.locked);
+    startLocker(&r2, prec, 1);
+    testOk(epicsEventWaitWithTimeout(r2.locked, 5.0) == epicsEventOK,
+        "Two readers share a lock set");
+    testOk1(epicsAtomicGetIntT(&ls->readers) == 2);
+
+    startLocker(&w, prec, 0);
+    testOk(epicsEventWaitWithTimeout(w.locked, 0.1) == epicsEventWaitTimeout,
+        "Writer waits for readers");
+    stopLocker(&r1);
+    stopLocker(&r2);
+    testOk(epicsEventWaitWithTimeout(w.locked, 5.0) == epicsEventOK,
+        "Writer gets the lock once the readers leave");
+
+    startLocker(&r3, prec, 1);
+    testOk(epicsEventWaitWithTimeout(r3.locked, 0.1) == epicsEventWaitTimeout,
+        "Reader waits for writer");
+    stopLocker(&w);
+    testOk(epicsEventWaitWithTimeout(r3.locked, 5.0) == epicsEventOK,
+        "Reader gets the lock once the writer leaves");
+    stopLocker(&r3);
+
+    dbScanLock(prec);
+    dbScanLockShared(prec);
+    /* a writer reading its own lock set keeps it exclusively */
+    testOk1(ls->readers == 0 && ls->depth == 2);
+    dbScanUnlockShared(prec);
+    dbScanUnlock(prec);
+
+    testOk(ls->nShared == 3 && ls->nReaderBlocked >= 1 &&
+        ls->nWriterWaited == 1,
+        "%lu shared, %lu readers blocked, %lu writers waited",
+        ls->nShared, ls->nReaderBlocked, ls->nWriterWaited);
+
+    dbLockSharedReads = 0;
+    dbScanLockShared(prec);
+    testOk(ls->writer == epicsThreadGetIdSelf(),
+        "Shared locks are exclusive when dbLockSharedReads is 0");
+    dbScanUnlockShared(prec);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+}
+
+static void testLockStats(void)
+{
+    lockerThread w;
+    dbCommon *prec;
+    lockSet *ls;
+
+    testDiag("testing lock set statistics");
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = testdbRecordPtr("reca");
+    ls = prec->lset->plockSet;
+
+    dbLockStatsReset();
+    dbScanLock(prec);
+    dbScanUnlock(prec);
+    testOk(ls->nExclusive == 1 && ls->nContended == 0 && ls->nHolds == 0,
+        "Untimed: %lu locks, %lu contended, %lu timed",
+        ls->nExclusive, ls->nContended, ls->nHolds);
+
+    dbLockStatsEnable(1);
+    dbLockStatsReset();
+    dbScanLock(prec);
+    startLocker(&w, prec, 0);
+    testOk1(epicsEventWaitWithTimeout(w.locked, 0.1) == epicsEventWaitTimeout);
+    dbScanUnlock(prec);
+    testOk1(epicsEventWaitWithTimeout(w.locked, 5.0) == epicsEventOK);
+    stopLocker(&w);
+    dbLockStatsEnable(0);
+
+    testOk(ls->nExclusive == 2 && ls->nContended == 1 && ls->nHolds == 2,
+        "Timed: %lu locks, %lu contended, %lu timed",
+        ls->nExclusive, ls->nContended, ls->nHolds);
+    testOk(ls->waitTime >= 50000000u && ls->holdMax >= 50000000u &&
+        ls->holdTime >= ls->holdMax,
+        "Waited %.1f ms, held for %.1f ms at most",
+        ls->waitTime * 1e-6, ls->holdMax * 1e-6);
+
+    testOk1(dbLockStatsReport(2, 1) == 0);
+
+    dbLockStatsReset();
+    testOk1(ls->nExclusive == 0 && ls->waitTime == 0 && ls->holdMax == 0);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+}
+
 static void testMultiLock(void)
 {
     dbCommon *prec[8];
@@ -417,12 +587,14 @@ static void testLinkNOP(void)
 MAIN(dbLockTest)
 {
 #ifdef LOCKSET_DEBUG
-    testPlan(100);
+    testPlan(116);
 #else
-    testPlan(88);
+    testPlan(104);
 #endif
     testSets();
     testSingleLock();
+    testSharedLock();
+    testLockStats();
     testMultiLock();
     testLinkBreak();
     testLinkMake();
@@ -188,6 +188,9 @@ static const struct testDataT {
     {"qq MSICA", CA_LINK, pvlOptInpNative|pvlOptCA|pvlOptMSI, "qq CA MSI"},
 
     {"x1 CA", CA_LINK, pvlOptInpNative|pvlOptCA, "x1 CA NMS"},
+    {"qq CP LATEST RATE=10", CA_LINK, pvlOptInpNative|pvlOptCP|pvlOptLatest,
+        "qq CP NMS LATEST RATE=10"},
+    {"qq CA LATEST RATE=10", CA_LINK, pvlOptInpNative|pvlOptCA, "qq CA NMS"},
     {NULL}
 };
 
@@ -701,7 +704,7 @@ void testTSEL(void)
 
 MAIN(dbPutLinkTest)
 {
-    testPlan(348);
+    testPlan(356);
     testLinkParse();
     testLinkFailParse();
     testCADBSet();
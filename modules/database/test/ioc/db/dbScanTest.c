@@ -11,6 +11,7 @@
  */
 
 #include <string.h>
+#include <stdio.h>
 
 #include "dbScan.h"
 #include "epicsEvent.h"
@@ -19,7 +20,10 @@
 #include "testMain.h"
 
 #include "dbAccess.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
 #include "errlog.h"
+#include "xRecord.h"
 
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
@@ -66,9 +70,173 @@ static void testOnce(void)
     epicsEventDestroy(waiter);
 }
 
+static void countOnce(xRecord *prec)
+{
+    prec->i32++;
+}
+
+static void testOnceCoalesce(void)
+{
+    xRecord *prec;
+    int i, queued = 1;
+
+    testDiag("check repeated scanOnce requests are merged");
+    waiter = epicsEventMustCreate(epicsEventEmpty);
+    called = 0;
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    testOk1(scanOnceSetThreads(3) == 0);
+    testOk1(scanOnceSetCoalesce(1) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanOnceSetCoalesce(0) != 0, "can't be configured after iocInit");
+
+    prec = (xRecord *)testdbRecordPtr("reca");
+    prec->clbk = countOnce;
+
+    /* Hold the lock so that the requests wait in the queue. The thread
+     * may already have taken the first one, letting one more be queued.
+     */
+    dbScanLock((dbCommon *)prec);
+    for (i = 0; i < 10; i++)
+        queued &= scanOnce((dbCommon *)prec) == 0;
+    dbScanUnlock((dbCommon *)prec);
+    testOk(queued, "requests accepted");
+
+    /* Never merged, and queued behind the first request */
+    scanOnceCallback((dbCommon *)prec, onceComp, &waiter);
+    epicsEventMustWait(waiter);
+    testOk(prec->i32 >= 2 && prec->i32 <= 3,
+        "processed %d times for 11 requests", prec->i32);
+    scanOnceQueueShow(0);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+    epicsEventDestroy(waiter);
+}
+
+#define NPAIRS 8
+
+static xRecord *pairs[NPAIRS][2];
+static int outOfOrder;
+
+/* Records a and b are processed in that order once per period */
+static void countProcess(xRecord *prec)
+{
+    int i;
+
+    prec->i32++;
+    for (i = 0; i < NPAIRS; i++) {
+        if (prec == pairs[i][1] && pairs[i][0]->i32 != prec->i32)
+            epicsAtomicIncrIntT(&outOfOrder);
+    }
+}
+
+static void loadPairs(void)
+{
+    int i;
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NPAIRS; i++) {
+        char macros[16];
+
+        sprintf(macros, "P=pair%d", i);
+        testdbReadDatabase("dbScanTest.db", NULL, macros);
+    }
+    for (i = 0; i < NPAIRS; i++) {
+        char name[16];
+
+        sprintf(name, "pair%da", i);
+        pairs[i][0] = (xRecord *)testdbRecordPtr(name);
+        sprintf(name, "pair%db", i);
+        pairs[i][1] = (xRecord *)testdbRecordPtr(name);
+        pairs[i][0]->clbk = pairs[i][1]->clbk = countProcess;
+    }
+    outOfOrder = 0;
+}
+
+static void checkPairs(void)
+{
+    int i, processed = 1;
+
+    for (i = 0; i < NPAIRS; i++) {
+        if (pairs[i][0]->i32 < 3 || pairs[i][1]->i32 < 3) {
+            testDiag("pair%d processed %d and %d times", i,
+                pairs[i][0]->i32, pairs[i][1]->i32);
+            processed = 0;
+        }
+    }
+    testOk(processed, "all records processed");
+    testOk(outOfOrder == 0, "lock set order kept (%d errors)", outOfOrder);
+}
+
+static void testPeriodicThreads(void)
+{
+    testDiag("check periodic scan list processed by several threads");
+
+    loadPairs();
+
+    testOk1(scanPeriodicThreads(3, 0.1) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanPeriodicThreads(2, 0.0) != 0,
+        "can't be configured after iocInit");
+
+    epicsThreadSleep(1.0);
+    scanppl(0.1);
+
+    testIocShutdownOk();
+    checkPairs();
+
+    testdbCleanup();
+}
+
+static void testPeriodicSpread(void)
+{
+    testDiag("check periodic scan list spread over the period");
+
+    loadPairs();
+
+    testOk1(scanPeriodicThreads(2, 0.1) == 0);
+    testOk1(scanPeriodicSpread(4, 0.1, 1) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanPeriodicSpread(2, 0.0, 0) != 0,
+        "can't be configured after iocInit");
+
+    epicsThreadSleep(1.0);
+    scanppl(0.1);
+
+    testIocShutdownOk();
+    checkPairs();
+
+    testdbCleanup();
+}
+
 MAIN(dbScanTest)
 {
-    testPlan(3);
+    testPlan(19);
     testOnce();
+    testOnceCoalesce();
+    testPeriodicThreads();
+    testPeriodicSpread();
     return testDone();
 }
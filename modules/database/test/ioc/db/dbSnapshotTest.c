@@ -0,0 +1,172 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define SNAPSHOT "dbSnapshotTest.dbsnap"
+#define DUMP1 "dbSnapshotTest1.txt"
+#define DUMP2 "dbSnapshotTest2.txt"
+
+static char * readAll(const char *filename, long *psize)
+{
+    FILE *fp = fopen(filename, "rb");
+    char *data = NULL;
+
+    *psize = 0;
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    *psize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = calloc(1, *psize + 1);
+    if (data && fread(data, 1, *psize, fp) != (size_t)*psize) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+static void writeAll(const char *filename, const char *data, long size)
+{
+    FILE *fp = fopen(filename, "wb");
+
+    if (fp) {
+        fwrite(data, 1, size, fp);
+        fclose(fp);
+    }
+}
+
+static void checkString(const char *pv, const char *expected)
+{
+    DBENTRY dbentry;
+    const char *value = NULL;
+
+    dbInitEntry(pdbbase, &dbentry);
+    if (!dbFindRecord(&dbentry, pv))
+        value = dbGetString(&dbentry);
+    testOk(value && !strcmp(value, expected), "%s is '%s'", pv,
+        value ? value : "not found");
+    dbFinishEntry(&dbentry);
+}
+
+static void prepare(void)
+{
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+}
+
+static void testRoundTrip(void)
+{
+    char *dump1, *dump2;
+    long size1, size2;
+    DBENTRY dbentry;
+
+    testDiag("Write and read back a snapshot");
+
+    prepare();
+    testdbReadDatabase("dbSnapshotTest.db", NULL, NULL);
+    testOk1(dbWriteSnapshot(pdbbase, SNAPSHOT) == 0);
+    dbWriteRecord(pdbbase, DUMP1, NULL, 0);
+    testdbCleanup();
+
+    prepare();
+    testOk1(dbReadSnapshot(&pdbbase, SNAPSHOT) == 0);
+    dbWriteRecord(pdbbase, DUMP2, NULL, 0);
+
+    dump1 = readAll(DUMP1, &size1);
+    dump2 = readAll(DUMP2, &size2);
+    testOk(dump1 && dump2 && size1 > 0 && size1 == size2 &&
+        !memcmp(dump1, dump2, size1), "dbWriteRecord output matches");
+    free(dump1);
+    free(dump2);
+    remove(DUMP1);
+    remove(DUMP2);
+
+    dbInitEntry(pdbbase, &dbentry);
+    testOk1(dbFindRecord(&dbentry, "src:alias") == 0 && dbIsAlias(&dbentry));
+    testOk1(dbFindRecord(&dbentry, "tgt:alias") == 0 && dbIsAlias(&dbentry));
+    testOk1(dbFindRecord(&dbentry, "tgt") == 0 &&
+        dbIsVisibleRecord(&dbentry));
+    testOk1(dbFindRecord(&dbentry, "src") == 0 &&
+        strcmp(dbGetInfo(&dbentry, "autosaveFields"), "VAL DESC") == 0);
+    dbFinishEntry(&dbentry);
+    checkString("src.INP", "tgt.VAL CP");
+    checkString("src.FLNK", "tgt");
+    checkString("tgt.LNK", "{z:{good:1}}");
+
+    testIocInitOk();
+    testdbGetFieldEqual("src.DESC", DBR_STRING, "snapshot \"test\"");
+    testdbGetFieldEqual("src.I32", DBR_LONG, 42);
+    testdbGetFieldEqual("src.F64", DBR_DOUBLE, 1.5);
+    testdbGetFieldEqual("tgt.SCAN", DBR_STRING, "1 second");
+    testdbGetFieldEqual("tgt.PHAS", DBR_SHORT, 2);
+    eltc(0);
+    testOk(dbWriteSnapshot(pdbbase, DUMP1) == -2, "Refused after iocInit");
+    eltc(1);
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+static void testBadSnapshots(void)
+{
+    char *data;
+    long size;
+
+    testDiag("Snapshots that must be refused");
+
+    data = readAll(SNAPSHOT, &size);
+    if (!data || size < 20) {
+        testAbort("Can't read " SNAPSHOT);
+        return;
+    }
+
+    prepare();
+    testdbReadDatabase("dbSnapshotTest.db", NULL, NULL);
+    eltc(0);
+    testOk(dbReadSnapshot(&pdbbase, SNAPSHOT) != 0,
+        "Records already loaded with the same type are merged, "
+        "a second alias is refused");
+    eltc(1);
+    testdbCleanup();
+
+    prepare();
+    eltc(0);
+    data[12] ^= 1;          /* checksum */
+    writeAll(SNAPSHOT, data, size);
+    testOk(dbReadSnapshot(&pdbbase, SNAPSHOT) != 0, "Checksum mismatch");
+    data[12] ^= 1;
+    writeAll(SNAPSHOT, data, size - 5);
+    testOk(dbReadSnapshot(&pdbbase, SNAPSHOT) != 0, "Truncated snapshot");
+    data[0] = 'X';
+    writeAll(SNAPSHOT, data, size);
+    testOk(dbReadSnapshot(&pdbbase, SNAPSHOT) != 0, "Bad magic");
+    testOk(dbReadSnapshot(&pdbbase, "noSuchFile.dbsnap") != 0, "No file");
+    eltc(1);
+    testdbCleanup();
+
+    free(data);
+    remove(SNAPSHOT);
+}
+
+MAIN(dbSnapshotTest)
+{
+    testPlan(21);
+    testRoundTrip();
+    testBadSnapshots();
+    return testDone();
+}
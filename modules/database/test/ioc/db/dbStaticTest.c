@@ -4,6 +4,8 @@
 * in file LICENSE that is included with this distribution.
  \*************************************************************************/
 
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <errlog.h>
@@ -303,6 +305,87 @@ static void testWrongAliasRecord(const char *filename)
            "Wrong alias record in %s is expected to fail", filename);
 }
 
+static void testRecordSlabs(void)
+{
+    DBENTRY entry;
+    dbRecordMemory before, mem, prev;
+    char name[20];
+    char *prec[40];
+    size_t recsize, nmore;
+    int i, adjacent = 0;
+
+    testDiag("Record slabs");
+
+    dbInitEntry(pdbbase, &entry);
+    if (dbFindRecordType(&entry, "x"))
+        testAbort("No record type x");
+    testOk1(!dbGetRecordMemory(&entry, &before));
+    recsize = before.recordSize;
+    testOk(recsize % 64 == 0, "Record size %lu is a multiple of 64",
+        (unsigned long)recsize);
+
+    for (i = 0; i < NELEMENTS(prec); i++) {
+        sprintf(name, "slab%d", i);
+        if (dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+        prec[i] = (char *)((dbRecordNode *)entry.precnode)->precord;
+    }
+    for (i = 1; i < NELEMENTS(prec); i++)
+        adjacent += prec[i] - prec[i - 1] == (ptrdiff_t)recsize;
+    testOk(adjacent >= (int)NELEMENTS(prec) - 5,
+        "%d of %d records follow the one before", adjacent,
+        (int)NELEMENTS(prec) - 1);
+
+    dbGetRecordMemory(&entry, &mem);
+    testOk(mem.records == before.records + NELEMENTS(prec),
+        "%lu records", (unsigned long)mem.records);
+    testOk(mem.capacity >= mem.records && mem.slabs > before.slabs,
+        "%lu slabs hold %lu records", (unsigned long)mem.slabs,
+        (unsigned long)mem.capacity);
+    testOk1(mem.bytes >= mem.capacity * recsize);
+
+    /* A new limit applies to the next slabs */
+    dbRecordSlabSize = 1;
+    nmore = mem.capacity - mem.records + 2;
+    prev = mem;
+    for (i = 0; i < nmore; i++) {
+        sprintf(name, "slabmore%d", i);
+        if (dbCreateRecord(&entry, name))
+            testAbort("Can't create %s", name);
+    }
+    dbGetRecordMemory(&entry, &mem);
+    testOk(mem.slabs == prev.slabs + 2 && mem.capacity == prev.capacity + 2,
+        "dbRecordSlabSize=1 gives %lu more slabs for %lu more records",
+        (unsigned long)(mem.slabs - prev.slabs),
+        (unsigned long)(mem.capacity - prev.capacity));
+    dbRecordSlabSize = 1024;
+    for (i = 0; i < nmore; i++) {
+        sprintf(name, "slabmore%d", i);
+        if (!dbFindRecord(&entry, name))
+            dbDeleteRecord(&entry);
+    }
+
+    if (!dbFindRecord(&entry, "slab7"))
+        dbDeleteRecord(&entry);
+    dbGetRecordMemory(&entry, &mem);
+    testOk1(mem.records == before.records + NELEMENTS(prec) - 1);
+    dbCreateRecord(&entry, "slabagain");
+    testOk(((dbRecordNode *)entry.precnode)->precord == (void *)prec[7],
+        "Freed record is reused");
+
+    for (i = 0; i < NELEMENTS(prec); i++) {
+        if (i == 7)
+            strcpy(name, "slabagain");
+        else
+            sprintf(name, "slab%d", i);
+        if (!dbFindRecord(&entry, name))
+            dbDeleteRecord(&entry);
+    }
+    dbGetRecordMemory(&entry, &mem);
+    testOk1(mem.records == before.records);
+    dbFinishEntry(&entry);
+}
+
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
 MAIN(dbStaticTest)
@@ -310,7 +393,7 @@ MAIN(dbStaticTest)
     const char *ldir;
     FILE *fp = NULL;
 
-    testPlan(312);
+    testPlan(322);
     testdbPrepare();
 
     testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
@@ -341,6 +424,8 @@ MAIN(dbStaticTest)
     testRec2Entry("testalias2");
     testRec2Entry("testalias3");
 
+    testRecordSlabs();
+
     eltc(0);
     testIocInitOk();
     eltc(1);
@@ -0,0 +1,191 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "callback.h"
+#include "dbAccess.h"
+#include "dbTrace.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char *traceFile = "dbTraceTest.json";
+static char *trace;
+
+/* Dump the trace and read it back into trace */
+static void readTrace(void)
+{
+    FILE *fp;
+    long size;
+
+    free(trace);
+    trace = NULL;
+    testOk1(dbTraceDump(traceFile) == 0);
+
+    fp = fopen(traceFile, "r");
+    if (!fp) {
+        testAbort("Can't read back %s", traceFile);
+        return;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    trace = calloc(1, size + 1);
+    if (!trace || fread(trace, 1, size, fp) != (size_t)size)
+        testAbort("Can't read back %s", traceFile);
+    fclose(fp);
+}
+
+/* Find an event at or after from, NULL if there is none */
+static const char * findEvent(const char *from, char phase,
+    const char *category, const char *name)
+{
+    char head[16], tail[64];
+    const char *pos = from;
+
+    sprintf(head, "{\"ph\":\"%c\"", phase);
+    sprintf(tail, "\"cat\":\"%s\",\"name\":\"%s\"", category, name);
+    while (pos && (pos = strstr(pos, head))) {
+        const char *end = strchr(pos, '}');
+        const char *match = strstr(pos, tail);
+
+        if (match && match < end)
+            return pos;
+        pos++;
+    }
+    return NULL;
+}
+
+static void testJSON(void)
+{
+    const char *pos;
+    int depth = 0, minDepth = 0;
+
+    testOk(strncmp(trace, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[",
+        39) == 0, "Trace starts with the event array");
+    testOk(strcmp(trace + strlen(trace) - 3, "]}\n") == 0,
+        "Trace ends with the event array");
+    for (pos = trace; *pos; pos++) {
+        if (*pos == '{' || *pos == '[')
+            depth++;
+        else if (*pos == '}' || *pos == ']')
+            depth--;
+        if (depth < minDepth)
+            minDepth = depth;
+    }
+    testOk(depth == 0 && minDepth == 0, "Brackets balance");
+}
+
+static void testFlagOnly(void)
+{
+    testDiag("Trace with only dbTraceMode set");
+
+    /* Set without dbTraceEnable(), before anything was initialized */
+    dbTraceMode = dbTraceAll;
+    testdbPutFieldOk("a.PROC", DBF_LONG, 1);
+    dbTraceMode = dbTraceOff;
+
+    readTrace();
+    testOk1(findEvent(trace, 'B', "process", "a") != NULL);
+}
+
+static void testAll(void)
+{
+    const char *aBegin, *bBegin, *bEnd, *aEnd;
+
+    testDiag("Trace all records");
+
+    dbTraceClear();
+    dbTraceEnable(dbTraceAll);
+    testdbPutFieldOk("a.PROC", DBF_LONG, 1);
+    dbTraceEnable(dbTraceOff);
+    testdbPutFieldOk("a.PROC", DBF_LONG, 1);
+
+    readTrace();
+    testJSON();
+
+    aBegin = findEvent(trace, 'B', "process", "a");
+    bBegin = findEvent(aBegin, 'B', "process", "b");
+    bEnd = findEvent(bBegin, 'E', "process", "b");
+    aEnd = findEvent(bEnd, 'E', "process", "a");
+    testOk(aBegin && bBegin && bEnd && aEnd,
+        "Processing of b is nested inside a");
+    testOk(aEnd && !findEvent(aEnd + 1, 'B', "process", "a"),
+        "Nothing traced once disabled");
+    testOk1(findEvent(trace, 'B', "lock", "a") != NULL);
+    testOk1(findEvent(trace, 'E', "lock", "a") != NULL);
+}
+
+static void testSelected(void)
+{
+    testDiag("Trace only selected records");
+
+    testOk1(dbTraceRecord("b", 1) == 0);
+    testOk1(dbTraceRecord("nonexistent", 1) != 0);
+
+    dbTraceClear();
+    dbTraceEnable(dbTraceSelected);
+    testdbPutFieldOk("a.PROC", DBF_LONG, 1);
+    dbTraceEnable(dbTraceOff);
+
+    readTrace();
+    testJSON();
+    testOk1(findEvent(trace, 'B', "process", "b") != NULL);
+    testOk1(findEvent(trace, 'B', "process", "a") == NULL);
+
+    testOk1(dbTraceRecord("b", 0) == 0);
+}
+
+static void testCallbacks(void)
+{
+    epicsCallback cb;
+
+    testDiag("Trace callbacks");
+
+    memset(&cb, 0, sizeof(cb));
+    dbTraceClear();
+    dbTraceEnable(dbTraceAll);
+    callbackRequestProcessCallback(&cb, priorityLow, testdbRecordPtr("b"));
+    testSyncCallback();
+    dbTraceEnable(dbTraceOff);
+
+    readTrace();
+    testJSON();
+    testOk1(findEvent(trace, 'i', "callback", "request") != NULL);
+    testOk1(findEvent(trace, 'B', "callback", "callback") != NULL);
+    testOk1(findEvent(trace, 'B', "lock", "b") != NULL);
+}
+
+MAIN(dbTraceTest)
+{
+    testPlan(30);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbTraceTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testFlagOnly();
+    testAll();
+    testSelected();
+    testCallbacks();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    free(trace);
+    remove(traceFile);
+    return testDone();
+}
@@ -37,6 +37,9 @@ typedef struct xpriv {
   int member;
 } xpriv;
 
+/* Called by the x record's init_record() for each pass, if set */
+epicsShareExtern void (*xInitRecordHook)(struct xRecord *, int pass);
+
 epicsShareFunc xdrv *xdrv_add(int group, xdrvcb cb, void *arg);
 epicsShareFunc xdrv *xdrv_get(int group);
 epicsShareFunc void xdrv_reset();
@@ -25,6 +25,10 @@ int dbServerTest(void);
 int dbCaStatsTest(void);
 int dbShutdownTest(void);
 int dbScanTest(void);
+int dbTraceTest(void);
+int iocInitTest(void);
+int dbBatchLoadTest(void);
+int dbSnapshotTest(void);
 int scanIoTest(void);
 int dbLockTest(void);
 int dbPutLinkTest(void);
@@ -48,6 +52,10 @@ void epicsRunDbTests(void)
     runTest(dbCaStatsTest);
     runTest(dbShutdownTest);
     runTest(dbScanTest);
+    runTest(dbTraceTest);
+    runTest(iocInitTest);
+    runTest(dbBatchLoadTest);
+    runTest(dbSnapshotTest);
     runTest(scanIoTest);
     runTest(dbLockTest);
     runTest(dbPutLinkTest);
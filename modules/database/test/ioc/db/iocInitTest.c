@@ -0,0 +1,168 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "devx.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "iocInit.h"
+#include "testMain.h"
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* More than one chunk of records for each pool thread */
+#define NRECORDS 1500
+
+/* Records in the order of their init_record() pass 1 */
+static xRecord *initOrder[NRECORDS];
+static int nInit, nOtherThread;
+static epicsThreadId mainThread;
+static epicsMutexId initLock;
+
+static void initRecordHook(xRecord *prec, int pass)
+{
+    if (!pass)
+        return;
+    epicsMutexMustLock(initLock);
+    if (nInit < NRECORDS)
+        initOrder[nInit++] = prec;
+    if (epicsThreadGetIdSelf() != mainThread)
+        nOtherThread++;
+    epicsMutexUnlock(initLock);
+}
+
+/* Every tenth record has a device support not declared thread safe */
+static void loadRecords(void)
+{
+    int i;
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NRECORDS; i++) {
+        char macros[40];
+
+        if (i % 10)
+            sprintf(macros, "N=rec%d", i);
+        else
+            sprintf(macros, "N=rec%d,DTYP=Scan I/O,INP=@1 %d", i, i);
+        testdbReadDatabase("iocInitTest.db", NULL, macros);
+    }
+    xdrv_add(1, NULL, NULL);
+
+    nInit = nOtherThread = 0;
+    mainThread = epicsThreadGetIdSelf();
+    xInitRecordHook = initRecordHook;
+}
+
+/* Whether pass 1 saw the records in the order of the record list */
+static int inListOrder(void)
+{
+    DBENTRY entry;
+    int i = 0, bad = 0;
+    long status;
+
+    dbInitEntry(pdbbase, &entry);
+    dbFindRecordType(&entry, "x");
+    for (status = dbFirstRecord(&entry); !status && !bad;
+         status = dbNextRecord(&entry))
+        bad = i >= nInit || initOrder[i++] != entry.precnode->precord;
+    dbFinishEntry(&entry);
+    return !bad && i == nInit;
+}
+
+static void cleanup(void)
+{
+    xInitRecordHook = NULL;
+    testdbCleanup();
+    xdrv_reset();
+}
+
+static void checkRecords(void)
+{
+    int i, good = 0;
+
+    for (i = 0; i < NRECORDS; i++) {
+        char name[16];
+        xRecord *prec;
+
+        sprintf(name, "rec%d", i);
+        prec = (xRecord *)testdbRecordPtr(name);
+        if (prec->dset && prec->mlok && prec->time.secPastEpoch)
+            good++;
+    }
+    testOk(good == NRECORDS, "%d of %d records initialized and processed",
+        good, NRECORDS);
+}
+
+static void testDeclare(void)
+{
+    testOk1(iocInitThreadSafe("x", NULL) == 0);
+    testOk1(iocInitThreadSafe("x", "Soft Channel") == 0);
+    testOk(iocInitThreadSafe("", NULL) != 0, "record type required");
+}
+
+/* The declarations have no effect with one thread */
+static void testSerial(void)
+{
+    testDiag("Initialize serially");
+
+    loadRecords();
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    checkRecords();
+    testOk(nInit == NRECORDS && !nOtherThread && inListOrder(),
+        "All initialized by the iocInit thread in order");
+    iocInitTimes();
+
+    testIocShutdownOk();
+    cleanup();
+}
+
+static void testParallel(void)
+{
+    testDiag("Initialize with a thread pool");
+
+    testOk1(iocInitThreads(4) == 0);
+
+    loadRecords();
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(iocInitThreads(2) != 0, "can't be configured after iocInit");
+    checkRecords();
+    testOk(nInit == NRECORDS && nOtherThread > 0,
+        "%d records initialized by pool threads", nOtherThread);
+    iocInitTimes();
+
+    testIocShutdownOk();
+    cleanup();
+
+    testOk1(iocInitThreads(1) == 0);
+}
+
+MAIN(iocInitTest)
+{
+    testPlan(10);
+    initLock = epicsMutexMustCreate();
+    testDeclare();
+    testSerial();
+    testParallel();
+    epicsMutexDestroy(initLock);
+    return testDone();
+}
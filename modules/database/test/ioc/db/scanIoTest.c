@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMessageQueue.h"
 #include "epicsPrint.h"
@@ -296,14 +297,215 @@ static void testMultiThreading(void)
     }
 }
 
+#define NMERGE 4
+
+typedef struct {
+    int count[NMERGE];
+    int completed;
+    int holding;
+    epicsEventId held;
+    epicsEventId release;
+    epicsEventId done;
+} testmerge;
+
+static void testcbmerge(xpriv *priv, void *raw)
+{
+    testmerge *td = raw;
+
+    epicsAtomicIncrIntT(&td->count[priv->member]);
+    if (priv->member == 0 && epicsAtomicCmpAndSwapIntT(&td->holding, 1, 0)) {
+        epicsEventMustTrigger(td->held);
+        epicsEventMustWait(td->release);
+    }
+}
+
+static void testcompmerge(void *raw, IOSCANPVT scan, int prio)
+{
+    testmerge *td = raw;
+
+    epicsAtomicIncrIntT(&td->completed);
+    epicsEventMustTrigger(td->done);
+}
+
+/* Wait for the completion callback to have been called n times */
+static int waitCompleted(testmerge *td, int n)
+{
+    while (epicsAtomicGetIntT(&td->completed) < n)
+        if (epicsEventWaitWithTimeout(td->done, 10.0) != epicsEventOK)
+            break;
+    epicsThreadSleep(0.1);
+    return epicsAtomicGetIntT(&td->completed);
+}
+
+static void testCompletions(void)
+{
+    testmerge data;
+    xdrv *drv;
+    int i, n;
+
+    memset(&data, 0, sizeof(data));
+    data.held = epicsEventMustCreate(epicsEventEmpty);
+    data.release = epicsEventMustCreate(epicsEventEmpty);
+    data.done = epicsEventMustCreate(epicsEventEmpty);
+
+    testDiag("Test one completion for each I/O Intr scan");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for(i=0; i<2; i++)
+        loadRecord(0, i, "LOW");
+
+    drv = xdrv_add(0, &testcbmerge, &data);
+    scanIoSetComplete(drv->scan, &testcompmerge, &data);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testDiag("Hold the first scan in g0m0, queue two more behind it");
+    data.holding = 1;
+    testOk1(scanIoRequest(drv->scan)==0x1);
+    epicsEventMustWait(data.held);
+    testOk1(scanIoRequest(drv->scan)==0x1);
+    testOk1(scanIoRequest(drv->scan)==0x1);
+
+    eltc(0);
+    testOk(scanIoSetParallel(drv->scan, 2)!=0,
+        "can't split while a scan is queued");
+    eltc(1);
+
+    epicsEventMustTrigger(data.release);
+    n = waitCompleted(&data, 3);
+    testOk(n==3, "3 completions for 3 scans (%d)", n);
+    for(i=0; i<2; i++)
+        testOk(data.count[i]==3, "g0m%d processed %d times", i,
+            data.count[i]);
+
+    testDiag("Split once idle");
+    testOk1(scanIoSetParallel(drv->scan, 2)==0);
+    testOk1(scanIoRequest(drv->scan)==0x1);
+    n = waitCompleted(&data, 4);
+    testOk(n==4, "1 completion for a split scan (%d)", n);
+    for(i=0; i<2; i++)
+        testOk(data.count[i]==4, "g0m%d processed %d times", i,
+            data.count[i]);
+    testOk1(scanIoSetParallel(drv->scan, 1)==0);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    xdrv_reset();
+
+    epicsEventDestroy(data.held);
+    epicsEventDestroy(data.release);
+    epicsEventDestroy(data.done);
+}
+
+static void testMergeAndSplit(void)
+{
+    testmerge data;
+    dbCommon *precs[NMERGE];
+    xdrv *drv;
+    int i, queued = 1, others = 0, othersDone;
+
+    memset(&data, 0, sizeof(data));
+    data.held = epicsEventMustCreate(epicsEventEmpty);
+    data.release = epicsEventMustCreate(epicsEventEmpty);
+    data.done = epicsEventMustCreate(epicsEventEmpty);
+
+    testDiag("Test merged and split I/O Intr scanning");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for(i=0; i<NMERGE; i++)
+        loadRecord(0, i, "LOW");
+
+    drv = xdrv_add(0, &testcbmerge, &data);
+    scanIoSetComplete(drv->scan, &testcompmerge, &data);
+
+    testOk1(scanIoSetMode(1, 2)==0);
+    callbackParallelThreads(2, "LOW");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanIoSetMode(0, 1)!=0, "can't be configured after iocInit");
+
+    for(i=0; i<NMERGE; i++) {
+        char name[16];
+
+        sprintf(name, "g0m%d", i);
+        precs[i] = testdbRecordPtr(name);
+    }
+
+    testDiag("Hold the first scan in g0m0");
+    data.holding = 1;
+    testOk1(scanIoRequest(drv->scan)==0x1);
+    epicsEventMustWait(data.held);
+
+    testDiag("Records in the other part are processed meanwhile");
+    for(i=1; i<NMERGE; i++) {
+        if (dbLockGetLockId(precs[i]) % 2 != dbLockGetLockId(precs[0]) % 2)
+            others |= 1 << i;
+    }
+    for(i=0; i<50; i++) {
+        int j;
+
+        othersDone = 0;
+        for(j=1; j<NMERGE; j++) {
+            if (epicsAtomicGetIntT(&data.count[j]))
+                othersDone |= 1 << j;
+        }
+        if ((othersDone & others) == others)
+            break;
+        epicsThreadSleep(0.1);
+    }
+    testOk(others && (othersDone & others) == others,
+        "other part processed (0x%x of 0x%x)", othersDone, others);
+
+    testDiag("Requests while held are merged into one scan");
+    for(i=0; i<10; i++)
+        queued &= scanIoRequest(drv->scan)==0x1;
+    testOk1(queued);
+
+    epicsEventMustTrigger(data.release);
+    i = waitCompleted(&data, 2);
+    testOk(i==2, "2 completions for 2 scans (%d)", i);
+
+    /* A split list runs one scan at a time */
+    for(i=0; i<NMERGE; i++)
+        testOk(data.count[i]==2,
+            "g0m%d processed %d times for 11 requests", i, data.count[i]);
+
+    scanpiol();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    xdrv_reset();
+
+    epicsEventDestroy(data.held);
+    epicsEventDestroy(data.release);
+    epicsEventDestroy(data.done);
+}
+
 MAIN(scanIoTest)
 {
-    testPlan(152);
+    testPlan(152 + 13 + 6 + NMERGE);
     testSingleThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testSingleThreading();
     testMultiThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testMultiThreading();
+    testCompletions();
+    testMergeAndSplit();
     return testDone();
 }
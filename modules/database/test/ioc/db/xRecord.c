@@ -30,11 +30,15 @@
 
 #include "devx.h"
 
+void (*xInitRecordHook)(struct xRecord *, int pass);
+
 static long init_record(struct dbCommon *pcommon, int pass)
 {
     struct xRecord *prec = (struct xRecord *)pcommon;
     long ret = 0;
     xdset *xset = (xdset*)prec->dset;
+    if(xInitRecordHook)
+        (*xInitRecordHook)(prec, pass);
     if(!pass) return 0;
 
     if(!xset) {
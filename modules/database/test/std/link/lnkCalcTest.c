@@ -108,6 +108,81 @@ static void testCalc()
         testOk(sevr == MINOR_ALARM, "Alarm severity = MINOR (%d)", sevr);
     }
 
+    testDiag("testing lnkCalc array input");
+
+    {
+        epicsFloat64 arr[5] = {0, 0, 0, 0, 0};
+        epicsEnum16 stat, sevr;
+        epicsInt32 i32 = 0;
+        long nelem = 0;
+        long nReq = 5;
+
+        testPutLongStr("io.INPUT", "{calc:{"
+            "expr:'A*B+C',"
+            "nelm:5,"
+            "major:'VAL>15',"
+            "args:[{const:[1,2,3,4,5]},{const:[2,2,2]},10]"
+            "}}");
+        if (testOk1(pinp->type == JSON_LINK))
+            testDiag("Link was set to '%s'", pinp->value.json.string);
+
+        status = dbGetNelements(pinp, &nelem);
+        testOk(!status && nelem == 5, "Link has %ld elements", nelem);
+
+        status = dbGetLink(pinp, DBF_DOUBLE, arr, NULL, &nReq);
+        testOk(!status, "dbGetLink succeeded (status = %ld)", status);
+        testOk(nReq == 3, "Got 3 elements (%ld)", nReq);
+        testOk(arr[0] == 12 && arr[1] == 14 && arr[2] == 16 && arr[3] == 0,
+            "Got [12, 14, 16] ([%g, %g, %g, %g])",
+            arr[0], arr[1], arr[2], arr[3]);
+        testOk(recGblResetAlarms(pio) & DBE_ALARM, "Record alarm was raised");
+        status = dbGetAlarm(pinp, &stat, &sevr);
+        testOk(!status && sevr == MAJOR_ALARM,
+            "Alarm severity = MAJOR (%d)", sevr);
+
+        status = dbGetLink(pinp, DBF_DOUBLE, &f64, NULL, NULL);
+        testOk(!status && f64 == 12, "Scalar read gets first element (%g)",
+            f64);
+
+        testPutLongStr("io.INPUT", "{calc:{"
+            "expr:'A*A',"
+            "nelm:10,"
+            "reduce:'sum',"
+            "args:[{const:[1,2,3,4]}]"
+            "}}");
+        if (testOk1(pinp->type == JSON_LINK))
+            testDiag("Link was set to '%s'", pinp->value.json.string);
+
+        status = dbGetNelements(pinp, &nelem);
+        testOk(!status && nelem == 1, "Reduced link has %ld elements", nelem);
+
+        nReq = 5;
+        status = dbGetLink(pinp, DBF_DOUBLE, arr, NULL, &nReq);
+        testOk(!status && nReq == 1 && arr[0] == 30,
+            "Sum of squares = %g (%ld elements)", arr[0], nReq);
+
+        testPutLongStr("io.INPUT", "{calc:{"
+            "expr:'A<0?-A:A',"
+            "nelm:4,"
+            "reduce:'MAX',"
+            "args:[{const:[1,-7,3,4]}]"
+            "}}");
+        status = dbGetLink(pinp, DBF_LONG, &i32, NULL, NULL);
+        testOk(!status && i32 == 7, "Largest magnitude = %d", i32);
+
+        {
+            const char bad[] = "{calc:{expr:'A',reduce:'sum',args:[1]}}";
+            DBADDR addr;
+
+            if (dbNameToAddr("io.INPUT", &addr))
+                testAbort("No io.INPUT");
+            eltc(0);
+            status = dbPutField(&addr, DBF_CHAR, bad, sizeof(bad));
+            eltc(1);
+            testOk(status != 0, "reduce without nelm is rejected");
+        }
+    }
+
     testDiag("testing lnkCalc output");
 
     {
@@ -157,7 +232,7 @@ static void testCalc()
 
 MAIN(lnkCalcTest)
 {
-    testPlan(30);
+    testPlan(46);
 
     testCalc();
 
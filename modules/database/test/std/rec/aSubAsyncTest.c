@@ -0,0 +1,164 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "alarm.h"
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "iocsh.h"
+#include "menuYesNo.h"
+#include "recGbl.h"
+#include "registryFunction.h"
+#include "testMain.h"
+
+#include "aSubRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static epicsEventId started, gate;
+static epicsThreadId subThread;
+static int gated;
+
+/* VALA = A + 1, a MINOR alarm above 100, an error below 0 */
+static long aSubAsyncSub(aSubRecord *prec)
+{
+    double a = *(double *)prec->a;
+
+    subThread = epicsThreadGetIdSelf();
+    if (gated) {
+        epicsEventMustTrigger(started);
+        epicsEventMustWait(gate);
+    }
+    if (a < 0)
+        return -1;
+    if (a > 100)
+        recGblSetSevr(prec, HIGH_ALARM, MINOR_ALARM);
+    *(double *)prec->vala = a + 1;
+    return 0;
+}
+
+static void processWait(testMonitor *pmon, double a)
+{
+    testMonitorCount(pmon, 1);
+    testdbPutFieldOk("as.A", DBF_DOUBLE, a);
+    testdbPutFieldOk("as.PROC", DBF_UCHAR, 1);
+    testMonitorWait(pmon);
+}
+
+static void testSync(testMonitor *pmon)
+{
+    testDiag("ASYN=NO");
+    processWait(pmon, 5.0);
+    testOk1(subThread == epicsThreadGetIdSelf());
+    testdbGetFieldEqual("out", DBF_DOUBLE, 6.0);
+    testdbGetFieldEqual("as.NRUN", DBF_ULONG, 0);
+
+    // number of tests = 5
+}
+
+static void testAsync(testMonitor *pmon)
+{
+    double texe = 0, tmax = 0;
+
+    testDiag("ASYN=YES");
+    testdbPutFieldOk("as.ASYN", DBF_UCHAR, menuYesNoYES);
+
+    gated = 1;
+    testMonitorCount(pmon, 1);
+    testdbPutFieldOk("as.A", DBF_DOUBLE, 7.0);
+    testdbPutFieldOk("as.PROC", DBF_UCHAR, 1);
+    epicsEventMustWait(started);
+
+    /* The record isn't locked while the subroutine runs */
+    testdbGetFieldEqual("as.PACT", DBF_UCHAR, 1);
+    testdbPutFieldOk("as.A", DBF_DOUBLE, 9.0);
+    testdbGetFieldEqual("out", DBF_DOUBLE, 6.0);
+    testOk(testMonitorCount(pmon, 0) == 0, "FLNK not yet processed");
+
+    epicsThreadSleep(0.01);
+    epicsEventMustTrigger(gate);
+    testMonitorWait(pmon);
+    gated = 0;
+
+    testOk1(subThread != epicsThreadGetIdSelf());
+    testdbGetFieldEqual("as.PACT", DBF_UCHAR, 0);
+    testdbGetFieldEqual("out", DBF_DOUBLE, 8.0);
+    testdbGetFieldEqual("as.VAL", DBF_LONG, 0);
+    testdbGetFieldEqual("as.NRUN", DBF_ULONG, 1);
+    testdbGetFieldEqual("as.A", DBF_DOUBLE, 9.0);
+
+    {
+        DBADDR addr;
+
+        if (dbNameToAddr("as.TEXE", &addr))
+            testAbort("No as.TEXE");
+        dbScanLock(addr.precord);
+        texe = ((aSubRecord *)addr.precord)->texe;
+        tmax = ((aSubRecord *)addr.precord)->tmax;
+        dbScanUnlock(addr.precord);
+    }
+    testOk(texe >= 0.005 && tmax == texe, "TEXE %g, TMAX %g", texe, tmax);
+    testdbPutFieldOk("as.TMAX", DBF_DOUBLE, 0.0);
+
+    testDiag("Error return and alarms");
+    processWait(pmon, -1.0);
+    testdbGetFieldEqual("as.VAL", DBF_LONG, -1);
+    testdbGetFieldEqual("as.SEVR", DBF_USHORT, MAJOR_ALARM);
+    testdbGetFieldEqual("out", DBF_DOUBLE, 8.0);
+
+    processWait(pmon, 200.0);
+    testdbGetFieldEqual("as.SEVR", DBF_USHORT, MINOR_ALARM);
+    testdbGetFieldEqual("as.STAT", DBF_USHORT, HIGH_ALARM);
+    testdbGetFieldEqual("out", DBF_DOUBLE, 201.0);
+    testdbGetFieldEqual("as.NRUN", DBF_ULONG, 3);
+
+    // number of tests = 26
+}
+
+static void testPoolFull(testMonitor *pmon)
+{
+    testDiag("No room on the pool");
+    iocshCmd("var aSubAsyncMaxJobs 0");
+    processWait(pmon, 10.0);
+    testOk1(subThread == epicsThreadGetIdSelf());
+    testdbGetFieldEqual("out", DBF_DOUBLE, 11.0);
+    testdbGetFieldEqual("as.NRUN", DBF_ULONG, 3);
+    testdbGetFieldEqual("as.NSYN", DBF_ULONG, 1);
+
+    // number of tests = 6
+}
+
+MAIN(aSubAsyncTest)
+{
+    testMonitor *pmon;
+
+    testPlan(37);
+
+    started = epicsEventMustCreate(epicsEventEmpty);
+    gate = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    registryFunctionAdd("aSubAsyncSub", (REGISTRYFUNCTION)aSubAsyncSub);
+    testdbReadDatabase("aSubAsyncTest.db", NULL, NULL);
+
+    testIocInitOk();
+    pmon = testMonitorCreate("cnt", DBE_VALUE, 0);
+
+    testSync(pmon);
+    testAsync(pmon);
+    testPoolFull(pmon);
+
+    testMonitorDestroy(pmon);
+    testIocShutdownOk();
+    testdbCleanup();
+
+    epicsEventDestroy(started);
+    epicsEventDestroy(gate);
+    return testDone();
+}
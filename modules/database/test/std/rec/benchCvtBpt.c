@@ -0,0 +1,109 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Breakpoint table conversion rates, with and without the grid index */
+
+#include "cantProceed.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "dbBase.h"
+#include "cvtTable.h"
+#include "epicsTime.h"
+#include "menuConvert.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NVALS 100000
+
+/* Million conversions/s, repeated for at least 0.2 sec. */
+static double runConvert(short linr, const double *pvals, double *pbuf,
+    int array)
+{
+    epicsTimeStamp start, stop;
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    double elapsed;
+    size_t count = 0;
+    int i;
+
+    epicsTimeGetCurrent(&start);
+    do {
+        for (i = 0; i < NVALS; i++)
+            pbuf[i] = pvals[i];
+        if (array)
+            cvtRawToEngBptArray(pbuf, NVALS, linr, 0, &ppbrk, &lbrk);
+        else
+            for (i = 0; i < NVALS; i++)
+                cvtRawToEngBpt(&pbuf[i], linr, 0, &ppbrk, &lbrk);
+        count += NVALS;
+        epicsTimeGetCurrent(&stop);
+        elapsed = epicsTimeDiffInSeconds(&stop, &start);
+    } while (elapsed < 0.2);
+    return count / elapsed / 1e6;
+}
+
+static void runTable(short linr, const char *name)
+{
+    double *prandom = callocMustSucceed(NVALS, sizeof(double), "runTable");
+    double *pramp = callocMustSucceed(NVALS, sizeof(double), "runTable");
+    double *pbuf = callocMustSucceed(NVALS, sizeof(double), "runTable");
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    double val = 0;
+    brkTable *pbrk;
+    brkIndex *prawIndex;
+    double first, span;
+    unsigned seed = 1;
+    int i, index;
+
+    cvtRawToEngBpt(&val, linr, 1, &ppbrk, &lbrk);
+    pbrk = (brkTable *)ppbrk;
+    first = pbrk->paBrkInt[0].raw;
+    span = pbrk->paBrkInt[pbrk->number - 1].raw - first;
+
+    /* Random values, and a slow ramp as a real sensor would give */
+    for (i = 0; i < NVALS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        prandom[i] = first + span * (seed >> 8) / (1u << 24);
+        pramp[i] = first + span * i / NVALS;
+    }
+
+    testDiag("%s, %ld points, million conversions/s", name, pbrk->number);
+    testDiag("         random  ramp  random[]  ramp[]");
+    prawIndex = pbrk->prawIndex;
+    for (index = 0; index < 2; index++) {
+        pbrk->prawIndex = index ? prawIndex : NULL;
+        testDiag("%-8s %6.1f %6.1f %8.1f %7.1f", index ? "grid" : "walk",
+            runConvert(linr, prandom, pbuf, 0),
+            runConvert(linr, pramp, pbuf, 0),
+            runConvert(linr, prandom, pbuf, 1),
+            runConvert(linr, pramp, pbuf, 1));
+    }
+    pbrk->prawIndex = prawIndex;
+
+    free(prandom);
+    free(pramp);
+    free(pbuf);
+}
+
+MAIN(benchCvtBpt)
+{
+    testPlan(0);
+
+    testdbPrepare();
+    testdbReadDatabase("cvtBptTest.dbd", NULL, NULL);
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    runTable(menuConverttypeKdegF, "typeKdegF");
+    runTable(menuConverttypeKdegC, "typeKdegC");
+    runTable(menuConverttypeJdegF, "typeJdegF");
+    runTable(menuConverttypeJdegC, "typeJdegC");
+
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,205 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "dbBase.h"
+#include "cvtTable.h"
+#include "menuConvert.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NVALS 10000
+
+/* Deterministic values jumping around the table and 10% past each end */
+static void fillValues(double *pval, double first, double last)
+{
+    double span = last - first;
+    unsigned seed = 12345;
+    int i;
+
+    for (i = 0; i < NVALS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pval[i] = first - 0.1 * span + 1.2 * span * (seed >> 8) / (1u << 24);
+    }
+}
+
+/* Find the interval by scanning the whole table */
+static double refConvert(const brkTable *pbrk, double val, int toEng,
+    long *pstatus)
+{
+    const brkInt *pint = pbrk->paBrkInt;
+    int last = pbrk->number - 1;
+    double x0 = toEng ? pint[0].raw : pint[0].eng;
+    double xn = toEng ? pint[last].raw : pint[last].eng;
+    int down = xn < x0;
+    int i;
+
+    *pstatus = 0;
+    if (down ? val > x0 : val < x0) {
+        *pstatus = 1;
+        i = 0;
+    }
+    else if (down ? val < xn : val > xn) {
+        *pstatus = 1;
+        i = last;
+    }
+    else {
+        for (i = 0; i < last - 1; i++) {
+            double next = toEng ? pint[i + 1].raw : pint[i + 1].eng;
+
+            if (down ? val >= next : val <= next)
+                break;
+        }
+    }
+    if (toEng)
+        return pint[i].eng + (val - pint[i].raw) * pint[i].slope;
+    return pint[i].raw + (val - pint[i].eng) / pint[i].slope;
+}
+
+/* Compare each conversion with the reference, returns the bad count */
+static int checkConvert(short linr, const brkTable *pbrk, const double *pvals,
+    int toEng)
+{
+    const brkInt *pint = pbrk->paBrkInt;
+    double scale = fabs(pint[pbrk->number - 1].eng - pint[0].eng) +
+        fabs(pint[pbrk->number - 1].raw - pint[0].raw);
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    int i, bad = 0;
+
+    for (i = 0; i < NVALS; i++) {
+        double val = pvals[i];
+        long refStatus, status;
+        double ref = refConvert(pbrk, val, toEng, &refStatus);
+
+        if (toEng)
+            status = cvtRawToEngBpt(&val, linr, 0, &ppbrk, &lbrk);
+        else
+            status = cvtEngToRawBpt(&val, linr, 0, &ppbrk, &lbrk);
+        if (status != refStatus || fabs(val - ref) > 1e-9 * scale) {
+            if (!bad++)
+                testDiag("%s %g gave %g status %ld, expected %g status %ld",
+                    toEng ? "raw" : "eng", pvals[i], val, status,
+                    ref, refStatus);
+        }
+    }
+    return bad;
+}
+
+/* The array routines must match the scalar ones exactly, and return
+ * the first non-zero status they do.
+ */
+static int checkArray(short linr, const double *pvals, int toEng)
+{
+    double *pbuf = malloc(NVALS * sizeof(double));
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    long status, refStatus = 0;
+    int i, bad = 0;
+
+    if (!pbuf)
+        testAbort("Out of memory");
+    for (i = 0; i < NVALS; i++)
+        pbuf[i] = pvals[i];
+    if (toEng)
+        status = cvtRawToEngBptArray(pbuf, NVALS, linr, 1, &ppbrk, &lbrk);
+    else
+        status = cvtEngToRawBptArray(pbuf, NVALS, linr, 1, &ppbrk, &lbrk);
+
+    for (i = 0; i < NVALS; i++) {
+        double val = pvals[i];
+        long stat;
+
+        if (toEng)
+            stat = cvtRawToEngBpt(&val, linr, 0, &ppbrk, &lbrk);
+        else
+            stat = cvtEngToRawBpt(&val, linr, 0, &ppbrk, &lbrk);
+        if (val != pbuf[i])
+            bad++;
+        if (!refStatus)
+            refStatus = stat;
+    }
+    if (status != refStatus) {
+        testDiag("Array status %ld, expected %ld", status, refStatus);
+        bad++;
+    }
+    free(pbuf);
+    return bad;
+}
+
+static void testTable(short linr, const char *name)
+{
+    double *prawVals = malloc(NVALS * sizeof(double));
+    double *pengVals = malloc(NVALS * sizeof(double));
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    double val = 0;
+    brkTable *pbrk;
+    brkIndex *prawIndex, *pengIndex;
+    int last;
+
+    if (!prawVals || !pengVals)
+        testAbort("Out of memory");
+
+    testDiag("Breakpoint table %s", name);
+    testOk1(cvtRawToEngBpt(&val, linr, 1, &ppbrk, &lbrk) != -1);
+    pbrk = (brkTable *)ppbrk;
+    last = pbrk->number - 1;
+    testOk(pbrk->prawIndex && pbrk->pengIndex,
+        "%ld points, indexed", pbrk->number);
+
+    fillValues(prawVals, pbrk->paBrkInt[0].raw, pbrk->paBrkInt[last].raw);
+    fillValues(pengVals, pbrk->paBrkInt[0].eng, pbrk->paBrkInt[last].eng);
+
+    testOk(!checkConvert(linr, pbrk, prawVals, 1), "Raw to eng");
+    testOk(!checkConvert(linr, pbrk, pengVals, 0), "Eng to raw");
+    testOk(!checkArray(linr, prawVals, 1), "Raw to eng array");
+    testOk(!checkArray(linr, pengVals, 0), "Eng to raw array");
+
+    /* Without the index the table is walked from the last interval */
+    prawIndex = pbrk->prawIndex;
+    pengIndex = pbrk->pengIndex;
+    pbrk->prawIndex = pbrk->pengIndex = NULL;
+    testOk(!checkConvert(linr, pbrk, prawVals, 1), "Raw to eng, no index");
+    testOk(!checkConvert(linr, pbrk, pengVals, 0), "Eng to raw, no index");
+    pbrk->prawIndex = prawIndex;
+    pbrk->pengIndex = pengIndex;
+
+    free(prawVals);
+    free(pengVals);
+}
+
+MAIN(cvtBptTest)
+{
+    void *ppbrk = NULL;
+    short lbrk = 0;
+    double val = 0;
+
+    testPlan(2 + 4 * 8);
+
+    testdbPrepare();
+    testdbReadDatabase("cvtBptTest.dbd", NULL, NULL);
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    testOk(cvtRawToEngBpt(&val, menuConvertNO_CONVERSION, 1, &ppbrk, &lbrk) == -1,
+        "NO_CONVERSION is not a breakpoint table");
+    testOk(cvtRawToEngBptArray(&val, 1, menuConvertSLOPE, 1, &ppbrk, &lbrk) == -1,
+        "SLOPE is not a breakpoint table");
+
+    testTable(menuConverttypeKdegF, "typeKdegF");
+    testTable(menuConverttypeKdegC, "typeKdegC");
+    testTable(menuConverttypeJdegF, "typeJdegF");
+    testTable(menuConverttypeJdegC, "typeJdegC");
+
+    testdbCleanup();
+    return testDone();
+}
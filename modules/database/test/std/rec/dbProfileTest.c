@@ -0,0 +1,196 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbProfile.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "registryFunction.h"
+#include "subRecord.h"
+#include "testMain.h"
+
+static
+long sleepSubr(subRecord *prec)
+{
+    epicsThreadSleep(prec->a);
+    return 0;
+}
+
+static
+long asyncSubr(subRecord *prec)
+{
+    if (!prec->pact)
+        prec->pact = 1;     /* Make asynchronous */
+    return 0;
+}
+
+static
+dbProfileEntry *findEntry(dbProfileEntry *entries, int n, const char *name)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (!strcmp(entries[i].precord->name, name))
+            return &entries[i];
+    }
+    return NULL;
+}
+
+static
+void testDisabled(void)
+{
+    dbProfileEntry entries[4];
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    testdbPutFieldOk("parent.PROC", DBF_CHAR, 1);
+    testOk(dbProfileTop(entries, 4) == 0, "Nothing profiled while disabled");
+}
+
+static
+void testFlagOnly(void)
+{
+    dbProfileEntry entries[4];
+    int n;
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    /* Set without dbProfileEnable(), before anything was initialized */
+    dbProfiling = 1;
+    testdbPutFieldOk("parent.PROC", DBF_CHAR, 1);
+    dbProfiling = 0;
+    n = dbProfileTop(entries, 4);
+    testOk(n == 2, "Two records profiled with only the flag set (%d)", n);
+    dbProfileReset();
+}
+
+static
+void testProcessTimes(void)
+{
+    dbProfileEntry entries[4], *parent, *child;
+    int n;
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    dbProfileEnable(1);
+    testdbPutFieldOk("parent.PROC", DBF_CHAR, 1);
+    testdbPutFieldOk("parent.PROC", DBF_CHAR, 1);
+
+    n = dbProfileTop(entries, 4);
+    testOk(n == 2, "Two records profiled (%d)", n);
+    parent = findEntry(entries, n, "parent");
+    child = findEntry(entries, n, "child");
+    if (!testOk(parent && child, "Found parent and child")) {
+        testSkip(6, "Missing entries");
+        return;
+    }
+    testOk(entries[0].precord == child->precord, "child is most costly");
+    testOk(parent->count == 2 && child->count == 2,
+        "Process counts %g and %g", parent->count, child->count);
+    testOk(parent->selfTime >= 0.019 && parent->selfTime < child->selfTime,
+        "parent self time %.3f s excludes child", parent->selfTime);
+    testOk(parent->totalTime >= parent->selfTime + child->totalTime * 0.99,
+        "parent total time %.3f s includes child %.3f s",
+        parent->totalTime, child->totalTime);
+    testOk(child->maxTime >= 0.029 && child->maxTime <= child->totalTime,
+        "child max time %.3f s", child->maxTime);
+    testOk(parent->asyncCount == 0, "No async completions");
+}
+
+static
+void testAsync(void)
+{
+    dbCommon *async = testdbRecordPtr("async");
+    dbProfileEntry entries[4], *pentry;
+    int n;
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    testdbPutFieldOk("async.PROC", DBF_CHAR, 1);
+    testOk(async->pact, "async is active");
+    epicsThreadSleep(0.05);
+
+    dbScanLock(async);
+    async->rset->process(async);
+    dbScanUnlock(async);
+
+    n = dbProfileTop(entries, 4);
+    pentry = findEntry(entries, n, "async");
+    if (!testOk(pentry != NULL, "Found async")) {
+        testSkip(2, "Missing entry");
+        return;
+    }
+    testOk(pentry->asyncCount == 1, "One async completion (%g)",
+        pentry->asyncCount);
+    testOk(pentry->asyncTime >= 0.049 && pentry->asyncMax == pentry->asyncTime,
+        "Async completion took %.3f s", pentry->asyncTime);
+}
+
+static
+void testWaveforms(void)
+{
+    char names[2][MAX_STRING_SIZE] = {"child", "parent"};
+    dbProfileEntry entries[1];
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    testOk1(dbProfileTop(entries, 1) == 1);
+    /* names forward links to self, so both use the same ranking */
+    testdbPutFieldOk("names.PROC", DBF_CHAR, 1);
+    testdbGetArrFieldEqual("names", DBF_STRING, 2, 2, names);
+    testdbGetArrFieldEqual("self", DBF_DOUBLE, 1, 1, &entries[0].selfTime);
+}
+
+static
+void testReset(void)
+{
+    dbProfileEntry entries[4];
+
+    testDiag("============ Starting %s ============", EPICS_FUNCTION);
+
+    dbprof(5, NULL);
+    dbProfileReset();
+    testOk(dbProfileTop(entries, 4) == 0, "Nothing left after reset");
+
+    dbProfileEnable(0);
+    testdbPutFieldOk("parent.PROC", DBF_CHAR, 1);
+    testOk(dbProfileTop(entries, 4) == 0, "Nothing profiled after disable");
+}
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+MAIN(dbProfileTest)
+{
+    testPlan(26);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    registryFunctionAdd("sleepSubr", (REGISTRYFUNCTION) sleepSubr);
+    registryFunctionAdd("asyncSubr", (REGISTRYFUNCTION) asyncSubr);
+
+    testdbReadDatabase("dbProfileTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testDisabled();
+    testFlagOnly();
+    testProcessTimes();
+    testAsync();
+    testWaveforms();
+    testReset();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
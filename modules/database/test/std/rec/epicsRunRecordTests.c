@@ -21,6 +21,7 @@ int asTest(void);
 int linkRetargetLinkTest(void);
 int linkInitTest(void);
 int asyncSoftTest(void);
+int dbProfileTest(void);
 int simmTest(void);
 int mbbioDirectTest(void);
 int scanEventTest(void);
@@ -28,6 +29,9 @@ int boTest(void);
 int biTest(void);
 int printfTest(void);
 int aiTest(void);
+int cvtBptTest(void);
+int fanoutTest(void);
+int aSubAsyncTest(void);
 
 void epicsRunRecordTests(void)
 {
@@ -49,6 +53,8 @@ void epicsRunRecordTests(void)
 
     runTest(asyncSoftTest);
 
+    runTest(dbProfileTest);
+
     runTest(simmTest);
 
     runTest(mbbioDirectTest);
@@ -62,6 +68,9 @@ void epicsRunRecordTests(void)
     runTest(printfTest);
 
     runTest(aiTest);
+    runTest(cvtBptTest);
+    runTest(fanoutTest);
+    runTest(aSubAsyncTest);
 
     epicsExit(0);   /* Trigger test harness */
 }
@@ -0,0 +1,121 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#define EPICS_DBCA_PRIVATE_API
+#include "callback.h"
+#include "dbAccess.h"
+#include "dbCa.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "menuYesNo.h"
+#include "testMain.h"
+
+#include "fanoutRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void testTargets(double t0, double t1, double t2, double t3,
+    double t4)
+{
+    testdbGetFieldEqual("t0", DBF_DOUBLE, t0);
+    testdbGetFieldEqual("t1", DBF_DOUBLE, t1);
+    testdbGetFieldEqual("t2", DBF_DOUBLE, t2);
+    testdbGetFieldEqual("t3", DBF_DOUBLE, t3);
+    testdbGetFieldEqual("t4", DBF_DOUBLE, t4);
+}
+
+static void testSerial(void)
+{
+    testDiag("PARL=NO");
+    testdbPutFieldOk("fo.PROC", DBF_UCHAR, 1);
+    dbCaSync();
+    testSyncCallback();
+    testTargets(1, 1, 1, 1, 1);
+
+    // number of tests = 6
+}
+
+static void testParallel(void)
+{
+    DBADDR addr;
+    epicsUInt8 proc = 1;
+    long status = 0;
+    int i;
+
+    testDiag("PARL=YES");
+    testdbPutFieldOk("fo.PARL", DBF_UCHAR, menuYesNoYES);
+    testdbPutFieldOk("fo.PROC", DBF_UCHAR, 1);
+    testSyncCallback();
+    testTargets(2, 2, 2, 2, 2);
+    testdbGetFieldEqual("fo.PACT", DBF_UCHAR, 0);
+
+    /* FLNK only processes once all the targets have */
+    testdbGetFieldEqual("sum", DBF_DOUBLE, 10.0);
+
+    testDiag("PARL=YES, SELM=Mask");
+    testdbPutFieldOk("fo.SELM", DBF_USHORT, fanoutSELM_Mask);
+    testdbPutFieldOk("fo.SHFT", DBF_SHORT, 0);
+    testdbPutFieldOk("fo.SELN", DBF_USHORT, 0x15);
+    testdbPutFieldOk("fo.PROC", DBF_UCHAR, 1);
+    testSyncCallback();
+    testTargets(3, 2, 3, 2, 3);
+    testdbGetFieldEqual("sum", DBF_DOUBLE, 13.0);
+
+    testDiag("PARL=YES, processed 20 times");
+    testdbPutFieldOk("fo.SELM", DBF_USHORT, fanoutSELM_All);
+    testOk1(!dbNameToAddr("fo.PROC", &addr));
+    for (i = 0; i < 20; i++) {
+        status |= dbPutField(&addr, DBR_UCHAR, &proc, 1);
+        testSyncCallback();
+    }
+    testOk1(!status);
+    testTargets(23, 22, 23, 22, 23);
+    testdbGetFieldEqual("sum", DBF_DOUBLE, 113.0);
+
+    testDiag("PARL=YES, LNK0 changed");
+    testdbPutFieldOk("fo.LNK0", DBF_STRING, "t1.PROC CA");
+    testdbCaWaitForConnect(&((fanoutRecord *)testdbRecordPtr("fo"))->lnk0);
+    testdbPutFieldOk("fo.PROC", DBF_UCHAR, 1);
+    testSyncCallback();
+    testTargets(23, 24, 24, 23, 24);
+    testdbGetFieldEqual("sum", DBF_DOUBLE, 118.0);
+
+    // number of tests = 36
+}
+
+MAIN(fanoutTest)
+{
+    testPlan(6 + 36);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("fanoutTest.db", NULL, NULL);
+
+    /* Several threads to run the targets on */
+    callbackParallelThreads(4, "");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    {
+        fanoutRecord *prec = (fanoutRecord *)testdbRecordPtr("fo");
+
+        testdbCaWaitForConnect(&prec->lnk0);
+        testdbCaWaitForConnect(&prec->lnk1);
+        testdbCaWaitForConnect(&prec->lnk2);
+        testdbCaWaitForConnect(&prec->lnk3);
+    }
+
+    testSerial();
+    testParallel();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -453,6 +453,90 @@ static void test_ll_flag(void){
     // number of tests = 6
 }
 
+static void test_hc_format(void){
+
+    const char format_string[] = "Format test string %hc%hhc";
+    const char result_string[] = "Format test string RS";
+
+    /* set format string */
+    testdbPutFieldOk("test_printf_rec.FMT", DBF_STRING, format_string);
+
+    /* set value on inp1, 83 is ASCII for S */
+    testdbPutFieldOk("test_printf_inp1_rec.VAL", DBF_STRING, "83");
+
+    /* set value on inp0, 82 is ASCII for R */
+    testdbPutFieldOk("test_printf_inp0_rec.VAL", DBF_SHORT, 82);
+
+    /* verify that string is formatted as expected */
+    testdbGetFieldEqual("test_printf_rec.VAL", DBF_STRING, result_string);
+
+    // number of tests = 4
+}
+
+static void test_l_negative(void){
+
+    const char format_string[] = "Format test string %ld";
+    const char result_string[] = "Format test string -42";
+
+    /* set format string */
+    testdbPutFieldOk("test_printf_rec.FMT", DBF_STRING, format_string);
+
+    /* set value on inp0 */
+    testdbPutFieldOk("test_printf_inp0_rec.VAL", DBF_LONG, -42);
+
+    /* verify that string is formatted as expected */
+    testdbGetFieldEqual("test_printf_rec.VAL", DBF_STRING, result_string);
+
+    // number of tests = 3
+}
+
+static void test_star_width(void){
+
+    const char format_string[] = "%d %s%*d|%%";
+    const char result_string[] = "4 Reperbahn   -5|%";
+
+    /* set format string */
+    testdbPutFieldOk("test_printf_rec.FMT", DBF_STRING, format_string);
+
+    /* set value on inp1 */
+    testdbPutFieldOk("test_printf_inp1_rec.VAL", DBF_STRING, "Reperbahn");
+
+    /* set width on inp2 */
+    testdbPutFieldOk("test_printf_inp2_rec.VAL", DBR_INT64, 5);
+
+    /* set value on inp3 */
+    testdbPutFieldOk("test_printf_inp3_rec.VAL", DBF_SHORT, -5);
+
+    /* set value on inp0 */
+    testdbPutFieldOk("test_printf_inp0_rec.VAL", DBF_SHORT, 4);
+
+    /* verify that string is formatted as expected */
+    testdbGetFieldEqual("test_printf_rec.VAL", DBF_STRING, result_string);
+
+    // number of tests = 6
+}
+
+static void test_bad_format(void){
+
+    const char format_string[] = "Format test string %d %q %s %";
+    const char result_string[] = "Format test string 8 %q Reperbahn ";
+
+    /* set format string */
+    testdbPutFieldOk("test_printf_rec.FMT", DBF_STRING, format_string);
+
+    /* set value on inp1 */
+    testdbPutFieldOk("test_printf_inp1_rec.VAL", DBF_STRING, "Reperbahn");
+
+    /* set value on inp0 */
+    testdbPutFieldOk("test_printf_inp0_rec.VAL", DBF_SHORT, 8);
+
+    /* verify that the bad directive is copied without using an input,
+     * and the unterminated one at the end is dropped */
+    testdbGetFieldEqual("test_printf_rec.VAL", DBF_STRING, result_string);
+
+    // number of tests = 4
+}
+
 static void test_sizv(void){
 
     const char format_string[] = "%d %s %llx";
@@ -530,7 +614,7 @@ MAIN(printfTest) {
 #endif
 #endif
 
-    testPlan(3+3+3+3+3+3+3+3+4+3+3+3+3+3+3+3+3+3+3+3+3+3+3+3+6+6+12);
+    testPlan(3+3+3+3+3+3+3+3+4+3+3+3+3+3+3+3+3+3+3+3+3+3+3+4+3+6+3+6+4+6+12);
 
     testdbPrepare();   
     testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
@@ -567,6 +651,10 @@ MAIN(printfTest) {
     test_hh_flag();
     test_l_flag();
     test_ll_flag();
+    test_hc_format();
+    test_l_negative();
+    test_star_width();
+    test_bad_format();
     test_sizv();
     test_all_inputs();
 
@@ -0,0 +1,633 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Evaluate calc expressions over arrays of arguments.
+ *
+ * Straight-line expressions are run a block of elements at a time, so
+ * each operator becomes a short loop over the block which the compiler
+ * can vectorize. The stack holds one block per level.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+#ifndef PI
+#define PI 3.14159265358979323
+#endif
+
+/* Elements evaluated together */
+#define CALC_BLOCK 64
+
+/* Stack levels that fit in the buffer on the thread's stack */
+#define LOCAL_DEPTH 4
+
+/* See calcPerform() for why these are careful about bit 31 */
+#define d2i(x) ((x)<0?(epicsInt32)(x):(epicsInt32)(epicsUInt32)(x))
+#define d2ui(x) ((x)<0?(epicsUInt32)(epicsInt32)(x):(epicsUInt32)(x))
+
+#define LOOP for (j = 0; j < m; j++)
+
+/* Turn off global optimization for 64-bit MSVC builds */
+#if defined(_WIN32) && defined(_M_X64) && !defined(_MINGW)
+#  pragma optimize("g", off)
+#endif
+
+/* Check whether the expression can be run a block at a time, and find
+ * the stack depth it needs. Returns 1 if it can, 0 if it must be run
+ * one element at a time, or -1 if it's not a valid expression.
+ */
+static int scanExpr(const char *pinst, int *pdepth)
+{
+    int depth = 0, maxDepth = 0;
+    int op;
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            depth++;
+            break;
+
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            depth++;
+            break;
+
+        case FETCH_VAL:
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+        case CONST_PI:
+        case CONST_D2R:
+        case CONST_R2D:
+            depth++;
+            break;
+
+        case UNARY_NEG: case ABS_VAL: case EXP: case LOG_10: case LOG_E:
+        case SQU_RT: case ACOS: case ASIN: case ATAN: case COS: case COSH:
+        case SIN: case SINH: case TAN: case TANH: case CEIL: case FLOOR:
+        case ISINF: case NINT: case REL_NOT: case BIT_NOT:
+            break;
+
+        case ADD: case SUB: case MULT: case DIV: case MODULO: case POWER:
+        case ATAN2: case FMOD: case REL_OR: case REL_AND:
+        case BIT_OR: case BIT_AND: case BIT_EXCL_OR:
+        case RIGHT_SHIFT_ARITH: case LEFT_SHIFT_ARITH: case RIGHT_SHIFT_LOGIC:
+        case NOT_EQ: case LESS_THAN: case LESS_OR_EQ:
+        case EQUAL: case GR_OR_EQ: case GR_THAN:
+            depth--;
+            break;
+
+        case MAX:
+        case MIN:
+        case FINITE:
+        case ISNAN:
+            depth -= *pinst++ - 1;
+            break;
+
+        default:
+            /* Assignments, conditionals and RNDM */
+            return 0;
+        }
+        if (depth < 1)
+            return -1;
+        if (depth > maxDepth)
+            maxDepth = depth;
+    }
+    if (depth != 1)
+        return -1;
+    *pdepth = maxDepth;
+    return 1;
+}
+
+/* Does the expression read VAL? */
+static int readsVal(const char *pinst)
+{
+    int op;
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            break;
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            break;
+        case MIN:
+        case MAX:
+        case FINITE:
+        case ISNAN:
+            pinst++;
+            break;
+        case FETCH_VAL:
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Run the expression over elements off to off+m-1, leaving the
+ * results at the bottom of the stack.
+ */
+static long evalBlock(const char *pinst, const calcArrayArg *pargs,
+    const double *pvals, double *pstack, epicsUInt32 off, int m)
+{
+    const calcArrayArg *parg;
+    double *px, *py;
+    double val;
+    epicsInt32 itop;
+    int top = -1;
+    int op, nargs, j;
+
+#define SLOT(i) (pstack + (i) * CALC_BLOCK)
+#define PUSH (px = SLOT(++top))
+#define POP (py = SLOT(top--), px = SLOT(top))
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+
+        case LITERAL_DOUBLE:
+            memcpy(&val, pinst, sizeof(double));
+            pinst += sizeof(double);
+            PUSH;
+            LOOP px[j] = val;
+            break;
+
+        case LITERAL_INT:
+            memcpy(&itop, pinst, sizeof(epicsInt32));
+            pinst += sizeof(epicsInt32);
+            val = itop;
+            PUSH;
+            LOOP px[j] = val;
+            break;
+
+        case FETCH_VAL:
+            PUSH;
+            memcpy(px, pvals + off, m * sizeof(double));
+            break;
+
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+            parg = &pargs[op - FETCH_A];
+            PUSH;
+            if (parg->pval && parg->nelem > 1)
+                memcpy(px, parg->pval + off, m * sizeof(double));
+            else {
+                val = parg->pval && parg->nelem ? parg->pval[0] : 0.0;
+                LOOP px[j] = val;
+            }
+            break;
+
+        case CONST_PI:
+            PUSH;
+            LOOP px[j] = PI;
+            break;
+
+        case CONST_D2R:
+            PUSH;
+            LOOP px[j] = PI/180.;
+            break;
+
+        case CONST_R2D:
+            PUSH;
+            LOOP px[j] = 180./PI;
+            break;
+
+        case UNARY_NEG:
+            px = SLOT(top);
+            LOOP px[j] = - px[j];
+            break;
+
+        case ADD:
+            POP;
+            LOOP px[j] += py[j];
+            break;
+
+        case SUB:
+            POP;
+            LOOP px[j] -= py[j];
+            break;
+
+        case MULT:
+            POP;
+            LOOP px[j] *= py[j];
+            break;
+
+        case DIV:
+            POP;
+            LOOP px[j] /= py[j];
+            break;
+
+        case MODULO:
+            POP;
+            LOOP {
+                itop = (epicsInt32) py[j];
+                if (itop)
+                    px[j] = (epicsInt32) px[j] % itop;
+                else
+                    px[j] = epicsNAN;
+            }
+            break;
+
+        case POWER:
+            POP;
+            LOOP px[j] = pow(px[j], py[j]);
+            break;
+
+        case ABS_VAL:
+            px = SLOT(top);
+            LOOP px[j] = fabs(px[j]);
+            break;
+
+        case EXP:
+            px = SLOT(top);
+            LOOP px[j] = exp(px[j]);
+            break;
+
+        case LOG_10:
+            px = SLOT(top);
+            LOOP px[j] = log10(px[j]);
+            break;
+
+        case LOG_E:
+            px = SLOT(top);
+            LOOP px[j] = log(px[j]);
+            break;
+
+        case MAX:
+            nargs = *pinst++;
+            while (--nargs) {
+                POP;
+                LOOP {
+                    if (px[j] < py[j] || isnan(py[j]))
+                        px[j] = py[j];
+                }
+            }
+            break;
+
+        case MIN:
+            nargs = *pinst++;
+            while (--nargs) {
+                POP;
+                LOOP {
+                    if (px[j] > py[j] || isnan(py[j]))
+                        px[j] = py[j];
+                }
+            }
+            break;
+
+        case SQU_RT:
+            px = SLOT(top);
+            LOOP px[j] = sqrt(px[j]);
+            break;
+
+        case ACOS:
+            px = SLOT(top);
+            LOOP px[j] = acos(px[j]);
+            break;
+
+        case ASIN:
+            px = SLOT(top);
+            LOOP px[j] = asin(px[j]);
+            break;
+
+        case ATAN:
+            px = SLOT(top);
+            LOOP px[j] = atan(px[j]);
+            break;
+
+        case ATAN2:
+            POP;
+            LOOP px[j] = atan2(py[j], px[j]);   /* Args backwards, as in calc */
+            break;
+
+        case COS:
+            px = SLOT(top);
+            LOOP px[j] = cos(px[j]);
+            break;
+
+        case SIN:
+            px = SLOT(top);
+            LOOP px[j] = sin(px[j]);
+            break;
+
+        case TAN:
+            px = SLOT(top);
+            LOOP px[j] = tan(px[j]);
+            break;
+
+        case COSH:
+            px = SLOT(top);
+            LOOP px[j] = cosh(px[j]);
+            break;
+
+        case SINH:
+            px = SLOT(top);
+            LOOP px[j] = sinh(px[j]);
+            break;
+
+        case TANH:
+            px = SLOT(top);
+            LOOP px[j] = tanh(px[j]);
+            break;
+
+        case CEIL:
+            px = SLOT(top);
+            LOOP px[j] = ceil(px[j]);
+            break;
+
+        case FLOOR:
+            px = SLOT(top);
+            LOOP px[j] = floor(px[j]);
+            break;
+
+        case FMOD:
+            POP;
+            LOOP px[j] = fmod(px[j], py[j]);
+            break;
+
+        case FINITE:
+            nargs = *pinst++;
+            px = SLOT(top);
+            LOOP px[j] = finite(px[j]);
+            while (--nargs) {
+                POP;
+                LOOP px[j] = py[j] && finite(px[j]);
+            }
+            break;
+
+        case ISINF:
+            px = SLOT(top);
+            LOOP px[j] = isinf(px[j]);
+            break;
+
+        case ISNAN:
+            nargs = *pinst++;
+            px = SLOT(top);
+            LOOP px[j] = isnan(px[j]);
+            while (--nargs) {
+                POP;
+                LOOP px[j] = py[j] || isnan(px[j]);
+            }
+            break;
+
+        case NINT:
+            px = SLOT(top);
+            LOOP {
+                val = px[j];
+                px[j] = (epicsInt32) (val >= 0 ? val + 0.5 : val - 0.5);
+            }
+            break;
+
+        case REL_OR:
+            POP;
+            LOOP px[j] = px[j] || py[j];
+            break;
+
+        case REL_AND:
+            POP;
+            LOOP px[j] = px[j] && py[j];
+            break;
+
+        case REL_NOT:
+            px = SLOT(top);
+            LOOP px[j] = ! px[j];
+            break;
+
+        case BIT_OR:
+            POP;
+            LOOP px[j] = (double)(d2i(px[j]) | d2i(py[j]));
+            break;
+
+        case BIT_AND:
+            POP;
+            LOOP px[j] = (double)(d2i(px[j]) & d2i(py[j]));
+            break;
+
+        case BIT_EXCL_OR:
+            POP;
+            LOOP px[j] = (double)(d2i(px[j]) ^ d2i(py[j]));
+            break;
+
+        case BIT_NOT:
+            px = SLOT(top);
+            LOOP px[j] = (double)~d2i(px[j]);
+            break;
+
+        case RIGHT_SHIFT_ARITH:
+            POP;
+            LOOP px[j] = (double)(d2i(px[j]) >> (d2i(py[j]) & 31));
+            break;
+
+        case LEFT_SHIFT_ARITH:
+            POP;
+            LOOP px[j] = (double)(d2i(px[j]) << (d2i(py[j]) & 31));
+            break;
+
+        case RIGHT_SHIFT_LOGIC:
+            POP;
+            LOOP px[j] = (double)(d2ui(px[j]) >> (d2ui(py[j]) & 31u));
+            break;
+
+        case NOT_EQ:
+            POP;
+            LOOP px[j] = px[j] != py[j];
+            break;
+
+        case LESS_THAN:
+            POP;
+            LOOP px[j] = px[j] < py[j];
+            break;
+
+        case LESS_OR_EQ:
+            POP;
+            LOOP px[j] = px[j] <= py[j];
+            break;
+
+        case EQUAL:
+            POP;
+            LOOP px[j] = px[j] == py[j];
+            break;
+
+        case GR_OR_EQ:
+            POP;
+            LOOP px[j] = px[j] >= py[j];
+            break;
+
+        case GR_THAN:
+            POP;
+            LOOP px[j] = px[j] > py[j];
+            break;
+
+        default:
+            /* scanExpr() let through something we can't handle */
+            return -1;
+        }
+    }
+    return 0;
+
+#undef SLOT
+#undef PUSH
+#undef POP
+}
+
+#if defined(_WIN32) && defined(_M_X64) && !defined(_MINGW)
+#  pragma optimize("", on)
+#endif
+
+/* Element j of an argument */
+static double argValue(const calcArrayArg *parg, epicsUInt32 j)
+{
+    if (!parg->pval || !parg->nelem)
+        return 0.0;
+    if (parg->nelem == 1)
+        return parg->pval[0];
+    /* Only unused arguments can be shorter than the result */
+    return j < parg->nelem ? parg->pval[j] : 0.0;
+}
+
+LIBCOM_API long
+    calcPerformArray(const calcArrayArg *pargs, double *presult,
+        epicsUInt32 *pnelem, const char *pinst)
+{
+    double local[LOCAL_DEPTH * CALC_BLOCK];
+    double *pstack = local;
+    unsigned long inputs;
+    epicsUInt32 n = *pnelem;
+    epicsUInt32 off;
+    int i, depth, vector;
+    int arrays = readsVal(pinst);
+    long status = 0;
+
+    if (calcArgUsage(pinst, &inputs, NULL))
+        return -1;
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        epicsUInt32 nelem = pargs[i].pval ? pargs[i].nelem : 1;
+
+        if (!(inputs & (1ul << i)) || nelem == 1)
+            continue;
+        arrays = 1;
+        if (nelem < n)
+            n = nelem;
+    }
+    if (!arrays && n > 1)
+        n = 1;
+
+    vector = scanExpr(pinst, &depth);
+    if (vector < 0)
+        return -1;
+
+    if (!vector) {
+        for (off = 0; off < n; off++) {
+            double args[CALCPERFORM_NARGS];
+
+            for (i = 0; i < CALCPERFORM_NARGS; i++)
+                args[i] = argValue(&pargs[i], off);
+            status = calcPerform(args, &presult[off], pinst);
+            if (status) {
+                *pnelem = off;
+                return status;
+            }
+        }
+        *pnelem = n;
+        return 0;
+    }
+
+    if (depth > LOCAL_DEPTH) {
+        pstack = malloc(depth * CALC_BLOCK * sizeof(double));
+        if (!pstack)
+            return -1;
+    }
+    for (off = 0; off < n; off += CALC_BLOCK) {
+        int m = n - off < CALC_BLOCK ? n - off : CALC_BLOCK;
+
+        status = evalBlock(pinst, pargs, presult, pstack, off, m);
+        if (status)
+            break;
+        memcpy(presult + off, pstack, m * sizeof(double));
+    }
+    if (pstack != local)
+        free(pstack);
+
+    *pnelem = status ? off : n;
+    return status;
+}
+
+LIBCOM_API long
+    calcArrayReduce(int op, const double *pval, epicsUInt32 nelem,
+        double *presult)
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    double mean, result;
+    epicsUInt32 i;
+
+    switch (op) {
+    case CALC_REDUCE_SUM:
+    case CALC_REDUCE_AVG:
+    case CALC_REDUCE_STD:
+        /* Separate sums let the additions overlap */
+        for (i = 0; i + 4 <= nelem; i += 4) {
+            s0 += pval[i];
+            s1 += pval[i + 1];
+            s2 += pval[i + 2];
+            s3 += pval[i + 3];
+        }
+        for (; i < nelem; i++)
+            s0 += pval[i];
+        result = (s0 + s1) + (s2 + s3);
+        if (op == CALC_REDUCE_SUM)
+            break;
+        if (!nelem) {
+            result = epicsNAN;
+            break;
+        }
+        mean = result / nelem;
+        if (op == CALC_REDUCE_AVG) {
+            result = mean;
+            break;
+        }
+        /* Two passes, the squares of the deviations lose less precision */
+        s0 = s1 = 0.0;
+        for (i = 0; i + 2 <= nelem; i += 2) {
+            double d0 = pval[i] - mean;
+            double d1 = pval[i + 1] - mean;
+
+            s0 += d0 * d0;
+            s1 += d1 * d1;
+        }
+        if (i < nelem)
+            s0 += (pval[i] - mean) * (pval[i] - mean);
+        result = sqrt((s0 + s1) / nelem);
+        break;
+
+    case CALC_REDUCE_MIN:
+        result = nelem ? pval[0] : epicsNAN;
+        for (i = 1; i < nelem; i++) {
+            if (result > pval[i] || isnan(pval[i]))
+                result = pval[i];
+        }
+        break;
+
+    case CALC_REDUCE_MAX:
+        result = nelem ? pval[0] : epicsNAN;
+        for (i = 1; i < nelem; i++) {
+            if (result < pval[i] || isnan(pval[i]))
+                result = pval[i];
+        }
+        break;
+
+    default:
+        return -1;
+    }
+    *presult = result;
+    return 0;
+}
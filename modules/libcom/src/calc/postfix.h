@@ -21,6 +21,7 @@
 #define INCpostfixh
 
 #include "libComAPI.h"
+#include "epicsTypes.h"
 
 /** \brief Number of input arguments to a calc expression (A-L) */
 #define CALCPERFORM_NARGS 12
@@ -321,6 +322,75 @@ LIBCOM_API long
 LIBCOM_API long
     calcPerform(double *parg, double *presult, const char *ppostfix);
 
+/** \brief An input argument for calcPerformArray()
+ *
+ * An argument with one element is used for every element of the result.
+ */
+typedef struct calcArrayArg {
+    /** \brief The argument values, NULL gives 0.0 */
+    const double *pval;
+    /** \brief Number of elements at \c pval */
+    epicsUInt32 nelem;
+} calcArrayArg;
+
+/** \brief Run the calculation engine over arrays
+ *
+ * Evaluates the postfix expression once for each element of the result,
+ * taking element \e i of each array argument that the expression reads.
+ * The result has as many elements as the shortest of those arguments, or
+ * one element if they are all scalars, but no more than \c *pnelem.
+ * An expression that reads \c VAL treats \c presult as another array
+ * argument of \c *pnelem elements.
+ *
+ * Expressions which don't use the conditional or assignment operators or
+ * RNDM are evaluated a block of elements at a time, with one loop over the
+ * block for each operator. Others are evaluated by calling calcPerform()
+ * for each element, in which case an assignment only affects the element
+ * being calculated.
+ *
+ * \param pargs Pointer to an array of ::CALCPERFORM_NARGS arguments for A-L.
+ * \param presult Where to put the results. On entry, element \e i is the
+ * value of \c VAL for the calculation of element \e i.
+ * \param pnelem On entry the number of elements \c presult can hold, on
+ * return the number of elements calculated.
+ * \param ppostfix The postfix expression created by postfix().
+ * \return Status value 0 for OK, or non-zero if an error is discovered
+ * during the evaluation process.
+ * \since UNRELEASED
+ */
+LIBCOM_API long
+    calcPerformArray(const calcArrayArg *pargs, double *presult,
+        epicsUInt32 *pnelem, const char *ppostfix);
+
+/** \name Reductions for calcArrayReduce()
+ * @{
+ */
+/** \brief Sum of the elements, 0 for an empty array */
+#define CALC_REDUCE_SUM 1
+/** \brief Smallest element, NaN if any element is a NaN */
+#define CALC_REDUCE_MIN 2
+/** \brief Largest element, NaN if any element is a NaN */
+#define CALC_REDUCE_MAX 3
+/** \brief Mean of the elements */
+#define CALC_REDUCE_AVG 4
+/** \brief Population standard deviation of the elements */
+#define CALC_REDUCE_STD 5
+/** @} */
+
+/** \brief Reduce an array to a single value
+ *
+ * Apart from ::CALC_REDUCE_SUM the result for an empty array is a NaN.
+ * \param op One of the \c CALC_REDUCE_ values.
+ * \param pval The array.
+ * \param nelem Number of elements in the array.
+ * \param presult Where to put the result.
+ * \return Status value 0 for OK, or non-zero for an unknown \c op.
+ * \since UNRELEASED
+ */
+LIBCOM_API long
+    calcArrayReduce(int op, const double *pval, epicsUInt32 nelem,
+        double *presult);
+
 /** \brief Find the inputs and outputs of an expression
  *
  * Software using the calc subsystem may need to know what expression
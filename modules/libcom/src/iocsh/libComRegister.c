@@ -394,6 +394,43 @@ static void epicsMutexShowAllCallFunc(const iocshArgBuf *args)
     epicsMutexShowAll(args[0].ival,args[1].ival);
 }
 
+/* epicsMutexProfileEnable */
+static const iocshArg epicsMutexProfileEnableArg0 = { "(0,1)=>(off,on)",iocshArgInt};
+static const iocshArg * const epicsMutexProfileEnableArgs[1] =
+    {&epicsMutexProfileEnableArg0};
+static const iocshFuncDef epicsMutexProfileEnableFuncDef = {
+    "epicsMutexProfileEnable",1,epicsMutexProfileEnableArgs,
+    "Start or stop collecting epicsMutex contention statistics\n"
+};
+static void epicsMutexProfileEnableCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileEnable(args[0].ival);
+}
+
+/* epicsMutexProfileReset */
+static const iocshFuncDef epicsMutexProfileResetFuncDef = {
+    "epicsMutexProfileReset",0,NULL,
+    "Clear the epicsMutex contention statistics\n"
+};
+static void epicsMutexProfileResetCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileReset();
+}
+
+/* epicsMutexProfileShow */
+static const iocshArg epicsMutexProfileShowArg0 = { "count",iocshArgInt};
+static const iocshArg * const epicsMutexProfileShowArgs[1] =
+    {&epicsMutexProfileShowArg0};
+static const iocshFuncDef epicsMutexProfileShowFuncDef = {
+    "epicsMutexProfileShow",1,epicsMutexProfileShowArgs,
+    "Display the epicsMutex creation sites with the longest lock wait times\n"
+    "  count - number of sites to list, 0 for all\n"
+};
+static void epicsMutexProfileShowCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileShow(args[0].ival);
+}
+
 /* epicsThreadSleep */
 static const iocshArg epicsThreadSleepArg0 = { "seconds",iocshArgDouble};
 static const iocshArg * const epicsThreadSleepArgs[1] = {&epicsThreadSleepArg0};
@@ -505,6 +542,9 @@ void epicsStdCall libComRegister(void)
     iocshRegister(&threadFuncDef, threadCallFunc);
     iocshRegister(&taskwdShowFuncDef,taskwdShowCallFunc);
     iocshRegister(&epicsMutexShowAllFuncDef,epicsMutexShowAllCallFunc);
+    iocshRegister(&epicsMutexProfileEnableFuncDef,epicsMutexProfileEnableCallFunc);
+    iocshRegister(&epicsMutexProfileResetFuncDef,epicsMutexProfileResetCallFunc);
+    iocshRegister(&epicsMutexProfileShowFuncDef,epicsMutexProfileShowCallFunc);
     iocshRegister(&epicsThreadSleepFuncDef,epicsThreadSleepCallFunc);
     iocshRegister(&epicsThreadResumeFuncDef,epicsThreadResumeCallFunc);
 
@@ -10,14 +10,19 @@
 /*
  * Implementation of core macro substitution library (macLib)
  *
- * The implementation is fairly unsophisticated and linked lists are
- * used to store macro values. Typically there will will be only a
- * small number of macros and performance won't be a problem. Special
+ * Macro values are stored in a linked list, which gives the scoping
+ * order, and are found by name through a small hash table. Special
  * measures are taken to avoid unnecessary expansion of macros whose
  * definitions reference other macros. Whenever a macro is created,
  * modified or deleted, a "dirty" flag is set; this causes a full
  * expansion of all macros the next time a macro value is read
  *
+ * Strings passed to macExpandString() are compiled into a list of
+ * literal text and simple macro references, which is cached by source
+ * text for all handles. Loading the same database file with different
+ * macro values then only splices in the values; anything more complex
+ * than $(NAME) or ${NAME} is still handled by trans()
+ *
  * Original Author: William Lupton, W. M. Keck Observatory
  */
 
@@ -29,6 +34,9 @@
 #include "dbDefs.h"
 #include "errlog.h"
 #include "dbmf.h"
+#include "epicsString.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
 #include "macLib.h"
 
 
@@ -39,6 +47,8 @@
  */
 typedef struct mac_entry {
     ELLNODE     node;           /* prev and next pointers */
+    struct mac_entry *chain;    /* next entry in hash bucket, older */
+    unsigned    hash;           /* hash of name */
     char        *name;          /* entry name */
     char        *type;          /* entry type */
     char        *rawval;        /* raw (unexpanded) value */
@@ -50,6 +60,27 @@ typedef struct mac_entry {
     int         level;          /* scoping level */
 } MAC_ENTRY;
 
+/*
+ * Step of a compiled expansion: literal text or a macro reference
+ */
+typedef struct mac_op {
+    const char  *text;          /* literal text or macro name */
+    size_t      length;         /* length of literal text */
+    unsigned    hash;           /* hash of macro name */
+    int         isRef;          /* macro reference? */
+} MAC_OP;
+
+/*
+ * Compiled expansion of a source string, kept in the expansion cache
+ */
+typedef struct mac_program {
+    struct mac_program *next;   /* next program in cache bucket */
+    unsigned    hash;           /* hash of source string */
+    int         nops;           /* number of steps, <0 to use trans() */
+    char        *source;        /* source string */
+    MAC_OP      ops[1];         /* actually nops */
+} MAC_PROGRAM;
+
 
 /*** Local function prototypes ***/
 
@@ -57,12 +88,12 @@ typedef struct mac_entry {
  * These static functions perform low-level operations on macro entries
  */
 static MAC_ENTRY *first   ( MAC_HANDLE *handle );
-static MAC_ENTRY *last    ( MAC_HANDLE *handle );
 static MAC_ENTRY *next    ( MAC_ENTRY  *entry );
-static MAC_ENTRY *previous( MAC_ENTRY  *entry );
 
 static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special );
 static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special );
+static MAC_ENTRY *hashed( MAC_HANDLE *handle, const char *name,
+                          unsigned hash, int special );
 static char      *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value );
 static void       delete( MAC_HANDLE *handle, MAC_ENTRY *entry );
 static long       expand( MAC_HANDLE *handle );
@@ -72,7 +103,14 @@ static void       trans ( MAC_HANDLE *handle, MAC_ENTRY *entry, int level,
 static void       refer ( MAC_HANDLE *handle, MAC_ENTRY *entry, int level,
                           const char **rawval, char **value, char *valend );
 
+static int        run   ( MAC_HANDLE *handle, MAC_ENTRY *entry,
+                          const char *src, char **value, char *valend );
+static MAC_PROGRAM *program( const char *src );
+static int        compile( const char *src, MAC_OP *ops, char *names );
+
 static void cpy2val( const char *src, char **value, const char *valend );
+static void cpyn2val( const char *src, size_t n, char **value,
+                      const char *valend );
 static char *Strdup( const char *string );
 
 
@@ -89,6 +127,18 @@ static char *Strdup( const char *string );
 #define FLAG_SUPPRESS_WARNINGS  0x1
 #define FLAG_USE_ENVIRONMENT    0x80
 
+/*
+ * Number of hash buckets in each handle, must be a power of 2
+ */
+#define MAC_HASH_SIZE   64
+
+/*
+ * Expansion cache size; programs are never freed, so once the cache holds
+ * MAC_CACHE_MAX programs further strings are expanded without it
+ */
+#define MAC_CACHE_SIZE  1024
+#define MAC_CACHE_MAX   16384
+
 
 /*** Library routines ***/
 
@@ -126,6 +176,12 @@ epicsStdCall macCreateHandle(
     handle->debug = 0;
     handle->flags = 0;
     ellInit( &handle->list );
+    handle->table = calloc( MAC_HASH_SIZE, sizeof( MAC_ENTRY * ) );
+    if ( handle->table == NULL ) {
+        errlogPrintf( "macCreateHandle: failed to allocate context\n" );
+        dbmfFree( handle );
+        return -1;
+    }
 
     /* use environment variables if so specified */
     if (pairs && pairs[0] && !strcmp(pairs[0],"") && pairs[1] && !strcmp(pairs[1],"environ") && !pairs[3]) {
@@ -135,7 +191,7 @@ epicsStdCall macCreateHandle(
         /* if supplied, load macro definitions */
         for ( ; pairs && pairs[0]; pairs += 2 ) {
             if ( macPutValue( handle, pairs[0], pairs[1] ) < 0 ) {
-                dbmfFree( handle );
+                macDeleteHandle( handle );
                 return -1;
             }
         }
@@ -213,7 +269,8 @@ epicsStdCall macExpandString(
     s  = src;
     d  = dest;
     *d = '\0';
-    trans( handle, &entry, 0, "", &s, &d, d + capacity - 1 );
+    if ( !run( handle, &entry, src, &d, d + capacity - 1 ) )
+        trans( handle, &entry, 0, "", &s, &d, d + capacity - 1 );
 
     /* return +/- #chars copied depending on successful expansion */
     length = d - dest;
@@ -381,6 +438,7 @@ epicsStdCall macDeleteHandle(
 
     /* clear magic field and free context structure */
     handle->magic = 0;
+    free( handle->table );
     dbmfFree( handle );
 
     return 0;
@@ -513,14 +571,6 @@ static MAC_ENTRY *first( MAC_HANDLE *handle )
     return ( MAC_ENTRY * ) ellFirst( &handle->list );
 }
 
-/*
- * Return pointer to last macro entry (could be preprocessor macro)
- */
-static MAC_ENTRY *last( MAC_HANDLE *handle )
-{
-    return ( MAC_ENTRY * ) ellLast( &handle->list );
-}
-
 /*
  * Return pointer to next macro entry (could be preprocessor macro)
  */
@@ -529,14 +579,6 @@ static MAC_ENTRY *next( MAC_ENTRY *entry )
     return ( MAC_ENTRY * ) ellNext( ( ELLNODE * ) entry );
 }
 
-/*
- * Return pointer to previous macro entry (could be preprocessor macro)
- */
-static MAC_ENTRY *previous( MAC_ENTRY *entry )
-{
-    return ( MAC_ENTRY * ) ellPrevious( ( ELLNODE * ) entry );
-}
-
 /*
  * Create new macro entry (can assume it doesn't exist)
  */
@@ -544,6 +586,7 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
 {
     ELLLIST   *list  = &handle->list;
     MAC_ENTRY *entry = ( MAC_ENTRY * ) dbmfMalloc( sizeof( MAC_ENTRY ) );
+    MAC_ENTRY **bucket;
 
     if ( entry != NULL ) {
         entry->name   = Strdup( name );
@@ -560,7 +603,13 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
             entry->visited = FALSE;
             entry->special = special;
             entry->level   = handle->level;
+            entry->hash    = epicsStrHash( name, 0 );
 
+            /* newest first, so scoping works */
+            bucket = &( ( MAC_ENTRY ** ) handle->table )
+                        [ entry->hash & ( MAC_HASH_SIZE - 1 ) ];
+            entry->chain = *bucket;
+            *bucket = entry;
             ellAdd( list, ( ELLNODE * ) entry );
         }
     }
@@ -579,13 +628,7 @@ static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special )
         printf( "lookup-> level = %d, name = %s, special = %d\n",
                 handle->level, name, special );
 
-    /* search backwards so scoping works */
-    for ( entry = last( handle ); entry != NULL; entry = previous( entry ) ) {
-        if ( entry->special != special )
-            continue;
-        if ( strcmp( name, entry->name ) == 0 )
-            break;
-    }
+    entry = hashed( handle, name, epicsStrHash( name, 0 ), special );
     if ( (special == FALSE) && (entry == NULL) &&
          (handle->flags & FLAG_USE_ENVIRONMENT) ) {
         char *value = name && *name ? getenv(name) : NULL;
@@ -606,6 +649,25 @@ static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special )
     return entry;
 }
 
+/*
+ * Find the most recent entry with matching "special" attribute and name
+ * in the hash table
+ */
+static MAC_ENTRY *hashed( MAC_HANDLE *handle, const char *name,
+                          unsigned hash, int special )
+{
+    MAC_ENTRY *entry = ( ( MAC_ENTRY ** ) handle->table )
+                        [ hash & ( MAC_HASH_SIZE - 1 ) ];
+
+    for ( ; entry != NULL; entry = entry->chain ) {
+        if ( entry->hash == hash && entry->special == special &&
+             strcmp( name, entry->name ) == 0 )
+            break;
+    }
+
+    return entry;
+}
+
 /*
  * Copy raw value to macro entry
  */
@@ -627,7 +689,12 @@ static char *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value )
 static void delete( MAC_HANDLE *handle, MAC_ENTRY *entry )
 {
     ELLLIST *list = &handle->list;
+    MAC_ENTRY **link = &( ( MAC_ENTRY ** ) handle->table )
+                        [ entry->hash & ( MAC_HASH_SIZE - 1 ) ];
 
+    while ( *link != entry )
+        link = &( *link )->chain;
+    *link = entry->chain;
     ellDelete( list, ( ELLNODE * ) entry );
 
     dbmfFree( entry->name );
@@ -925,6 +992,186 @@ cleanup:
     *value = v;
 }
 
+/*
+ * Expand a string using a compiled program from the expansion cache.
+ * Returns FALSE, with nothing copied to value, if trans() must be used;
+ * that handles macro definitions which need expanding, environment
+ * variables, undefined macros and anything but simple references
+ */
+static int run( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *src,
+                char **value, char *valend )
+{
+    const MAC_PROGRAM *prog;
+    char *v = *value;
+    int error = FALSE;
+    int i;
+
+    if ( handle->dirty || ( handle->debug & 2 ) ||
+         ( handle->flags & FLAG_USE_ENVIRONMENT ) )
+        return FALSE;
+
+    /* at level 0 quotes and escapes are kept, so this is just a copy */
+    if ( strchr( src, '$' ) == NULL ) {
+        cpy2val( src, value, valend );
+        return TRUE;
+    }
+
+    prog = program( src );
+    if ( prog == NULL || prog->nops < 0 )
+        return FALSE;
+
+    for ( i = 0; i < prog->nops; i++ ) {
+        const MAC_OP *op = &prog->ops[i];
+        MAC_ENTRY *refentry;
+
+        if ( !op->isRef ) {
+            cpyn2val( op->text, op->length, &v, valend );
+            continue;
+        }
+        refentry = hashed( handle, op->text, op->hash, FALSE );
+        if ( refentry == NULL ) {
+            **value = '\0';
+            return FALSE;
+        }
+        cpy2val( refentry->value, &v, valend );
+        error = error || refentry->error;
+    }
+
+    entry->error = error;
+    *value = v;
+    return TRUE;
+}
+
+/*
+ * Return the compiled program for a source string from the expansion
+ * cache, compiling and adding it if necessary. Programs are never freed
+ * so they can be used without holding the lock
+ */
+static epicsThreadOnceId cacheOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId cacheLock;
+static MAC_PROGRAM *cache[MAC_CACHE_SIZE];
+static int cacheCount;
+
+static void cacheInit( void *arg )
+{
+    cacheLock = epicsMutexMustCreate();
+}
+
+static MAC_PROGRAM *program( const char *src )
+{
+    unsigned hash = epicsStrHash( src, 0 );
+    MAC_PROGRAM **bucket = &cache[ hash & ( MAC_CACHE_SIZE - 1 ) ];
+    MAC_PROGRAM *prog;
+    size_t length;
+    int nops;
+
+    epicsThreadOnce( &cacheOnce, cacheInit, NULL );
+    epicsMutexMustLock( cacheLock );
+
+    for ( prog = *bucket; prog != NULL; prog = prog->next ) {
+        if ( prog->hash == hash && strcmp( src, prog->source ) == 0 )
+            break;
+    }
+
+    if ( prog == NULL && cacheCount < MAC_CACHE_MAX ) {
+        /* room for the steps, the source and the names it refers to */
+        length = strlen( src ) + 1;
+        nops = compile( src, NULL, NULL );
+        prog = malloc( sizeof( MAC_PROGRAM ) +
+                       ( nops > 0 ? nops * sizeof( MAC_OP ) : 0 ) +
+                       2 * length );
+        if ( prog != NULL ) {
+            prog->source = ( char * ) &prog->ops[ nops > 0 ? nops + 1 : 1 ];
+            memcpy( prog->source, src, length );
+            prog->hash = hash;
+            prog->nops = ( nops < 0 ) ? -1 :
+                         compile( prog->source, prog->ops,
+                                  prog->source + length );
+            prog->next = *bucket;
+            *bucket = prog;
+            cacheCount++;
+        }
+    }
+
+    epicsMutexUnlock( cacheLock );
+
+    return prog;
+}
+
+/*
+ * Split a source string into literal text and macro references, following
+ * the rules of trans() at level 0. Returns the number of steps, or -1 if
+ * the string contains a reference which isn't a plain $(NAME) or ${NAME}.
+ * If ops is NULL the steps are only counted, otherwise they are stored in
+ * ops with copies of the names in names. The literal text points into src
+ */
+static int compile( const char *src, MAC_OP *ops, char *names )
+{
+    const char *r, *lit;
+    char quote = 0;
+    int nops = 0;
+
+    for ( r = lit = src; *r != '\0'; r++ ) {
+        const char *name;
+        char close;
+        size_t n;
+
+        if ( quote ) {
+            if ( *r == quote )
+                quote = 0;
+        }
+        else if ( *r == '"' || *r == '\'' ) {
+            quote = *r;
+        }
+
+        if ( *r != '$' || ( r[1] != '(' && r[1] != '{' ) || quote == '\'' ) {
+            /* skip the escaped character */
+            if ( *r == '\\' && r[1] != '\0' )
+                r++;
+            continue;
+        }
+
+        close = ( r[1] == '(' ) ? ')' : '}';
+        name = r + 2;
+        n = strcspn( name, ( close == ')' ) ? "=,)$\\\"'" : "=,}$\\\"'" );
+        if ( n == 0 || name[n] != close )
+            return -1;
+
+        if ( r > lit ) {
+            if ( ops ) {
+                ops[nops].text   = lit;
+                ops[nops].length = r - lit;
+                ops[nops].isRef  = FALSE;
+            }
+            nops++;
+        }
+        if ( ops ) {
+            memcpy( names, name, n );
+            names[n] = '\0';
+            ops[nops].text   = names;
+            ops[nops].length = n;
+            ops[nops].hash   = epicsStrHash( names, 0 );
+            ops[nops].isRef  = TRUE;
+            names += n + 1;
+        }
+        nops++;
+
+        r = name + n;
+        lit = r + 1;
+    }
+
+    if ( r > lit ) {
+        if ( ops ) {
+            ops[nops].text   = lit;
+            ops[nops].length = r - lit;
+            ops[nops].isRef  = FALSE;
+        }
+        nops++;
+    }
+
+    return nops;
+}
+
 /*
  * Copy a string, honoring the 'end of destination string' pointer
  * Returns with **value pointing to the '\0' terminator
@@ -937,6 +1184,22 @@ static void cpy2val(const char *src, char **value, const char *valend)
     *value = v;
 }
 
+/*
+ * Copy n characters, honoring the 'end of destination string' pointer
+ * Returns with **value pointing to the '\0' terminator
+ */
+static void cpyn2val(const char *src, size_t n, char **value,
+                     const char *valend)
+{
+    char *v = *value;
+    if (n > (size_t)(valend - v))
+        n = valend - v;
+    memcpy(v, src, n);
+    v += n;
+    *v = '\0';
+    *value = v;
+}
+
 /*
  * strdup() implementation which uses our own memory allocator
  */
@@ -47,6 +47,7 @@ typedef struct {
     int         debug;          /**< \brief debugging level */
     ELLLIST     list;           /**< \brief macro name / value list */
     int         flags;          /**< \brief operating mode flags */
+    void        *table;         /**< \brief hash table of macro entries */
 } MAC_HANDLE;
 
 /** \name Core Library
@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "epicsStdio.h"
+#include "epicsTime.h"
 #include "epicsThread.h"
 #include "valgrind/valgrind.h"
 #include "ellLib.h"
@@ -46,9 +47,17 @@ struct epicsMutexParm {
 #   endif
     const char *pFileName;
     int lineno;
+    /* Contention profile, only updated while this mutex is held */
+    unsigned lockDepth;
+    epicsUInt64 holdStart;
+    size_t acquired;
+    size_t contended;
+    epicsUInt64 waitTotal;
+    epicsUInt64 holdMax;
 };
 
 static epicsMutexOSD * epicsMutexGlobalLock;
+static int epicsMutexProfiling;
 
 
 // vxWorks 5.4 gcc fails during compile when I use std::exception
@@ -112,6 +121,12 @@ epicsMutexId epicsStdCall epicsMutexOsiCreate(
 #   endif
     pmutexNode->pFileName = pFileName;
     pmutexNode->lineno = lineno;
+    pmutexNode->lockDepth = 0;
+    pmutexNode->holdStart = 0;
+    pmutexNode->acquired = 0;
+    pmutexNode->contended = 0;
+    pmutexNode->waitTotal = 0;
+    pmutexNode->holdMax = 0;
     ellAdd(&mutexList,&pmutexNode->node);
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
     return(pmutexNode);
@@ -138,15 +153,64 @@ void epicsStdCall epicsMutexDestroy(epicsMutexId pmutexNode)
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
 }
 
+/* Called with the mutex held, after each profiled acquisition */
+static void profileAcquired(epicsMutexParm *pmutexNode,
+    epicsUInt64 now, epicsUInt64 wait)
+{
+    pmutexNode->acquired++;
+    if (wait) {
+        pmutexNode->contended++;
+        pmutexNode->waitTotal += wait;
+    }
+    if (pmutexNode->lockDepth++ == 0)
+        pmutexNode->holdStart = now;
+}
+
+/* Called with the mutex held, just before it is released */
+static void profileRelease(epicsMutexParm *pmutexNode)
+{
+    if (--pmutexNode->lockDepth == 0) {
+        epicsUInt64 hold = epicsMonotonicGet() - pmutexNode->holdStart;
+
+        if (hold > pmutexNode->holdMax)
+            pmutexNode->holdMax = hold;
+    }
+}
+
+static epicsMutexLockStatus profiledLock(epicsMutexParm *pmutexNode)
+{
+    epicsMutexLockStatus status = epicsMutexOsdTryLock(pmutexNode->id);
+    epicsUInt64 now, wait = 0;
+
+    if (status == epicsMutexLockTimeout) {
+        epicsUInt64 start = epicsMonotonicGet();
+
+        status = epicsMutexOsdLock(pmutexNode->id);
+        now = epicsMonotonicGet();
+        /* Make sure a contended acquisition is never recorded as free */
+        wait = now > start ? now - start : 1;
+    }
+    else {
+        now = epicsMonotonicGet();
+    }
+    if (status == epicsMutexLockOK)
+        profileAcquired(pmutexNode, now, wait);
+    return status;
+}
+
 void epicsStdCall epicsMutexUnlock(epicsMutexId pmutexNode)
 {
+    /* lockDepth is only non-zero if the acquisition was profiled */
+    if (pmutexNode->lockDepth)
+        profileRelease(pmutexNode);
     epicsMutexOsdUnlock(pmutexNode->id);
 }
 
 epicsMutexLockStatus epicsStdCall epicsMutexLock(
     epicsMutexId pmutexNode)
 {
-    epicsMutexLockStatus status =
+    epicsMutexLockStatus status = epicsMutexProfiling ?
+        profiledLock(pmutexNode) :
         epicsMutexOsdLock(pmutexNode->id);
 #   ifdef LOG_LAST_OWNER
         if ( status == epicsMutexLockOK ) {
@@ -161,6 +225,9 @@ epicsMutexLockStatus epicsStdCall epicsMutexTryLock(
 {
     epicsMutexLockStatus status =
         epicsMutexOsdTryLock(pmutexNode->id);
+    if ( status == epicsMutexLockOK && epicsMutexProfiling ) {
+        profileAcquired(pmutexNode, epicsMonotonicGet(), 0);
+    }
 #   ifdef LOG_LAST_OWNER
         if ( status == epicsMutexLockOK ) {
             pmutexNode->lastOwner = epicsThreadGetIdSelf();
@@ -210,6 +277,12 @@ void epicsStdCall epicsMutexShow(
             (void *)pmutexNode, pmutexNode->pFileName,
             pmutexNode->lineno);
 #   endif
+    if ( pmutexNode->acquired ) {
+        printf("    acquired %lu contended %lu wait %.3f ms max hold %.3f ms\n",
+            (unsigned long) pmutexNode->acquired,
+            (unsigned long) pmutexNode->contended,
+            pmutexNode->waitTotal * 1e-6, pmutexNode->holdMax * 1e-6);
+    }
     if ( level > 0 ) {
         epicsMutexOsdShow(pmutexNode->id,level-1);
     }
@@ -246,6 +319,154 @@ void epicsStdCall epicsMutexShowAll(int onlyLocked,unsigned  int level)
             reinterpret_cast < epicsMutexParm * > ( ellNext(&pmutexNode->node) );
     }
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
+    if (epicsMutexProfiling)
+        epicsMutexProfileShow(10);
+}
+
+void epicsStdCall epicsMutexProfileEnable(int enable)
+{
+    epicsMutexProfiling = enable;
+}
+
+void epicsStdCall epicsMutexProfileReset(void)
+{
+    ELLNODE *cur;
+
+    if (epicsMutexOsiOnce == EPICS_THREAD_ONCE_INIT)
+        return;
+
+    /* Counters of mutexes being held right now may lose an update */
+    epicsMutexLockStatus lockStat =
+        epicsMutexOsdLock(epicsMutexGlobalLock);
+    assert ( lockStat == epicsMutexLockOK );
+    for (cur = ellFirst(&mutexList); cur; cur = ellNext(cur)) {
+        epicsMutexParm *pmutexNode =
+            reinterpret_cast < epicsMutexParm * > ( cur );
+        pmutexNode->acquired = 0;
+        pmutexNode->contended = 0;
+        pmutexNode->waitTotal = 0;
+        pmutexNode->holdMax = 0;
+    }
+    epicsMutexOsdUnlock(epicsMutexGlobalLock);
+}
+
+void epicsStdCall epicsMutexProfileGet(epicsMutexId pmutexNode,
+    epicsMutexProfileData *pdata)
+{
+    pdata->acquired = pmutexNode->acquired;
+    pdata->contended = pmutexNode->contended;
+    pdata->waitTotal = pmutexNode->waitTotal * 1e-9;
+    pdata->holdMax = pmutexNode->holdMax * 1e-9;
+}
+
+namespace {
+struct profileSite {
+    const char *pFileName;
+    int lineno;
+    unsigned nMutex;
+    size_t acquired;
+    size_t contended;
+    epicsUInt64 waitTotal;
+    epicsUInt64 holdMax;
+};
+
+int siteCompare(const void *a, const void *b)
+{
+    const profileSite *pa = static_cast < const profileSite * > ( a );
+    const profileSite *pb = static_cast < const profileSite * > ( b );
+    int cmp = strcmp(pa->pFileName, pb->pFileName);
+
+    return cmp ? cmp : pa->lineno - pb->lineno;
+}
+
+int siteWaitCompare(const void *a, const void *b)
+{
+    const profileSite *pa = static_cast < const profileSite * > ( a );
+    const profileSite *pb = static_cast < const profileSite * > ( b );
+
+    if (pa->waitTotal != pb->waitTotal)
+        return pa->waitTotal < pb->waitTotal ? 1 : -1;
+    if (pa->contended != pb->contended)
+        return pa->contended < pb->contended ? 1 : -1;
+    return 0;
+}
+}
+
+void epicsStdCall epicsMutexProfileShow(unsigned count)
+{
+    profileSite *sites;
+    ELLNODE *cur;
+    int nNodes, nSites = 0, i;
+
+    if (epicsMutexOsiOnce == EPICS_THREAD_ONCE_INIT)
+        return;
+
+    epicsMutexLockStatus lockStat =
+        epicsMutexOsdLock(epicsMutexGlobalLock);
+    assert ( lockStat == epicsMutexLockOK );
+    nNodes = ellCount(&mutexList);
+    sites = static_cast < profileSite * > (
+        calloc(nNodes ? nNodes : 1, sizeof(profileSite)) );
+    if (!sites) {
+        epicsMutexOsdUnlock(epicsMutexGlobalLock);
+        fprintf(stderr, "epicsMutexProfileShow: out of memory\n");
+        return;
+    }
+    for (cur = ellFirst(&mutexList); cur; cur = ellNext(cur)) {
+        epicsMutexParm *pmutexNode =
+            reinterpret_cast < epicsMutexParm * > ( cur );
+        profileSite *psite;
+
+        if (!pmutexNode->acquired)
+            continue;
+        psite = &sites[nSites++];
+        psite->pFileName = pmutexNode->pFileName ? pmutexNode->pFileName : "";
+        psite->lineno = pmutexNode->lineno;
+        psite->nMutex = 1;
+        psite->acquired = pmutexNode->acquired;
+        psite->contended = pmutexNode->contended;
+        psite->waitTotal = pmutexNode->waitTotal;
+        psite->holdMax = pmutexNode->holdMax;
+    }
+    epicsMutexOsdUnlock(epicsMutexGlobalLock);
+
+    /* Merge the mutexes created at the same source location */
+    qsort(sites, nSites, sizeof(profileSite), siteCompare);
+    nNodes = nSites;
+    nSites = nNodes ? 1 : 0;
+    for (i = 1; i < nNodes; i++) {
+        profileSite *plast = &sites[nSites - 1];
+
+        if (siteCompare(plast, &sites[i]) == 0) {
+            plast->nMutex++;
+            plast->acquired += sites[i].acquired;
+            plast->contended += sites[i].contended;
+            plast->waitTotal += sites[i].waitTotal;
+            if (sites[i].holdMax > plast->holdMax)
+                plast->holdMax = sites[i].holdMax;
+        }
+        else {
+            sites[nSites++] = sites[i];
+        }
+    }
+    qsort(sites, nSites, sizeof(profileSite), siteWaitCompare);
+
+    if (count == 0 || count > unsigned(nSites))
+        count = nSites;
+    printf("epicsMutex contention profile is %s, top %u of %d sites:\n",
+        epicsMutexProfiling ? "enabled" : "disabled", count, nSites);
+    if (count)
+        printf("%8s %12s %12s %12s %12s  %s\n", "mutexes", "acquired",
+            "contended", "wait ms", "maxhold ms", "source");
+    for (i = 0; i < int(count); i++) {
+        printf("%8u %12lu %12lu %12.3f %12.3f  %s:%d\n",
+            sites[i].nMutex,
+            (unsigned long) sites[i].acquired,
+            (unsigned long) sites[i].contended,
+            sites[i].waitTotal * 1e-6, sites[i].holdMax * 1e-6,
+            sites[i].pFileName, sites[i].lineno);
+    }
+    free(sites);
 }
 
 #if !defined(__GNUC__) || __GNUC__<4 || (__GNUC__==4 && __GNUC_MINOR__<8)
@@ -41,6 +41,8 @@
 #ifndef epicsMutexh
 #define epicsMutexh
 
+#include <stddef.h>
+
 #include "epicsAssert.h"
 
 #include "libComAPI.h"
@@ -247,6 +249,54 @@ LIBCOM_API void epicsStdCall epicsMutexShow(
 LIBCOM_API void epicsStdCall epicsMutexShowAll(
     int onlyLocked,unsigned  int level);
 
+/**\brief Enable or disable the epicsMutex contention profiler.
+ *
+ * While enabled, every epicsMutexLock() first tries to take the mutex
+ * without blocking, and counts the acquisition as contended when that fails.
+ * The profiler records for each mutex the number of acquisitions, the number
+ * of contended acquisitions, the total time spent waiting and the longest
+ * time the mutex was held. When disabled the only overhead is one test of a
+ * flag on each lock and unlock.
+ *
+ * \param enable Non-zero to start profiling, zero to stop.
+ **/
+LIBCOM_API void epicsStdCall epicsMutexProfileEnable(int enable);
+
+/**\brief Clear the contention statistics of all epicsMutex semaphores.
+ **/
+LIBCOM_API void epicsStdCall epicsMutexProfileReset(void);
+
+/**\brief Contention statistics of one epicsMutex. */
+typedef struct epicsMutexProfileData {
+    /** Number of profiled acquisitions */
+    size_t acquired;
+    /** Number of those that had to wait for another thread */
+    size_t contended;
+    /** Total time spent waiting, in seconds */
+    double waitTotal;
+    /** Longest time the mutex was held, in seconds */
+    double holdMax;
+} epicsMutexProfileData;
+
+/**\brief Fetch the contention statistics of one epicsMutex.
+ *
+ * \param id The mutex identifier.
+ * \param pdata Where to store the statistics.
+ **/
+LIBCOM_API void epicsStdCall epicsMutexProfileGet(
+    epicsMutexId id, epicsMutexProfileData *pdata);
+
+/**\brief Display the epicsMutex contention profile.
+ *
+ * Statistics are summed over all mutexes created at the same source
+ * location, and the sites are listed in order of decreasing total wait time.
+ * epicsMutexShowAll() also calls this routine with a count of 10 while the
+ * profiler is enabled.
+ *
+ * \param count Maximum number of sites to list, zero for all of them.
+ **/
+LIBCOM_API void epicsStdCall epicsMutexProfileShow(unsigned count);
+
 /**@privatesection
  * The following are interfaces to the OS dependent
  * implementation and should NOT be called directly by
@@ -0,0 +1,185 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* osi/os/Linux/osdEvent.c */
+
+/*
+ * Binary semaphore built directly on a Linux futex. Triggering an event
+ * that nobody is waiting for, and taking an event that is already full,
+ * are handled entirely in user space without any system call.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "epicsEvent.h"
+#include "epicsAtomic.h"
+#include "errlog.h"
+
+/* Values of the state word */
+#define EVENT_EMPTY     0
+#define EVENT_FULL      1
+#define EVENT_WAITERS  -1  /* empty, and threads may be sleeping on it */
+
+struct epicsEventOSD {
+    int state;
+};
+
+static int futexWait(int *addr, int val, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout,
+        NULL, 0);
+}
+
+static void futexWake(int *addr, int count)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/* Take the event if it is full. Whoever takes it after having slept may
+ * leave other sleepers behind, so it marks the event as having waiters.
+ */
+static int tryTake(epicsEventId pevent, int newState)
+{
+    return epicsAtomicCmpAndSwapIntT(&pevent->state, EVENT_FULL, newState)
+        == EVENT_FULL;
+}
+
+/* A waiter that leaves without the event may have been the one that was
+ * woken to restore the waiters mark, so it restores the mark itself.
+ */
+static epicsEventStatus giveUp(epicsEventId pevent, epicsEventStatus status)
+{
+    if (tryTake(pevent, EVENT_WAITERS))
+        return epicsEventOK;
+    epicsAtomicCmpAndSwapIntT(&pevent->state, EVENT_EMPTY, EVENT_WAITERS);
+    return status;
+}
+
+static epicsEventStatus waitUntil(epicsEventId pevent,
+    const struct timespec *deadline)
+{
+    if (tryTake(pevent, EVENT_EMPTY))
+        return epicsEventOK;
+
+    for (;;) {
+        struct timespec remain, *premain = NULL;
+        int state = epicsAtomicGetIntT(&pevent->state);
+
+        if (state == EVENT_FULL) {
+            if (tryTake(pevent, EVENT_WAITERS))
+                return epicsEventOK;
+            continue;
+        }
+        if (state == EVENT_EMPTY &&
+            epicsAtomicCmpAndSwapIntT(&pevent->state, EVENT_EMPTY,
+                EVENT_WAITERS) != EVENT_EMPTY)
+            continue;
+
+        if (deadline) {
+            struct timespec now;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remain.tv_sec = deadline->tv_sec - now.tv_sec;
+            remain.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+            if (remain.tv_nsec < 0) {
+                remain.tv_nsec += 1000000000L;
+                remain.tv_sec--;
+            }
+            if (remain.tv_sec < 0)
+                return giveUp(pevent, epicsEventWaitTimeout);
+            premain = &remain;
+        }
+        if (futexWait(&pevent->state, EVENT_WAITERS, premain) &&
+            errno != EAGAIN && errno != EINTR) {
+            if (errno == ETIMEDOUT)
+                return giveUp(pevent, epicsEventWaitTimeout);
+            errlogPrintf("epicsEvent futex wait failed: %s\n",
+                strerror(errno));
+            return giveUp(pevent, epicsEventError);
+        }
+    }
+}
+
+LIBCOM_API epicsEventId epicsEventCreate(epicsEventInitialState init)
+{
+    epicsEventId pevent = malloc(sizeof(*pevent));
+
+    if (pevent)
+        pevent->state = (init == epicsEventFull) ? EVENT_FULL : EVENT_EMPTY;
+    return pevent;
+}
+
+LIBCOM_API void epicsEventDestroy(epicsEventId pevent)
+{
+    free(pevent);
+}
+
+LIBCOM_API epicsEventStatus epicsEventTrigger(epicsEventId pevent)
+{
+    int state = epicsAtomicGetIntT(&pevent->state);
+    int prev;
+
+    while (state != EVENT_FULL &&
+           (prev = epicsAtomicCmpAndSwapIntT(&pevent->state, state,
+                EVENT_FULL)) != state)
+        state = prev;
+    if (state == EVENT_WAITERS)
+        futexWake(&pevent->state, 1);
+    return epicsEventOK;
+}
+
+LIBCOM_API epicsEventStatus epicsEventWait(epicsEventId pevent)
+{
+    return waitUntil(pevent, NULL);
+}
+
+LIBCOM_API epicsEventStatus epicsEventWaitWithTimeout(epicsEventId pevent,
+    double timeout)
+{
+    struct timespec deadline;
+    double whole;
+
+    if (tryTake(pevent, EVENT_EMPTY))
+        return epicsEventOK;
+    if (!(timeout > 0.0))
+        return epicsEventWaitTimeout;
+    if (timeout > 60 * 60 * 24 * 3652.5)
+        timeout = 60 * 60 * 24 * 3652.5;    /* 10 years */
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    whole = (double)(time_t)timeout;
+    deadline.tv_sec += (time_t)whole;
+    deadline.tv_nsec += (long)((timeout - whole) * 1e9);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        deadline.tv_sec++;
+    }
+    return waitUntil(pevent, &deadline);
+}
+
+LIBCOM_API epicsEventStatus epicsEventTryWait(epicsEventId pevent)
+{
+    return tryTake(pevent, EVENT_EMPTY) ?
+        epicsEventOK : epicsEventWaitTimeout;
+}
+
+LIBCOM_API void epicsEventShow(epicsEventId pevent, unsigned int level)
+{
+    int state = epicsAtomicGetIntT(&pevent->state);
+
+    printf("epicsEvent %p: %s\n", pevent,
+        state == EVENT_FULL ? "full" : "empty");
+    if (level > 0)
+        printf("    futex = %p, %s\n", &pevent->state,
+            state == EVENT_WAITERS ? "may have waiters" : "no waiters");
+}
@@ -0,0 +1,373 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS Base is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* osi/os/Linux/osdMessageQueue.cpp */
+
+/*
+ * Message queue for Linux built from a lock-free ring of message slots
+ * and two futexes. Senders and receivers claim slots with compare-and-swap
+ * and copy their messages without holding any lock. A thread only makes a
+ * system call when it has to sleep because the queue is full or empty, or
+ * when it has to wake such a sleeping thread.
+ *
+ * Each slot carries a sequence number: the slot for position pos is free
+ * for a sender when seq == pos and holds a message for a receiver when
+ * seq == pos + 1. Positions count up forever and wrap modulo 2^32, so the
+ * number of slots is rounded up to a power of two; the capacity of the
+ * queue is still limited to the number of messages asked for.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "epicsMessageQueue.h"
+#include "epicsAtomic.h"
+#include "errlog.h"
+
+struct slotHeader {
+    int             seq;
+    unsigned int    size;
+};
+
+struct epicsMessageQueueOSD {
+    unsigned long   capacity;
+    unsigned long   maxMessageSize;
+    unsigned long   slotSize;
+    unsigned int    mask;
+    char           *slots;
+
+    /* Each group below is written by different threads */
+    char            pad0[64];
+    int             sendPos;
+    int             sendersWaiting;
+    int             sendFutex;
+    char            pad1[64];
+    int             receivePos;
+    int             receiversWaiting;
+    int             receiveFutex;
+    char            pad2[64];
+};
+
+static inline slotHeader *
+slotAt(epicsMessageQueueId pmsg, unsigned int pos)
+{
+    return reinterpret_cast < slotHeader * >
+        ( pmsg->slots + (pos & pmsg->mask) * pmsg->slotSize );
+}
+
+static void
+futexWake(int *addr)
+{
+    epicsAtomicIncrIntT(addr);
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/*
+ * Sleep until *addr no longer holds val, the deadline passes (returns
+ * false), or the thread is woken for some other reason.
+ */
+static bool
+futexWait(int *addr, int val, const struct timespec *deadline)
+{
+    struct timespec remain, *premain = NULL;
+
+    if (deadline) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        remain.tv_sec = deadline->tv_sec - now.tv_sec;
+        remain.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+        if (remain.tv_nsec < 0) {
+            remain.tv_nsec += 1000000000L;
+            remain.tv_sec--;
+        }
+        if (remain.tv_sec < 0)
+            return false;
+        premain = &remain;
+    }
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, premain,
+            NULL, 0) == 0)
+        return true;
+    if (errno == ETIMEDOUT)
+        return false;
+    if (errno != EAGAIN && errno != EINTR) {
+        errlogPrintf("epicsMessageQueue futex wait failed: %s\n",
+            strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Claim the next position at *pnext if its slot has seq == pos + lag.
+ */
+static bool
+claim(epicsMessageQueueId pmsg, int *pnext, int lag, unsigned int *ppos)
+{
+    for (;;) {
+        unsigned int pos = unsigned(epicsAtomicGetIntT(pnext));
+        slotHeader *pslot = slotAt(pmsg, pos);
+        int diff = int(unsigned(epicsAtomicGetIntT(&pslot->seq)) -
+            (pos + unsigned(lag)));
+
+        if (diff < 0)
+            return false;
+        if (lag == 0 && int(pos - unsigned(epicsAtomicGetIntT(
+                &pmsg->receivePos))) >= int(pmsg->capacity))
+            return false;
+        if (diff == 0 && epicsAtomicCmpAndSwapIntT(pnext, int(pos),
+                int(pos + 1)) == int(pos)) {
+            epicsAtomicReadMemoryBarrier();
+            *ppos = pos;
+            return true;
+        }
+    }
+}
+
+static bool
+tryPut(epicsMessageQueueId pmsg, void *message, unsigned int size)
+{
+    unsigned int pos;
+
+    if (!claim(pmsg, &pmsg->sendPos, 0, &pos))
+        return false;
+    slotHeader *pslot = slotAt(pmsg, pos);
+    pslot->size = size;
+    memcpy(pslot + 1, message, size);
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetIntT(&pslot->seq, int(pos + 1));
+    return true;
+}
+
+/*
+ * Returns the message size, -1 if the message was too large for the
+ * buffer (it is discarded), or -2 if the queue was empty.
+ */
+static int
+tryGet(epicsMessageQueueId pmsg, void *message, unsigned int size)
+{
+    unsigned int pos;
+    int ret;
+
+    if (!claim(pmsg, &pmsg->receivePos, 1, &pos))
+        return -2;
+    slotHeader *pslot = slotAt(pmsg, pos);
+    if (pslot->size <= size) {
+        memcpy(message, pslot + 1, pslot->size);
+        ret = int(pslot->size);
+    }
+    else {
+        ret = -1;
+    }
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetIntT(&pslot->seq, int(pos + pmsg->mask + 1));
+    return ret;
+}
+
+static void
+makeDeadline(double timeout, struct timespec *deadline)
+{
+    double whole;
+
+    if (timeout > 60 * 60 * 24 * 3652.5)
+        timeout = 60 * 60 * 24 * 3652.5;    /* 10 years */
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    whole = (double)(time_t)timeout;
+    deadline->tv_sec += (time_t)whole;
+    deadline->tv_nsec += (long)((timeout - whole) * 1e9);
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_nsec -= 1000000000L;
+        deadline->tv_sec++;
+    }
+}
+
+LIBCOM_API epicsMessageQueueId epicsStdCall epicsMessageQueueCreate(
+    unsigned int capacity,
+    unsigned int maxMessageSize)
+{
+    epicsMessageQueueId pmsg;
+    unsigned int nslots = 1;
+
+    if(capacity == 0 || capacity > 0x40000000u)
+        return NULL;
+    while (nslots < capacity)
+        nslots <<= 1;
+
+    pmsg = (epicsMessageQueueId)calloc(1, sizeof(*pmsg));
+    if(!pmsg)
+        return NULL;
+
+    pmsg->capacity = capacity;
+    pmsg->maxMessageSize = maxMessageSize;
+    pmsg->slotSize = sizeof(slotHeader) + ((maxMessageSize + sizeof(double) - 1)
+        & ~(sizeof(double) - 1));
+    pmsg->mask = nslots - 1;
+    pmsg->slots = (char *)calloc(nslots, pmsg->slotSize);
+    if(!pmsg->slots) {
+        free(pmsg);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < nslots; i++)
+        slotAt(pmsg, i)->seq = int(i);
+    epicsAtomicWriteMemoryBarrier();
+    return pmsg;
+}
+
+LIBCOM_API void epicsStdCall
+epicsMessageQueueDestroy(epicsMessageQueueId pmsg)
+{
+    free(pmsg->slots);
+    free(pmsg);
+}
+
+static int
+mySend(epicsMessageQueueId pmsg, void *message, unsigned int size,
+    double timeout)
+{
+    struct timespec deadline;
+    bool sent;
+
+    if(size > pmsg->maxMessageSize)
+        return -1;
+
+    sent = tryPut(pmsg, message, size);
+    if (!sent && timeout != 0) {
+        /*
+         * Wait for a receiver to make room. NB -1 means wait forever.
+         */
+        if (timeout > 0)
+            makeDeadline(timeout, &deadline);
+        epicsAtomicIncrIntT(&pmsg->sendersWaiting);
+        for (;;) {
+            int seen = epicsAtomicGetIntT(&pmsg->sendFutex);
+
+            if ((sent = tryPut(pmsg, message, size)))
+                break;
+            if (!futexWait(&pmsg->sendFutex, seen,
+                    timeout > 0 ? &deadline : NULL)) {
+                sent = tryPut(pmsg, message, size);
+                break;
+            }
+        }
+        epicsAtomicDecrIntT(&pmsg->sendersWaiting);
+    }
+    if (!sent)
+        return -1;
+    if (epicsAtomicGetIntT(&pmsg->receiversWaiting))
+        futexWake(&pmsg->receiveFutex);
+    return 0;
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueTrySend(epicsMessageQueueId pmsg, void *message,
+    unsigned int size)
+{
+    return mySend(pmsg, message, size, 0);
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueSend(epicsMessageQueueId pmsg, void *message,
+    unsigned int size)
+{
+    return mySend(pmsg, message, size, -1);
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueSendWithTimeout(epicsMessageQueueId pmsg, void *message,
+    unsigned int size, double timeout)
+{
+    return mySend(pmsg, message, size, timeout);
+}
+
+static int
+myReceive(epicsMessageQueueId pmsg, void *message, unsigned int size,
+    double timeout)
+{
+    struct timespec deadline;
+    int ret;
+
+    ret = tryGet(pmsg, message, size);
+    if (ret == -2 && timeout != 0) {
+        /*
+         * Wait for a message to arrive. NB -1 means wait forever.
+         */
+        if (timeout > 0)
+            makeDeadline(timeout, &deadline);
+        epicsAtomicIncrIntT(&pmsg->receiversWaiting);
+        for (;;) {
+            int seen = epicsAtomicGetIntT(&pmsg->receiveFutex);
+
+            if ((ret = tryGet(pmsg, message, size)) != -2)
+                break;
+            if (!futexWait(&pmsg->receiveFutex, seen,
+                    timeout > 0 ? &deadline : NULL)) {
+                ret = tryGet(pmsg, message, size);
+                break;
+            }
+        }
+        epicsAtomicDecrIntT(&pmsg->receiversWaiting);
+    }
+    if (ret == -2)
+        return -1;
+    if (epicsAtomicGetIntT(&pmsg->sendersWaiting))
+        futexWake(&pmsg->sendFutex);
+    return ret;
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueTryReceive(epicsMessageQueueId pmsg, void *message,
+    unsigned int size)
+{
+    return myReceive(pmsg, message, size, 0);
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueReceive(epicsMessageQueueId pmsg, void *message,
+    unsigned int size)
+{
+    return myReceive(pmsg, message, size, -1);
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueueReceiveWithTimeout(epicsMessageQueueId pmsg, void *message,
+    unsigned int size, double timeout)
+{
+    return myReceive(pmsg, message, size, timeout);
+}
+
+LIBCOM_API int epicsStdCall
+epicsMessageQueuePending(epicsMessageQueueId pmsg)
+{
+    int received = epicsAtomicGetIntT(&pmsg->receivePos);
+    int nmsg = int(unsigned(epicsAtomicGetIntT(&pmsg->sendPos)) -
+        unsigned(received));
+
+    /* The two positions are read at different times */
+    if (nmsg < 0)
+        nmsg = 0;
+    if (nmsg > int(pmsg->capacity))
+        nmsg = int(pmsg->capacity);
+    return nmsg;
+}
+
+LIBCOM_API void epicsStdCall
+epicsMessageQueueShow(epicsMessageQueueId pmsg, int level)
+{
+    printf("Message Queue Used:%d  Slots:%lu",
+        epicsMessageQueuePending(pmsg), pmsg->capacity);
+    if (level >= 1)
+        printf("  Maximum size:%lu", pmsg->maxMessageSize);
+    if (level >= 2)
+        printf("  Waiting senders:%d receivers:%d",
+            epicsAtomicGetIntT(&pmsg->sendersWaiting),
+            epicsAtomicGetIntT(&pmsg->receiversWaiting));
+    printf("\n");
+}
@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "epicsSpin.h"
+#include "epicsAtomic.h"
 #include "dbDefs.h"
 #include "epicsRingBytes.h"
 
@@ -33,8 +34,12 @@
  */
 #define SLOP    16
 
+/* Marks a ring that lives in memory provided by the caller */
+#define RING_IN_MEMORY  0x52424d31u
+
 typedef struct ringPvt {
     epicsSpinId    lock;
+    unsigned       inMemory;
     volatile int   nextPut;
     volatile int   nextGet;
     int            size;
@@ -52,6 +57,7 @@ LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesCreate(int size)
     pring->nextGet = 0;
     pring->nextPut = 0;
     pring->lock    = 0;
+    pring->inMemory = 0;
     return((void *)pring);
 }
 
@@ -64,11 +70,42 @@ LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesLockedCreate(int size)
     return((void *)pring);
 }
 
+LIBCOM_API size_t epicsStdCall epicsRingBytesMemorySize(int size)
+{
+    return sizeof(ringPvt) + size + SLOP;
+}
+
+LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesCreateInMemory(
+    void *memory, int size)
+{
+    ringPvt *pring = (ringPvt *)memory;
+    if(!pring || size < 0)
+        return NULL;
+    pring->size = size + SLOP;
+    pring->highWaterMark = 0;
+    pring->nextGet = 0;
+    pring->nextPut = 0;
+    pring->lock    = 0;
+    epicsAtomicWriteMemoryBarrier();
+    pring->inMemory = RING_IN_MEMORY;
+    return((void *)pring);
+}
+
+LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesAttach(void *memory)
+{
+    ringPvt *pring = (ringPvt *)memory;
+    if(!pring || pring->inMemory != RING_IN_MEMORY)
+        return NULL;
+    epicsAtomicReadMemoryBarrier();
+    return((void *)pring);
+}
+
 LIBCOM_API void epicsStdCall epicsRingBytesDelete(epicsRingBytesId id)
 {
     ringPvt *pring = (ringPvt *)id;
     if (pring->lock) epicsSpinDestroy(pring->lock);
-    free((void *)pring);
+    if (pring->inMemory != RING_IN_MEMORY)
+        free((void *)pring);
 }
 
 LIBCOM_API int epicsStdCall epicsRingBytesGet(
@@ -167,6 +204,138 @@ LIBCOM_API int epicsStdCall epicsRingBytesPut(
     return nbytes;
 }
 
+LIBCOM_API int epicsStdCall epicsRingBytesReserve(
+    epicsRingBytesId id, int nbytes, epicsRingBytesSpan span[2])
+{
+    ringPvt *pring = (ringPvt *)id;
+    int nextGet, nextPut, size;
+    int freeCount, topCount;
+
+    if (pring->lock) epicsSpinLock(pring->lock);
+    nextGet = pring->nextGet;
+    nextPut = pring->nextPut;
+    if (pring->lock) epicsSpinUnlock(pring->lock);
+    size = pring->size;
+
+    if (nextPut < nextGet)
+        freeCount = nextGet - nextPut - SLOP;
+    else
+        freeCount = size - nextPut + nextGet - SLOP;
+    if (nbytes < 0 || nbytes > freeCount) {
+        span[0].data = span[1].data = NULL;
+        span[0].nbytes = span[1].nbytes = 0;
+        return 0;
+    }
+
+    topCount = size - nextPut;
+    span[0].data = (char *)&pring->buffer[nextPut];
+    if (nbytes > topCount) {
+        span[0].nbytes = topCount;
+        span[1].data = (char *)&pring->buffer[0];
+        span[1].nbytes = nbytes - topCount;
+    }
+    else {
+        span[0].nbytes = nbytes;
+        span[1].data = NULL;
+        span[1].nbytes = 0;
+    }
+    return nbytes;
+}
+
+LIBCOM_API int epicsStdCall epicsRingBytesCommit(
+    epicsRingBytesId id, int nbytes)
+{
+    ringPvt *pring = (ringPvt *)id;
+    int nextGet, nextPut, size;
+    int freeCount, used;
+
+    if (pring->lock) epicsSpinLock(pring->lock);
+    nextGet = pring->nextGet;
+    nextPut = pring->nextPut;
+    size = pring->size;
+
+    if (nextPut < nextGet)
+        freeCount = nextGet - nextPut - SLOP;
+    else
+        freeCount = size - nextPut + nextGet - SLOP;
+    if (nbytes > freeCount)
+        nbytes = freeCount;
+    if (nbytes < 0)
+        nbytes = 0;
+
+    nextPut += nbytes;
+    if (nextPut >= size)
+        nextPut -= size;
+    /* The data must be visible before the new position */
+    epicsAtomicWriteMemoryBarrier();
+    pring->nextPut = nextPut;
+
+    used = nextPut - nextGet;
+    if (used < 0) used += size;
+    if (used > pring->highWaterMark) pring->highWaterMark = used;
+
+    if (pring->lock) epicsSpinUnlock(pring->lock);
+    return nbytes;
+}
+
+LIBCOM_API int epicsStdCall epicsRingBytesPeek(
+    epicsRingBytesId id, epicsRingBytesSpan span[2])
+{
+    ringPvt *pring = (ringPvt *)id;
+    int nextGet, nextPut, size;
+
+    if (pring->lock) epicsSpinLock(pring->lock);
+    nextGet = pring->nextGet;
+    nextPut = pring->nextPut;
+    if (pring->lock) epicsSpinUnlock(pring->lock);
+    size = pring->size;
+    /* Don't look at the data before reading its position */
+    epicsAtomicReadMemoryBarrier();
+
+    span[0].data = (char *)&pring->buffer[nextGet];
+    if (nextGet <= nextPut) {
+        span[0].nbytes = nextPut - nextGet;
+        span[1].data = NULL;
+        span[1].nbytes = 0;
+    }
+    else {
+        span[0].nbytes = size - nextGet;
+        span[1].data = (char *)&pring->buffer[0];
+        span[1].nbytes = nextPut;
+    }
+    return span[0].nbytes + span[1].nbytes;
+}
+
+LIBCOM_API int epicsStdCall epicsRingBytesConsume(
+    epicsRingBytesId id, int nbytes)
+{
+    ringPvt *pring = (ringPvt *)id;
+    int nextGet, nextPut, size;
+    int used;
+
+    if (pring->lock) epicsSpinLock(pring->lock);
+    nextGet = pring->nextGet;
+    nextPut = pring->nextPut;
+    size = pring->size;
+
+    used = nextPut - nextGet;
+    if (used < 0) used += size;
+    if (nbytes > used)
+        nbytes = used;
+    if (nbytes < 0)
+        nbytes = 0;
+
+    nextGet += nbytes;
+    if (nextGet >= size)
+        nextGet -= size;
+    /* Finish with the data before the writer may reuse its space */
+    epicsAtomicWriteMemoryBarrier();
+    pring->nextGet = nextGet;
+
+    if (pring->lock) epicsSpinUnlock(pring->lock);
+    return nbytes;
+}
+
 LIBCOM_API void epicsStdCall epicsRingBytesFlush(epicsRingBytesId id)
 {
     ringPvt *pring = (ringPvt *)id;
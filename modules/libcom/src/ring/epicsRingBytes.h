@@ -23,11 +23,22 @@
  * \note If there is only one writer it is not necessary to lock for puts.
  * If there is a single reader it is not necessary to lock for gets.
  * epicsRingBytesLocked uses a spinlock.
+ *
+ * The zero-copy functions epicsRingBytesReserve(), epicsRingBytesCommit(),
+ * epicsRingBytesPeek() and epicsRingBytesConsume() give direct access to
+ * the bytes stored in the ring, so a producer can fill the ring and a
+ * consumer can process its contents without an intermediate buffer.
+ * A region of the ring that wraps around the end of the buffer is
+ * described as two spans. At most one producer may hold a reservation
+ * and one consumer may be working on peeked data at any time, even when
+ * using the locked variant.
  */
 
 #ifndef INCepicsRingBytesh
 #define INCepicsRingBytesh
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,6 +49,14 @@ extern "C" {
 typedef void *epicsRingBytesId;
 typedef void const *epicsRingBytesIdConst;
 
+/** \brief A contiguous region inside a ring buffer */
+typedef struct epicsRingBytesSpan {
+    /** \brief Address of the first byte */
+    char *data;
+    /** \brief Number of bytes, may be zero */
+    int   nbytes;
+} epicsRingBytesSpan;
+
 /**
  * \brief Create a new ring buffer
  * \param nbytes Size of ring buffer to create
@@ -50,6 +69,35 @@ LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesCreate(int nbytes);
  * \return Ring buffer Id or NULL on failure
  */
 LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesLockedCreate(int nbytes);
+/**
+ * \brief Return the amount of memory needed for a ring buffer
+ * \param nbytes Size of the ring buffer
+ * \return Number of bytes to pass to epicsRingBytesCreateInMemory()
+ */
+LIBCOM_API size_t epicsStdCall epicsRingBytesMemorySize(int nbytes);
+/**
+ * \brief Create a new ring buffer in memory provided by the caller
+ *
+ * The ring buffer state is stored entirely inside the given memory and
+ * contains no pointers, so the memory may be a shared memory mapping
+ * (e.g. of a POSIX shared memory object or a Linux memfd) that another
+ * process uses through epicsRingBytesAttach(). Such a ring has no lock,
+ * so there must be only one writer and one reader.
+ * epicsRingBytesDelete() does not free the memory.
+ * \param memory Start of the memory, suitably aligned for an int
+ * \param nbytes Size of ring buffer to create; the memory must hold at
+ * least epicsRingBytesMemorySize(nbytes) bytes
+ * \return Ring buffer Id or NULL on failure
+ */
+LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesCreateInMemory(
+    void *memory, int nbytes);
+/**
+ * \brief Use a ring buffer created by another process
+ * \param memory Start of the ring in this process's mapping of the
+ * memory given to epicsRingBytesCreateInMemory()
+ * \return Ring buffer Id or NULL if no ring was found at memory
+ */
+LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesAttach(void *memory);
 /**
  * \brief Delete the ring buffer and free any associated memory
  * \param id RingbufferID returned by epicsRingBytesCreate()
@@ -73,6 +121,47 @@ LIBCOM_API int  epicsStdCall epicsRingBytesGet(
  */
 LIBCOM_API int  epicsStdCall epicsRingBytesPut(
     epicsRingBytesId id, char *value,int nbytes);
+/**
+ * \brief Reserve space in the ring buffer for writing in place
+ *
+ * The reserved bytes are described by one or two spans; span[1].nbytes
+ * is zero unless the space wraps around the end of the buffer. The data
+ * becomes visible to the reader when epicsRingBytesCommit() is called.
+ * \param id RingbufferID returned by epicsRingBytesCreate()
+ * \param nbytes How many bytes to reserve
+ * \param span Two spans filled in to describe the reserved space
+ * \return nbytes, or zero if there is not enough space
+ */
+LIBCOM_API int  epicsStdCall epicsRingBytesReserve(
+    epicsRingBytesId id, int nbytes, epicsRingBytesSpan span[2]);
+/**
+ * \brief Publish bytes written into reserved space
+ * \param id RingbufferID returned by epicsRingBytesCreate()
+ * \param nbytes How many bytes to publish, at most the number reserved
+ * \return The number of bytes actually published
+ */
+LIBCOM_API int  epicsStdCall epicsRingBytesCommit(
+    epicsRingBytesId id, int nbytes);
+/**
+ * \brief Look at the data in the ring buffer without removing it
+ *
+ * The stored bytes are described by one or two spans; span[1].nbytes is
+ * zero unless the data wraps around the end of the buffer. The data stays
+ * in the ring until released by epicsRingBytesConsume().
+ * \param id RingbufferID returned by epicsRingBytesCreate()
+ * \param span Two spans filled in to describe the stored data
+ * \return The total number of bytes described by the spans
+ */
+LIBCOM_API int  epicsStdCall epicsRingBytesPeek(
+    epicsRingBytesId id, epicsRingBytesSpan span[2]);
+/**
+ * \brief Remove bytes from the front of the ring buffer
+ * \param id RingbufferID returned by epicsRingBytesCreate()
+ * \param nbytes How many bytes to remove
+ * \return The number of bytes actually removed
+ */
+LIBCOM_API int  epicsStdCall epicsRingBytesConsume(
+    epicsRingBytesId id, int nbytes);
 /**
  * \brief Make the ring buffer empty
  * \param id RingbufferID returned by epicsRingBytesCreate()
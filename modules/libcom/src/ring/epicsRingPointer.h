@@ -19,7 +19,10 @@
  * unlocked kind is designed so that one writer thread and one reader thread
  * can access the ring simultaneously without requiring mutual exclusion. The
  * locked variant uses an epicsSpinLock, and works with any numbers of writer
- * and reader threads.
+ * and reader threads. The lock-free variant also works with any numbers of
+ * writer and reader threads, but uses a sequence number in each slot and
+ * atomic compare-and-swap operations instead of a lock, so a thread that is
+ * preempted in the middle of an operation never blocks the other threads.
  * \note If there is only one writer it is not necessary to lock pushes.
  * If there is a single reader it is not necessary to lock pops.
  * epicsRingPointerLocked uses a spinlock.
@@ -30,6 +33,7 @@
 
 
 #include "epicsSpin.h"
+#include "epicsAtomic.h"
 #include "libComAPI.h"
 
 #ifdef __cplusplus
@@ -44,8 +48,10 @@ public: /* Functions */
     /**\brief Constructor
      * \param size Maximum number of elements (pointers) that can be stored
      * \param locked If true, the spin lock secured variant is created
+     * \param lockFree If true, the lock-free variant that supports multiple
+     * writers and readers is created, and \c locked is ignored
      */
-    epicsRingPointer(int size, bool locked);
+    epicsRingPointer(int size, bool locked, bool lockFree = false);
     /**\brief Destructor
      */
     ~epicsRingPointer();
@@ -57,6 +63,17 @@ public: /* Functions */
      * \return The element, or NULL if the ring was empty
      */
     T* pop();
+    /**\brief Push up to \c n entries on the ring
+     *
+     * Entries are pushed in order, as many as there is space for.
+     * \return The number of entries pushed, 0 if the ring was full
+     */
+    int pushMany(T * const *p, int n);
+    /**\brief Take up to \c n elements off the ring
+     * \return The number of elements stored into \c p, 0 if the ring
+     * was empty
+     */
+    int popMany(T **p, int n);
     /**\brief Remove all elements from the ring.
      * \note If this operation is performed on a ring buffer of the
      * unsecured kind, all access to the ring should be locked.
@@ -102,6 +119,20 @@ private: /* Prevent compiler-generated member functions */
     epicsRingPointer(const epicsRingPointer &);
     epicsRingPointer& operator=(const epicsRingPointer &);
     int getUsedNoLock() const;
+    int claimLockFree(int *pnext, int lag, int n, unsigned *ppos);
+    int pushManyLockFree(T * const *p, int n);
+    int popManyLockFree(T **p, int n);
+    int getUsedLockFree() const;
+    void updateHighWaterMarkLockFree(int used);
+
+    /* Lock-free variant: slot i is free for the push at position pos when
+     * seq == pos, and holds the entry for the pop at pos when seq == pos+1.
+     * Positions count up forever, wrapping modulo 2^32.
+     */
+    struct slot {
+        T * volatile p;
+        int seq;
+    };
 
 private: /* Data */
     epicsSpinId lock;
@@ -110,6 +141,14 @@ private: /* Data */
     int size;
     int highWaterMark;
     T  * volatile * buffer;
+    slot *slots;
+    unsigned mask;
+    /* Lock-free push and pop positions, kept on separate cache lines */
+    char pad0[64];
+    int pushPos;
+    char pad1[64 - sizeof(int)];
+    int popPos;
+    char pad2[64 - sizeof(int)];
 };
 
 extern "C" {
@@ -130,6 +169,15 @@ LIBCOM_API epicsRingPointerId  epicsStdCall epicsRingPointerCreate(int size);
  * \return Ring buffer identifier or NULL on failure
  */
 LIBCOM_API epicsRingPointerId  epicsStdCall epicsRingPointerLockedCreate(int size);
+/**
+ * \brief Create a new lock-free ring buffer for multiple writers and readers
+ *
+ * The ring can be used with all of the other epicsRingPointer routines,
+ * from any number of threads concurrently.
+ * \param size Size of ring buffer to create
+ * \return Ring buffer identifier or NULL on failure
+ */
+LIBCOM_API epicsRingPointerId  epicsStdCall epicsRingPointerLockFreeCreate(int size);
 /**
  * \brief Delete the ring buffer and free any associated memory
  * \param id Ring buffer identifier
@@ -148,6 +196,26 @@ LIBCOM_API int  epicsStdCall epicsRingPointerPush(epicsRingPointerId id,void *p)
  * \return The pointer from the buffer, or NULL if the ring was empty
  */
 LIBCOM_API void* epicsStdCall epicsRingPointerPop(epicsRingPointerId id) ;
+/**
+ * \brief Push several pointers into the ring buffer
+ *
+ * The pointers are pushed in order, as many as there is space for.
+ * \param id Ring buffer identifier
+ * \param p Array of pointers to be pushed to the ring
+ * \param n Number of entries in \c p
+ * \return The number of pointers pushed, 0 if the buffer was full
+ */
+LIBCOM_API int  epicsStdCall epicsRingPointerPushMany(epicsRingPointerId id,
+    void * const *p, int n);
+/**
+ * \brief Take several elements off the ring
+ * \param id Ring buffer identifier
+ * \param p Array to store the pointers taken from the buffer
+ * \param n Maximum number of pointers to take
+ * \return The number of pointers stored into \c p, 0 if the ring was empty
+ */
+LIBCOM_API int  epicsStdCall epicsRingPointerPopMany(epicsRingPointerId id,
+    void **p, int n);
 /**
  * \brief Remove all elements from the ring
  * \param id Ring buffer identifier
@@ -217,10 +285,25 @@ LIBCOM_API void epicsStdCall epicsRingPointerResetHighWaterMark(epicsRingPointer
 #ifdef __cplusplus
 
 template <class T>
-inline epicsRingPointer<T>::epicsRingPointer(int sz, bool locked) :
+inline epicsRingPointer<T>::epicsRingPointer(int sz, bool locked,
+    bool lockFree) :
     lock(0), nextPush(0), nextPop(0), size(sz+1), highWaterMark(0),
-    buffer(new T* [sz+1])
+    buffer(0), slots(0), mask(0), pushPos(0), popPos(0)
 {
+    if (lockFree) {
+        unsigned nslots = 1;
+        while (nslots < unsigned(sz))
+            nslots <<= 1;
+        mask = nslots - 1;
+        slots = new slot [nslots];
+        for (unsigned i = 0; i < nslots; i++) {
+            slots[i].p = 0;
+            slots[i].seq = int(i);
+        }
+        epicsAtomicWriteMemoryBarrier();
+        return;
+    }
+    buffer = new T* [sz+1];
     if (locked)
         lock = epicsSpinCreate();
 }
@@ -230,11 +313,112 @@ inline epicsRingPointer<T>::~epicsRingPointer()
 {
     if (lock) epicsSpinDestroy(lock);
     delete [] buffer;
+    delete [] slots;
+}
+
+/* Claim up to n consecutive positions starting at *pnext whose slots have
+ * seq == pos + lag, then advance *pnext past them. Returns the number of
+ * positions claimed and the first one in *ppos.
+ */
+template <class T>
+inline int epicsRingPointer<T>::claimLockFree(int *pnext, int lag, int n,
+    unsigned *ppos)
+{
+    for (;;) {
+        unsigned pos = unsigned(epicsAtomicGetIntT(pnext));
+        int avail = 0;
+
+        if (lag == 0) {
+            /* A push must not overtake the capacity the user asked for */
+            int room = size - 1 - int(pos - unsigned(epicsAtomicGetIntT(&popPos)));
+            if (room < n)
+                n = room;
+        }
+        while (avail < n) {
+            unsigned want = pos + unsigned(avail) + unsigned(lag);
+            int diff = int(unsigned(epicsAtomicGetIntT(
+                &slots[(pos + avail) & mask].seq)) - want);
+            if (diff != 0) {
+                if (avail == 0 && diff < 0)
+                    return 0;   /* full or empty */
+                break;
+            }
+            avail++;
+        }
+        if (avail > 0 && epicsAtomicCmpAndSwapIntT(pnext, int(pos),
+                int(pos + unsigned(avail))) == int(pos)) {
+            epicsAtomicReadMemoryBarrier();
+            *ppos = pos;
+            return avail;
+        }
+        if (avail == 0 && n <= 0)
+            return 0;
+    }
+}
+
+template <class T>
+inline int epicsRingPointer<T>::pushManyLockFree(T * const *p, int n)
+{
+    unsigned pos;
+    int count = claimLockFree(&pushPos, 0, n, &pos);
+
+    for (int i = 0; i < count; i++, pos++) {
+        slot *s = &slots[pos & mask];
+        s->p = p[i];
+        epicsAtomicWriteMemoryBarrier();
+        s->seq = int(pos + 1);
+    }
+    if (count) {
+        epicsAtomicWriteMemoryBarrier();
+        updateHighWaterMarkLockFree(getUsedLockFree());
+    }
+    return count;
+}
+
+template <class T>
+inline int epicsRingPointer<T>::popManyLockFree(T **p, int n)
+{
+    unsigned pos;
+    int count = claimLockFree(&popPos, 1, n, &pos);
+
+    for (int i = 0; i < count; i++, pos++) {
+        slot *s = &slots[pos & mask];
+        p[i] = s->p;
+        epicsAtomicWriteMemoryBarrier();
+        s->seq = int(pos + mask + 1);
+    }
+    if (count)
+        epicsAtomicWriteMemoryBarrier();
+    return count;
+}
+
+template <class T>
+inline int epicsRingPointer<T>::getUsedLockFree() const
+{
+    int popped = epicsAtomicGetIntT(&popPos);
+    int n = int(unsigned(epicsAtomicGetIntT(&pushPos)) - unsigned(popped));
+    /* The two positions are read at different times */
+    if (n < 0) n = 0;
+    if (n > size - 1) n = size - 1;
+    return n;
+}
+
+template <class T>
+inline void epicsRingPointer<T>::updateHighWaterMarkLockFree(int used)
+{
+    int hwm = highWaterMark;
+    while (used > hwm) {
+        int prev = epicsAtomicCmpAndSwapIntT(&highWaterMark, hwm, used);
+        if (prev == hwm)
+            break;
+        hwm = prev;
+    }
 }
 
 template <class T>
 inline bool epicsRingPointer<T>::push(T *p)
 {
+    if (slots) return pushManyLockFree(&p, 1) == 1;
     if (lock) epicsSpinLock(lock);
     int next = nextPush;
     int newNext = next + 1;
@@ -254,6 +438,10 @@ inline bool epicsRingPointer<T>::push(T *p)
 template <class T>
 inline T* epicsRingPointer<T>::pop()
 {
+    if (slots) {
+        T *p;
+        return popManyLockFree(&p, 1) ? p : 0;
+    }
     if (lock) epicsSpinLock(lock);
     int next = nextPop;
     if (next == nextPush) {
@@ -268,9 +456,52 @@ inline T* epicsRingPointer<T>::pop()
     return(p);
 }
 
+template <class T>
+inline int epicsRingPointer<T>::pushMany(T * const *p, int n)
+{
+    if (slots) return pushManyLockFree(p, n);
+    if (lock) epicsSpinLock(lock);
+    int count = 0;
+    int next = nextPush;
+    while (count < n) {
+        int newNext = next + 1;
+        if(newNext>=size) newNext=0;
+        if (newNext == nextPop) break;
+        buffer[next] = p[count++];
+        next = newNext;
+    }
+    nextPush = next;
+    int used = getUsedNoLock();
+    if (used > highWaterMark) highWaterMark = used;
+    if (lock) epicsSpinUnlock(lock);
+    return count;
+}
+
+template <class T>
+inline int epicsRingPointer<T>::popMany(T **p, int n)
+{
+    if (slots) return popManyLockFree(p, n);
+    if (lock) epicsSpinLock(lock);
+    int count = 0;
+    int next = nextPop;
+    while (count < n && next != nextPush) {
+        p[count++] = buffer[next];
+        ++next;
+        if(next >=size) next = 0;
+    }
+    nextPop = next;
+    if (lock) epicsSpinUnlock(lock);
+    return count;
+}
+
 template <class T>
 inline void epicsRingPointer<T>::flush()
 {
+    if (slots) {
+        T *p[16];
+        while (popManyLockFree(p, 16) > 0) {}
+        return;
+    }
     if (lock) epicsSpinLock(lock);
     nextPop = 0;
     nextPush = 0;
@@ -280,6 +511,7 @@ inline void epicsRingPointer<T>::flush()
 template <class T>
 inline int epicsRingPointer<T>::getFree() const
 {
+    if (slots) return size - 1 - getUsedLockFree();
     if (lock) epicsSpinLock(lock);
     int n = nextPop - nextPush - 1;
     if (n < 0) n += size;
@@ -298,6 +530,7 @@ inline int epicsRingPointer<T>::getUsedNoLock() const
 template <class T>
 inline int epicsRingPointer<T>::getUsed() const
 {
+    if (slots) return getUsedLockFree();
     if (lock) epicsSpinLock(lock);
     int n = getUsedNoLock();
     if (lock) epicsSpinUnlock(lock);
@@ -314,6 +547,7 @@ template <class T>
 inline bool epicsRingPointer<T>::isEmpty() const
 {
     bool isEmpty;
+    if (slots) return getUsedLockFree() == 0;
     if (lock) epicsSpinLock(lock);
     isEmpty = (nextPush == nextPop);
     if (lock) epicsSpinUnlock(lock);
@@ -323,6 +557,7 @@ inline bool epicsRingPointer<T>::isEmpty() const
 template <class T>
 inline bool epicsRingPointer<T>::isFull() const
 {
+    if (slots) return getUsedLockFree() == size - 1;
     if (lock) epicsSpinLock(lock);
     int count = nextPush - nextPop +1;
     if (lock) epicsSpinUnlock(lock);
@@ -338,6 +573,10 @@ inline int epicsRingPointer<T>::getHighWaterMark() const
 template <class T>
 inline void epicsRingPointer<T>::resetHighWaterMark()
 {
+    if (slots) {
+        epicsAtomicSetIntT(&highWaterMark, getUsedLockFree());
+        return;
+    }
     if (lock) epicsSpinLock(lock);
     highWaterMark = getUsedNoLock();
     if (lock) epicsSpinUnlock(lock);
@@ -0,0 +1,260 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsUnitTest.h"
+#include "epicsMath.h"
+#include "epicsTime.h"
+#include "postfix.h"
+#include "testMain.h"
+
+/* Not a multiple of the block size, so there's a partial block */
+#define NELEM 150
+
+static double valA[NELEM], valB[NELEM], valC[NELEM];
+static double scalarD = 4.0;
+
+static char * compile(const char *expr)
+{
+    char *rpn = malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr) + 1));
+    short err;
+
+    if (!rpn)
+        testAbort("Out of memory");
+    if (postfix(expr, rpn, &err)) {
+        testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+        free(rpn);
+        return NULL;
+    }
+    return rpn;
+}
+
+static void setArgs(calcArrayArg *pargs, epicsUInt32 nelem)
+{
+    memset(pargs, 0, CALCPERFORM_NARGS * sizeof(calcArrayArg));
+    pargs[0].pval = valA;
+    pargs[0].nelem = nelem;
+    pargs[1].pval = valB;
+    pargs[1].nelem = nelem;
+    pargs[2].pval = valC;
+    pargs[2].nelem = nelem;
+    pargs[3].pval = &scalarD;
+    pargs[3].nelem = 1;
+}
+
+/* Compare calcPerformArray() with calcPerform() on each element */
+static void testArray(const char *expr)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    double result[NELEM];
+    epicsUInt32 nelem = NELEM;
+    char *rpn = compile(expr);
+    int i, bad = 0;
+
+    if (!rpn) {
+        testFail("%s", expr);
+        return;
+    }
+    setArgs(args, NELEM);
+    for (i = 0; i < NELEM; i++)
+        result[i] = i;
+
+    if (calcPerformArray(args, result, &nelem, rpn) || nelem != NELEM) {
+        testFail("%s: calcPerformArray failed, %u elements", expr, nelem);
+        free(rpn);
+        return;
+    }
+    for (i = 0; i < NELEM; i++) {
+        double scalar[CALCPERFORM_NARGS] = {0};
+        double expect = i;
+
+        scalar[0] = valA[i];
+        scalar[1] = valB[i];
+        scalar[2] = valC[i];
+        scalar[3] = scalarD;
+        calcPerform(scalar, &expect, rpn);
+        if (!(expect == result[i] || (isnan(expect) && isnan(result[i])))) {
+            if (!bad++)
+                testDiag("Element %d is %g, expected %g", i, result[i], expect);
+        }
+    }
+    testOk(!bad, "%s", expr);
+    free(rpn);
+}
+
+static void testLength(const char *expr, epicsUInt32 na, epicsUInt32 nb,
+    epicsUInt32 room, epicsUInt32 expect)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    double result[NELEM];
+    epicsUInt32 nelem = room;
+    char *rpn = compile(expr);
+
+    setArgs(args, NELEM);
+    args[0].nelem = na;
+    args[1].nelem = nb;
+    memset(result, 0, sizeof(result));
+    testOk(rpn && !calcPerformArray(args, result, &nelem, rpn) &&
+        nelem == expect, "%s with A[%u], B[%u] into %u gives %u (%u)",
+        expr, na, nb, room, expect, nelem);
+    free(rpn);
+}
+
+static void testReduce(int op, const char *name, const double *pval,
+    epicsUInt32 nelem, double expect)
+{
+    double result = 0;
+
+    testOk(!calcArrayReduce(op, pval, nelem, &result) &&
+        (fabs(result - expect) < 1e-9 || (isnan(expect) && isnan(result))),
+        "%s of %u elements = %g (%g)", name, nelem, expect, result);
+}
+
+/* Million elements/s for an expression, element at a time and arrays */
+static void benchmark(const char *expr)
+{
+    enum {nbench = 1000};
+    calcArrayArg args[CALCPERFORM_NARGS];
+    double result[NELEM];
+    char *rpn = compile(expr);
+    epicsTimeStamp start, stop;
+    double elementRate, arrayRate;
+    int i, j;
+
+    if (!rpn)
+        return;
+    setArgs(args, NELEM);
+
+    epicsTimeGetCurrent(&start);
+    for (j = 0; j < nbench; j++) {
+        for (i = 0; i < NELEM; i++) {
+            double scalar[CALCPERFORM_NARGS] = {0};
+
+            scalar[0] = valA[i];
+            scalar[1] = valB[i];
+            scalar[2] = valC[i];
+            scalar[3] = scalarD;
+            calcPerform(scalar, &result[i], rpn);
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    elementRate = nbench * NELEM / epicsTimeDiffInSeconds(&stop, &start) / 1e6;
+
+    epicsTimeGetCurrent(&start);
+    for (j = 0; j < nbench; j++) {
+        epicsUInt32 nelem = NELEM;
+
+        calcPerformArray(args, result, &nelem, rpn);
+    }
+    epicsTimeGetCurrent(&stop);
+    arrayRate = nbench * NELEM / epicsTimeDiffInSeconds(&stop, &start) / 1e6;
+
+    testDiag("%-20s %7.1f %7.1f M/s", expr, elementRate, arrayRate);
+    free(rpn);
+}
+
+MAIN(epicsCalcArrayTest)
+{
+    static const double ramp[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    static const double withNaN[] = {3, 1, 2, 0, 5};
+    double nanVals[5];
+    double result;
+    int i;
+
+    testPlan(51);
+
+    for (i = 0; i < NELEM; i++) {
+        valA[i] = i - 50.5;
+        valB[i] = (i % 7) - 3;
+        valC[i] = 0.01 * i;
+    }
+
+    testDiag("Elementwise, compared with calcPerform()");
+    testArray("A+B");
+    testArray("A-B*C/D");
+    testArray("-A");
+    testArray("A%B");
+    testArray("A^2+B**3");
+    testArray("ABS(A)+SQR(C)");
+    testArray("EXP(C)+LOG(C)+LN(C)+LOGE(C)");
+    testArray("MAX(A,B,C)+MIN(A,B)");
+    testArray("MAX(A,B/0)");
+    testArray("SIN(C)+COS(C)+TAN(C)");
+    testArray("ASIN(C/2)+ACOS(C/2)+ATAN(A)+ATAN2(A,B)");
+    testArray("SINH(C)+COSH(C)+TANH(C)");
+    testArray("CEIL(C)+FLOOR(C)+NINT(A)+FMOD(A,D)");
+    testArray("FINITE(A,B/0)+ISNAN(C,B/0)+ISINF(A/B)");
+    testArray("A||B&&!C");
+    testArray("(A|B)+(A&B)+(A XOR B)+~A");
+    testArray("(A>>2)+(A<<2)+(A>>>2)");
+    testArray("(A<B)+(A<=B)+(A=B)+(A>=B)+(A>B)+(A!=B)");
+    testArray("A+PI*D2R*R2D+1.5+2");
+    testArray("VAL+A");
+    testArray("A+B+C+D+(A+(B+(C+(D+(A+B)))))");
+
+    testDiag("Element at a time");
+    testArray("A<0?B:C");
+    testArray("A>0?(B<0?1:2):3");
+    testArray("E:=A*2;E+B");
+
+    testDiag("Result lengths");
+    testLength("A+B", 10, 20, NELEM, 10);
+    testLength("A+B", 20, 10, NELEM, 10);
+    testLength("A+B", 20, 10, 5, 5);
+    testLength("A+D", 1, 20, NELEM, 1);
+    testLength("A+B", 0, 20, NELEM, 0);
+    testLength("C+D", 0, 0, NELEM, NELEM);
+    testLength("D*2", 10, 20, NELEM, 1);
+    testLength("A<0?B:C", 10, 20, NELEM, 10);
+    testLength("B:=1;A+B", 30, 20, NELEM, 30);
+    testLength("VAL>D", 30, 20, NELEM, NELEM);
+    testLength("VAL+A", 30, 20, NELEM, 30);
+
+    {
+        calcArrayArg args[CALCPERFORM_NARGS];
+        epicsUInt32 nelem = NELEM;
+        double buf[NELEM];
+        char *rpn = compile("A+");
+
+        testOk(!rpn, "Bad expression doesn't compile");
+        free(rpn);
+
+        rpn = compile("D*2");
+        setArgs(args, NELEM);
+        testOk(rpn && !calcPerformArray(args, buf, &nelem, rpn) &&
+            nelem == 1 && buf[0] == 8.0, "Scalar D*2 = %g", buf[0]);
+        free(rpn);
+    }
+
+    testDiag("Reductions");
+    for (i = 0; i < 5; i++)
+        nanVals[i] = withNaN[i];
+    testReduce(CALC_REDUCE_SUM, "SUM", ramp, 9, 45);
+    testReduce(CALC_REDUCE_SUM, "SUM", ramp, 3, 6);
+    testReduce(CALC_REDUCE_SUM, "SUM", ramp, 0, 0);
+    testReduce(CALC_REDUCE_MIN, "MIN", withNaN, 5, 0);
+    testReduce(CALC_REDUCE_MAX, "MAX", withNaN, 5, 5);
+    testReduce(CALC_REDUCE_MIN, "MIN", ramp, 0, epicsNAN);
+    testReduce(CALC_REDUCE_AVG, "AVG", ramp, 9, 5);
+    testReduce(CALC_REDUCE_AVG, "AVG", ramp, 0, epicsNAN);
+    testReduce(CALC_REDUCE_STD, "STD", ramp, 9, sqrt(60.0 / 9));
+    testReduce(CALC_REDUCE_STD, "STD", ramp + 4, 1, 0);
+    nanVals[2] = epicsNAN;
+    testReduce(CALC_REDUCE_MIN, "MIN with NaN", nanVals, 5, epicsNAN);
+    testReduce(CALC_REDUCE_MAX, "MAX with NaN", nanVals, 5, epicsNAN);
+    testReduce(CALC_REDUCE_SUM, "SUM with NaN", nanVals, 5, epicsNAN);
+    testOk(calcArrayReduce(0, ramp, 9, &result) != 0, "Unknown reduction");
+
+    testDiag("Evaluation rates, element at a time and whole arrays");
+    benchmark("A+B");
+    benchmark("A*D+C*C-B/2");
+    benchmark("MAX(A,B)-ABS(C)");
+    benchmark("SQR(C)+SIN(C)");
+
+    return testDone();
+}
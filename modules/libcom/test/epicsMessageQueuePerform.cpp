@@ -0,0 +1,89 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Measures the rate at which messages pass through an epicsMessageQueue
+ * from one or more producer threads to a single consumer thread, for
+ * small and larger messages. Everybody blocks on the queue, so the
+ * results include the cost of waking sleeping senders and receivers.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "epicsMessageQueue.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+const unsigned queueCapacity = 256;
+const int nMessages = 400000;
+const int maxProducers = 16;
+
+struct producer {
+    epicsMessageQueueId queue;
+    unsigned size;
+    int count;
+};
+
+extern "C" void producerThread(void *raw)
+{
+    producer *pp = static_cast<producer *>(raw);
+    char msg[256];
+
+    memset(msg, 0x5a, sizeof(msg));
+    for (int i = 0; i < pp->count; i++)
+        epicsMessageQueueSend(pp->queue, msg, pp->size);
+}
+
+void measure(int nProducers, unsigned size)
+{
+    epicsMessageQueueId queue = epicsMessageQueueCreate(queueCapacity, size);
+    epicsThreadId tid[maxProducers];
+    producer producers[maxProducers];
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    char msg[256];
+    int i, bad = 0;
+
+    opts.joinable = 1;
+    opts.priority = epicsThreadPriorityMedium;
+
+    epicsTime begin = epicsTime::getMonotonic();
+    for (i = 0; i < nProducers; i++) {
+        producers[i].queue = queue;
+        producers[i].size = size;
+        producers[i].count = nMessages / nProducers;
+        tid[i] = epicsThreadCreateOpt("mqPerf", producerThread,
+            &producers[i], &opts);
+    }
+    int total = (nMessages / nProducers) * nProducers;
+    for (i = 0; i < total; i++) {
+        if (epicsMessageQueueReceive(queue, msg, sizeof(msg)) != int(size))
+            bad++;
+    }
+    double delay = epicsTime::getMonotonic() - begin;
+    for (i = 0; i < nProducers; i++)
+        epicsThreadMustJoin(tid[i]);
+
+    testDiag("%2d producer%s %3u byte messages: %10.0f messages/s%s",
+        nProducers, nProducers == 1 ? " " : "s", size, total / delay,
+        bad ? " (bad sizes received)" : "");
+    epicsMessageQueueDestroy(queue);
+}
+
+} // namespace
+
+MAIN(epicsMessageQueuePerform)
+{
+    testPlan(0);
+    for (unsigned size = 8; size <= 256; size *= 32) {
+        for (int nProducers = 1; nProducers <= maxProducers; nProducers *= 2)
+            measure(nProducers, size);
+    }
+    return testDone();
+}
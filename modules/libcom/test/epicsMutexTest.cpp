@@ -234,6 +234,82 @@ void verifyTryLock ()
     epicsEventDestroy ( verify.done );
 }
 
+struct verifyProfile {
+    epicsMutexId mutex;
+    epicsEventId started;
+    epicsEventId done;
+};
+
+extern "C" void verifyProfileThread ( void *pArg )
+{
+    struct verifyProfile *pVerify =
+        ( struct verifyProfile * ) pArg;
+
+    epicsEventSignal ( pVerify->started );
+    epicsMutexLock ( pVerify->mutex );
+    epicsMutexUnlock ( pVerify->mutex );
+    epicsEventSignal ( pVerify->done );
+}
+
+void verifyProfile ()
+{
+    struct verifyProfile verify;
+    epicsMutexProfileData data;
+
+    verify.mutex = epicsMutexMustCreate ();
+    verify.started = epicsEventMustCreate ( epicsEventEmpty );
+    verify.done = epicsEventMustCreate ( epicsEventEmpty );
+
+    epicsMutexProfileEnable ( 1 );
+
+    /* Hold the mutex while the other thread waits for it */
+    epicsMutexLock ( verify.mutex );
+    epicsThreadCreate ( "verifyProfileThread", 40,
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        verifyProfileThread, &verify );
+    epicsEventMustWait ( verify.started );
+    epicsThreadSleep ( 0.2 );
+    epicsMutexUnlock ( verify.mutex );
+    testOk1(epicsEventWait ( verify.done ) == epicsEventWaitOK);
+
+    epicsMutexProfileGet ( verify.mutex, &data );
+    testOk(data.acquired == 2, "acquired %lu times",
+        (unsigned long) data.acquired);
+    testOk(data.contended == 1, "contended %lu times",
+        (unsigned long) data.contended);
+    testOk(data.waitTotal >= 0.1, "waited %.3f seconds", data.waitTotal);
+    testOk(data.holdMax >= 0.1,
+        "held for up to %.3f seconds", data.holdMax);
+
+    /* Uncontended acquisitions */
+    epicsMutexLock ( verify.mutex );
+    epicsMutexUnlock ( verify.mutex );
+    testOk1(epicsMutexTryLock ( verify.mutex ) == epicsMutexLockOK);
+    epicsMutexUnlock ( verify.mutex );
+    epicsMutexProfileGet ( verify.mutex, &data );
+    testOk(data.acquired == 4 && data.contended == 1,
+        "acquired %lu, contended %lu after two more",
+        (unsigned long) data.acquired, (unsigned long) data.contended);
+
+    epicsMutexProfileReset ();
+    epicsMutexProfileGet ( verify.mutex, &data );
+    testOk(data.acquired == 0 && data.contended == 0 &&
+        data.waitTotal == 0 && data.holdMax == 0,
+        "epicsMutexProfileReset() clears the statistics");
+
+    /* Nothing is counted while disabled */
+    epicsMutexProfileEnable ( 0 );
+    epicsMutexLock ( verify.mutex );
+    epicsMutexUnlock ( verify.mutex );
+    epicsMutexProfileGet ( verify.mutex, &data );
+    testOk(data.acquired == 0, "acquired %lu times while disabled",
+        (unsigned long) data.acquired);
+
+    epicsMutexDestroy ( verify.mutex );
+    epicsEventDestroy ( verify.started );
+    epicsEventDestroy ( verify.done );
+}
+
 MAIN(epicsMutexTest)
 {
     const int nthreads = 3;
@@ -247,9 +323,10 @@ MAIN(epicsMutexTest)
     epicsMutexId mutex;
     int status;
 
-    testPlan(5 + nthreads * nrounds);
+    testPlan(14 + nthreads * nrounds);
 
     verifyTryLock ();
+    verifyProfile ();
 
     mutex = epicsMutexMustCreate();
     status = epicsMutexLock(mutex);
@@ -22,6 +22,7 @@ int blockingSockTest(void);
 int epicsAlgorithm(void);
 int epicsAtomicTest(void);
 int epicsCalcTest(void);
+int epicsCalcArrayTest(void);
 int epicsEllTest(void);
 int epicsEnvTest(void);
 int epicsErrlogTest(void);
@@ -81,6 +82,7 @@ void epicsRunLibComTests(void)
     runTest(epicsAlgorithm);
     runTest(epicsAtomicTest);
     runTest(epicsCalcTest);
+    runTest(epicsCalcArrayTest);
     runTest(epicsEllTest);
     runTest(epicsEnvTest);
     runTest(epicsErrlogTest);
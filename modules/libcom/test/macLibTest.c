@@ -64,9 +64,34 @@ static void ovcheck(void)
     testOk(output[53] == '~', "sentinel character %x, expect 7e, (~)", output[53]);
 }
 
+/* Expanding the same text again must use the current macro values */
+static void cachecheck(void)
+{
+    MAC_HANDLE *saved = h;
+    const char *line = "record(ai, \"$(P):${R}\") { field(DESC, '$(P)') }";
+
+    if (macCreateHandle(&h, NULL))
+        testAbort("macCreateHandle() failed");
+    macPutValue(h, "P", "A");
+    macPutValue(h, "R", "B");
+    check(line, " record(ai, \"A:B\") { field(DESC, '$(P)') }");
+    macPutValue(h, "P", "C");
+    check(line, " record(ai, \"C:B\") { field(DESC, '$(P)') }");
+    macPushScope(h);
+    macPutValue(h, "R", "D");
+    check(line, " record(ai, \"C:D\") { field(DESC, '$(P)') }");
+    macPopScope(h);
+    check(line, " record(ai, \"C:B\") { field(DESC, '$(P)') }");
+    macPutValue(h, "R", NULL);
+    check(line, "!record(ai, \"C:$(R,undefined)\") { field(DESC, '$(P)') }");
+    check("\\$(P)x$(P)", " \\$(P)xC");
+    macDeleteHandle(h);
+    h = saved;
+}
+
 MAIN(macLibTest)
 {
-    testPlan(93);
+    testPlan(99);
 
     if (macCreateHandle(&h, NULL))
         testAbort("macCreateHandle() failed");
@@ -221,6 +246,7 @@ MAIN(macLibTest)
     check("${FOO}", "!$(BAR)");
 
     ovcheck();
+    cachecheck();
 
     return testDone();
 }
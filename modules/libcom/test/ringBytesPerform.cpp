@@ -0,0 +1,93 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Measures the throughput of epicsRingBytes in GB/s, comparing the
+ * copying put/get calls with the zero-copy reserve/commit and peek/consume
+ * calls. The producer fills a block and the consumer sums it, so both
+ * sides touch every byte. Producer and consumer run in turn in one thread,
+ * so the results show the cost of copying rather than of scheduling.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "epicsRingBytes.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+const int ringSize = 1 << 20;
+const double totalBytes = 4e9;
+
+unsigned sum(const char *data, int nbytes)
+{
+    unsigned total = 0;
+    for (int i = 0; i < nbytes; i++)
+        total += (unsigned char) data[i];
+    return total;
+}
+
+void report(const char *how, int block, double delay, unsigned check)
+{
+    testDiag("%-10s %7d byte blocks: %6.2f GB/s%s", how, block,
+        1e-9 * totalBytes / delay, check ? "" : " (no data seen)");
+}
+
+void measureCopy(epicsRingBytesId ring, int block)
+{
+    static char source[ringSize], dest[ringSize];
+    long nBlocks = long(totalBytes / block);
+    unsigned check = 0;
+
+    epicsTime begin = epicsTime::getMonotonic();
+    for (long i = 0; i < nBlocks; i++) {
+        memset(source, int(i), block);
+        epicsRingBytesPut(ring, source, block);
+        epicsRingBytesGet(ring, dest, block);
+        check += sum(dest, block);
+    }
+    report("put/get", block, epicsTime::getMonotonic() - begin, check);
+}
+
+void measureZeroCopy(epicsRingBytesId ring, int block)
+{
+    long nBlocks = long(totalBytes / block);
+    epicsRingBytesSpan span[2];
+    unsigned check = 0;
+
+    epicsTime begin = epicsTime::getMonotonic();
+    for (long i = 0; i < nBlocks; i++) {
+        epicsRingBytesReserve(ring, block, span);
+        memset(span[0].data, int(i), span[0].nbytes);
+        if (span[1].nbytes)
+            memset(span[1].data, int(i), span[1].nbytes);
+        epicsRingBytesCommit(ring, block);
+
+        epicsRingBytesPeek(ring, span);
+        check += sum(span[0].data, span[0].nbytes);
+        if (span[1].nbytes)
+            check += sum(span[1].data, span[1].nbytes);
+        epicsRingBytesConsume(ring, span[0].nbytes + span[1].nbytes);
+    }
+    report("zero-copy", block, epicsTime::getMonotonic() - begin, check);
+}
+
+} // namespace
+
+MAIN(ringBytesPerform)
+{
+    epicsRingBytesId ring = epicsRingBytesCreate(ringSize);
+
+    testPlan(0);
+    for (int block = 256; block <= ringSize / 4; block *= 16) {
+        measureCopy(ring, block);
+        measureZeroCopy(ring, block);
+    }
+    epicsRingBytesDelete(ring);
+    return testDone();
+}
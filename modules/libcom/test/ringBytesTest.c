@@ -51,6 +51,102 @@ static void check(epicsRingBytesId ring, int expectedFree,
            highWaterMark, expectedHighWaterMark);
 }
 
+static void testZeroCopy(epicsRingBytesId ring)
+{
+    epicsRingBytesSpan span[2];
+    char put[RINGSIZE];
+    char get[RINGSIZE];
+    int i, n;
+
+    testDiag("Zero-copy reserve/commit and peek/consume");
+    for (i = 0 ; i < RINGSIZE ; i++)
+        put[i] = 'a' + i;
+
+    n = epicsRingBytesReserve(ring, RINGSIZE+1, span);
+    testOk(n==0 && span[0].nbytes==0 && span[1].nbytes==0,
+           "reserve beyond ring capacity (%d, expected 0)", n);
+
+    /* Move the positions so the next data wraps around */
+    for (i = 0 ; i < 2 ; i++) {
+        n = epicsRingBytesPut(ring, put, RINGSIZE);
+        testOk(n==RINGSIZE, "ring put %d", RINGSIZE);
+        n = epicsRingBytesGet(ring, get, RINGSIZE);
+        testOk(n==RINGSIZE, "ring get %d", RINGSIZE);
+    }
+
+    n = epicsRingBytesReserve(ring, 0, span);
+    testOk(n==0 && span[0].nbytes==0 && span[1].nbytes==0, "reserve 0");
+
+    n = epicsRingBytesReserve(ring, RINGSIZE, span);
+    testOk(n==RINGSIZE, "reserve %d", RINGSIZE);
+    testOk(span[0].nbytes + span[1].nbytes == RINGSIZE,
+           "spans hold %d + %d bytes", span[0].nbytes, span[1].nbytes);
+    testOk(span[0].nbytes > 0 && span[1].nbytes > 0, "reservation wraps");
+    memcpy(span[0].data, put, span[0].nbytes);
+    memcpy(span[1].data, put + span[0].nbytes, span[1].nbytes);
+    check(ring, RINGSIZE, RINGSIZE);
+
+    n = epicsRingBytesPeek(ring, span);
+    testOk(n==0, "nothing to peek before commit (%d)", n);
+
+    n = epicsRingBytesCommit(ring, RINGSIZE);
+    testOk(n==RINGSIZE, "commit %d", RINGSIZE);
+    check(ring, 0, RINGSIZE);
+
+    n = epicsRingBytesPeek(ring, span);
+    testOk(n==RINGSIZE, "peek %d", n);
+    testOk(span[0].nbytes > 0 && span[1].nbytes > 0, "data wraps");
+    memcpy(get, span[0].data, span[0].nbytes);
+    memcpy(get + span[0].nbytes, span[1].data, span[1].nbytes);
+    testOk(memcmp(put, get, RINGSIZE)==0, "peek matches reserved data");
+
+    n = epicsRingBytesConsume(ring, 3);
+    testOk(n==3, "consume %d", n);
+    check(ring, 3, RINGSIZE);
+    n = epicsRingBytesGet(ring, get, RINGSIZE);
+    testOk(n==RINGSIZE-3 && memcmp(put+3, get, n)==0,
+           "get %d remaining bytes", n);
+
+    n = epicsRingBytesConsume(ring, 1);
+    testOk(n==0, "consume from empty ring");
+    n = epicsRingBytesReserve(ring, 4, span);
+    testOk(n==4, "reserve %d", n);
+    n = epicsRingBytesCommit(ring, 2);
+    testOk(n==2, "commit %d of the reserved bytes", n);
+    check(ring, RINGSIZE-2, RINGSIZE);
+    n = epicsRingBytesConsume(ring, RINGSIZE);
+    testOk(n==2, "consume is limited to the stored bytes (%d)", n);
+}
+
+static void testInMemory(void)
+{
+    size_t memSize = epicsRingBytesMemorySize(RINGSIZE);
+    void *mem = calloc(1, memSize);
+    epicsRingBytesId ring, other;
+    char put[RINGSIZE], get[RINGSIZE];
+    int i, n;
+
+    testDiag("Ring in caller-provided memory");
+    if (!mem)
+        testAbort("calloc failed");
+    testOk1(epicsRingBytesAttach(mem) == NULL);
+    ring = epicsRingBytesCreateInMemory(mem, RINGSIZE);
+    testOk(ring != NULL, "epicsRingBytesCreateInMemory");
+    other = epicsRingBytesAttach(mem);
+    testOk(other != NULL, "epicsRingBytesAttach");
+
+    for (i = 0 ; i < RINGSIZE ; i++)
+        put[i] = i;
+    n = epicsRingBytesPut(ring, put, RINGSIZE);
+    testOk(n==RINGSIZE, "put through one id");
+    n = epicsRingBytesGet(other, get, RINGSIZE);
+    testOk(n==RINGSIZE && memcmp(put, get, n)==0, "get through the other");
+    check(other, RINGSIZE, RINGSIZE);
+
+    epicsRingBytesDelete(ring);
+    free(mem);
+}
+
 MAIN(ringBytesTest)
 {
     int i, n;
@@ -60,7 +156,7 @@ MAIN(ringBytesTest)
     char get[RINGSIZE+1];
     epicsRingBytesId ring;
 
-    testPlan(292);
+    testPlan(382);
 
     pinfo = calloc(1,sizeof(info));
     if (!pinfo) {
@@ -125,6 +221,15 @@ MAIN(ringBytesTest)
     check(ring, RINGSIZE, 1);
 
     epicsRingBytesDelete(ring);
+
+    ring = epicsRingBytesCreate(RINGSIZE);
+    testZeroCopy(ring);
+    epicsRingBytesDelete(ring);
+    ring = epicsRingBytesLockedCreate(RINGSIZE);
+    testZeroCopy(ring);
+    epicsRingBytesDelete(ring);
+    testInMemory();
+
     epicsEventDestroy(consumerEvent);
     free(pinfo);
 
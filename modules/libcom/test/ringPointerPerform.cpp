@@ -0,0 +1,115 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Measures the throughput of the locked and lock-free epicsRingPointer
+ * variants with increasing numbers of threads. Each thread pushes and pops
+ * in turn, either one entry at a time or in batches, so every thread is
+ * both a producer and a consumer and all of them contend for the ring.
+ */
+
+#include <cstdio>
+
+#include "epicsRingPointer.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+const int ringSize = 1024;
+const int nOpsTotal = 2000000;
+const int maxThreads = 64;
+
+struct worker {
+    epicsRingPointer<void> *ring;
+    epicsEventId start;
+    int nOps;
+    int batch;
+    int failed;
+};
+
+extern "C" void workerThread(void *raw)
+{
+    worker *pw = static_cast<worker *>(raw);
+    void *in[16], *out[16];
+    int i;
+
+    for (i = 0; i < 16; i++)
+        in[i] = &in[i];
+
+    epicsEventMustWait(pw->start);
+    /* Pass the start signal on to the next worker */
+    epicsEventMustTrigger(pw->start);
+
+    if (pw->batch == 1) {
+        for (i = 0; i < pw->nOps; i++) {
+            if (!pw->ring->push(in[0]))
+                pw->failed++;
+            if (!pw->ring->pop())
+                pw->failed++;
+        }
+    }
+    else {
+        for (i = 0; i < pw->nOps; i += pw->batch) {
+            int n = pw->ring->pushMany(in, pw->batch);
+            if (pw->ring->popMany(out, pw->batch) != pw->batch)
+                pw->failed++;
+            if (n != pw->batch)
+                pw->failed++;
+        }
+    }
+}
+
+void measure(bool lockFree, int nThreads, int batch)
+{
+    epicsRingPointer<void> ring(ringSize, !lockFree, lockFree);
+    epicsEventId start = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadId tid[maxThreads];
+    worker workers[maxThreads];
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i, failed = 0;
+
+    opts.joinable = 1;
+    opts.priority = epicsThreadPriorityMedium;
+    for (i = 0; i < nThreads; i++) {
+        workers[i].ring = &ring;
+        workers[i].start = start;
+        workers[i].nOps = nOpsTotal / nThreads;
+        workers[i].batch = batch;
+        workers[i].failed = 0;
+        tid[i] = epicsThreadCreateOpt("ringPerf", workerThread,
+            &workers[i], &opts);
+    }
+
+    epicsTime begin = epicsTime::getMonotonic();
+    epicsEventMustTrigger(start);
+    for (i = 0; i < nThreads; i++) {
+        epicsThreadMustJoin(tid[i]);
+        failed += workers[i].failed;
+    }
+    double delay = epicsTime::getMonotonic() - begin;
+
+    testDiag("%-9s batch %2d %2d threads: %8.3f Mops/s, %d misses",
+        lockFree ? "lock-free" : "locked", batch, nThreads,
+        2e-6 * nOpsTotal / delay, failed);
+    epicsEventDestroy(start);
+}
+
+} // namespace
+
+MAIN(ringPointerPerform)
+{
+    testPlan(0);
+    for (int batch = 1; batch <= 16; batch *= 16) {
+        for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+            measure(false, nThreads, batch);
+            measure(true, nThreads, batch);
+        }
+    }
+    return testDone();
+}
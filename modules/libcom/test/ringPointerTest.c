@@ -24,6 +24,7 @@
 #include "epicsRingPointer.h"
 #include "errlog.h"
 #include "epicsEvent.h"
+#include "epicsAtomic.h"
 #include "epicsUnitTest.h"
 #include "testMain.h"
 
@@ -49,16 +50,27 @@ size_t ptr2int(void *p)
     return i&0xffff;
 }
 
-static void testSingle(void)
+static const char * const kindName[] = {"unlocked", "locked", "lock-free"};
+
+static epicsRingPointerId createRing(int kind, int size)
+{
+    switch (kind) {
+    case 1:  return epicsRingPointerLockedCreate(size);
+    case 2:  return epicsRingPointerLockFreeCreate(size);
+    default: return epicsRingPointerCreate(size);
+    }
+}
+
+static void testSingle(int kind)
 {
     int i;
     const int rsize = 100;
     void *addr = 0;
-    epicsRingPointerId ring = epicsRingPointerCreate(rsize);
+    epicsRingPointerId ring = createRing(kind, rsize);
 
     foundCorruption = 0;
 
-    testDiag("Testing operations w/o threading");
+    testDiag("Testing %s operations w/o threading", kindName[kind]);
 
     testOk1(epicsRingPointerIsEmpty(ring));
     testOk1(!epicsRingPointerIsFull(ring));
@@ -174,17 +186,134 @@ static void pairConsumer(void *raw)
     epicsEventMustTrigger(pvt->sync);
 }
 
-static void testPair(int locked)
+static void testBatch(int kind)
+{
+    const int rsize = 8;
+    void *in[10], *out[10];
+    int i, inOrder = 1;
+    epicsRingPointerId ring = createRing(kind, rsize);
+
+    testDiag("Testing %s batch operations", kindName[kind]);
+
+    for (i = 0; i < 10; i++)
+        in[i] = int2ptr(i + 1);
+
+    testOk1(epicsRingPointerPushMany(ring, in, 10) == rsize);
+    testOk1(epicsRingPointerPopMany(ring, out, 5) == 5);
+    testOk1(epicsRingPointerPopMany(ring, out + 5, 5) == rsize - 5);
+    for (i = 0; i < rsize; i++)
+        inOrder &= out[i] == in[i];
+    testOk(inOrder, "Entries popped in order");
+    testOk1(epicsRingPointerPopMany(ring, out, 10) == 0);
+
+    epicsRingPointerDelete(ring);
+}
+
+#define NMPMC_THREADS 4
+#define NMPMC_ITEMS 20000
+
+typedef struct {
+    epicsRingPointerId ring;
+    int id;
+    int producing;
+    int consumed;
+    int outOfOrder;
+} mpmcPvt;
+
+static void mpmcProducer(void *raw)
+{
+    mpmcPvt *pvt = raw;
+    int i;
+
+    for (i = 1; i <= NMPMC_ITEMS; i++) {
+        char *zero = 0;
+        while (!epicsRingPointerPush(pvt->ring,
+                zero + ((size_t)pvt->id << 20 | i)))
+            epicsThreadSleep(epicsThreadSleepQuantum());
+    }
+}
+
+static void mpmcConsumer(void *raw)
+{
+    mpmcPvt *pvt = raw;
+    mpmcPvt *shared = pvt - pvt->id;
+    int last[NMPMC_THREADS] = {0};
+
+    while (1) {
+        void *p = epicsRingPointerPop(pvt->ring);
+        size_t v;
+
+        if (!p) {
+            if (!epicsAtomicGetIntT(&shared->producing) &&
+                epicsRingPointerIsEmpty(pvt->ring))
+                break;
+            epicsThreadSleep(epicsThreadSleepQuantum());
+            continue;
+        }
+        v = (char *)p - (char *)0;
+        if (((v >> 20) & 0xf) >= NMPMC_THREADS ||
+            (int)(v & 0xfffff) <= last[(v >> 20) & 0xf]) {
+            pvt->outOfOrder++;
+        }
+        else {
+            last[(v >> 20) & 0xf] = (int)(v & 0xfffff);
+        }
+        pvt->consumed++;
+    }
+}
+
+static void testMPMC(void)
+{
+    mpmcPvt prod[NMPMC_THREADS], cons[NMPMC_THREADS];
+    epicsThreadId prodId[NMPMC_THREADS], consId[NMPMC_THREADS];
+    epicsRingPointerId ring = epicsRingPointerLockFreeCreate(64);
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i, consumed = 0, outOfOrder = 0;
+
+    testDiag("%d producers, %d consumers, lock-free", NMPMC_THREADS,
+        NMPMC_THREADS);
+
+    memset(prod, 0, sizeof(prod));
+    memset(cons, 0, sizeof(cons));
+    for (i = 0; i < NMPMC_THREADS; i++) {
+        prod[i].ring = cons[i].ring = ring;
+        prod[i].id = cons[i].id = i;
+    }
+    cons[0].producing = 1;
+    opts.joinable = 1;
+    opts.priority = epicsThreadPriorityMedium;
+    for (i = 0; i < NMPMC_THREADS; i++) {
+        consId[i] = epicsThreadCreateOpt("mpmcCons", mpmcConsumer,
+            &cons[i], &opts);
+        prodId[i] = epicsThreadCreateOpt("mpmcProd", mpmcProducer,
+            &prod[i], &opts);
+    }
+    for (i = 0; i < NMPMC_THREADS; i++)
+        epicsThreadMustJoin(prodId[i]);
+    /* All producers are finished, let the consumers drain the ring */
+    epicsAtomicSetIntT(&cons[0].producing, 0);
+    for (i = 0; i < NMPMC_THREADS; i++)
+        epicsThreadMustJoin(consId[i]);
+
+    for (i = 0; i < NMPMC_THREADS; i++) {
+        consumed += cons[i].consumed;
+        outOfOrder += cons[i].outOfOrder;
+    }
+    testOk(consumed == NMPMC_THREADS * NMPMC_ITEMS, "consumed %d of %d",
+        consumed, NMPMC_THREADS * NMPMC_ITEMS);
+    testOk(outOfOrder == 0, "%d entries out of order", outOfOrder);
+    testOk1(epicsRingPointerIsEmpty(ring));
+
+    epicsRingPointerDelete(ring);
+}
+
+static void testPair(int kind)
 {
     unsigned int myprio = epicsThreadGetPrioritySelf(), consumerprio;
     pairPvt pvt;
     const int rsize = 100;
     int i, expect;
-    epicsRingPointerId ring;
-    if(locked)
-        ring = epicsRingPointerLockedCreate(rsize);
-    else
-        ring = epicsRingPointerCreate(rsize);
+    epicsRingPointerId ring = createRing(kind, rsize);
 
     pvt.ring = ring;
     pvt.sync = epicsEventCreate(epicsEventEmpty);
@@ -194,7 +323,7 @@ static void testPair(int locked)
 
     foundCorruption = 0;
 
-    testDiag("single producer, single consumer with%s locking", locked?"":"out");
+    testDiag("single producer, single consumer, %s", kindName[kind]);
 
     /* give the consumer thread a slightly higher priority so that
      * it can preempt us on RTOS targets.  On non-RTOS targets
@@ -246,6 +375,7 @@ void testInThread(void *raw)
     epicsEventId stop = raw;
     testPair(0);
     testPair(1);
+    testPair(2);
     epicsEventMustTrigger(stop);
 }
 
@@ -255,8 +385,13 @@ MAIN(ringPointerTest)
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
     epicsEventId stop = epicsEventMustCreate(epicsEventEmpty);
 
-    testPlan(42);
-    testSingle();
+    testPlan(36*2 + 3*3 + 5*3 + 3);
+    testSingle(0);
+    testSingle(2);
+    testBatch(0);
+    testBatch(1);
+    testBatch(2);
+    testMPMC();
     /* testPair() needs to run with a priority > 0.
      * Start a new thread since main() is a "non-epics"
      * thread, for which we can/should not change the priority